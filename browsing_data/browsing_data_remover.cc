@@ -4,6 +4,7 @@
 
 #include "chrome/browser/browsing_data/browsing_data_remover.h"
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
@@ -12,6 +13,7 @@
 #include "base/bind_helpers.h"
 #include "base/callback.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
 #include "base/prefs/pref_service.h"
 #include "chrome/browser/autofill/personal_data_manager_factory.h"
 #include "chrome/browser/browser_process.h"
@@ -99,6 +101,34 @@ using content::BrowserContext;
 using content::BrowserThread;
 using content::DOMStorageContext;
 
+namespace {
+
+// The names of the phases in the BrowsingData.RemovalPhaseTime histograms, in
+// the order of BrowsingDataRemover::Phase.
+const char* const kPhaseNames[] = {
+  "AutofillOriginURLs",
+  "Cache",
+  "ChannelIDs",
+  "ContentLicenses",
+  "Cookies",
+  "DomainReliabilityMonitor",
+  "FormData",
+  "History",
+  "HostnameResolutionCache",
+  "KeywordData",
+  "LoggedInPredictor",
+  "NaClCache",
+  "NetworkPredictor",
+  "NetworkingHistory",
+  "PlatformKeys",
+  "PluginData",
+  "PnaclCache",
+  "StoragePartitionData",
+  "WebRtcLogs",
+};
+
+}  // namespace
+
 bool BrowsingDataRemover::is_removing_ = false;
 
 BrowsingDataRemover::CompletionInhibitor*
@@ -186,43 +216,28 @@ BrowsingDataRemover::BrowsingDataRemover(Profile* profile,
     : profile_(profile),
       delete_begin_(delete_begin),
       delete_end_(delete_end),
-      next_cache_state_(STATE_NONE),
-      cache_(NULL),
       main_context_getter_(profile->GetRequestContext()),
       media_context_getter_(profile->GetMediaRequestContext()),
       deauthorize_content_licenses_request_id_(0),
-      waiting_for_clear_autofill_origin_urls_(false),
-      waiting_for_clear_cache_(false),
-      waiting_for_clear_channel_ids_(false),
-      waiting_for_clear_content_licenses_(false),
-      waiting_for_clear_cookies_count_(0),
-      waiting_for_clear_domain_reliability_monitor_(false),
-      waiting_for_clear_form_(false),
-      waiting_for_clear_history_(false),
-      waiting_for_clear_hostname_resolution_cache_(false),
-      waiting_for_clear_keyword_data_(false),
-      waiting_for_clear_logged_in_predictor_(false),
-      waiting_for_clear_nacl_cache_(false),
-      waiting_for_clear_network_predictor_(false),
-      waiting_for_clear_networking_history_(false),
-      waiting_for_clear_platform_keys_(false),
-      waiting_for_clear_plugin_data_(false),
-      waiting_for_clear_pnacl_cache_(false),
-      waiting_for_clear_storage_partition_data_(false),
-#if defined(ENABLE_WEBRTC)
-      waiting_for_clear_webrtc_logs_(false),
-#endif
+      phases_started_(0),
+      phases_done_(0),
+      profile_destroyed_(false),
       remove_mask_(0),
       remove_origin_(GURL()),
       origin_set_mask_(0),
-      storage_partition_for_testing_(NULL) {
+      storage_partition_for_testing_(NULL),
+      weak_ptr_factory_(this) {
   DCHECK(profile);
+  std::fill(pending_tasks_, pending_tasks_ + PHASE_COUNT, 0);
   // crbug.com/140910: Many places were calling this with base::Time() as
   // delete_end, even though they should've used base::Time::Max(). Work around
   // it here. New code should use base::Time::Max().
   DCHECK(delete_end_ != base::Time());
   if (delete_end_ == base::Time())
     delete_end_ = base::Time::Max();
+
+  registrar_.Add(this, chrome::NOTIFICATION_PROFILE_DESTROYED,
+                 content::Source<Profile>(profile_));
 }
 
 BrowsingDataRemover::~BrowsingDataRemover() {
@@ -244,6 +259,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
                                      int origin_set_mask) {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
   set_removing(true);
+  remove_start_time_ = base::TimeTicks::Now();
   remove_mask_ = remove_mask;
   remove_origin_ = origin;
   origin_set_mask_ = origin_set_mask;
@@ -285,7 +301,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
       if (!remove_origin_.is_empty())
         restrict_urls.insert(remove_origin_);
       content::RecordAction(UserMetricsAction("ClearBrowsingData_History"));
-      waiting_for_clear_history_ = true;
+      StartPhase(PHASE_HISTORY);
 
       history_service->ExpireLocalAndRemoteHistoryBetween(
           restrict_urls, delete_begin_, delete_end_,
@@ -305,7 +321,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     // reveals some history: we have no mechanism to track when these items were
     // created, so we'll clear them all. Better safe than sorry.
     if (g_browser_process->io_thread()) {
-      waiting_for_clear_hostname_resolution_cache_ = true;
+      StartPhase(PHASE_HOSTNAME_RESOLUTION_CACHE);
       BrowserThread::PostTask(
           BrowserThread::IO, FROM_HERE,
           base::Bind(
@@ -314,7 +330,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
               g_browser_process->io_thread()));
     }
     if (profile_->GetNetworkPredictor()) {
-      waiting_for_clear_network_predictor_ = true;
+      StartPhase(PHASE_NETWORK_PREDICTOR);
       BrowserThread::PostTask(
           BrowserThread::IO, FROM_HERE,
           base::Bind(&BrowsingDataRemover::ClearNetworkPredictorOnIOThread,
@@ -326,11 +342,11 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     TemplateURLService* keywords_model =
         TemplateURLServiceFactory::GetForProfile(profile_);
     if (keywords_model && !keywords_model->loaded()) {
+      StartPhase(PHASE_KEYWORD_DATA);
       template_url_sub_ = keywords_model->RegisterOnLoadedCallback(
           base::Bind(&BrowsingDataRemover::OnKeywordsLoaded,
                      base::Unretained(this)));
       keywords_model->Load();
-      waiting_for_clear_keyword_data_ = true;
     } else if (keywords_model) {
       keywords_model->RemoveAutoGeneratedForOriginBetween(remove_origin_,
           delete_begin_, delete_end_);
@@ -376,7 +392,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
         WebDataServiceFactory::GetAutofillWebDataForProfile(
             profile_, Profile::EXPLICIT_ACCESS);
     if (web_data_service.get()) {
-      waiting_for_clear_autofill_origin_urls_ = true;
+      StartPhase(PHASE_AUTOFILL_ORIGIN_URLS);
       web_data_service->RemoveOriginURLsModifiedBetween(
           delete_begin_, delete_end_);
       // The above calls are done on the UI thread but do their work on the DB
@@ -394,7 +410,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     }
 
 #if defined(ENABLE_WEBRTC)
-    waiting_for_clear_webrtc_logs_ = true;
+    StartPhase(PHASE_WEBRTC_LOGS);
     BrowserThread::PostTaskAndReply(
         BrowserThread::FILE,
         FROM_HERE,
@@ -451,7 +467,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
       if (sb_service) {
         net::URLRequestContextGetter* sb_context =
             sb_service->url_request_context();
-        ++waiting_for_clear_cookies_count_;
+        StartPhase(PHASE_COOKIES);
         BrowserThread::PostTask(
             BrowserThread::IO, FROM_HERE,
             base::Bind(&BrowsingDataRemover::ClearCookiesOnIOThread,
@@ -471,7 +487,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     // Since we are running on the UI thread don't call GetURLRequestContext().
     net::URLRequestContextGetter* rq_context = profile_->GetRequestContext();
     if (rq_context) {
-      waiting_for_clear_channel_ids_ = true;
+      StartPhase(PHASE_CHANNEL_IDS);
       BrowserThread::PostTask(
           BrowserThread::IO, FROM_HERE,
           base::Bind(&BrowsingDataRemover::ClearChannelIDsOnIOThread,
@@ -512,7 +528,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
       origin_set_mask_ & BrowsingDataHelper::UNPROTECTED_WEB) {
     content::RecordAction(UserMetricsAction("ClearBrowsingData_LSOData"));
 
-    waiting_for_clear_plugin_data_ = true;
+    StartPhase(PHASE_PLUGIN_DATA);
     if (!plugin_data_remover_.get())
       plugin_data_remover_.reset(content::PluginDataRemover::Create(profile_));
     base::WaitableEvent* event =
@@ -549,7 +565,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
             profile_, Profile::EXPLICIT_ACCESS);
 
     if (web_data_service.get()) {
-      waiting_for_clear_form_ = true;
+      StartPhase(PHASE_FORM_DATA);
       web_data_service->RemoveFormElementsAddedBetween(delete_begin_,
           delete_end_);
       web_data_service->RemoveAutofillDataModifiedBetween(
@@ -573,24 +589,31 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     // Tell the renderers to clear their cache.
     WebCacheManager::GetInstance()->ClearCache();
 
-    // Invoke DoClearCache on the IO thread.
-    waiting_for_clear_cache_ = true;
+    // Clear the main and the media HTTP caches on the IO thread. They are
+    // independent, so neither waits for the other.
     content::RecordAction(UserMetricsAction("ClearBrowsingData_Cache"));
-
+    DCHECK(main_context_getter_.get());
+    DCHECK(media_context_getter_.get());
+    StartPhase(PHASE_CACHE);
     BrowserThread::PostTask(
         BrowserThread::IO, FROM_HERE,
         base::Bind(&BrowsingDataRemover::ClearCacheOnIOThread,
-                   base::Unretained(this)));
+                   base::Unretained(this), main_context_getter_));
+    StartPhase(PHASE_CACHE);
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&BrowsingDataRemover::ClearCacheOnIOThread,
+                   base::Unretained(this), media_context_getter_));
 
 #if !defined(DISABLE_NACL)
-    waiting_for_clear_nacl_cache_ = true;
+    StartPhase(PHASE_NACL_CACHE);
 
     BrowserThread::PostTask(
         BrowserThread::IO, FROM_HERE,
         base::Bind(&BrowsingDataRemover::ClearNaClCacheOnIOThread,
                    base::Unretained(this)));
 
-    waiting_for_clear_pnacl_cache_ = true;
+    StartPhase(PHASE_PNACL_CACHE);
     BrowserThread::PostTask(
         BrowserThread::IO, FROM_HERE,
         base::Bind(&BrowsingDataRemover::ClearPnaclCacheOnIOThread,
@@ -621,7 +644,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
   }
 
   if (storage_partition_remove_mask) {
-    waiting_for_clear_storage_partition_data_ = true;
+    StartPhase(PHASE_STORAGE_PARTITION_DATA);
 
     content::StoragePartition* storage_partition;
     if (storage_partition_for_testing_)
@@ -649,7 +672,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
         delete_begin_,
         delete_end_,
         base::Bind(&BrowsingDataRemover::OnClearedStoragePartitionData,
-                   base::Unretained(this)));
+                   weak_ptr_factory_.GetWeakPtr()));
   }
 
 #if defined(ENABLE_PLUGINS)
@@ -657,7 +680,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     content::RecordAction(
         UserMetricsAction("ClearBrowsingData_ContentLicenses"));
 
-    waiting_for_clear_content_licenses_ = true;
+    StartPhase(PHASE_CONTENT_LICENSES);
     if (!pepper_flash_settings_manager_.get()) {
       pepper_flash_settings_manager_.reset(
           new PepperFlashSettingsManager(this, profile_));
@@ -671,6 +694,7 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     if (!user) {
       LOG(WARNING) << "Failed to find user for current profile.";
     } else {
+      StartPhase(PHASE_PLATFORM_KEYS);
       chromeos::DBusThreadManager::Get()->GetCryptohomeClient()->
           TpmAttestationDeleteKeys(
               chromeos::attestation::KEY_USER,
@@ -678,7 +702,6 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
               chromeos::attestation::kContentProtectionKeyPrefix,
               base::Bind(&BrowsingDataRemover::OnClearPlatformKeys,
                          base::Unretained(this)));
-      waiting_for_clear_platform_keys_ = true;
     }
 #endif
   }
@@ -690,11 +713,11 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
 
   // Always wipe accumulated network related data (TransportSecurityState and
   // HttpServerPropertiesManager data).
-  waiting_for_clear_networking_history_ = true;
+  StartPhase(PHASE_NETWORKING_HISTORY);
   profile_->ClearNetworkingHistorySince(
       delete_begin_,
       base::Bind(&BrowsingDataRemover::OnClearedNetworkingHistory,
-                 base::Unretained(this)));
+                 weak_ptr_factory_.GetWeakPtr()));
 
   if (remove_mask & (REMOVE_COOKIES | REMOVE_HISTORY)) {
     domain_reliability::DomainReliabilityService* service =
@@ -707,11 +730,11 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
       else
         mode = domain_reliability::CLEAR_BEACONS;
 
-      waiting_for_clear_domain_reliability_monitor_ = true;
+      StartPhase(PHASE_DOMAIN_RELIABILITY_MONITOR);
       service->ClearBrowsingData(
           mode,
           base::Bind(&BrowsingDataRemover::OnClearedDomainReliabilityMonitor,
-                     base::Unretained(this)));
+                     weak_ptr_factory_.GetWeakPtr()));
     }
   }
 }
@@ -725,8 +748,7 @@ void BrowsingDataRemover::RemoveObserver(Observer* observer) {
 }
 
 void BrowsingDataRemover::OnHistoryDeletionDone() {
-  waiting_for_clear_history_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_HISTORY);
 }
 
 void BrowsingDataRemover::OverrideStoragePartitionForTesting(
@@ -762,27 +784,86 @@ base::Time BrowsingDataRemover::CalculateBeginDeleteTime(
 }
 
 bool BrowsingDataRemover::AllDone() {
-  return !waiting_for_clear_autofill_origin_urls_ &&
-         !waiting_for_clear_cache_ &&
-         !waiting_for_clear_content_licenses_ &&
-         !waiting_for_clear_channel_ids_ &&
-         !waiting_for_clear_cookies_count_ &&
-         !waiting_for_clear_domain_reliability_monitor_ &&
-         !waiting_for_clear_form_ &&
-         !waiting_for_clear_history_ &&
-         !waiting_for_clear_hostname_resolution_cache_ &&
-         !waiting_for_clear_keyword_data_ &&
-         !waiting_for_clear_logged_in_predictor_ &&
-         !waiting_for_clear_nacl_cache_ &&
-         !waiting_for_clear_network_predictor_ &&
-         !waiting_for_clear_networking_history_ &&
-         !waiting_for_clear_platform_keys_ &&
-         !waiting_for_clear_plugin_data_ &&
-         !waiting_for_clear_pnacl_cache_ &&
-#if defined(ENABLE_WEBRTC)
-         !waiting_for_clear_webrtc_logs_ &&
+  for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+    if (pending_tasks_[phase])
+      return false;
+  }
+  return true;
+}
+
+void BrowsingDataRemover::Observe(
+    int type,
+    const content::NotificationSource& source,
+    const content::NotificationDetails& details) {
+  DCHECK_EQ(chrome::NOTIFICATION_PROFILE_DESTROYED, type);
+  CancelProfilePhases();
+}
+
+void BrowsingDataRemover::StartPhase(Phase phase) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  if (pending_tasks_[phase]++ == 0) {
+    phase_start_time_[phase] = base::TimeTicks::Now();
+    ++phases_started_;
+  }
+}
+
+void BrowsingDataRemover::FinishPhase(Phase phase) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  COMPILE_ASSERT(arraysize(kPhaseNames) == PHASE_COUNT,
+                 phase_names_must_match_phases);
+  DCHECK_GT(pending_tasks_[phase], 0);
+  if (--pending_tasks_[phase] > 0)
+    return;
+
+  // The times of cancelled phases would skew the histograms.
+  if (!profile_destroyed_) {
+    // Same as UMA_HISTOGRAM_LONG_TIMES, which needs a constant name.
+    base::HistogramBase* histogram = base::Histogram::FactoryTimeGet(
+        std::string("BrowsingData.RemovalPhaseTime.") + kPhaseNames[phase],
+        base::TimeDelta::FromMilliseconds(1),
+        base::TimeDelta::FromHours(1),
+        100,
+        base::HistogramBase::kUmaTargetedHistogramFlag);
+    histogram->AddTime(base::TimeTicks::Now() - phase_start_time_[phase]);
+  }
+
+  ++phases_done_;
+  FOR_EACH_OBSERVER(Observer, observer_list_,
+                    OnBrowsingDataRemoverProgress(phases_done_,
+                                                  phases_started_));
+  NotifyAndDeleteIfDone();
+}
+
+bool BrowsingDataRemover::IsWaitingFor(Phase phase) const {
+  return pending_tasks_[phase] > 0;
+}
+
+void BrowsingDataRemover::CancelProfilePhases() {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  profile_destroyed_ = true;
+
+  // None of these callbacks may run after the phases are finished below.
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  history_task_tracker_.TryCancelAll();
+  template_url_sub_.reset();
+#if defined(ENABLE_PLUGINS)
+  watcher_.StopWatching();
+  pepper_flash_settings_manager_.reset();
 #endif
-         !waiting_for_clear_storage_partition_data_;
+
+  const Phase kProfilePhases[] = {
+    PHASE_CONTENT_LICENSES,
+    PHASE_DOMAIN_RELIABILITY_MONITOR,
+    PHASE_HISTORY,
+    PHASE_KEYWORD_DATA,
+    PHASE_NETWORKING_HISTORY,
+    PHASE_PLUGIN_DATA,
+    PHASE_STORAGE_PARTITION_DATA,
+  };
+  for (size_t i = 0; i < arraysize(kProfilePhases); ++i) {
+    while (IsWaitingFor(kProfilePhases[i]))
+      FinishPhase(kProfilePhases[i]);
+  }
 }
 
 void BrowsingDataRemover::OnKeywordsLoaded() {
@@ -791,21 +872,25 @@ void BrowsingDataRemover::OnKeywordsLoaded() {
   TemplateURLService* model =
       TemplateURLServiceFactory::GetForProfile(profile_);
   model->RemoveAutoGeneratedBetween(delete_begin_, delete_end_);
-  waiting_for_clear_keyword_data_ = false;
   template_url_sub_.reset();
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_KEYWORD_DATA);
 }
 
 void BrowsingDataRemover::NotifyAndDelete() {
   set_removing(false);
 
-  // Send global notification, then notify any explicit observers.
-  BrowsingDataRemover::NotificationDetails details(delete_begin_, remove_mask_,
-      origin_set_mask_);
-  content::NotificationService::current()->Notify(
-      chrome::NOTIFICATION_BROWSING_DATA_REMOVED,
-      content::Source<Profile>(profile_),
-      content::Details<BrowsingDataRemover::NotificationDetails>(&details));
+  if (!profile_destroyed_) {
+    UMA_HISTOGRAM_LONG_TIMES("BrowsingData.RemovalTime",
+                             base::TimeTicks::Now() - remove_start_time_);
+
+    // Send global notification, then notify any explicit observers.
+    BrowsingDataRemover::NotificationDetails details(delete_begin_,
+        remove_mask_, origin_set_mask_);
+    content::NotificationService::current()->Notify(
+        chrome::NOTIFICATION_BROWSING_DATA_REMOVED,
+        content::Source<Profile>(profile_),
+        content::Details<BrowsingDataRemover::NotificationDetails>(&details));
+  }
 
   FOR_EACH_OBSERVER(Observer, observer_list_, OnBrowsingDataRemoverDone());
 
@@ -834,8 +919,7 @@ void BrowsingDataRemover::NotifyAndDeleteIfDone() {
 
 void BrowsingDataRemover::OnClearedHostnameResolutionCache() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_hostname_resolution_cache_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_HOSTNAME_RESOLUTION_CACHE);
 }
 
 void BrowsingDataRemover::ClearHostnameResolutionCacheOnIOThread(
@@ -854,14 +938,13 @@ void BrowsingDataRemover::ClearHostnameResolutionCacheOnIOThread(
 
 void BrowsingDataRemover::OnClearedLoggedInPredictor() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  DCHECK(waiting_for_clear_logged_in_predictor_);
-  waiting_for_clear_logged_in_predictor_ = false;
-  NotifyAndDeleteIfDone();
+  DCHECK(IsWaitingFor(PHASE_LOGGED_IN_PREDICTOR));
+  FinishPhase(PHASE_LOGGED_IN_PREDICTOR);
 }
 
 void BrowsingDataRemover::ClearLoggedInPredictor() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  DCHECK(!waiting_for_clear_logged_in_predictor_);
+  DCHECK(!IsWaitingFor(PHASE_LOGGED_IN_PREDICTOR));
 
   predictors::PredictorDatabase* predictor_db =
       predictors::PredictorDatabaseFactory::GetForProfile(profile_);
@@ -873,7 +956,7 @@ void BrowsingDataRemover::ClearLoggedInPredictor() {
   if (!logged_in_table)
     return;
 
-  waiting_for_clear_logged_in_predictor_ = true;
+  StartPhase(PHASE_LOGGED_IN_PREDICTOR);
 
   BrowserThread::PostTaskAndReply(
       BrowserThread::DB,
@@ -888,8 +971,7 @@ void BrowsingDataRemover::ClearLoggedInPredictor() {
 
 void BrowsingDataRemover::OnClearedNetworkPredictor() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_network_predictor_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_NETWORK_PREDICTOR);
 }
 
 void BrowsingDataRemover::ClearNetworkPredictorOnIOThread(
@@ -910,106 +992,75 @@ void BrowsingDataRemover::ClearNetworkPredictorOnIOThread(
 
 void BrowsingDataRemover::OnClearedNetworkingHistory() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_networking_history_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_NETWORKING_HISTORY);
 }
 
 void BrowsingDataRemover::ClearedCache() {
-  waiting_for_clear_cache_ = false;
-
-  NotifyAndDeleteIfDone();
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  FinishPhase(PHASE_CACHE);
 }
 
-void BrowsingDataRemover::ClearCacheOnIOThread() {
+void BrowsingDataRemover::ClearCacheOnIOThread(
+    scoped_refptr<net::URLRequestContextGetter> getter) {
   // This function should be called on the IO thread.
   DCHECK_CURRENTLY_ON(BrowserThread::IO);
-  DCHECK_EQ(STATE_NONE, next_cache_state_);
-  DCHECK(main_context_getter_.get());
-  DCHECK(media_context_getter_.get());
 
-  next_cache_state_ = STATE_CREATE_MAIN;
-  DoClearCache(net::OK);
+  net::HttpCache* http_cache =
+      getter->GetURLRequestContext()->http_transaction_factory()->GetCache();
+
+  // Clear QUIC server information from memory and the disk cache.
+  http_cache->GetSession()->quic_stream_factory()->
+      ClearCachedStatesInCryptoConfig();
+
+  // Clear SDCH dictionary state.
+  net::SdchManager* sdch_manager =
+      getter->GetURLRequestContext()->sdch_manager();
+  // The test is probably overkill, since chrome should always have an
+  // SdchManager.  But in general the URLRequestContext  is *not*
+  // guaranteed to have an SdchManager, so checking is wise.
+  if (sdch_manager)
+    sdch_manager->ClearData();
+
+  // The callback owns the pointer the backend is returned in.
+  disk_cache::Backend** backend = new disk_cache::Backend*(NULL);
+  net::CompletionCallback callback =
+      base::Bind(&BrowsingDataRemover::DoomCacheEntriesOnIOThread,
+                 base::Unretained(this), base::Owned(backend));
+  int rv = http_cache->GetBackend(backend, callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
 }
 
-// The expected state sequence is STATE_NONE --> STATE_CREATE_MAIN -->
-// STATE_DELETE_MAIN --> STATE_CREATE_MEDIA --> STATE_DELETE_MEDIA -->
-// STATE_DONE, and any errors are ignored.
-void BrowsingDataRemover::DoClearCache(int rv) {
-  DCHECK_NE(STATE_NONE, next_cache_state_);
-
-  while (rv != net::ERR_IO_PENDING && next_cache_state_ != STATE_NONE) {
-    switch (next_cache_state_) {
-      case STATE_CREATE_MAIN:
-      case STATE_CREATE_MEDIA: {
-        // Get a pointer to the cache.
-        net::URLRequestContextGetter* getter =
-            (next_cache_state_ == STATE_CREATE_MAIN)
-                ? main_context_getter_.get()
-                : media_context_getter_.get();
-        net::HttpCache* http_cache =
-            getter->GetURLRequestContext()->http_transaction_factory()->
-                GetCache();
-
-        next_cache_state_ = (next_cache_state_ == STATE_CREATE_MAIN) ?
-                                STATE_DELETE_MAIN : STATE_DELETE_MEDIA;
-
-        // Clear QUIC server information from memory and the disk cache.
-        http_cache->GetSession()->quic_stream_factory()->
-            ClearCachedStatesInCryptoConfig();
-
-        // Clear SDCH dictionary state.
-        net::SdchManager* sdch_manager =
-            getter->GetURLRequestContext()->sdch_manager();
-        // The test is probably overkill, since chrome should always have an
-        // SdchManager.  But in general the URLRequestContext  is *not*
-        // guaranteed to have an SdchManager, so checking is wise.
-        if (sdch_manager)
-          sdch_manager->ClearData();
-
-        rv = http_cache->GetBackend(
-            &cache_, base::Bind(&BrowsingDataRemover::DoClearCache,
-                                base::Unretained(this)));
-        break;
-      }
-      case STATE_DELETE_MAIN:
-      case STATE_DELETE_MEDIA: {
-        next_cache_state_ = (next_cache_state_ == STATE_DELETE_MAIN) ?
-                                STATE_CREATE_MEDIA : STATE_DONE;
-
-        // |cache_| can be null if it cannot be initialized.
-        if (cache_) {
-          if (delete_begin_.is_null()) {
-            rv = cache_->DoomAllEntries(
-                base::Bind(&BrowsingDataRemover::DoClearCache,
-                           base::Unretained(this)));
-          } else {
-            rv = cache_->DoomEntriesBetween(
-                delete_begin_, delete_end_,
-                base::Bind(&BrowsingDataRemover::DoClearCache,
-                           base::Unretained(this)));
-          }
-          cache_ = NULL;
-        }
-        break;
-      }
-      case STATE_DONE: {
-        cache_ = NULL;
-        next_cache_state_ = STATE_NONE;
+void BrowsingDataRemover::DoomCacheEntriesOnIOThread(
+    disk_cache::Backend** backend,
+    int rv) {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
 
-        // Notify the UI thread that we are done.
-        BrowserThread::PostTask(
-            BrowserThread::UI, FROM_HERE,
-            base::Bind(&BrowsingDataRemover::ClearedCache,
-                       base::Unretained(this)));
-        return;
-      }
-      default: {
-        NOTREACHED() << "bad state";
-        next_cache_state_ = STATE_NONE;  // Stop looping.
-        return;
-      }
-    }
+  // |*backend| can be null if the cache cannot be initialized.
+  if (!*backend) {
+    ClearedCacheOnIOThread(rv);
+    return;
   }
+
+  net::CompletionCallback callback =
+      base::Bind(&BrowsingDataRemover::ClearedCacheOnIOThread,
+                 base::Unretained(this));
+  if (delete_begin_.is_null())
+    rv = (*backend)->DoomAllEntries(callback);
+  else
+    rv = (*backend)->DoomEntriesBetween(delete_begin_, delete_end_, callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
+}
+
+void BrowsingDataRemover::ClearedCacheOnIOThread(int rv) {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+
+  // Notify the UI thread that we are done.
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(&BrowsingDataRemover::ClearedCache,
+                 base::Unretained(this)));
 }
 
 #if !defined(DISABLE_NACL)
@@ -1017,9 +1068,7 @@ void BrowsingDataRemover::ClearedNaClCache() {
   // This function should be called on the UI thread.
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
 
-  waiting_for_clear_nacl_cache_ = false;
-
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_NACL_CACHE);
 }
 
 void BrowsingDataRemover::ClearedNaClCacheOnIOThread() {
@@ -1045,9 +1094,7 @@ void BrowsingDataRemover::ClearedPnaclCache() {
   // This function should be called on the UI thread.
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
 
-  waiting_for_clear_pnacl_cache_ = false;
-
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_PNACL_CACHE);
 }
 
 void BrowsingDataRemover::ClearedPnaclCacheOnIOThread() {
@@ -1074,19 +1121,17 @@ void BrowsingDataRemover::ClearPnaclCacheOnIOThread(base::Time begin,
 
 void BrowsingDataRemover::OnWaitableEventSignaled(
     base::WaitableEvent* waitable_event) {
-  waiting_for_clear_plugin_data_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_PLUGIN_DATA);
 }
 
 #if defined(ENABLE_PLUGINS)
 void BrowsingDataRemover::OnDeauthorizeContentLicensesCompleted(
     uint32 request_id,
     bool /* success */) {
-  DCHECK(waiting_for_clear_content_licenses_);
+  DCHECK(IsWaitingFor(PHASE_CONTENT_LICENSES));
   DCHECK_EQ(request_id, deauthorize_content_licenses_request_id_);
 
-  waiting_for_clear_content_licenses_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_CONTENT_LICENSES);
 }
 #endif
 
@@ -1094,12 +1139,11 @@ void BrowsingDataRemover::OnDeauthorizeContentLicensesCompleted(
 void BrowsingDataRemover::OnClearPlatformKeys(
     chromeos::DBusMethodCallStatus call_status,
     bool result) {
-  DCHECK(waiting_for_clear_platform_keys_);
+  DCHECK(IsWaitingFor(PHASE_PLATFORM_KEYS));
   if (call_status != chromeos::DBUS_METHOD_CALL_SUCCESS || !result) {
     LOG(ERROR) << "Failed to clear platform keys.";
   }
-  waiting_for_clear_platform_keys_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_PLATFORM_KEYS);
 }
 #endif
 
@@ -1112,9 +1156,7 @@ void BrowsingDataRemover::OnClearedCookies(int num_deleted) {
     return;
   }
 
-  DCHECK_GT(waiting_for_clear_cookies_count_, 0);
-  --waiting_for_clear_cookies_count_;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_COOKIES);
 }
 
 void BrowsingDataRemover::ClearCookiesOnIOThread(
@@ -1155,38 +1197,32 @@ void BrowsingDataRemover::OnClearedChannelIDsOnIOThread(
 
 void BrowsingDataRemover::OnClearedChannelIDs() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_channel_ids_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_CHANNEL_IDS);
 }
 
 void BrowsingDataRemover::OnClearedFormData() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_form_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_FORM_DATA);
 }
 
 void BrowsingDataRemover::OnClearedAutofillOriginURLs() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_autofill_origin_urls_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_AUTOFILL_ORIGIN_URLS);
 }
 
 void BrowsingDataRemover::OnClearedStoragePartitionData() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_storage_partition_data_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_STORAGE_PARTITION_DATA);
 }
 
 #if defined(ENABLE_WEBRTC)
 void BrowsingDataRemover::OnClearedWebRtcLogs() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_webrtc_logs_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_WEBRTC_LOGS);
 }
 #endif
 
 void BrowsingDataRemover::OnClearedDomainReliabilityMonitor() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-  waiting_for_clear_domain_reliability_monitor_ = false;
-  NotifyAndDeleteIfDone();
+  FinishPhase(PHASE_DOMAIN_RELIABILITY_MONITOR);
 }
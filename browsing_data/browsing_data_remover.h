@@ -9,6 +9,7 @@
 
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
 #include "base/prefs/pref_member.h"
 #include "base/sequenced_task_runner_helpers.h"
@@ -17,6 +18,8 @@
 #include "base/time/time.h"
 #include "chrome/browser/pepper_flash_settings_manager.h"
 #include "components/search_engines/template_url_service.h"
+#include "content/public/browser/notification_observer.h"
+#include "content/public/browser/notification_registrar.h"
 #if defined(OS_CHROMEOS)
 #include "chromeos/dbus/dbus_method_call_status.h"
 #endif
@@ -56,10 +59,16 @@ struct SessionStorageUsageInfo;
 
 // BrowsingDataRemover is responsible for removing data related to browsing:
 // visits in url database, downloads, cookies ...
-
-class BrowsingDataRemover
+//
+// The removal is split into phases (history, cache, cookies, ...) which are
+// all started at once and run in parallel on their own threads. Observers are
+// told as each phase finishes, and the time each phase took is recorded in
+// UMA. If the profile is destroyed during the removal, the phases that depend
+// on its services are cancelled.
+
+class BrowsingDataRemover : public content::NotificationObserver
 #if defined(ENABLE_PLUGINS)
-    : public PepperFlashSettingsManager::Client
+    , public PepperFlashSettingsManager::Client
 #endif
     {
  public:
@@ -148,6 +157,11 @@ class BrowsingDataRemover
    public:
     virtual void OnBrowsingDataRemoverDone() = 0;
 
+    // Called each time a phase of the removal finishes. |phases_done| of the
+    // |phases_total| phases that were started have finished.
+    virtual void OnBrowsingDataRemoverProgress(int phases_done,
+                                               int phases_total) {}
+
    protected:
     virtual ~Observer() {}
   };
@@ -227,13 +241,29 @@ class BrowsingDataRemover
   // TODO(mkwst): See http://crbug.com/113621
   friend class BrowsingDataRemoverTest;
 
-  enum CacheState {
-    STATE_NONE,
-    STATE_CREATE_MAIN,
-    STATE_CREATE_MEDIA,
-    STATE_DELETE_MAIN,
-    STATE_DELETE_MEDIA,
-    STATE_DONE
+  // The phases of a removal, which run in parallel. A phase may be waiting on
+  // more than one task, e.g. the main and the media HTTP caches.
+  enum Phase {
+    PHASE_AUTOFILL_ORIGIN_URLS,
+    PHASE_CACHE,
+    PHASE_CHANNEL_IDS,
+    PHASE_CONTENT_LICENSES,
+    PHASE_COOKIES,
+    PHASE_DOMAIN_RELIABILITY_MONITOR,
+    PHASE_FORM_DATA,
+    PHASE_HISTORY,
+    PHASE_HOSTNAME_RESOLUTION_CACHE,
+    PHASE_KEYWORD_DATA,
+    PHASE_LOGGED_IN_PREDICTOR,
+    PHASE_NACL_CACHE,
+    PHASE_NETWORK_PREDICTOR,
+    PHASE_NETWORKING_HISTORY,
+    PHASE_PLATFORM_KEYS,
+    PHASE_PLUGIN_DATA,
+    PHASE_PNACL_CACHE,
+    PHASE_STORAGE_PARTITION_DATA,
+    PHASE_WEBRTC_LOGS,
+    PHASE_COUNT
   };
 
   // Setter for |is_removing_|; DCHECKs that we can only start removing if we're
@@ -252,6 +282,28 @@ class BrowsingDataRemover
   friend class base::DeleteHelper<BrowsingDataRemover>;
   virtual ~BrowsingDataRemover();
 
+  // content::NotificationObserver implementation.
+  virtual void Observe(int type,
+                       const content::NotificationSource& source,
+                       const content::NotificationDetails& details) OVERRIDE;
+
+  // Starts waiting for a task of |phase|. The phase is timed from its first
+  // task.
+  void StartPhase(Phase phase);
+
+  // Stops waiting for a task of |phase|. Once all its tasks are done, records
+  // how long the phase took, notifies observers of the progress and invokes
+  // NotifyAndDeleteIfDone.
+  void FinishPhase(Phase phase);
+
+  // Returns true if a task of |phase| is still running.
+  bool IsWaitingFor(Phase phase) const;
+
+  // Cancels the phases that depend on the services of |profile_|, which is
+  // being destroyed. The phases running on other threads are still waited
+  // for, as their tasks refer to this object.
+  void CancelProfilePhases();
+
   // Callback for when TemplateURLService has finished loading. Clears the data,
   // clears the respective waiting flag, and invokes NotifyAndDeleteIfDone.
   void OnKeywordsLoaded();
@@ -312,15 +364,21 @@ class BrowsingDataRemover
   // Clears the respective waiting flag and invokes NotifyAndDeleteIfDone.
   void OnClearedNetworkingHistory();
 
-  // Callback for when the cache has been deleted. Invokes
+  // Callback for when one of the HTTP caches has been deleted. Invokes
   // NotifyAndDeleteIfDone.
   void ClearedCache();
 
-  // Invoked on the IO thread to delete from the cache.
-  void ClearCacheOnIOThread();
+  // Invoked on the IO thread to delete from the HTTP cache of |getter|. The
+  // main and the media caches are cleared in parallel.
+  void ClearCacheOnIOThread(
+      scoped_refptr<net::URLRequestContextGetter> getter);
+
+  // Invoked on the IO thread once the backend of a cache has been created, to
+  // delete its entries. Errors are ignored.
+  void DoomCacheEntriesOnIOThread(disk_cache::Backend** backend, int rv);
 
-  // Performs the actual work to delete the cache.
-  void DoClearCache(int rv);
+  // Invoked on the IO thread once the entries of a cache have been deleted.
+  void ClearedCacheOnIOThread(int rv);
 
 #if !defined(DISABLE_NACL)
   // Callback for when the NaCl cache has been deleted. Invokes
@@ -400,9 +458,6 @@ class BrowsingDataRemover
   // to artificially delay completion. Used for testing.
   static CompletionInhibitor* completion_inhibitor_;
 
-  CacheState next_cache_state_;
-  disk_cache::Backend* cache_;
-
   // Used to delete data from HTTP cache.
   scoped_refptr<net::URLRequestContextGetter> main_context_getter_;
   scoped_refptr<net::URLRequestContextGetter> media_context_getter_;
@@ -417,30 +472,23 @@ class BrowsingDataRemover
 #endif
 
   uint32 deauthorize_content_licenses_request_id_;
-  // True if we're waiting for various data to be deleted.
-  // These may only be accessed from UI thread in order to avoid races!
-  bool waiting_for_clear_autofill_origin_urls_;
-  bool waiting_for_clear_cache_;
-  bool waiting_for_clear_channel_ids_;
-  bool waiting_for_clear_content_licenses_;
-  // Non-zero if waiting for cookies to be cleared.
-  int waiting_for_clear_cookies_count_;
-  bool waiting_for_clear_domain_reliability_monitor_;
-  bool waiting_for_clear_form_;
-  bool waiting_for_clear_history_;
-  bool waiting_for_clear_hostname_resolution_cache_;
-  bool waiting_for_clear_keyword_data_;
-  bool waiting_for_clear_logged_in_predictor_;
-  bool waiting_for_clear_nacl_cache_;
-  bool waiting_for_clear_network_predictor_;
-  bool waiting_for_clear_networking_history_;
-  bool waiting_for_clear_platform_keys_;
-  bool waiting_for_clear_plugin_data_;
-  bool waiting_for_clear_pnacl_cache_;
-  bool waiting_for_clear_storage_partition_data_;
-#if defined(ENABLE_WEBRTC)
-  bool waiting_for_clear_webrtc_logs_;
-#endif
+  // The number of tasks of each phase we're waiting for, and when the first
+  // of them was started. These may only be accessed from UI thread in order
+  // to avoid races!
+  int pending_tasks_[PHASE_COUNT];
+  base::TimeTicks phase_start_time_[PHASE_COUNT];
+
+  // The number of phases that were started and that have finished, for
+  // progress notifications.
+  int phases_started_;
+  int phases_done_;
+
+  // When the removal was started.
+  base::TimeTicks remove_start_time_;
+
+  // Set when |profile_| is being destroyed. Its services must not be used
+  // anymore.
+  bool profile_destroyed_;
 
   // The removal mask for the current removal operation.
   int remove_mask_;
@@ -461,6 +509,12 @@ class BrowsingDataRemover
   // We do not own this.
   content::StoragePartition* storage_partition_for_testing_;
 
+  content::NotificationRegistrar registrar_;
+
+  // Used for the callbacks of the profile's services, which may never be
+  // run once the profile is destroyed.
+  base::WeakPtrFactory<BrowsingDataRemover> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(BrowsingDataRemover);
 };
 
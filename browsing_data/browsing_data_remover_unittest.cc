@@ -706,6 +706,43 @@ class ClearDomainReliabilityTester {
   MockDomainReliabilityService* mock_service_;
 };
 
+// Records the progress reported by a BrowsingDataRemover.
+class RemoveProgressTester : public BrowsingDataRemover::Observer {
+ public:
+  explicit RemoveProgressTester(BrowsingDataRemover* remover)
+      : progress_count_(0),
+        phases_done_(0),
+        phases_total_(0) {
+    remover->AddObserver(this);
+  }
+
+  virtual ~RemoveProgressTester() {}
+
+  int progress_count() const { return progress_count_; }
+  int phases_done() const { return phases_done_; }
+  int phases_total() const { return phases_total_; }
+
+  // BrowsingDataRemover::Observer:
+  virtual void OnBrowsingDataRemoverDone() OVERRIDE {}
+
+  virtual void OnBrowsingDataRemoverProgress(int phases_done,
+                                             int phases_total) OVERRIDE {
+    // Phases finish one at a time.
+    EXPECT_EQ(phases_done_ + 1, phases_done);
+    EXPECT_LE(phases_done, phases_total);
+    ++progress_count_;
+    phases_done_ = phases_done;
+    phases_total_ = phases_total;
+  }
+
+ private:
+  int progress_count_;
+  int phases_done_;
+  int phases_total_;
+
+  DISALLOW_COPY_AND_ASSIGN(RemoveProgressTester);
+};
+
 // Test Class ----------------------------------------------------------------
 
 class BrowsingDataRemoverTest : public testing::Test,
@@ -1740,6 +1777,54 @@ TEST_F(BrowsingDataRemoverTest, CompletionInhibition) {
   EXPECT_EQ(BrowsingDataHelper::UNPROTECTED_WEB, GetOriginSetMask());
 }
 
+TEST_F(BrowsingDataRemoverTest, ReportsProgress) {
+  called_with_details_.reset(new BrowsingDataRemover::NotificationDetails());
+
+  // BrowsingDataRemover deletes itself when it completes.
+  BrowsingDataRemover* remover = BrowsingDataRemover::CreateForPeriod(
+      GetProfile(), BrowsingDataRemover::EVERYTHING);
+  TestStoragePartition storage_partition;
+  remover->OverrideStoragePartitionForTesting(&storage_partition);
+
+  RemoveProgressTester progress_tester(remover);
+  BrowsingDataRemoverCompletionObserver completion_observer(remover);
+  remover->Remove(BrowsingDataRemover::REMOVE_HISTORY |
+                      BrowsingDataRemover::REMOVE_COOKIES,
+                  BrowsingDataHelper::UNPROTECTED_WEB);
+  completion_observer.BlockUntilCompletion();
+
+  // At least the history, the storage partition and the networking history
+  // phases were run, and all of them finished.
+  EXPECT_LE(3, progress_tester.progress_count());
+  EXPECT_EQ(progress_tester.progress_count(), progress_tester.phases_done());
+  EXPECT_EQ(progress_tester.phases_total(), progress_tester.phases_done());
+  EXPECT_EQ(BrowsingDataRemover::REMOVE_HISTORY |
+                BrowsingDataRemover::REMOVE_COOKIES,
+            GetRemovalMask());
+}
+
+TEST_F(BrowsingDataRemoverTest, CancelledOnProfileDestruction) {
+  called_with_details_.reset(new BrowsingDataRemover::NotificationDetails());
+
+  // BrowsingDataRemover deletes itself when it completes.
+  BrowsingDataRemover* remover = BrowsingDataRemover::CreateForPeriod(
+      GetProfile(), BrowsingDataRemover::EVERYTHING);
+  BrowsingDataRemoverCompletionObserver completion_observer(remover);
+  remover->Remove(BrowsingDataRemover::REMOVE_HISTORY,
+                  BrowsingDataHelper::UNPROTECTED_WEB);
+
+  // The history deletion is cancelled, and the removal still completes.
+  content::NotificationService::current()->Notify(
+      chrome::NOTIFICATION_PROFILE_DESTROYED,
+      content::Source<Profile>(GetProfile()),
+      content::NotificationService::NoDetails());
+  completion_observer.BlockUntilCompletion();
+
+  // No notification is sent for a profile that is going away.
+  EXPECT_EQ(-1, GetRemovalMask());
+  EXPECT_EQ(-1, GetOriginSetMask());
+}
+
 TEST_F(BrowsingDataRemoverTest, ZeroSuggestCacheClear) {
   PrefService* prefs = GetProfile()->GetPrefs();
   prefs->SetString(prefs::kZeroSuggestCachedResults,
@@ -0,0 +1,149 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/content_settings/content_settings_rule_index.h"
+
+#include "base/logging.h"
+#include "chrome/common/content_settings_pattern.h"
+#include "url/gurl.h"
+
+namespace content_settings {
+
+namespace {
+
+const char kDomainWildcard[] = "[*.]";
+const char kSchemeSeparator[] = "://";
+
+// Strips trailing dots so that "example.com." and "example.com" share a
+// bucket. The patterns themselves decide whether such hosts really match.
+std::string NormalizeHost(const std::string& host) {
+  std::string result(host);
+  while (!result.empty() && result[result.size() - 1] == '.')
+    result.erase(result.size() - 1);
+  return result;
+}
+
+}  // namespace
+
+RuleIndex::Entry::Entry(const Rule& rule, const std::string& scheme, int tag)
+    : rule(rule),
+      scheme(scheme),
+      tag(tag) {
+}
+
+RuleIndex::Entry::~Entry() {}
+
+RuleIndex::RuleIndex() {}
+
+RuleIndex::~RuleIndex() {}
+
+void RuleIndex::AddRules(RuleIterator* rule_iterator, int tag) {
+  while (rule_iterator->HasNext()) {
+    Rule rule = rule_iterator->Next();
+    std::string scheme;
+    std::string host = GetHostKey(rule.primary_pattern, &scheme);
+    size_t index = entries_.size();
+    entries_.push_back(Entry(rule, scheme, tag));
+    if (host.empty())
+      wildcard_entries_.push_back(index);
+    else
+      host_entries_[host].push_back(index);
+  }
+}
+
+const Rule* RuleIndex::GetMatchingRule(const GURL& primary_url,
+                                       const GURL& secondary_url,
+                                       int* tag) const {
+  // Collect the buckets of every suffix of the host that starts at a label
+  // boundary, e.g. "a.example.com", "example.com" and "com".
+  std::vector<const EntryList*> lists;
+  if (!wildcard_entries_.empty())
+    lists.push_back(&wildcard_entries_);
+  std::string host = NormalizeHost(primary_url.host());
+  size_t start = 0;
+  while (start < host.size()) {
+    HostMap::const_iterator it = host_entries_.find(host.substr(start));
+    if (it != host_entries_.end())
+      lists.push_back(&it->second);
+    size_t dot = host.find('.', start);
+    if (dot == std::string::npos)
+      break;
+    start = dot + 1;
+  }
+
+  // Every list is sorted by precedence, so merge them and stop at the first
+  // matching rule.
+  std::vector<size_t> positions(lists.size(), 0);
+  while (true) {
+    size_t best_list = lists.size();
+    size_t best_index = entries_.size();
+    for (size_t i = 0; i < lists.size(); ++i) {
+      if (positions[i] < lists[i]->size() &&
+          (*lists[i])[positions[i]] < best_index) {
+        best_list = i;
+        best_index = (*lists[i])[positions[i]];
+      }
+    }
+    if (best_list == lists.size())
+      return NULL;
+    ++positions[best_list];
+
+    const Entry& entry = entries_[best_index];
+    if (EntryMatches(entry, primary_url, secondary_url)) {
+      if (tag)
+        *tag = entry.tag;
+      return &entry.rule;
+    }
+  }
+}
+
+// static
+std::string RuleIndex::GetHostKey(const ContentSettingsPattern& pattern,
+                                  std::string* scheme) {
+  if (scheme)
+    scheme->clear();
+  if (!pattern.IsValid() || pattern.MatchesAllHosts())
+    return std::string();
+
+  std::string spec = pattern.ToString();
+  size_t host_start = 0;
+  size_t separator = spec.find(kSchemeSeparator);
+  if (separator != std::string::npos) {
+    if (scheme && spec.compare(0, separator, "*") != 0)
+      *scheme = spec.substr(0, separator);
+    host_start = separator + arraysize(kSchemeSeparator) - 1;
+  }
+  if (spec.compare(host_start, arraysize(kDomainWildcard) - 1,
+                   kDomainWildcard) == 0) {
+    host_start += arraysize(kDomainWildcard) - 1;
+  }
+
+  size_t host_end;
+  if (host_start < spec.size() && spec[host_start] == '[') {
+    // IPv6 literal; keep the brackets, like GURL::host() does.
+    host_end = spec.find(']', host_start);
+    if (host_end != std::string::npos)
+      ++host_end;
+  } else {
+    host_end = spec.find_first_of(":/", host_start);
+  }
+  std::string host = NormalizeHost(spec.substr(
+      host_start,
+      host_end == std::string::npos ? std::string::npos
+                                    : host_end - host_start));
+  if (host == "*")
+    return std::string();
+  return host;
+}
+
+bool RuleIndex::EntryMatches(const Entry& entry,
+                             const GURL& primary_url,
+                             const GURL& secondary_url) const {
+  if (!entry.scheme.empty() && !primary_url.SchemeIs(entry.scheme.c_str()))
+    return false;
+  return entry.rule.primary_pattern.Matches(primary_url) &&
+         entry.rule.secondary_pattern.Matches(secondary_url);
+}
+
+}  // namespace content_settings
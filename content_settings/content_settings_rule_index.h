@@ -0,0 +1,87 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_CONTENT_SETTINGS_CONTENT_SETTINGS_RULE_INDEX_H_
+#define CHROME_BROWSER_CONTENT_SETTINGS_CONTENT_SETTINGS_RULE_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/memory/ref_counted.h"
+#include "chrome/browser/content_settings/content_settings_rule.h"
+
+class ContentSettingsPattern;
+class GURL;
+
+namespace content_settings {
+
+// An immutable snapshot of the rules of one content type and resource
+// identifier, bucketed by the host of their primary pattern so that a lookup
+// only has to test the rules whose host is a suffix of the URL's host, plus the
+// rules that match any host. The index is filled on one thread and can then be
+// shared and queried from any thread without holding the providers' locks.
+class RuleIndex : public base::RefCountedThreadSafe<RuleIndex> {
+ public:
+  RuleIndex();
+
+  // Appends all rules returned by |rule_iterator| and tags them with |tag|.
+  // Rules that are added first take precedence over rules added later. Must
+  // not be called once the index is shared with other threads.
+  void AddRules(RuleIterator* rule_iterator, int tag);
+
+  // Returns the rule with the highest precedence that matches |primary_url|
+  // and |secondary_url|, or NULL if no rule matches. If |tag| is not NULL, it
+  // is set to the tag the rule was added with. The returned rule is owned by
+  // the index.
+  const Rule* GetMatchingRule(const GURL& primary_url,
+                              const GURL& secondary_url,
+                              int* tag) const;
+
+  size_t size() const { return entries_.size(); }
+
+  // Returns the host a URL must be equal to, or a subdomain of, for
+  // |pattern| to match it. Returns an empty string if the pattern is not
+  // restricted to one host. If |scheme| is not NULL, it is set to the scheme
+  // the pattern is restricted to, or to an empty string for any scheme.
+  static std::string GetHostKey(const ContentSettingsPattern& pattern,
+                                std::string* scheme);
+
+ private:
+  friend class base::RefCountedThreadSafe<RuleIndex>;
+
+  struct Entry {
+    Entry(const Rule& rule, const std::string& scheme, int tag);
+    ~Entry();
+
+    Rule rule;
+    std::string scheme;
+    int tag;
+  };
+
+  // Indices into |entries_|, in ascending order.
+  typedef std::vector<size_t> EntryList;
+  typedef base::hash_map<std::string, EntryList> HostMap;
+
+  ~RuleIndex();
+
+  bool EntryMatches(const Entry& entry,
+                    const GURL& primary_url,
+                    const GURL& secondary_url) const;
+
+  std::vector<Entry> entries_;
+
+  // Rules keyed by the host of their primary pattern.
+  HostMap host_entries_;
+
+  // Rules whose primary pattern is not restricted to a single host.
+  EntryList wildcard_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(RuleIndex);
+};
+
+}  // namespace content_settings
+
+#endif  // CHROME_BROWSER_CONTENT_SETTINGS_CONTENT_SETTINGS_RULE_INDEX_H_
@@ -0,0 +1,91 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/content_settings/content_settings_rule_index.h"
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/content_settings/content_settings_origin_identifier_value_map.h"
+#include "chrome/browser/content_settings/content_settings_utils.h"
+#include "chrome/common/content_settings_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace content_settings {
+
+namespace {
+
+const int kNumRules = 10000;
+const int kNumLookups = 1000;
+
+// Compares a linear scan over many exceptions with a lookup in the index.
+TEST(RuleIndexPerfTest, ManyRules) {
+  OriginIdentifierValueMap map;
+  for (int i = 0; i < kNumRules; ++i) {
+    map.SetValue(ContentSettingsPattern::FromString(base::StringPrintf(
+                     "[*.]host%d.example%d.com", i, i % 100)),
+                 ContentSettingsPattern::Wildcard(),
+                 CONTENT_SETTINGS_TYPE_COOKIES,
+                 std::string(),
+                 new base::FundamentalValue(i % 3));
+  }
+  map.SetValue(ContentSettingsPattern::Wildcard(),
+               ContentSettingsPattern::Wildcard(),
+               CONTENT_SETTINGS_TYPE_COOKIES,
+               std::string(),
+               new base::FundamentalValue(3));
+
+  std::vector<GURL> urls;
+  for (int i = 0; i < kNumLookups; ++i) {
+    // Every other URL misses all exceptions and hits the wildcard rule.
+    int host = (i * 7919) % kNumRules;
+    urls.push_back(GURL(base::StringPrintf(
+        "http://www.host%d.example%d.com/", host,
+        i % 2 ? host % 100 : (host + 1) % 100)));
+  }
+  GURL secondary_url("http://www.google.com/");
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (size_t i = 0; i < urls.size(); ++i) {
+    scoped_ptr<RuleIterator> rule_iterator(map.GetRuleIterator(
+        CONTENT_SETTINGS_TYPE_COOKIES, std::string(), NULL));
+    scoped_ptr<base::Value> value(GetContentSettingValueAndPatterns(
+        rule_iterator.get(), urls[i], secondary_url, NULL, NULL));
+    ASSERT_TRUE(value.get());
+  }
+  base::TimeDelta linear_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  scoped_refptr<RuleIndex> index(new RuleIndex);
+  scoped_ptr<RuleIterator> rule_iterator(map.GetRuleIterator(
+      CONTENT_SETTINGS_TYPE_COOKIES, std::string(), NULL));
+  index->AddRules(rule_iterator.get(), 0);
+  rule_iterator.reset();
+  base::TimeDelta build_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  for (size_t i = 0; i < urls.size(); ++i)
+    ASSERT_TRUE(index->GetMatchingRule(urls[i], secondary_url, NULL));
+  base::TimeDelta index_time = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("content_settings_lookup", "", "linear",
+                         linear_time.InMicroseconds() /
+                             static_cast<double>(kNumLookups),
+                         "us", true);
+  perf_test::PrintResult("content_settings_lookup", "", "indexed",
+                         index_time.InMicroseconds() /
+                             static_cast<double>(kNumLookups),
+                         "us", true);
+  perf_test::PrintResult("content_settings_index_build", "", "build",
+                         build_time.InMillisecondsF(), "ms", false);
+}
+
+}  // namespace
+
+}  // namespace content_settings
@@ -0,0 +1,156 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/content_settings/content_settings_rule_index.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "chrome/browser/content_settings/content_settings_origin_identifier_value_map.h"
+#include "chrome/browser/content_settings/content_settings_utils.h"
+#include "chrome/common/content_settings_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace content_settings {
+
+namespace {
+
+void SetValue(OriginIdentifierValueMap* map,
+              const std::string& primary_pattern,
+              const std::string& secondary_pattern,
+              int value) {
+  map->SetValue(ContentSettingsPattern::FromString(primary_pattern),
+                ContentSettingsPattern::FromString(secondary_pattern),
+                CONTENT_SETTINGS_TYPE_COOKIES,
+                std::string(),
+                new base::FundamentalValue(value));
+}
+
+void AddRules(RuleIndex* index, const OriginIdentifierValueMap& map, int tag) {
+  scoped_ptr<RuleIterator> rule_iterator(map.GetRuleIterator(
+      CONTENT_SETTINGS_TYPE_COOKIES, std::string(), NULL));
+  index->AddRules(rule_iterator.get(), tag);
+}
+
+// Returns the value of the rule matching the URLs, or -1 if none matches.
+int GetValue(const RuleIndex* index,
+             const std::string& primary_url,
+             const std::string& secondary_url,
+             int* tag) {
+  const Rule* rule =
+      index->GetMatchingRule(GURL(primary_url), GURL(secondary_url), tag);
+  int value = -1;
+  if (rule)
+    EXPECT_TRUE(rule->value->GetAsInteger(&value));
+  return value;
+}
+
+}  // namespace
+
+TEST(RuleIndexTest, GetHostKey) {
+  std::string scheme;
+  EXPECT_EQ("example.com", RuleIndex::GetHostKey(
+      ContentSettingsPattern::FromString("[*.]example.com"), &scheme));
+  EXPECT_EQ("", scheme);
+  EXPECT_EQ("www.example.com", RuleIndex::GetHostKey(
+      ContentSettingsPattern::FromString("https://www.example.com:443"),
+      &scheme));
+  EXPECT_EQ("https", scheme);
+  EXPECT_EQ("127.0.0.1", RuleIndex::GetHostKey(
+      ContentSettingsPattern::FromString("127.0.0.1:8080"), &scheme));
+
+  EXPECT_EQ("", RuleIndex::GetHostKey(ContentSettingsPattern::Wildcard(),
+                                      &scheme));
+  EXPECT_EQ("", scheme);
+  EXPECT_EQ("", RuleIndex::GetHostKey(
+      ContentSettingsPattern::FromString("file:///foo/bar.html"), &scheme));
+}
+
+TEST(RuleIndexTest, Precedence) {
+  OriginIdentifierValueMap policy_map;
+  SetValue(&policy_map, "[*.]example.com", "*", 1);
+
+  OriginIdentifierValueMap pref_map;
+  SetValue(&pref_map, "http://www.example.com", "*", 2);
+  SetValue(&pref_map, "[*.]google.com", "[*.]example.com", 3);
+  SetValue(&pref_map, "*", "*", 4);
+
+  scoped_refptr<RuleIndex> index(new RuleIndex);
+  AddRules(index.get(), policy_map, 0);
+  AddRules(index.get(), pref_map, 1);
+  EXPECT_EQ(4u, index->size());
+
+  int tag = -1;
+  // Rules added first win, even if a later rule is more specific.
+  EXPECT_EQ(1, GetValue(index.get(), "http://www.example.com/",
+                        "http://foo.com/", &tag));
+  EXPECT_EQ(0, tag);
+
+  EXPECT_EQ(3, GetValue(index.get(), "http://mail.google.com/",
+                        "http://www.example.com/", &tag));
+  EXPECT_EQ(1, tag);
+  // Falls through to the wildcard rule if the secondary URL doesn't match.
+  EXPECT_EQ(4, GetValue(index.get(), "http://mail.google.com/",
+                        "http://foo.com/", &tag));
+  // Suffixes only match at label boundaries.
+  EXPECT_EQ(4, GetValue(index.get(), "http://notexample.com/",
+                        "http://foo.com/", &tag));
+
+  scoped_refptr<RuleIndex> empty_index(new RuleIndex);
+  EXPECT_EQ(-1, GetValue(empty_index.get(), "http://www.example.com/",
+                         "http://foo.com/", NULL));
+}
+
+TEST(RuleIndexTest, SchemeFilter) {
+  OriginIdentifierValueMap map;
+  SetValue(&map, "https://[*.]example.com", "*", 1);
+
+  scoped_refptr<RuleIndex> index(new RuleIndex);
+  AddRules(index.get(), map, 0);
+  EXPECT_EQ(1, GetValue(index.get(), "https://www.example.com/",
+                        "http://foo.com/", NULL));
+  EXPECT_EQ(-1, GetValue(index.get(), "http://www.example.com/",
+                         "http://foo.com/", NULL));
+}
+
+// Checks that the index returns the same rules as a linear scan over many
+// exceptions.
+TEST(RuleIndexTest, ManyRules) {
+  const int kNumRules = 1000;
+  const int kNumLookups = 200;
+
+  OriginIdentifierValueMap map;
+  for (int i = 0; i < kNumRules; ++i) {
+    SetValue(&map,
+             base::StringPrintf("[*.]host%d.example%d.com", i, i % 100),
+             "*",
+             i % 3);
+  }
+  SetValue(&map, "*", "*", 3);
+
+  scoped_refptr<RuleIndex> index(new RuleIndex);
+  AddRules(index.get(), map, 0);
+  EXPECT_EQ(static_cast<size_t>(kNumRules + 1), index->size());
+
+  GURL secondary_url("http://www.google.com/");
+  for (int i = 0; i < kNumLookups; ++i) {
+    // Every other URL misses all exceptions and hits the wildcard rule.
+    int host = (i * 7919) % kNumRules;
+    GURL url(base::StringPrintf("http://www.host%d.example%d.com/", host,
+                                i % 2 ? host % 100 : (host + 1) % 100));
+    scoped_ptr<RuleIterator> rule_iterator(map.GetRuleIterator(
+        CONTENT_SETTINGS_TYPE_COOKIES, std::string(), NULL));
+    scoped_ptr<base::Value> value(GetContentSettingValueAndPatterns(
+        rule_iterator.get(), url, secondary_url, NULL, NULL));
+    int linear_value = -1;
+    ASSERT_TRUE(value.get());
+    EXPECT_TRUE(value->GetAsInteger(&linear_value));
+    EXPECT_EQ(linear_value,
+              GetValue(index.get(), url.spec(), secondary_url.spec(), NULL))
+        << url;
+  }
+}
+
+}  // namespace content_settings
@@ -23,6 +23,7 @@
 #include "chrome/browser/content_settings/content_settings_pref_provider.h"
 #include "chrome/browser/content_settings/content_settings_provider.h"
 #include "chrome/browser/content_settings/content_settings_rule.h"
+#include "chrome/browser/content_settings/content_settings_rule_index.h"
 #include "chrome/browser/content_settings/content_settings_utils.h"
 #include "chrome/browser/extensions/api/content_settings/content_settings_service.h"
 #include "chrome/browser/extensions/extension_service.h"
@@ -79,6 +80,34 @@ bool SupportsResourceIdentifier(ContentSettingsType content_type) {
 
 }  // namespace
 
+class HostContentSettingsMap::ProviderObserver
+    : public content_settings::Observer {
+ public:
+  ProviderObserver(HostContentSettingsMap* map, ProviderType provider_type)
+      : map_(map),
+        provider_type_(provider_type) {
+  }
+
+  virtual void OnContentSettingChanged(
+      const ContentSettingsPattern& primary_pattern,
+      const ContentSettingsPattern& secondary_pattern,
+      ContentSettingsType content_type,
+      std::string resource_identifier) OVERRIDE {
+    map_->OnProviderContentSettingChanged(provider_type_,
+                                          primary_pattern,
+                                          secondary_pattern,
+                                          content_type,
+                                          resource_identifier);
+  }
+
+ private:
+  // Weak; owns this observer.
+  HostContentSettingsMap* map_;
+  ProviderType provider_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProviderObserver);
+};
+
 HostContentSettingsMap::HostContentSettingsMap(
     PrefService* prefs,
     bool incognito) :
@@ -87,19 +116,22 @@ HostContentSettingsMap::HostContentSettingsMap(
 #endif
       prefs_(prefs),
       is_off_the_record_(incognito) {
+  for (int i = 0; i < NUM_PROVIDER_TYPES; ++i)
+    rule_index_generations_[i] = 0;
+
   content_settings::ObservableProvider* policy_provider =
       new content_settings::PolicyProvider(prefs_);
-  policy_provider->AddObserver(this);
+  ObserveProvider(policy_provider, POLICY_PROVIDER);
   content_settings_providers_[POLICY_PROVIDER] = policy_provider;
 
   content_settings::ObservableProvider* pref_provider =
       new content_settings::PrefProvider(prefs_, is_off_the_record_);
-  pref_provider->AddObserver(this);
+  ObserveProvider(pref_provider, PREF_PROVIDER);
   content_settings_providers_[PREF_PROVIDER] = pref_provider;
 
   content_settings::ObservableProvider* default_provider =
       new content_settings::DefaultProvider(prefs_, is_off_the_record_);
-  default_provider->AddObserver(this);
+  ObserveProvider(default_provider, DEFAULT_PROVIDER);
   content_settings_providers_[DEFAULT_PROVIDER] = default_provider;
 
   if (!is_off_the_record_) {
@@ -117,7 +149,7 @@ void HostContentSettingsMap::RegisterExtensionService(
 
   content_settings::InternalExtensionProvider* internal_extension_provider =
       new content_settings::InternalExtensionProvider(extension_service);
-  internal_extension_provider->AddObserver(this);
+  ObserveProvider(internal_extension_provider, INTERNAL_EXTENSION_PROVIDER);
   content_settings_providers_[INTERNAL_EXTENSION_PROVIDER] =
       internal_extension_provider;
 
@@ -126,7 +158,7 @@ void HostContentSettingsMap::RegisterExtensionService(
           extensions::ContentSettingsService::Get(
               extension_service->GetBrowserContext())->content_settings_store(),
           is_off_the_record_);
-  custom_extension_provider->AddObserver(this);
+  ObserveProvider(custom_extension_provider, CUSTOM_EXTENSION_PROVIDER);
   content_settings_providers_[CUSTOM_EXTENSION_PROVIDER] =
       custom_extension_provider;
 
@@ -534,6 +566,31 @@ void HostContentSettingsMap::OnContentSettingChanged(
     const ContentSettingsPattern& secondary_pattern,
     ContentSettingsType content_type,
     std::string resource_identifier) {
+  for (int i = 0; i < NUM_PROVIDER_TYPES; ++i)
+    InvalidateRuleIndices(static_cast<ProviderType>(i), content_type);
+  FOR_EACH_OBSERVER(content_settings::Observer,
+                    observers_,
+                    OnContentSettingChanged(primary_pattern,
+                                            secondary_pattern,
+                                            content_type,
+                                            resource_identifier));
+}
+
+void HostContentSettingsMap::ObserveProvider(
+    content_settings::ObservableProvider* provider,
+    ProviderType provider_type) {
+  ProviderObserver* observer = new ProviderObserver(this, provider_type);
+  provider_observers_.push_back(observer);
+  provider->AddObserver(observer);
+}
+
+void HostContentSettingsMap::OnProviderContentSettingChanged(
+    ProviderType provider_type,
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    ContentSettingsType content_type,
+    std::string resource_identifier) {
+  InvalidateRuleIndices(provider_type, content_type);
   FOR_EACH_OBSERVER(content_settings::Observer,
                     observers_,
                     OnContentSettingChanged(primary_pattern,
@@ -705,26 +762,23 @@ base::Value* HostContentSettingsMap::GetWebsiteSetting(
     return new base::FundamentalValue(CONTENT_SETTING_ALLOW);
   }
 
-  ContentSettingsPattern* primary_pattern = NULL;
-  ContentSettingsPattern* secondary_pattern = NULL;
-  if (info) {
-    primary_pattern = &info->primary_pattern;
-    secondary_pattern = &info->secondary_pattern;
-  }
+  scoped_refptr<content_settings::RuleIndex> rule_indices[NUM_PROVIDER_TYPES];
+  GetRuleIndices(content_type, resource_identifier, rule_indices);
 
-  // The list of |content_settings_providers_| is ordered according to their
-  // precedence.
+  // Iterate through the providers in precedence order.
   for (ConstProviderIterator provider = content_settings_providers_.begin();
        provider != content_settings_providers_.end();
        ++provider) {
-    base::Value* value = content_settings::GetContentSettingValueAndPatterns(
-        provider->second, primary_url, secondary_url, content_type,
-        resource_identifier, is_off_the_record_,
-        primary_pattern, secondary_pattern);
-    if (value) {
-      if (info)
+    const content_settings::Rule* rule =
+        rule_indices[provider->first]->GetMatchingRule(
+            primary_url, secondary_url, NULL);
+    if (rule) {
+      if (info) {
         info->source = kProviderSourceMap[provider->first];
-      return value;
+        info->primary_pattern = rule->primary_pattern;
+        info->secondary_pattern = rule->secondary_pattern;
+      }
+      return rule->value->DeepCopy();
     }
   }
 
@@ -736,6 +790,68 @@ base::Value* HostContentSettingsMap::GetWebsiteSetting(
   return NULL;
 }
 
+void HostContentSettingsMap::GetRuleIndices(
+    ContentSettingsType content_type,
+    const std::string& resource_identifier,
+    scoped_refptr<content_settings::RuleIndex>* rule_indices) const {
+  RuleIndexKey key(content_type, resource_identifier);
+  int64 generations[NUM_PROVIDER_TYPES];
+  {
+    base::AutoLock auto_lock(rule_index_lock_);
+    for (int i = 0; i < NUM_PROVIDER_TYPES; ++i) {
+      RuleIndexMap::const_iterator it = rule_indices_[i].find(key);
+      if (it != rule_indices_[i].end())
+        rule_indices[i] = it->second;
+      generations[i] = rule_index_generations_[i];
+    }
+  }
+
+  for (ConstProviderIterator provider = content_settings_providers_.begin();
+       provider != content_settings_providers_.end();
+       ++provider) {
+    ProviderType provider_type = provider->first;
+    if (rule_indices[provider_type].get())
+      continue;
+
+    // Incognito-specific rules take precedence over the normal rules of the
+    // same provider. Each |RuleIterator| holds the provider's lock, so it has
+    // to go out of scope before the next one is created.
+    scoped_refptr<content_settings::RuleIndex> rule_index(
+        new content_settings::RuleIndex);
+    if (is_off_the_record_) {
+      scoped_ptr<content_settings::RuleIterator> incognito_rule_iterator(
+          provider->second->GetRuleIterator(
+              content_type, resource_identifier, true));
+      rule_index->AddRules(incognito_rule_iterator.get(), provider_type);
+    }
+    scoped_ptr<content_settings::RuleIterator> rule_iterator(
+        provider->second->GetRuleIterator(
+            content_type, resource_identifier, false));
+    rule_index->AddRules(rule_iterator.get(), provider_type);
+    rule_indices[provider_type] = rule_index;
+
+    base::AutoLock auto_lock(rule_index_lock_);
+    if (generations[provider_type] == rule_index_generations_[provider_type])
+      rule_indices_[provider_type][key] = rule_index;
+  }
+}
+
+void HostContentSettingsMap::InvalidateRuleIndices(
+    ProviderType provider_type,
+    ContentSettingsType content_type) {
+  base::AutoLock auto_lock(rule_index_lock_);
+  ++rule_index_generations_[provider_type];
+  RuleIndexMap& rule_indices = rule_indices_[provider_type];
+  if (content_type == CONTENT_SETTINGS_TYPE_DEFAULT) {
+    rule_indices.clear();
+    return;
+  }
+  RuleIndexMap::iterator it =
+      rule_indices.lower_bound(RuleIndexKey(content_type, std::string()));
+  while (it != rule_indices.end() && it->first.first == content_type)
+    rule_indices.erase(it++);
+}
+
 // static
 HostContentSettingsMap::ProviderType
     HostContentSettingsMap::GetProviderTypeFromSource(
@@ -10,12 +10,15 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
 #include "base/observer_list.h"
 #include "base/prefs/pref_change_registrar.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
 #include "base/tuple.h"
 #include "chrome/browser/content_settings/content_settings_observer.h"
@@ -33,8 +36,10 @@ class Value;
 }
 
 namespace content_settings {
+class ObservableProvider;
 class ProviderInterface;
 class PrefProvider;
+class RuleIndex;
 }
 
 namespace user_prefs {
@@ -264,8 +269,43 @@ class HostContentSettingsMap
   typedef ProviderMap::iterator ProviderIterator;
   typedef ProviderMap::const_iterator ConstProviderIterator;
 
+  typedef std::pair<ContentSettingsType, std::string> RuleIndexKey;
+  typedef std::map<RuleIndexKey, scoped_refptr<content_settings::RuleIndex> >
+      RuleIndexMap;
+
+  // Forwards the changes reported by one provider, so that only the rule
+  // indices of that provider are dropped.
+  class ProviderObserver;
+
   virtual ~HostContentSettingsMap();
 
+  // Registers an observer for the provider of |provider_type|.
+  void ObserveProvider(content_settings::ObservableProvider* provider,
+                       ProviderType provider_type);
+
+  // Called by the ProviderObserver of |provider_type|.
+  void OnProviderContentSettingChanged(
+      ProviderType provider_type,
+      const ContentSettingsPattern& primary_pattern,
+      const ContentSettingsPattern& secondary_pattern,
+      ContentSettingsType content_type,
+      std::string resource_identifier);
+
+  // Sets |rule_indices[provider_type]| to the rules of each provider for
+  // |content_type| and |resource_identifier|, compiled into an index. An index
+  // is cached until its provider reports a change to |content_type|.
+  //
+  // This may be called on any thread.
+  void GetRuleIndices(
+      ContentSettingsType content_type,
+      const std::string& resource_identifier,
+      scoped_refptr<content_settings::RuleIndex>* rule_indices) const;
+
+  // Drops the cached rule indices of |provider_type| for |content_type|, or
+  // for all types if |content_type| is CONTENT_SETTINGS_TYPE_DEFAULT.
+  void InvalidateRuleIndices(ProviderType provider_type,
+                             ContentSettingsType content_type);
+
   ContentSetting GetDefaultContentSettingFromProvider(
       ContentSettingsType content_type,
       content_settings::ProviderInterface* provider) const;
@@ -317,6 +357,19 @@ class HostContentSettingsMap
 
   ObserverList<content_settings::Observer> observers_;
 
+  ScopedVector<ProviderObserver> provider_observers_;
+
+  // Guards |rule_indices_| and |rule_index_generations_|. The indices
+  // themselves are immutable, so lookups only hold the lock while taking
+  // references.
+  mutable base::Lock rule_index_lock_;
+  mutable RuleIndexMap rule_indices_[NUM_PROVIDER_TYPES];
+
+  // Incremented on every invalidation of a provider's indices, so that an
+  // index built from rules that changed while it was being built is not
+  // cached.
+  int64 rule_index_generations_[NUM_PROVIDER_TYPES];
+
   DISALLOW_COPY_AND_ASSIGN(HostContentSettingsMap);
 };
 
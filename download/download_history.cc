@@ -145,6 +145,10 @@ history::DownloadRow GetDownloadRow(
       by_ext_name);
 }
 
+// How long updates that only report progress may wait to be written together
+// with the updates of other downloads.
+const int kUpdateBatchIntervalMs = 2000;
+
 bool ShouldUpdateHistory(const history::DownloadRow* previous,
                          const history::DownloadRow& current) {
   // Ignore url, referrer, mime_type, original_mime_type, start_time,
@@ -165,6 +169,21 @@ bool ShouldUpdateHistory(const history::DownloadRow* previous,
           (previous->by_ext_name != current.by_ext_name));
 }
 
+// Returns true if |current| only differs from |previous| in the fields that
+// change as a download makes progress.
+bool IsProgressUpdate(const history::DownloadRow* previous,
+                      const history::DownloadRow& current) {
+  if (!previous)
+    return false;
+  history::DownloadRow progressed(*previous);
+  progressed.end_time = current.end_time;
+  progressed.received_bytes = current.received_bytes;
+  progressed.total_bytes = current.total_bytes;
+  progressed.etag = current.etag;
+  progressed.last_modified = current.last_modified;
+  return !ShouldUpdateHistory(&progressed, current);
+}
+
 typedef std::vector<history::DownloadRow> InfoVector;
 
 }  // anonymous namespace
@@ -185,9 +204,9 @@ void DownloadHistory::HistoryAdapter::CreateDownload(
   history_->CreateDownload(info, callback);
 }
 
-void DownloadHistory::HistoryAdapter::UpdateDownload(
-    const history::DownloadRow& data) {
-  history_->UpdateDownload(data);
+void DownloadHistory::HistoryAdapter::UpdateDownloads(
+    const std::vector<history::DownloadRow>& data) {
+  history_->UpdateDownloads(data);
 }
 
 void DownloadHistory::HistoryAdapter::RemoveDownloads(
@@ -210,6 +229,8 @@ DownloadHistory::DownloadHistory(content::DownloadManager* manager,
     history_(history.Pass()),
     loading_id_(content::DownloadItem::kInvalidId),
     history_size_(0),
+    update_batch_interval_(
+        base::TimeDelta::FromMilliseconds(kUpdateBatchIntervalMs)),
     weak_ptr_factory_(this) {
   DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
   content::DownloadManager::DownloadVector items;
@@ -224,6 +245,9 @@ DownloadHistory::DownloadHistory(content::DownloadManager* manager,
 
 DownloadHistory::~DownloadHistory() {
   DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
+  // Don't lose the progress of downloads that changed since the last batch.
+  if (!updating_rows_.empty())
+    UpdateDownloadsBatch();
   FOR_EACH_OBSERVER(Observer, observers_, OnDownloadHistoryDestroyed());
   observers_.Clear();
 }
@@ -405,9 +429,11 @@ void DownloadHistory::OnDownloadUpdated(
   UMA_HISTOGRAM_ENUMERATION("Download.HistoryPropagatedUpdate",
                             should_update, 2);
   if (should_update) {
-    history_->UpdateDownload(current_info);
-    FOR_EACH_OBSERVER(Observer, observers_, OnDownloadStored(
-        item, current_info));
+    // Many downloads in progress would each write their progress several
+    // times a second, so batch progress updates. Write everything else, such
+    // as state changes, immediately.
+    ScheduleUpdateDownload(current_info,
+                           !IsProgressUpdate(data->info(), current_info));
   }
   if (item->GetState() == content::DownloadItem::IN_PROGRESS) {
     data->set_info(current_info);
@@ -433,6 +459,8 @@ void DownloadHistory::OnDownloadRemoved(
     }
     return;
   }
+  // The record is going away, so don't update it.
+  updating_rows_.erase(item->GetId());
   ScheduleRemoveDownload(item->GetId());
   // This is important: another OnDownloadRemoved() handler could do something
   // that synchronously fires an OnDownloadUpdated().
@@ -463,3 +491,40 @@ void DownloadHistory::RemoveDownloadsBatch() {
   history_->RemoveDownloads(remove_ids);
   FOR_EACH_OBSERVER(Observer, observers_, OnDownloadsRemoved(remove_ids));
 }
+
+void DownloadHistory::ScheduleUpdateDownload(const history::DownloadRow& row,
+                                             bool flush) {
+  DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
+  updating_rows_[row.id] = row;
+  if (flush) {
+    UpdateDownloadsBatch();
+    return;
+  }
+  if (!update_timer_.IsRunning()) {
+    update_timer_.Start(FROM_HERE, update_batch_interval_, this,
+                        &DownloadHistory::UpdateDownloadsBatch);
+  }
+}
+
+void DownloadHistory::UpdateDownloadsBatch() {
+  DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
+  update_timer_.Stop();
+  InfoVector rows;
+  rows.reserve(updating_rows_.size());
+  for (std::map<uint32, history::DownloadRow>::const_iterator it =
+           updating_rows_.begin();
+       it != updating_rows_.end(); ++it) {
+    rows.push_back(it->second);
+  }
+  updating_rows_.clear();
+  UMA_HISTOGRAM_COUNTS_100("Download.HistoryUpdateBatchSize", rows.size());
+  history_->UpdateDownloads(rows);
+  // The items may be gone if the manager is shutting down.
+  if (!notifier_.GetManager())
+    return;
+  for (InfoVector::const_iterator it = rows.begin(); it != rows.end(); ++it) {
+    content::DownloadItem* item = notifier_.GetManager()->GetDownload(it->id);
+    if (item)
+      FOR_EACH_OBSERVER(Observer, observers_, OnDownloadStored(item, *it));
+  }
+}
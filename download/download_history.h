@@ -5,6 +5,7 @@
 #ifndef CHROME_BROWSER_DOWNLOAD_DOWNLOAD_HISTORY_H_
 #define CHROME_BROWSER_DOWNLOAD_DOWNLOAD_HISTORY_H_
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -12,15 +13,14 @@
 #include "base/callback.h"
 #include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "chrome/browser/download/all_download_item_notifier.h"
+#include "chrome/browser/history/download_row.h"
 #include "chrome/browser/history/history_service.h"
 #include "content/public/browser/download_item.h"
 #include "content/public/browser/download_manager.h"
 
-namespace history {
-struct DownloadRow;
-}  // namespace history
-
 // Observes a single DownloadManager and all its DownloadItems, keeping the
 // DownloadDatabase up to date.
 class DownloadHistory : public AllDownloadItemNotifier::Observer {
@@ -40,7 +40,7 @@ class DownloadHistory : public AllDownloadItemNotifier::Observer {
         const history::DownloadRow& info,
         const HistoryService::DownloadCreateCallback& callback);
 
-    virtual void UpdateDownload(const history::DownloadRow& data);
+    virtual void UpdateDownloads(const std::vector<history::DownloadRow>& data);
 
     virtual void RemoveDownloads(const std::set<uint32>& ids);
 
@@ -55,7 +55,8 @@ class DownloadHistory : public AllDownloadItemNotifier::Observer {
     virtual ~Observer();
 
     // Fires when a download is added to or updated in the database, just after
-    // the task is posted to the history thread.
+    // the task is posted to the history thread. Updates that only report
+    // progress may be posted up to a batch interval after the item changed.
     virtual void OnDownloadStored(content::DownloadItem* item,
                                   const history::DownloadRow& info) {}
 
@@ -93,6 +94,12 @@ class DownloadHistory : public AllDownloadItemNotifier::Observer {
   // this specific DownloadHistory instance.
   bool WasRestoredFromHistory(const content::DownloadItem* item) const;
 
+  // Sets how long updates that only report progress may wait to be batched
+  // with other updates.
+  void set_update_batch_interval_for_testing(base::TimeDelta interval) {
+    update_batch_interval_ = interval;
+  }
+
  private:
   typedef std::set<content::DownloadItem*> ItemSet;
 
@@ -126,6 +133,15 @@ class DownloadHistory : public AllDownloadItemNotifier::Observer {
   // Removes all |removing_ids_| from |history_|.
   void RemoveDownloadsBatch();
 
+  // Schedule |row| to be written to |history_| the next time
+  // UpdateDownloadsBatch() runs, replacing any row scheduled for the same
+  // download. Runs UpdateDownloadsBatch() now if |flush|, else schedules it to
+  // run after |update_batch_interval_| if it isn't already scheduled.
+  void ScheduleUpdateDownload(const history::DownloadRow& row, bool flush);
+
+  // Writes all |updating_rows_| to |history_| in one task.
+  void UpdateDownloadsBatch();
+
   AllDownloadItemNotifier notifier_;
 
   scoped_ptr<HistoryAdapter> history_;
@@ -139,6 +155,12 @@ class DownloadHistory : public AllDownloadItemNotifier::Observer {
   // facilitate batching removals together for database efficiency.
   IdSet removing_ids_;
 
+  // The latest rows of items that are scheduled to be updated in history, by
+  // id, to batch progress updates of all downloads together.
+  std::map<uint32, history::DownloadRow> updating_rows_;
+  base::TimeDelta update_batch_interval_;
+  base::OneShotTimer<DownloadHistory> update_timer_;
+
   // |GetId()|s of items that were removed while they were being added, so that
   // they can be removed when the database finishes adding them.
   // TODO(benjhayden) Can this be removed now that it doesn't need to wait for
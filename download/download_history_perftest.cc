@@ -0,0 +1,181 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/download/download_history.h"
+
+#include <set>
+#include <vector>
+
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "chrome/browser/history/download_row.h"
+#include "content/public/test/mock_download_item.h"
+#include "content/public/test/mock_download_manager.h"
+#include "content/public/test/test_browser_thread.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRefOfCopy;
+using testing::SaveArg;
+using testing::_;
+
+namespace {
+
+const int kNumItems = 100;
+// DownloadItems report progress about twice a second, and progress is
+// written every two seconds.
+const int kUpdatesPerBatch = 4;
+const int kBatches = 10;
+const double kBatchIntervalSeconds = 2.0;
+
+typedef NiceMock<content::MockDownloadItem> NiceMockDownloadItem;
+
+// Adds every download right away, and counts the progress writes.
+class CountingHistoryAdapter : public DownloadHistory::HistoryAdapter {
+ public:
+  CountingHistoryAdapter()
+      : DownloadHistory::HistoryAdapter(NULL),
+        update_batches_(0),
+        update_statements_(0) {
+  }
+
+  virtual ~CountingHistoryAdapter() {}
+
+  virtual void QueryDownloads(
+      const HistoryService::DownloadQueryCallback& callback) OVERRIDE {
+    callback.Run(make_scoped_ptr(new std::vector<history::DownloadRow>()));
+  }
+
+  virtual void CreateDownload(
+      const history::DownloadRow& info,
+      const HistoryService::DownloadCreateCallback& callback) OVERRIDE {
+    callback.Run(true);
+  }
+
+  virtual void UpdateDownloads(
+      const std::vector<history::DownloadRow>& infos) OVERRIDE {
+    ++update_batches_;
+    update_statements_ += static_cast<int>(infos.size());
+  }
+
+  virtual void RemoveDownloads(const std::set<uint32>& ids) OVERRIDE {}
+
+  int update_batches() const { return update_batches_; }
+  int update_statements() const { return update_statements_; }
+
+ private:
+  int update_batches_;
+  int update_statements_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingHistoryAdapter);
+};
+
+class DownloadHistoryPerfTest : public testing::Test {
+ public:
+  DownloadHistoryPerfTest()
+      : ui_thread_(content::BrowserThread::UI, &loop_),
+        manager_observer_(NULL),
+        history_(NULL) {
+  }
+
+  virtual ~DownloadHistoryPerfTest() {
+    STLDeleteElements(&items_);
+  }
+
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ON_CALL(manager_, AddObserver(_))
+        .WillByDefault(SaveArg<0>(&manager_observer_));
+    history_ = new CountingHistoryAdapter();
+    download_history_.reset(new DownloadHistory(
+        &manager_, scoped_ptr<DownloadHistory::HistoryAdapter>(history_)));
+    // Batches are written when the message loop runs, which stands for the
+    // end of each interval.
+    download_history_->set_update_batch_interval_for_testing(
+        base::TimeDelta());
+    ASSERT_TRUE(manager_observer_);
+
+    for (int i = 0; i < kNumItems; ++i) {
+      NiceMockDownloadItem* item = new NiceMockDownloadItem();
+      items_.push_back(item);
+      base::FilePath path(FILE_PATH_LITERAL("/foo/bar.zip"));
+      std::vector<GURL> url_chain(1, GURL(base::StringPrintf(
+          "http://example.com/%d.zip", i)));
+      ON_CALL(*item, GetId()).WillByDefault(Return(i + 1));
+      ON_CALL(*item, GetFullPath()).WillByDefault(ReturnRefOfCopy(path));
+      ON_CALL(*item, GetTargetFilePath())
+          .WillByDefault(ReturnRefOfCopy(path));
+      ON_CALL(*item, GetURL()).WillByDefault(ReturnRefOfCopy(url_chain[0]));
+      ON_CALL(*item, GetUrlChain()).WillByDefault(ReturnRefOfCopy(url_chain));
+      ON_CALL(*item, GetReferrerUrl()).WillByDefault(ReturnRefOfCopy(GURL()));
+      ON_CALL(*item, GetETag())
+          .WillByDefault(ReturnRefOfCopy(std::string()));
+      ON_CALL(*item, GetLastModifiedTime())
+          .WillByDefault(ReturnRefOfCopy(std::string()));
+      ON_CALL(*item, GetTotalBytes()).WillByDefault(Return(1 << 20));
+      ON_CALL(*item, GetState())
+          .WillByDefault(Return(content::DownloadItem::IN_PROGRESS));
+      ON_CALL(manager_, GetDownload(i + 1)).WillByDefault(Return(item));
+      manager_observer_->OnDownloadCreated(&manager_, item);
+      ASSERT_TRUE(DownloadHistory::IsPersisted(item));
+    }
+  }
+
+  virtual void TearDown() OVERRIDE {
+    download_history_.reset();
+  }
+
+  base::MessageLoopForUI loop_;
+  content::TestBrowserThread ui_thread_;
+  NiceMock<content::MockDownloadManager> manager_;
+  content::DownloadManager::Observer* manager_observer_;
+  CountingHistoryAdapter* history_;
+  scoped_ptr<DownloadHistory> download_history_;
+  std::vector<NiceMockDownloadItem*> items_;
+};
+
+// Measures the progress writes of many parallel downloads.
+TEST_F(DownloadHistoryPerfTest, ParallelProgress) {
+  int64 received_bytes = 0;
+  base::TimeDelta notify_time;
+  for (int batch = 0; batch < kBatches; ++batch) {
+    for (int update = 0; update < kUpdatesPerBatch; ++update) {
+      received_bytes += 1000;
+      for (int i = 0; i < kNumItems; ++i) {
+        ON_CALL(*items_[i], GetReceivedBytes())
+            .WillByDefault(Return(received_bytes));
+        base::TimeTicks start = base::TimeTicks::Now();
+        items_[i]->NotifyObserversDownloadUpdated();
+        notify_time += base::TimeTicks::Now() - start;
+      }
+    }
+    base::RunLoop().RunUntilIdle();
+  }
+  EXPECT_EQ(kBatches, history_->update_batches());
+  EXPECT_EQ(kNumItems * kBatches, history_->update_statements());
+
+  double seconds = kBatches * kBatchIntervalSeconds;
+  perf_test::PrintResult("download_history_update_tasks", "", "unbatched",
+                         kNumItems * kUpdatesPerBatch * kBatches / seconds,
+                         "tasks/s", false);
+  perf_test::PrintResult("download_history_update_tasks", "", "batched",
+                         history_->update_batches() / seconds, "tasks/s",
+                         true);
+  perf_test::PrintResult("download_history_update_statements", "", "batched",
+                         history_->update_statements() / seconds,
+                         "statements/s", true);
+  perf_test::PrintResult("download_history_on_updated", "", "progress",
+                         notify_time.InMicrosecondsF() /
+                             (kNumItems * kUpdatesPerBatch * kBatches),
+                         "us", true);
+}
+
+}  // namespace
@@ -7,6 +7,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/rand_util.h"
 #include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
 #include "chrome/browser/download/download_history.h"
 #include "chrome/browser/history/download_database.h"
 #include "chrome/browser/history/download_row.h"
@@ -67,7 +68,9 @@ class FakeHistoryAdapter : public DownloadHistory::HistoryAdapter {
   FakeHistoryAdapter()
     : DownloadHistory::HistoryAdapter(NULL),
       slow_create_download_(false),
-      fail_create_download_(false) {
+      fail_create_download_(false),
+      update_batches_(0),
+      update_statements_(0) {
   }
 
   virtual ~FakeHistoryAdapter() {}
@@ -108,12 +111,21 @@ class FakeHistoryAdapter : public DownloadHistory::HistoryAdapter {
     create_download_callback_.Reset();
   }
 
-  virtual void UpdateDownload(
-      const history::DownloadRow& info) OVERRIDE {
+  virtual void UpdateDownloads(const InfoVector& infos) OVERRIDE {
     DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
-    update_download_ = info;
+    ++update_batches_;
+    for (InfoVector::const_iterator it = infos.begin();
+         it != infos.end(); ++it) {
+      update_download_ = *it;
+      ++update_statements_;
+    }
   }
 
+  // The number of UpdateDownloads() tasks and of the UPDATE statements they
+  // would run.
+  int update_batches() const { return update_batches_; }
+  int update_statements() const { return update_statements_; }
+
   virtual void RemoveDownloads(const IdSet& ids) OVERRIDE {
     DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
     for (IdSet::const_iterator it = ids.begin();
@@ -184,6 +196,8 @@ class FakeHistoryAdapter : public DownloadHistory::HistoryAdapter {
  private:
   bool slow_create_download_;
   bool fail_create_download_;
+  int update_batches_;
+  int update_statements_;
   base::Closure create_download_callback_;
   history::DownloadRow update_download_;
   scoped_ptr<InfoVector> expect_query_downloads_;
@@ -263,6 +277,10 @@ class DownloadHistoryTest : public testing::Test {
     EXPECT_CALL(*manager_.get(), GetAllDownloads(_)).WillRepeatedly(Return());
     download_history_.reset(new DownloadHistory(
         &manager(), scoped_ptr<DownloadHistory::HistoryAdapter>(history_)));
+    // Write progress updates as soon as the message loop runs so that tests
+    // can expect them after RunAllPendingInMessageLoop().
+    download_history_->set_update_batch_interval_for_testing(
+        base::TimeDelta());
     content::RunAllPendingInMessageLoop(content::BrowserThread::UI);
     history_->ExpectQueryDownloadsDone();
   }
@@ -329,6 +347,8 @@ class DownloadHistoryTest : public testing::Test {
     history_->ExpectDownloadsRemoved(ids);
   }
 
+  FakeHistoryAdapter* history() { return history_; }
+
   void ExpectDownloadsRestoredFromHistory(bool expected_value) {
     DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
     pre_on_create_handler_ =
@@ -371,6 +391,33 @@ class DownloadHistoryTest : public testing::Test {
              info);
   }
 
+  void InitInProgressItem(const base::FilePath::CharType* path,
+                          const char* url_string,
+                          history::DownloadRow* info) {
+    std::vector<GURL> url_chain;
+    url_chain.push_back(GURL(url_string));
+    InitItem(static_cast<uint32>(items_.size() + 1),
+             base::FilePath(path),
+             base::FilePath(path),
+             url_chain,
+             GURL("http://example.com/referrer.html"),
+             "application/octet-stream",
+             "application/octet-stream",
+             (base::Time::Now() - base::TimeDelta::FromMinutes(10)),
+             base::Time(),
+             "Etag",
+             "abc",
+             0,
+             1 << 20,
+             content::DownloadItem::IN_PROGRESS,
+             content::DOWNLOAD_DANGER_TYPE_NOT_DANGEROUS,
+             content::DOWNLOAD_INTERRUPT_REASON_NONE,
+             false,
+             std::string(),
+             std::string(),
+             info);
+  }
+
   void InitItem(
       uint32 id,
       const base::FilePath& current_path,
@@ -868,4 +915,55 @@ TEST_F(DownloadHistoryTest, DownloadHistoryTest_UpdateWhileAdding) {
   ExpectDownloadUpdated(info);
 }
 
+// Test that the progress updates of many downloads in progress are written
+// together, and that other changes are written immediately.
+TEST_F(DownloadHistoryTest, DownloadHistoryTest_ParallelProgressBatched) {
+  static const int kNumItems = 20;
+  static const int kUpdatesPerBatch = 4;
+  static const int kBatches = 10;
+
+  CreateDownloadHistory(scoped_ptr<InfoVector>(new InfoVector()));
+  std::vector<history::DownloadRow> infos(kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    std::string url = base::StringPrintf("http://example.com/%d.zip", i);
+    InitInProgressItem(FILE_PATH_LITERAL("/foo/bar.zip"), url.c_str(),
+                       &infos[i]);
+    CallOnDownloadCreated(i);
+    ExpectDownloadCreated(infos[i]);
+    EXPECT_TRUE(DownloadHistory::IsPersisted(&item(i)));
+  }
+  ASSERT_EQ(0, history()->update_statements());
+
+  int64 received_bytes = 0;
+  for (int batch = 0; batch < kBatches; ++batch) {
+    for (int update = 0; update < kUpdatesPerBatch; ++update) {
+      received_bytes += 1000;
+      for (int i = 0; i < kNumItems; ++i) {
+        EXPECT_CALL(item(i), GetReceivedBytes())
+            .WillRepeatedly(Return(received_bytes));
+        item(i).NotifyObserversDownloadUpdated();
+      }
+    }
+    // The batch is written when the interval, zero here, has passed.
+    EXPECT_EQ(batch, history()->update_batches());
+    content::RunAllPendingInMessageLoop(content::BrowserThread::UI);
+    EXPECT_EQ(batch + 1, history()->update_batches());
+  }
+  // Each download was written once per batch, with its latest progress.
+  EXPECT_EQ(kNumItems * kBatches, history()->update_statements());
+  infos[kNumItems - 1].received_bytes = received_bytes;
+  ExpectDownloadUpdated(infos[kNumItems - 1]);
+
+  // Completing a download is written without waiting for the batch, along
+  // with the progress of the other downloads.
+  EXPECT_CALL(item(1), GetReceivedBytes())
+      .WillRepeatedly(Return(received_bytes + 1000));
+  item(1).NotifyObserversDownloadUpdated();
+  EXPECT_CALL(item(0), GetState())
+      .WillRepeatedly(Return(content::DownloadItem::COMPLETE));
+  item(0).NotifyObserversDownloadUpdated();
+  EXPECT_EQ(kBatches + 1, history()->update_batches());
+  EXPECT_EQ(kNumItems * kBatches + 2, history()->update_statements());
+}
+
 }  // anonymous namespace
@@ -5,6 +5,7 @@
 #include "chrome/browser/download/download_query.h"
 
 #include <algorithm>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,7 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
 #include "base/values.h"
+#include "chrome/browser/download/download_query_index.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/pref_names.h"
 #include "content/public/browser/content_browser_client.h"
@@ -106,21 +108,12 @@ static int64 GetEndTimeMsEpoch(const DownloadItem& item) {
   return (item.GetEndTime() - base::Time::UnixEpoch()).InMilliseconds();
 }
 
-std::string TimeToISO8601(const base::Time& t) {
-  base::Time::Exploded exploded;
-  t.UTCExplode(&exploded);
-  return base::StringPrintf(
-      "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", exploded.year, exploded.month,
-      exploded.day_of_month, exploded.hour, exploded.minute, exploded.second,
-      exploded.millisecond);
-}
-
 static std::string GetStartTime(const DownloadItem& item) {
-  return TimeToISO8601(item.GetStartTime());
+  return DownloadQuery::TimeToISO8601(item.GetStartTime());
 }
 
 static std::string GetEndTime(const DownloadItem& item) {
-  return TimeToISO8601(item.GetEndTime());
+  return DownloadQuery::TimeToISO8601(item.GetEndTime());
 }
 
 static bool GetDangerAccepted(const DownloadItem& item) {
@@ -235,10 +228,72 @@ static ComparisonType Compare(
   return EQ;
 }
 
+typedef DownloadQueryIndex::StartTimeIndex::const_iterator StartTimeIterator;
+
+// Sets [|begin|, |end|) to the items of |by_start_time| which satisfy all of
+// the start time filters |bounds|. Returns false if none can.
+bool GetStartTimeRange(
+    const DownloadQueryIndex::StartTimeIndex& by_start_time,
+    const std::vector<std::pair<DownloadQuery::FilterType, std::string> >&
+        bounds,
+    StartTimeIterator* begin,
+    StartTimeIterator* end) {
+  const std::string* lower = NULL;
+  const std::string* upper = NULL;
+  bool lower_inclusive = true;
+  bool upper_inclusive = true;
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    const std::string& value = bounds[i].second;
+    bool after = bounds[i].first == DownloadQuery::FILTER_STARTED_AFTER;
+    bool before = bounds[i].first == DownloadQuery::FILTER_STARTED_BEFORE;
+    if (!before && (!lower || value > *lower ||
+                    (value == *lower && after))) {
+      lower = &value;
+      lower_inclusive = !after;
+    }
+    if (!after && (!upper || value < *upper ||
+                   (value == *upper && before))) {
+      upper = &value;
+      upper_inclusive = !before;
+    }
+  }
+  if (lower && upper &&
+      (*lower > *upper ||
+       (*lower == *upper && !(lower_inclusive && upper_inclusive)))) {
+    return false;
+  }
+  *begin = !lower ? by_start_time.begin() :
+      lower_inclusive ? by_start_time.lower_bound(*lower) :
+                        by_start_time.upper_bound(*lower);
+  *end = !upper ? by_start_time.end() :
+      upper_inclusive ? by_start_time.upper_bound(*upper) :
+                        by_start_time.lower_bound(*upper);
+  return true;
+}
+
+// Returns the distance from |iter| to |last|, or |max| if that is less.
+size_t CountUpTo(StartTimeIterator iter, StartTimeIterator last, size_t max) {
+  size_t count = 0;
+  for (; iter != last && count < max; ++iter)
+    ++count;
+  return count;
+}
+
 }  // anonymous namespace
 
+// static
+std::string DownloadQuery::TimeToISO8601(const base::Time& t) {
+  base::Time::Exploded exploded;
+  t.UTCExplode(&exploded);
+  return base::StringPrintf(
+      "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", exploded.year, exploded.month,
+      exploded.day_of_month, exploded.hour, exploded.minute, exploded.second,
+      exploded.millisecond);
+}
+
 DownloadQuery::DownloadQuery()
-  : limit_(kuint32max) {
+  : limit_(kuint32max),
+    sorted_by_start_time_(false) {
 }
 
 DownloadQuery::~DownloadQuery() {
@@ -258,6 +313,7 @@ bool DownloadQuery::AddFilter(const DownloadQuery::FilterCallback& value) {
 void DownloadQuery::AddFilter(DownloadItem::DownloadState state) {
   AddFilter(base::Bind(&FieldMatches<DownloadItem::DownloadState>, state, EQ,
       base::Bind(&GetState)));
+  required_states_.push_back(state);
 }
 
 void DownloadQuery::AddFilter(DownloadDangerType danger) {
@@ -267,6 +323,39 @@ void DownloadQuery::AddFilter(DownloadDangerType danger) {
 
 bool DownloadQuery::AddFilter(DownloadQuery::FilterType type,
                               const base::Value& value) {
+  if (!AddTypedFilter(type, value))
+    return false;
+  // Note what the new filter requires of the indexed fields so that Search()
+  // can narrow down the items to match with a DownloadQueryIndex.
+  switch (type) {
+    case FILTER_FILENAME: {
+      base::string16 filename;
+      if (GetAs(value, &filename))
+        required_filenames_.push_back(filename);
+      break;
+    }
+    case FILTER_STARTED_AFTER:
+    case FILTER_STARTED_BEFORE:
+    case FILTER_START_TIME: {
+      std::string start_time;
+      if (GetAs(value, &start_time))
+        start_time_bounds_.push_back(std::make_pair(type, start_time));
+      break;
+    }
+    case FILTER_URL: {
+      std::string url;
+      if (GetAs(value, &url) && GURL(url).is_valid())
+        required_hosts_.push_back(GURL(url).host());
+      break;
+    }
+    default:
+      break;
+  }
+  return true;
+}
+
+bool DownloadQuery::AddTypedFilter(DownloadQuery::FilterType type,
+                                   const base::Value& value) {
   switch (type) {
     case FILTER_BYTES_RECEIVED:
       return AddFilter(BuildFilter<int>(value, EQ, &GetReceivedBytes));
@@ -393,6 +482,8 @@ void DownloadQuery::AddSorter(DownloadQuery::SortType type,
       sorters_.push_back(Sorter::Build<int64>(direction, &GetEndTimeMsEpoch));
       break;
     case SORT_START_TIME:
+      if (sorters_.empty())
+        sorted_by_start_time_ = true;
       sorters_.push_back(Sorter::Build<int64>(direction, &GetStartTimeMsEpoch));
       break;
     case SORT_URL:
@@ -440,3 +531,102 @@ void DownloadQuery::FinishSearch(DownloadQuery::DownloadVector* results) const {
   if (results->size() > limit_)
     results->resize(limit_);
 }
+
+void DownloadQuery::Search(
+    const std::vector<const DownloadQueryIndex*>& indexes,
+    DownloadVector* results) const {
+  results->clear();
+  for (size_t i = 0; i < indexes.size(); ++i)
+    AppendIndexMatches(*indexes[i], results);
+  FinishSearch(results);
+}
+
+// AppendIndexMatches() plans which items of a DownloadQueryIndex to match
+// against the filters. The start time filters bound a range of the start time
+// index. Every state, host and filename the filters require picks out a set of
+// candidates that the results must be among; a filename picks the set of its
+// least common token. The smallest of these sets is matched if it is smaller
+// than the start time range. Otherwise, if the results are sorted by start
+// time and limited, the range is walked in sort order until enough items
+// match. Otherwise the whole range is matched.
+
+void DownloadQuery::AppendIndexMatches(const DownloadQueryIndex& index,
+                                       DownloadVector* results) const {
+  if (limit_ == 0)
+    return;
+  StartTimeIterator begin;
+  StartTimeIterator end;
+  if (!GetStartTimeRange(index.by_start_time(), start_time_bounds_, &begin,
+                         &end)) {
+    return;
+  }
+
+  const DownloadQueryIndex::ItemSet* candidates = NULL;
+  for (size_t i = 0; i < required_states_.size(); ++i) {
+    const DownloadQueryIndex::ItemSet& items =
+        index.GetItemsWithState(required_states_[i]);
+    if (!candidates || items.size() < candidates->size())
+      candidates = &items;
+  }
+  for (size_t i = 0; i < required_hosts_.size(); ++i) {
+    const DownloadQueryIndex::ItemSet& items =
+        index.GetItemsWithHost(required_hosts_[i]);
+    if (!candidates || items.size() < candidates->size())
+      candidates = &items;
+  }
+  for (size_t i = 0; i < required_filenames_.size(); ++i) {
+    std::vector<base::string16> tokens;
+    DownloadQueryIndex::GetFilenameTokens(required_filenames_[i], &tokens);
+    for (size_t j = 0; j < tokens.size(); ++j) {
+      const DownloadQueryIndex::ItemSet& items =
+          index.GetItemsWithFilenameToken(tokens[j]);
+      if (!candidates || items.size() < candidates->size())
+        candidates = &items;
+    }
+  }
+
+  if (candidates &&
+      candidates->size() < CountUpTo(begin, end, candidates->size() + 1)) {
+    for (DownloadQueryIndex::ItemSet::const_iterator it = candidates->begin();
+         it != candidates->end(); ++it) {
+      if (Matches(**it))
+        results->push_back(*it);
+    }
+    return;
+  }
+
+  if (sorted_by_start_time_ && limit_ < index.size()) {
+    if (sorters_[0].direction == ASCENDING) {
+      AppendMatchesInOrder(begin, end, results);
+    } else {
+      AppendMatchesInOrder(std::reverse_iterator<StartTimeIterator>(end),
+                           std::reverse_iterator<StartTimeIterator>(begin),
+                           results);
+    }
+    return;
+  }
+
+  for (; begin != end; ++begin) {
+    if (Matches(*begin->second))
+      results->push_back(begin->second);
+  }
+}
+
+template <typename Iterator>
+void DownloadQuery::AppendMatchesInOrder(Iterator iter,
+                                         const Iterator last,
+                                         DownloadVector* results) const {
+  // Items which start at the same time as the last item to fill the limit
+  // are still needed, since the later sorters may order them before it.
+  size_t matches = 0;
+  const std::string* last_start_time = NULL;
+  for (; iter != last; ++iter) {
+    if (matches >= limit_ && iter->first != *last_start_time)
+      return;
+    if (Matches(*iter->second)) {
+      results->push_back(iter->second);
+      ++matches;
+      last_start_time = &iter->first;
+    }
+  }
+}
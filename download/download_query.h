@@ -7,12 +7,17 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/callback_forward.h"
+#include "base/strings/string16.h"
 #include "content/public/browser/download_item.h"
 
+class DownloadQueryIndex;
+
 namespace base {
+class Time;
 class Value;
 }
 
@@ -89,6 +94,9 @@ class DownloadQuery {
     DESCENDING,
   };
 
+  // Returns |t| as the ISO 8601 string that the time filters compare with.
+  static std::string TimeToISO8601(const base::Time& t);
+
   DownloadQuery();
   ~DownloadQuery();
 
@@ -132,6 +140,16 @@ class DownloadQuery {
     FinishSearch(results);
   }
 
+  // Like Search(), over the items of |indexes|. Only the items of the most
+  // selective index that the filters allow are matched against the filters.
+  // When the results are sorted primarily by start time and limited, the
+  // items are visited in start time order until the limit is reached. The
+  // indexes only see changes to items when DownloadItem observers are
+  // notified, so search items with the iterator version from inside
+  // notifications.
+  void Search(const std::vector<const DownloadQueryIndex*>& indexes,
+              DownloadVector* results) const;
+
  private:
   struct Sorter;
   class DownloadComparator;
@@ -141,13 +159,37 @@ class DownloadQuery {
   bool FilterRegex(const std::string& regex_str,
                    const base::Callback<std::string(
                        const content::DownloadItem&)>& accessor);
+  bool AddTypedFilter(FilterType type, const base::Value& value);
   bool Matches(const content::DownloadItem& item) const;
   void FinishSearch(DownloadVector* results) const;
 
+  // Appends the items of |index| which match the filters to |results|, or
+  // with a limit in start time order, enough of them to fill the limit.
+  void AppendIndexMatches(const DownloadQueryIndex& index,
+                          DownloadVector* results) const;
+  // Appends the items from |iter| to |last| which match the filters to
+  // |results|, until the limit is filled.
+  template <typename Iterator>
+  void AppendMatchesInOrder(Iterator iter,
+                            const Iterator last,
+                            DownloadVector* results) const;
+
   FilterCallbackVector filters_;
   SorterVector sorters_;
   size_t limit_;
 
+  // What the filters require of the fields that DownloadQueryIndex indexes,
+  // recorded as they are added. The filters still check every item the
+  // indexes give.
+  std::vector<content::DownloadItem::DownloadState> required_states_;
+  std::vector<std::string> required_hosts_;
+  std::vector<base::string16> required_filenames_;
+  // The FILTER_STARTED_AFTER, FILTER_STARTED_BEFORE and FILTER_START_TIME
+  // filters and their ISO 8601 values.
+  std::vector<std::pair<FilterType, std::string> > start_time_bounds_;
+  // Whether the first sorter sorts by start time.
+  bool sorted_by_start_time_;
+
   DISALLOW_COPY_AND_ASSIGN(DownloadQuery);
 };
 
@@ -0,0 +1,180 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/download/download_query_index.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+#include "chrome/browser/download/download_query.h"
+#include "content/public/browser/download_manager.h"
+#include "url/gurl.h"
+
+using content::DownloadItem;
+
+namespace {
+
+bool IsTokenCharacter(base::char16 c) {
+  return c >= 0x80 || IsAsciiAlpha(c) || IsAsciiDigit(c);
+}
+
+// Removes |item| from the set under |key| in |index|, and the set itself once
+// it is empty.
+template <typename Index>
+void RemoveFromIndex(Index* index,
+                     const typename Index::key_type& key,
+                     DownloadItem* item) {
+  typename Index::iterator it = index->find(key);
+  DCHECK(it != index->end());
+  if (it == index->end())
+    return;
+  it->second.erase(item);
+  if (it->second.empty())
+    index->erase(it);
+}
+
+}  // namespace
+
+DownloadQueryIndex::Entry::Entry()
+    : state(DownloadItem::MAX_DOWNLOAD_STATE) {
+}
+
+DownloadQueryIndex::Entry::~Entry() {
+}
+
+DownloadQueryIndex::DownloadQueryIndex(content::DownloadManager* manager) {
+  if (!manager)
+    return;
+  notifier_.reset(new AllDownloadItemNotifier(manager, this));
+  content::DownloadManager::DownloadVector items;
+  manager->GetAllDownloads(&items);
+  for (size_t i = 0; i < items.size(); ++i)
+    AddItem(items[i]);
+}
+
+DownloadQueryIndex::~DownloadQueryIndex() {
+}
+
+void DownloadQueryIndex::AddItem(DownloadItem* item) {
+  DCHECK(entries_.find(item) == entries_.end());
+  Entry& entry = entries_[item];
+  // The start time and URL of an item never change.
+  entry.start_time = by_start_time_.insert(
+      std::make_pair(GetStartTimeKey(*item), item));
+  entry.host = item->GetOriginalUrl().host();
+  by_host_[entry.host].insert(item);
+  entry.state = item->GetState();
+  if (entry.state < DownloadItem::MAX_DOWNLOAD_STATE)
+    by_state_[entry.state].insert(item);
+  IndexFilename(item, &entry);
+}
+
+void DownloadQueryIndex::UpdateItem(DownloadItem* item) {
+  std::map<DownloadItem*, Entry>::iterator it = entries_.find(item);
+  if (it == entries_.end())
+    return;
+  Entry& entry = it->second;
+  // Updates mostly report progress, so check cheaply what changed.
+  DownloadItem::DownloadState state = item->GetState();
+  if (state != entry.state) {
+    if (entry.state < DownloadItem::MAX_DOWNLOAD_STATE)
+      by_state_[entry.state].erase(item);
+    entry.state = state;
+    if (state < DownloadItem::MAX_DOWNLOAD_STATE)
+      by_state_[state].insert(item);
+  }
+  if (item->GetTargetFilePath() != entry.target_path) {
+    UnindexFilename(item, entry);
+    IndexFilename(item, &entry);
+  }
+}
+
+void DownloadQueryIndex::RemoveItem(DownloadItem* item) {
+  std::map<DownloadItem*, Entry>::iterator it = entries_.find(item);
+  if (it == entries_.end())
+    return;
+  const Entry& entry = it->second;
+  by_start_time_.erase(entry.start_time);
+  RemoveFromIndex(&by_host_, entry.host, item);
+  if (entry.state < DownloadItem::MAX_DOWNLOAD_STATE)
+    by_state_[entry.state].erase(item);
+  UnindexFilename(item, entry);
+  entries_.erase(it);
+}
+
+const DownloadQueryIndex::ItemSet& DownloadQueryIndex::GetItemsWithState(
+    DownloadItem::DownloadState state) const {
+  if (state < 0 || state >= DownloadItem::MAX_DOWNLOAD_STATE)
+    return empty_set_;
+  return by_state_[state];
+}
+
+const DownloadQueryIndex::ItemSet& DownloadQueryIndex::GetItemsWithHost(
+    const std::string& host) const {
+  HostIndex::const_iterator it = by_host_.find(host);
+  return it == by_host_.end() ? empty_set_ : it->second;
+}
+
+const DownloadQueryIndex::ItemSet&
+DownloadQueryIndex::GetItemsWithFilenameToken(
+    const base::string16& token) const {
+  TokenIndex::const_iterator it = by_filename_token_.find(token);
+  return it == by_filename_token_.end() ? empty_set_ : it->second;
+}
+
+// static
+std::string DownloadQueryIndex::GetStartTimeKey(const DownloadItem& item) {
+  return DownloadQuery::TimeToISO8601(item.GetStartTime());
+}
+
+// static
+void DownloadQueryIndex::GetFilenameTokens(
+    const base::string16& filename,
+    std::vector<base::string16>* tokens) {
+  tokens->clear();
+  size_t begin = 0;
+  while (begin < filename.size()) {
+    while (begin < filename.size() && !IsTokenCharacter(filename[begin]))
+      ++begin;
+    size_t end = begin;
+    while (end < filename.size() && IsTokenCharacter(filename[end]))
+      ++end;
+    if (end > begin)
+      tokens->push_back(filename.substr(begin, end - begin));
+    begin = end;
+  }
+  std::sort(tokens->begin(), tokens->end());
+  tokens->erase(std::unique(tokens->begin(), tokens->end()), tokens->end());
+}
+
+void DownloadQueryIndex::OnDownloadCreated(content::DownloadManager* manager,
+                                           DownloadItem* item) {
+  AddItem(item);
+}
+
+void DownloadQueryIndex::OnDownloadUpdated(content::DownloadManager* manager,
+                                           DownloadItem* item) {
+  UpdateItem(item);
+}
+
+void DownloadQueryIndex::OnDownloadRemoved(content::DownloadManager* manager,
+                                           DownloadItem* item) {
+  RemoveItem(item);
+}
+
+void DownloadQueryIndex::IndexFilename(DownloadItem* item, Entry* entry) {
+  entry->target_path = item->GetTargetFilePath();
+  // DownloadQuery compares filenames as the user sees them.
+  GetFilenameTokens(entry->target_path.LossyDisplayName(),
+                    &entry->filename_tokens);
+  for (size_t i = 0; i < entry->filename_tokens.size(); ++i)
+    by_filename_token_[entry->filename_tokens[i]].insert(item);
+}
+
+void DownloadQueryIndex::UnindexFilename(DownloadItem* item,
+                                         const Entry& entry) {
+  for (size_t i = 0; i < entry.filename_tokens.size(); ++i)
+    RemoveFromIndex(&by_filename_token_, entry.filename_tokens[i], item);
+}
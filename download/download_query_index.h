@@ -0,0 +1,103 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_DOWNLOAD_DOWNLOAD_QUERY_INDEX_H_
+#define CHROME_BROWSER_DOWNLOAD_DOWNLOAD_QUERY_INDEX_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string16.h"
+#include "chrome/browser/download/all_download_item_notifier.h"
+#include "content/public/browser/download_item.h"
+
+namespace content {
+class DownloadManager;
+}
+
+// Secondary indexes over the DownloadItems of a DownloadManager, kept up to
+// date as items are created, updated and removed. DownloadQuery::Search() uses
+// them to consider only the items of its most selective index instead of
+// scanning every item, and to walk the items in start time order when that is
+// how the results are sorted.
+class DownloadQueryIndex : public AllDownloadItemNotifier::Observer {
+ public:
+  typedef std::set<content::DownloadItem*> ItemSet;
+  // Keyed by the ISO 8601 start time that DownloadQuery filters compare
+  // against, which sorts the same way as the start time itself.
+  typedef std::multimap<std::string, content::DownloadItem*> StartTimeIndex;
+
+  // Indexes the items of |manager| and follows its changes. |manager| may be
+  // NULL, in which case items are only indexed by the methods below.
+  explicit DownloadQueryIndex(content::DownloadManager* manager);
+  virtual ~DownloadQueryIndex();
+
+  void AddItem(content::DownloadItem* item);
+  // Re-indexes the fields of |item| which changed.
+  void UpdateItem(content::DownloadItem* item);
+  void RemoveItem(content::DownloadItem* item);
+
+  size_t size() const { return entries_.size(); }
+
+  // Every indexed item, in start time order.
+  const StartTimeIndex& by_start_time() const { return by_start_time_; }
+
+  const ItemSet& GetItemsWithState(
+      content::DownloadItem::DownloadState state) const;
+  const ItemSet& GetItemsWithHost(const std::string& host) const;
+  // Items whose target path contains |token|, as split by
+  // GetFilenameTokens().
+  const ItemSet& GetItemsWithFilenameToken(const base::string16& token) const;
+
+  static std::string GetStartTimeKey(const content::DownloadItem& item);
+  // Splits |filename| into the runs of characters between ASCII punctuation,
+  // whitespace and path separators.
+  static void GetFilenameTokens(const base::string16& filename,
+                                std::vector<base::string16>* tokens);
+
+ private:
+  typedef std::map<std::string, ItemSet> HostIndex;
+  typedef std::map<base::string16, ItemSet> TokenIndex;
+
+  // What an item is indexed under, to find and update its index entries.
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    StartTimeIndex::iterator start_time;
+    std::string host;
+    base::FilePath target_path;
+    std::vector<base::string16> filename_tokens;
+    content::DownloadItem::DownloadState state;
+  };
+
+  // AllDownloadItemNotifier::Observer
+  virtual void OnDownloadCreated(content::DownloadManager* manager,
+                                 content::DownloadItem* item) OVERRIDE;
+  virtual void OnDownloadUpdated(content::DownloadManager* manager,
+                                 content::DownloadItem* item) OVERRIDE;
+  virtual void OnDownloadRemoved(content::DownloadManager* manager,
+                                 content::DownloadItem* item) OVERRIDE;
+
+  void IndexFilename(content::DownloadItem* item, Entry* entry);
+  void UnindexFilename(content::DownloadItem* item, const Entry& entry);
+
+  std::map<content::DownloadItem*, Entry> entries_;
+  StartTimeIndex by_start_time_;
+  HostIndex by_host_;
+  TokenIndex by_filename_token_;
+  ItemSet by_state_[content::DownloadItem::MAX_DOWNLOAD_STATE];
+  const ItemSet empty_set_;
+
+  scoped_ptr<AllDownloadItemNotifier> notifier_;
+
+  DISALLOW_COPY_AND_ASSIGN(DownloadQueryIndex);
+};
+
+#endif  // CHROME_BROWSER_DOWNLOAD_DOWNLOAD_QUERY_INDEX_H_
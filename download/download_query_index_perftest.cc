@@ -0,0 +1,137 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/download/download_query_index.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/download/download_query.h"
+#include "content/public/test/mock_download_item.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+using ::testing::Return;
+using ::testing::ReturnRef;
+using content::DownloadItem;
+typedef DownloadQuery::DownloadVector DownloadVector;
+
+namespace {
+
+const int kSomeKnownTime = 1355864160;
+const int kNumItems = 50000;
+// The number of items the downloads page shows.
+const size_t kPageLimit = 150;
+
+bool IdLess(const DownloadItem* left, const DownloadItem* right) {
+  return left->GetId() < right->GetId();
+}
+
+class DownloadQueryIndexPerfTest : public testing::Test {
+ public:
+  DownloadQueryIndexPerfTest() : index_(NULL) {}
+
+  virtual ~DownloadQueryIndexPerfTest() {}
+
+  virtual void SetUp() OVERRIDE {
+    // Two items start in each second, the hosts repeat every 7 items, the
+    // filenames every 5 and the states every 3.
+    urls_.reserve(kNumItems);
+    paths_.reserve(kNumItems);
+    for (int i = 0; i < kNumItems; ++i) {
+      urls_.push_back(GURL(base::StringPrintf(
+          "http://host%d.example.com/file%d", i % 7, i)));
+      paths_.push_back(base::FilePath::FromUTF8Unsafe(
+          base::StringPrintf("report-%d.pdf", i % 5)));
+    }
+    for (int i = 0; i < kNumItems; ++i) {
+      content::MockDownloadItem* item = new content::MockDownloadItem();
+      mocks_.push_back(item);
+      EXPECT_CALL(*item, GetId()).WillRepeatedly(Return(i));
+      EXPECT_CALL(*item, GetStartTime()).WillRepeatedly(Return(
+          base::Time::FromTimeT(kSomeKnownTime + i / 2)));
+      EXPECT_CALL(*item, GetOriginalUrl()).WillRepeatedly(ReturnRef(urls_[i]));
+      EXPECT_CALL(*item, GetTargetFilePath()).WillRepeatedly(
+          ReturnRef(paths_[i]));
+      EXPECT_CALL(*item, GetState()).WillRepeatedly(Return(
+          static_cast<DownloadItem::DownloadState>(i % 3)));
+      index_.AddItem(item);
+    }
+  }
+
+  virtual void TearDown() OVERRIDE {
+    STLDeleteElements(&mocks_);
+  }
+
+  content::MockDownloadItem& mock(int index) { return *mocks_[index]; }
+
+  void AddFilter(DownloadQuery* query,
+                 DownloadQuery::FilterType type,
+                 const std::string& value) {
+    CHECK(query->AddFilter(type, base::StringValue(value)));
+  }
+
+  // Runs |query| over all items and over the index, checks that both find
+  // the same items, and reports both times as |trace|.
+  void TimeSearch(const DownloadQuery& query, const std::string& trace) {
+    DownloadVector linear_results, index_results;
+    base::TimeTicks start = base::TimeTicks::Now();
+    query.Search(mocks_.begin(), mocks_.end(), &linear_results);
+    base::TimeTicks middle = base::TimeTicks::Now();
+    std::vector<const DownloadQueryIndex*> indexes(1, &index_);
+    query.Search(indexes, &index_results);
+    base::TimeTicks end = base::TimeTicks::Now();
+
+    std::sort(linear_results.begin(), linear_results.end(), IdLess);
+    std::sort(index_results.begin(), index_results.end(), IdLess);
+    EXPECT_EQ(linear_results, index_results);
+
+    perf_test::PrintResult("download_search_linear", "", trace,
+                           (middle - start).InMillisecondsF(), "ms", false);
+    perf_test::PrintResult("download_search_index", "", trace,
+                           (end - middle).InMillisecondsF(), "ms", true);
+  }
+
+ private:
+  std::vector<GURL> urls_;
+  std::vector<base::FilePath> paths_;
+  std::vector<content::MockDownloadItem*> mocks_;
+  DownloadQueryIndex index_;
+
+  DISALLOW_COPY_AND_ASSIGN(DownloadQueryIndexPerfTest);
+};
+
+// The first page of the downloads page, newest first.
+TEST_F(DownloadQueryIndexPerfTest, Page) {
+  DownloadQuery query;
+  query.AddSorter(DownloadQuery::SORT_START_TIME, DownloadQuery::DESCENDING);
+  query.Limit(kPageLimit);
+  TimeSearch(query, "page");
+}
+
+TEST_F(DownloadQueryIndexPerfTest, Url) {
+  DownloadQuery query;
+  AddFilter(&query, DownloadQuery::FILTER_URL,
+            "http://host1.example.com/file1234");
+  TimeSearch(query, "url");
+}
+
+TEST_F(DownloadQueryIndexPerfTest, StartTimeRange) {
+  DownloadQuery query;
+  AddFilter(&query, DownloadQuery::FILTER_STARTED_AFTER,
+            DownloadQueryIndex::GetStartTimeKey(mock(kNumItems / 2)));
+  AddFilter(&query, DownloadQuery::FILTER_STARTED_BEFORE,
+            DownloadQueryIndex::GetStartTimeKey(mock(kNumItems / 2 + 500)));
+  TimeSearch(query, "start_time_range");
+}
+
+}  // namespace
@@ -0,0 +1,227 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/stl_util.h"
+#include "base/strings/string16.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/download/download_query.h"
+#include "chrome/browser/download/download_query_index.h"
+#include "content/public/test/mock_download_item.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+using ::testing::Return;
+using ::testing::ReturnRef;
+using content::DownloadItem;
+typedef DownloadQuery::DownloadVector DownloadVector;
+
+namespace {
+
+static const int kSomeKnownTime = 1355864160;
+
+bool IdLess(const DownloadItem* left, const DownloadItem* right) {
+  return left->GetId() < right->GetId();
+}
+
+}  // anonymous namespace
+
+class DownloadQueryIndexTest : public testing::Test {
+ public:
+  DownloadQueryIndexTest() : index_(NULL) {}
+
+  virtual ~DownloadQueryIndexTest() {}
+
+  virtual void TearDown() {
+    STLDeleteElements(&mocks_);
+  }
+
+  // Creates |count| items: two start in each second, the hosts repeat every
+  // 7 items, the filenames every 5 and the states every 3.
+  void CreateMocks(int count) {
+    urls_.reserve(count);
+    paths_.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      urls_.push_back(GURL(base::StringPrintf(
+          "http://host%d.example.com/file%d", i % 7, i)));
+      paths_.push_back(base::FilePath::FromUTF8Unsafe(
+          base::StringPrintf("report-%d.pdf", i % 5)));
+    }
+    for (int i = 0; i < count; ++i) {
+      content::MockDownloadItem* item = new content::MockDownloadItem();
+      mocks_.push_back(item);
+      EXPECT_CALL(*item, GetId()).WillRepeatedly(Return(i));
+      EXPECT_CALL(*item, GetStartTime()).WillRepeatedly(Return(
+          base::Time::FromTimeT(kSomeKnownTime + i / 2)));
+      EXPECT_CALL(*item, GetOriginalUrl()).WillRepeatedly(ReturnRef(urls_[i]));
+      EXPECT_CALL(*item, GetTargetFilePath()).WillRepeatedly(
+          ReturnRef(paths_[i]));
+      EXPECT_CALL(*item, GetState()).WillRepeatedly(Return(
+          static_cast<DownloadItem::DownloadState>(i % 3)));
+      index_.AddItem(item);
+    }
+  }
+
+  content::MockDownloadItem& mock(int index) { return *mocks_[index]; }
+
+  DownloadQueryIndex* index() { return &index_; }
+
+  void AddFilter(DownloadQuery* query,
+                 DownloadQuery::FilterType type,
+                 const std::string& value) {
+    CHECK(query->AddFilter(type, base::StringValue(value)));
+  }
+
+  void SearchLinear(const DownloadQuery& query, DownloadVector* results) {
+    query.Search(mocks_.begin(), mocks_.end(), results);
+  }
+
+  void SearchIndex(const DownloadQuery& query, DownloadVector* results) {
+    std::vector<const DownloadQueryIndex*> indexes(1, &index_);
+    query.Search(indexes, results);
+  }
+
+  // Expects the indexed search to find the same items as the linear search.
+  // Unsorted results may come in any order.
+  void ExpectSameResults(const DownloadQuery& query, bool sorted) {
+    DownloadVector linear_results, index_results;
+    SearchLinear(query, &linear_results);
+    SearchIndex(query, &index_results);
+    if (!sorted) {
+      std::sort(linear_results.begin(), linear_results.end(), IdLess);
+      std::sort(index_results.begin(), index_results.end(), IdLess);
+    }
+    EXPECT_EQ(linear_results, index_results);
+  }
+
+ private:
+  std::vector<GURL> urls_;
+  std::vector<base::FilePath> paths_;
+  std::vector<content::MockDownloadItem*> mocks_;
+  DownloadQueryIndex index_;
+
+  DISALLOW_COPY_AND_ASSIGN(DownloadQueryIndexTest);
+};
+
+TEST_F(DownloadQueryIndexTest, GetFilenameTokens) {
+  std::vector<base::string16> tokens;
+  DownloadQueryIndex::GetFilenameTokens(
+      base::ASCIIToUTF16("My Report (2).final.Report.pdf"), &tokens);
+  // "Report" is only kept once.
+  ASSERT_EQ(5U, tokens.size());
+  EXPECT_EQ(base::ASCIIToUTF16("2"), tokens[0]);
+  EXPECT_EQ(base::ASCIIToUTF16("My"), tokens[1]);
+  EXPECT_EQ(base::ASCIIToUTF16("Report"), tokens[2]);
+  EXPECT_EQ(base::ASCIIToUTF16("final"), tokens[3]);
+  EXPECT_EQ(base::ASCIIToUTF16("pdf"), tokens[4]);
+  DownloadQueryIndex::GetFilenameTokens(base::ASCIIToUTF16("..."), &tokens);
+  EXPECT_TRUE(tokens.empty());
+}
+
+TEST_F(DownloadQueryIndexTest, UpdateAndRemove) {
+  CreateMocks(3);
+  EXPECT_EQ(3U, index()->size());
+  EXPECT_EQ(1U, index()->GetItemsWithState(DownloadItem::COMPLETE).size());
+  EXPECT_EQ(1U, index()->GetItemsWithHost("host1.example.com").size());
+  EXPECT_EQ(3U, index()->GetItemsWithFilenameToken(
+      base::ASCIIToUTF16("pdf")).size());
+
+  // mock(0) completes and is renamed.
+  base::FilePath renamed(FILE_PATH_LITERAL("summary.txt"));
+  EXPECT_CALL(mock(0), GetState()).WillRepeatedly(Return(
+      DownloadItem::COMPLETE));
+  EXPECT_CALL(mock(0), GetTargetFilePath()).WillRepeatedly(ReturnRef(renamed));
+  index()->UpdateItem(&mock(0));
+  EXPECT_EQ(0U, index()->GetItemsWithState(DownloadItem::IN_PROGRESS).size());
+  EXPECT_EQ(2U, index()->GetItemsWithState(DownloadItem::COMPLETE).size());
+  EXPECT_EQ(2U, index()->GetItemsWithFilenameToken(
+      base::ASCIIToUTF16("pdf")).size());
+  EXPECT_EQ(1U, index()->GetItemsWithFilenameToken(
+      base::ASCIIToUTF16("summary")).size());
+
+  index()->RemoveItem(&mock(0));
+  EXPECT_EQ(2U, index()->size());
+  EXPECT_EQ(2U, index()->by_start_time().size());
+  EXPECT_EQ(1U, index()->GetItemsWithState(DownloadItem::COMPLETE).size());
+  EXPECT_EQ(0U, index()->GetItemsWithHost("host0.example.com").size());
+  EXPECT_EQ(0U, index()->GetItemsWithFilenameToken(
+      base::ASCIIToUTF16("summary")).size());
+}
+
+TEST_F(DownloadQueryIndexTest, SearchMatchesLinearSearch) {
+  CreateMocks(200);
+  std::string start_time_40 = DownloadQueryIndex::GetStartTimeKey(mock(40));
+  std::string start_time_61 = DownloadQueryIndex::GetStartTimeKey(mock(61));
+
+  {
+    DownloadQuery query;
+    query.AddFilter(DownloadItem::COMPLETE);
+    ExpectSameResults(query, false);
+  }
+  {
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_URL,
+              "http://host3.example.com/file10");
+    ExpectSameResults(query, false);
+  }
+  {
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_FILENAME, "report-2.pdf");
+    query.AddFilter(DownloadItem::CANCELLED);
+    ExpectSameResults(query, false);
+  }
+  {
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_STARTED_AFTER, start_time_40);
+    AddFilter(&query, DownloadQuery::FILTER_STARTED_BEFORE, start_time_61);
+    ExpectSameResults(query, false);
+  }
+  {
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_START_TIME, start_time_61);
+    ExpectSameResults(query, false);
+  }
+  {
+    // No item can start both after and before the same time.
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_STARTED_AFTER, start_time_40);
+    AddFilter(&query, DownloadQuery::FILTER_STARTED_BEFORE, start_time_40);
+    DownloadVector results;
+    SearchIndex(query, &results);
+    EXPECT_TRUE(results.empty());
+  }
+  {
+    DownloadQuery query;
+    query.AddFilter(DownloadItem::IN_PROGRESS);
+    query.AddSorter(DownloadQuery::SORT_START_TIME, DownloadQuery::DESCENDING);
+    query.Limit(7);
+    ExpectSameResults(query, true);
+  }
+  {
+    // Items which start at the same time as the last one within the limit are
+    // ordered by the next sorter.
+    DownloadQuery query;
+    AddFilter(&query, DownloadQuery::FILTER_STARTED_AFTER, start_time_40);
+    query.AddSorter(DownloadQuery::SORT_START_TIME, DownloadQuery::ASCENDING);
+    query.AddSorter(DownloadQuery::SORT_URL, DownloadQuery::DESCENDING);
+    query.Limit(5);
+    ExpectSameResults(query, true);
+  }
+  {
+    DownloadQuery query;
+    query.AddSorter(DownloadQuery::SORT_START_TIME, DownloadQuery::DESCENDING);
+    query.Limit(0);
+    DownloadVector results;
+    SearchIndex(query, &results);
+    EXPECT_TRUE(results.empty());
+  }
+}
@@ -8,6 +8,7 @@
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/download/chrome_download_manager_delegate.h"
 #include "chrome/browser/download/download_history.h"
+#include "chrome/browser/download/download_query_index.h"
 #include "chrome/browser/download/download_service_factory.h"
 #include "chrome/browser/download/download_status_updater.h"
 #include "chrome/browser/download/download_ui_controller.h"
@@ -50,6 +51,10 @@ ChromeDownloadManagerDelegate* DownloadService::GetDownloadManagerDelegate() {
 
   manager_delegate_->SetDownloadManager(manager);
 
+  // Index the downloads before anything that might search them hears about
+  // changes to them.
+  query_index_.reset(new DownloadQueryIndex(manager));
+
 #if defined(ENABLE_EXTENSIONS)
   extension_event_router_.reset(
       new extensions::ExtensionDownloadsEventRouter(profile_, manager));
@@ -86,6 +91,12 @@ DownloadHistory* DownloadService::GetDownloadHistory() {
   return download_history_.get();
 }
 
+DownloadQueryIndex* DownloadService::GetDownloadQueryIndex() {
+  if (!download_manager_created_)
+    GetDownloadManagerDelegate();
+  return query_index_.get();
+}
+
 bool DownloadService::HasCreatedDownloadManager() {
   return download_manager_created_;
 }
@@ -177,4 +188,5 @@ void DownloadService::Shutdown() {
 #endif
   manager_delegate_.reset();
   download_history_.reset();
+  query_index_.reset();
 }
@@ -12,6 +12,7 @@
 
 class ChromeDownloadManagerDelegate;
 class DownloadHistory;
+class DownloadQueryIndex;
 class DownloadUIController;
 class ExtensionDownloadsEventRouter;
 class Profile;
@@ -38,6 +39,10 @@ class DownloadService : public KeyedService {
   // no HistoryService for profile. Virtual for testing.
   virtual DownloadHistory* GetDownloadHistory();
 
+  // Get the indexes of the downloads that DownloadQuery searches use, creating
+  // the download manager delegate if it doesn't already exist.
+  DownloadQueryIndex* GetDownloadQueryIndex();
+
 #if defined(ENABLE_EXTENSIONS)
   extensions::ExtensionDownloadsEventRouter* GetExtensionEventRouter() {
     return extension_event_router_.get();
@@ -85,6 +90,9 @@ class DownloadService : public KeyedService {
 
   scoped_ptr<DownloadHistory> download_history_;
 
+  // Follows the download manager like download_ui_.
+  scoped_ptr<DownloadQueryIndex> query_index_;
+
   // The UI controller is responsible for observing the download manager and
   // notifying the UI of any new downloads. Its lifetime matches that of the
   // associated download manager.
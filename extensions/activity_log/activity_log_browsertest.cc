@@ -114,7 +114,8 @@ IN_PROC_BROWSER_TEST_F(ActivityLogPrerenderTest, TestScriptInjected) {
       prerender_manager->AddPrerenderFromLocalPredictor(
           url,
           web_contents->GetController().GetDefaultSessionStorageNamespace(),
-          kSize));
+          kSize,
+          1.0));
 
   page_observer.Wait();
 
@@ -254,7 +254,8 @@ TEST_F(ActivityLogTest, LogPrerender) {
       prerender_manager->AddPrerenderFromLocalPredictor(
           url,
           web_contents()->GetController().GetDefaultSessionStorageNamespace(),
-          kSize));
+          kSize,
+          1.0));
 
   const std::vector<content::WebContents*> contentses =
       prerender_manager->GetAllPrerenderingContents();
@@ -38,8 +38,10 @@
 #include "base/files/file_path.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_string_value_serializer.h"
+#include "base/metrics/histogram.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/time/time.h"
 #include "chrome/common/chrome_constants.h"
 
 using content::BrowserThread;
@@ -85,6 +87,77 @@ const ApiList kAlwaysLog[] = {
     {Action::ACTION_DOM_ACCESS, "Document.createElementNS"},
 };
 
+// The string-valued columns of an action which are stored as identifiers from
+// the string_ids or url_ids table, in the order they are matched in
+// CountingPolicy::FlushDatabase.
+enum StringColumn {
+  EXTENSION_ID_COLUMN = 0,
+  API_NAME_COLUMN,
+  ARGS_COLUMN,
+  PAGE_URL_COLUMN,
+  PAGE_TITLE_COLUMN,
+  ARG_URL_COLUMN,
+  OTHER_COLUMN,
+  NUM_STRING_COLUMNS
+};
+
+bool IsUrlColumn(int column) {
+  return column == PAGE_URL_COLUMN || column == ARG_URL_COLUMN;
+}
+
+// The serialized string columns of one queued action.  Columns which are
+// stored as NULL in the database have |present| set to false.
+struct SerializedAction {
+  SerializedAction() {
+    for (int i = 0; i < NUM_STRING_COLUMNS; i++)
+      present[i] = false;
+  }
+
+  void Set(StringColumn column, const std::string& value) {
+    values[column] = value;
+    present[column] = true;
+  }
+
+  std::string values[NUM_STRING_COLUMNS];
+  bool present[NUM_STRING_COLUMNS];
+};
+
+void SerializeAction(const Action& action, SerializedAction* serialized) {
+  serialized->Set(EXTENSION_ID_COLUMN, action.extension_id());
+  serialized->Set(API_NAME_COLUMN, action.api_name());
+
+  if (action.args()) {
+    std::string args = extensions::ActivityLogPolicy::Util::Serialize(
+        action.args());
+    // TODO(mvrable): For now, truncate long argument lists.  This is a
+    // workaround for excessively-long values coming from DOM logging.  When
+    // the V8ValueConverter is fixed to return more reasonable values, we can
+    // drop the truncation.
+    if (args.length() > 10000) {
+      args = "[\"<too_large>\"]";
+    }
+    serialized->Set(ARGS_COLUMN, args);
+  }
+
+  std::string page_url_string = action.SerializePageUrl();
+  if (!page_url_string.empty())
+    serialized->Set(PAGE_URL_COLUMN, page_url_string);
+
+  // TODO(mvrable): Create a title_table_?
+  if (!action.page_title().empty())
+    serialized->Set(PAGE_TITLE_COLUMN, action.page_title());
+
+  std::string arg_url_string = action.SerializeArgUrl();
+  if (!arg_url_string.empty())
+    serialized->Set(ARG_URL_COLUMN, arg_url_string);
+
+  if (action.other()) {
+    serialized->Set(OTHER_COLUMN,
+                    extensions::ActivityLogPolicy::Util::Serialize(
+                        action.other()));
+  }
+}
+
 // Columns in the main database table.  See the file-level comment for a
 // discussion of how data is stored and the meanings of the _x columns.
 const char* kTableContentFields[] = {
@@ -247,6 +320,7 @@ bool CountingPolicy::FlushDatabase(sql::Connection* db) {
   if (queue.empty() && !clean_database)
     return true;
 
+  base::TimeTicks flush_start_time = base::TimeTicks::Now();
   sql::Transaction transaction(db);
   if (!transaction.Begin())
     return false;
@@ -282,77 +356,59 @@ bool CountingPolicy::FlushDatabase(sql::Connection* db) {
   locate_str += " ORDER BY time DESC LIMIT 1";
   insert_str += ")";
 
-  for (ActionQueue::iterator i = queue.begin(); i != queue.end(); ++i) {
+  // Serialize the string columns of every action up front, so that all the
+  // strings which are not cached yet can be interned with a few batched
+  // statements rather than a few statements per string.
+  std::vector<SerializedAction> serialized_actions(queue.size());
+  std::vector<std::string> strings;
+  std::vector<std::string> urls;
+  size_t action_index = 0;
+  for (ActionQueue::iterator i = queue.begin(); i != queue.end();
+       ++i, ++action_index) {
+    SerializedAction* serialized = &serialized_actions[action_index];
+    SerializeAction(*i->first, serialized);
+    for (int column = 0; column < NUM_STRING_COLUMNS; column++) {
+      if (!serialized->present[column])
+        continue;
+      if (IsUrlColumn(column))
+        urls.push_back(serialized->values[column]);
+      else
+        strings.push_back(serialized->values[column]);
+    }
+  }
+  DatabaseStringTable::StringIdMap string_ids;
+  DatabaseStringTable::StringIdMap url_ids;
+  if (!string_table_.StringsToInts(db, strings, &string_ids))
+    return false;
+  if (!url_table_.StringsToInts(db, urls, &url_ids))
+    return false;
+
+  action_index = 0;
+  for (ActionQueue::iterator i = queue.begin(); i != queue.end();
+       ++i, ++action_index) {
     const Action& action = *i->first;
     int count = i->second;
+    const SerializedAction& serialized = serialized_actions[action_index];
 
     base::Time day_start = action.time().LocalMidnight();
     base::Time next_day = Util::AddDays(day_start, 1);
 
     // The contents in values must match up with fields in matched_columns.  A
     // value of -1 is used to encode a null database value.
-    int64 id;
     std::vector<int64> matched_values;
-
-    if (!string_table_.StringToInt(db, action.extension_id(), &id))
-      return false;
-    matched_values.push_back(id);
-
-    matched_values.push_back(static_cast<int>(action.action_type()));
-
-    if (!string_table_.StringToInt(db, action.api_name(), &id))
-      return false;
-    matched_values.push_back(id);
-
-    if (action.args()) {
-      std::string args = Util::Serialize(action.args());
-      // TODO(mvrable): For now, truncate long argument lists.  This is a
-      // workaround for excessively-long values coming from DOM logging.  When
-      // the V8ValueConverter is fixed to return more reasonable values, we can
-      // drop the truncation.
-      if (args.length() > 10000) {
-        args = "[\"<too_large>\"]";
+    for (int column = 0; column < NUM_STRING_COLUMNS; column++) {
+      if (column == API_NAME_COLUMN)
+        matched_values.push_back(static_cast<int>(action.action_type()));
+      if (!serialized.present[column]) {
+        matched_values.push_back(-1);
+        continue;
       }
-      if (!string_table_.StringToInt(db, args, &id))
-        return false;
-      matched_values.push_back(id);
-    } else {
-      matched_values.push_back(-1);
-    }
-
-    std::string page_url_string = action.SerializePageUrl();
-    if (!page_url_string.empty()) {
-      if (!url_table_.StringToInt(db, page_url_string, &id))
-        return false;
-      matched_values.push_back(id);
-    } else {
-      matched_values.push_back(-1);
-    }
-
-    // TODO(mvrable): Create a title_table_?
-    if (!action.page_title().empty()) {
-      if (!string_table_.StringToInt(db, action.page_title(), &id))
-        return false;
-      matched_values.push_back(id);
-    } else {
-      matched_values.push_back(-1);
-    }
-
-    std::string arg_url_string = action.SerializeArgUrl();
-    if (!arg_url_string.empty()) {
-      if (!url_table_.StringToInt(db, arg_url_string, &id))
-        return false;
-      matched_values.push_back(id);
-    } else {
-      matched_values.push_back(-1);
-    }
-
-    if (action.other()) {
-      if (!string_table_.StringToInt(db, Util::Serialize(action.other()), &id))
-        return false;
-      matched_values.push_back(id);
-    } else {
-      matched_values.push_back(-1);
+      const DatabaseStringTable::StringIdMap& ids =
+          IsUrlColumn(column) ? url_ids : string_ids;
+      DatabaseStringTable::StringIdMap::const_iterator id =
+          ids.find(serialized.values[column]);
+      DCHECK(id != ids.end());
+      matched_values.push_back(id->second);
     }
 
     // Search for a matching row for this action whose count can be
@@ -413,6 +469,10 @@ bool CountingPolicy::FlushDatabase(sql::Connection* db) {
   if (!transaction.Commit())
     return false;
 
+  UMA_HISTOGRAM_TIMES("ExtensionActivity.CountingPolicy.FlushTime",
+                      base::TimeTicks::Now() - flush_start_time);
+  UMA_HISTOGRAM_COUNTS("ExtensionActivity.CountingPolicy.FlushedActions",
+                       static_cast<int>(queue.size()));
   return true;
 }
 
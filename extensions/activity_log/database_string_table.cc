@@ -4,6 +4,8 @@
 
 #include "chrome/browser/extensions/activity_log/database_string_table.h"
 
+#include <algorithm>
+
 #include "base/strings/stringprintf.h"
 #include "sql/connection.h"
 #include "sql/statement.h"
@@ -12,12 +14,19 @@ using base::StringPrintf;
 
 namespace extensions {
 
-// A target maximum size (in number of entries) for the mapping tables.  If the
-// cache would grow larger than this, the size should be reduced.
+// The maximum size (in number of entries) for the mapping tables.  If the
+// cache would grow larger than this, the least recently used entries are
+// evicted.
 static const size_t kMaximumCacheSize = 1000;
 
+// The number of strings looked up by a single SELECT in StringsToInts.  This
+// is kept well below SQLite's limit on the number of bound parameters.
+static const size_t kLookupBatchSize = 100;
+
 DatabaseStringTable::DatabaseStringTable(const std::string& table)
-    : table_(table) {}
+    : id_to_value_(kMaximumCacheSize),
+      value_to_id_(kMaximumCacheSize),
+      table_(table) {}
 
 DatabaseStringTable::~DatabaseStringTable() {}
 
@@ -37,17 +46,13 @@ bool DatabaseStringTable::Initialize(sql::Connection* connection) {
 bool DatabaseStringTable::StringToInt(sql::Connection* connection,
                                       const std::string& value,
                                       int64* id) {
-  std::map<std::string, int64>::const_iterator lookup =
-      value_to_id_.find(value);
+  base::HashingMRUCache<std::string, int64>::iterator lookup =
+      value_to_id_.Get(value);
   if (lookup != value_to_id_.end()) {
     *id = lookup->second;
     return true;
   }
 
-  // We will be adding data to the cache below--check the cache size now and
-  // reduce it if needed.
-  PruneCache();
-
   // Operate on the assumption that the cache does a good job on
   // frequently-used strings--if there is a cache miss, first act on the
   // assumption that the string is not in the database either.
@@ -60,8 +65,7 @@ bool DatabaseStringTable::StringToInt(sql::Connection* connection,
 
   if (connection->GetLastChangeCount() == 1) {
     *id = connection->GetLastInsertRowId();
-    id_to_value_[*id] = value;
-    value_to_id_[value] = *id;
+    AddToCache(*id, value);
     return true;
   }
 
@@ -75,25 +79,79 @@ bool DatabaseStringTable::StringToInt(sql::Connection* connection,
   if (!query.Step())
     return false;
   *id = query.ColumnInt64(0);
-  id_to_value_[*id] = value;
-  value_to_id_[value] = *id;
+  AddToCache(*id, value);
+  return true;
+}
+
+bool DatabaseStringTable::StringsToInts(sql::Connection* connection,
+                                        const std::vector<std::string>& values,
+                                        StringIdMap* ids) {
+  std::vector<std::string> misses;
+  base::hash_set<std::string> seen_misses;
+  for (size_t i = 0; i < values.size(); ++i) {
+    const std::string& value = values[i];
+    if (ids->find(value) != ids->end())
+      continue;
+    base::HashingMRUCache<std::string, int64>::iterator lookup =
+        value_to_id_.Get(value);
+    if (lookup != value_to_id_.end())
+      (*ids)[value] = lookup->second;
+    else if (seen_misses.insert(value).second)
+      misses.push_back(value);
+  }
+  if (misses.empty())
+    return true;
+
+  // Look up the strings which are already stored in the database, several at
+  // a time.
+  for (size_t start = 0; start < misses.size(); start += kLookupBatchSize) {
+    size_t end = std::min(misses.size(), start + kLookupBatchSize);
+    std::string sql = StringPrintf("SELECT id, value FROM %s WHERE value IN (",
+                                   table_.c_str());
+    for (size_t i = start; i < end; ++i)
+      sql += (i == start) ? "?" : ", ?";
+    sql += ")";
+    sql::Statement query(connection->GetUniqueStatement(sql.c_str()));
+    for (size_t i = start; i < end; ++i)
+      query.BindString(i - start, misses[i]);
+    while (query.Step()) {
+      int64 id = query.ColumnInt64(0);
+      std::string value = query.ColumnString(1);
+      AddToCache(id, value);
+      (*ids)[value] = id;
+    }
+    if (!query.Succeeded())
+      return false;
+  }
+
+  // Insert the remaining strings, reusing a single prepared statement.
+  sql::Statement insert(connection->GetUniqueStatement(
+      StringPrintf("INSERT INTO %s(value) VALUES (?)", table_.c_str())
+          .c_str()));
+  for (size_t i = 0; i < misses.size(); ++i) {
+    if (ids->find(misses[i]) != ids->end())
+      continue;
+    insert.Reset(true);
+    insert.BindString(0, misses[i]);
+    if (!insert.Run())
+      return false;
+    int64 id = connection->GetLastInsertRowId();
+    AddToCache(id, misses[i]);
+    (*ids)[misses[i]] = id;
+  }
   return true;
 }
 
 bool DatabaseStringTable::IntToString(sql::Connection* connection,
                                       int64 id,
                                       std::string* value) {
-  std::map<int64, std::string>::const_iterator lookup =
-      id_to_value_.find(id);
+  base::HashingMRUCache<int64, std::string>::iterator lookup =
+      id_to_value_.Get(id);
   if (lookup != id_to_value_.end()) {
     *value = lookup->second;
     return true;
   }
 
-  // We will be adding data to the cache below--check the cache size now and
-  // reduce it if needed.
-  PruneCache();
-
   sql::Statement query(connection->GetUniqueStatement(
       StringPrintf("SELECT value FROM %s WHERE id = ?", table_.c_str())
           .c_str()));
@@ -102,26 +160,18 @@ bool DatabaseStringTable::IntToString(sql::Connection* connection,
     return false;
 
   *value = query.ColumnString(0);
-  id_to_value_[id] = *value;
-  value_to_id_[*value] = id;
+  AddToCache(id, *value);
   return true;
 }
 
 void DatabaseStringTable::ClearCache() {
-  id_to_value_.clear();
-  value_to_id_.clear();
+  id_to_value_.Clear();
+  value_to_id_.Clear();
 }
 
-void DatabaseStringTable::PruneCache() {
-  if (id_to_value_.size() <= kMaximumCacheSize &&
-      value_to_id_.size() <= kMaximumCacheSize)
-    return;
-
-  // TODO(mvrable): Perhaps implement a more intelligent caching policy.  For
-  // now, to limit memory usage we simply clear the entire cache when it would
-  // become too large.  Data will be brought back in from the database as
-  // needed.
-  ClearCache();
+void DatabaseStringTable::AddToCache(int64 id, const std::string& value) {
+  id_to_value_.Put(id, value);
+  value_to_id_.Put(value, id);
 }
 
 }  // namespace extensions
@@ -5,10 +5,12 @@
 #ifndef CHROME_BROWSER_EXTENSIONS_ACTIVITY_LOG_DATABASE_STRING_TABLE_H_
 #define CHROME_BROWSER_EXTENSIONS_ACTIVITY_LOG_DATABASE_STRING_TABLE_H_
 
-#include <map>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/containers/mru_cache.h"
 #include "base/gtest_prod_util.h"
 
 namespace sql {
@@ -22,7 +24,7 @@ namespace extensions {
 // disk by replacing repeated strings by smaller integers.
 //
 // The mapping from integers to strings is maintained in a database table, but
-// the mapping is also cached in memory.
+// the most recently used part of the mapping is also cached in memory.
 //
 // The database table used to store the strings is configurable, but its layout
 // is fixed: it always consists of just two columns, "id" and "value".
@@ -30,6 +32,8 @@ namespace extensions {
 // All calls to DatabaseStringTable must occur on the database thread.
 class DatabaseStringTable {
  public:
+  typedef base::hash_map<std::string, int64> StringIdMap;
+
   explicit DatabaseStringTable(const std::string& table);
 
   ~DatabaseStringTable();
@@ -46,6 +50,16 @@ class DatabaseStringTable {
                    const std::string& value,
                    int64* id);
 
+  // Interns every string in |values| and adds the corresponding integers to
+  // *ids, keyed by string.  Strings missing from the cache are looked up and
+  // inserted with a handful of prepared statements instead of one round of
+  // statements per string, so this should be preferred when many strings are
+  // interned within one transaction.  Returns true on success and false on
+  // database error.
+  bool StringsToInts(sql::Connection* connection,
+                     const std::vector<std::string>& values,
+                     StringIdMap* ids);
+
   // Looks up an integer value and converts it to a string (which is stored in
   // *value).  Returns true on success.  A false return does not necessarily
   // indicate a database error; it might simply be that the value cannot be
@@ -57,17 +71,19 @@ class DatabaseStringTable {
   void ClearCache();
 
  private:
-  // Reduces the size of the cache if too many entries are held in it.
-  void PruneCache();
+  // Records a mapping in the in-memory caches.  The least recently used
+  // entries are evicted once the caches are full.
+  void AddToCache(int64 id, const std::string& value);
 
   // In-memory caches of recently accessed values.
-  std::map<int64, std::string> id_to_value_;
-  std::map<std::string, int64> value_to_id_;
+  base::HashingMRUCache<int64, std::string> id_to_value_;
+  base::HashingMRUCache<std::string, int64> value_to_id_;
 
   // The name of the database table where the mapping is stored.
   std::string table_;
 
   FRIEND_TEST_ALL_PREFIXES(DatabaseStringTableTest, Prune);
+  FRIEND_TEST_ALL_PREFIXES(DatabaseStringTableTest, PruneKeepsRecentlyUsed);
 
   DISALLOW_COPY_AND_ASSIGN(DatabaseStringTable);
 };
@@ -156,4 +156,70 @@ TEST_F(DatabaseStringTableTest, Prune) {
   ASSERT_LE(table.value_to_id_.size(), 1005U);
 }
 
+// Check that pruning evicts the least recently used strings, so that a string
+// which is used frequently stays cached.
+TEST_F(DatabaseStringTableTest, PruneKeepsRecentlyUsed) {
+  DatabaseStringTable table("size_test");
+  table.Initialize(&db_);
+
+  sql::Transaction transaction(&db_);
+  transaction.Begin();
+  int64 hot_id;
+  ASSERT_TRUE(table.StringToInt(&db_, "hot", &hot_id));
+  for (int i = 0; i < 2000; i++) {
+    int64 id;
+    ASSERT_TRUE(table.StringToInt(&db_, base::StringPrintf("value-%d", i),
+                                  &id));
+    if (i % 100 == 0) {
+      ASSERT_TRUE(table.StringToInt(&db_, "hot", &id));
+      ASSERT_EQ(hot_id, id);
+    }
+  }
+  transaction.Commit();
+
+  EXPECT_TRUE(table.value_to_id_.Peek("hot") != table.value_to_id_.end());
+  EXPECT_TRUE(table.value_to_id_.Peek("value-0") == table.value_to_id_.end());
+  EXPECT_TRUE(table.value_to_id_.Peek("value-1999") !=
+              table.value_to_id_.end());
+}
+
+// Check that batched interning agrees with interning strings one at a time,
+// for strings that are cached, only stored in the database, or new.
+TEST_F(DatabaseStringTableTest, InsertBatch) {
+  DatabaseStringTable table("test");
+  table.Initialize(&db_);
+
+  int64 stored_id;
+  ASSERT_TRUE(table.StringToInt(&db_, "stored", &stored_id));
+  table.ClearCache();
+  int64 cached_id;
+  ASSERT_TRUE(table.StringToInt(&db_, "cached", &cached_id));
+
+  std::vector<std::string> values;
+  values.push_back("stored");
+  values.push_back("cached");
+  values.push_back("new");
+  values.push_back("new");
+  for (int i = 0; i < 250; i++)
+    values.push_back(base::StringPrintf("batch-%d", i));
+
+  sql::Transaction transaction(&db_);
+  transaction.Begin();
+  DatabaseStringTable::StringIdMap ids;
+  ASSERT_TRUE(table.StringsToInts(&db_, values, &ids));
+  transaction.Commit();
+
+  ASSERT_EQ(253U, ids.size());
+  EXPECT_EQ(stored_id, ids["stored"]);
+  EXPECT_EQ(cached_id, ids["cached"]);
+  EXPECT_NE(ids["new"], ids["batch-0"]);
+
+  table.ClearCache();
+  for (size_t i = 0; i < values.size(); i++) {
+    int64 id;
+    ASSERT_TRUE(table.StringToInt(&db_, values[i], &id));
+    EXPECT_EQ(ids[values[i]], id) << values[i];
+  }
+}
+
 }  // namespace extensions
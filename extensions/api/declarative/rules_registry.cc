@@ -254,7 +254,10 @@ void RulesRegistry::DeserializeAndAddRules(
     scoped_ptr<base::Value> rules) {
   DCHECK_CURRENTLY_ON(owner_thread());
 
+  base::TimeTicks start = base::TimeTicks::Now();
   AddRulesNoFill(extension_id, RulesFromValue(rules.get()));
+  UMA_HISTOGRAM_TIMES("Extensions.DeclarativeRulesDeserializeAndAdd",
+                      base::TimeTicks::Now() - start);
 }
 
 RulesRegistry::~RulesRegistry() {
@@ -4,6 +4,7 @@
 
 #include "chrome/browser/extensions/api/declarative_content/content_rules_registry.h"
 
+#include "base/metrics/histogram.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/extensions/api/declarative_content/content_action.h"
 #include "chrome/browser/extensions/api/declarative_content/content_condition.h"
@@ -67,6 +68,7 @@ void ContentRulesRegistry::Apply(
     const std::vector<std::string>& matching_css_selectors) {
   const int tab_id = ExtensionTabUtil::GetTabId(contents);
   RendererContentMatchData renderer_data;
+  UpdateURLMatcher();
   renderer_data.page_url_matches = url_matcher_.MatchURL(contents->GetURL());
   renderer_data.css_selectors.insert(matching_css_selectors.begin(),
                                      matching_css_selectors.end());
@@ -167,6 +169,7 @@ std::string ContentRulesRegistry::AddRulesImpl(
                             &error));
     if (!error.empty()) {
       // Clean up temporary condition sets created during rule creation.
+      UpdateURLMatcher();
       url_matcher_.ClearUnusedConditionSets();
       return error;
     }
@@ -190,13 +193,12 @@ std::string ContentRulesRegistry::AddRulesImpl(
     }
   }
 
-  // Register url patterns in url_matcher_.
-  URLMatcherConditionSet::Vector all_new_condition_sets;
+  // Register url patterns in url_matcher_ when it is used next.
   for (RulesMap::iterator i = new_content_rules.begin();
        i != new_content_rules.end(); ++i) {
-    i->second->conditions().GetURLMatcherConditionSets(&all_new_condition_sets);
+    i->second->conditions().GetURLMatcherConditionSets(
+        &pending_condition_sets_);
   }
-  url_matcher_.AddConditionSets(all_new_condition_sets);
 
   UpdateConditionCache();
 
@@ -251,6 +253,7 @@ std::string ContentRulesRegistry::RemoveRulesImpl(
   }
 
   // Clear URLMatcher based on condition_set_ids that are not needed any more.
+  UpdateURLMatcher();
   url_matcher_.RemoveConditionSets(remove_from_url_matcher);
 
   UpdateConditionCache();
@@ -302,6 +305,17 @@ void ContentRulesRegistry::UpdateConditionCache() {
   }
 }
 
+void ContentRulesRegistry::UpdateURLMatcher() {
+  if (pending_condition_sets_.empty())
+    return;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  url_matcher_.AddConditionSets(pending_condition_sets_);
+  pending_condition_sets_.clear();
+  UMA_HISTOGRAM_TIMES("Extensions.DeclarativeContentURLMatcherUpdate",
+                      base::TimeTicks::Now() - start);
+}
+
 void ContentRulesRegistry::InstructRenderProcess(
     content::RenderProcessHost* process) {
   process->Send(new ExtensionMsg_WatchPages(watched_css_selectors_));
@@ -309,7 +323,7 @@ void ContentRulesRegistry::InstructRenderProcess(
 
 bool ContentRulesRegistry::IsEmpty() const {
   return match_id_to_rule_.empty() && content_rules_.empty() &&
-      url_matcher_.IsEmpty();
+      pending_condition_sets_.empty() && url_matcher_.IsEmpty();
 }
 
 ContentRulesRegistry::~ContentRulesRegistry() {}
@@ -116,6 +116,11 @@ class ContentRulesRegistry : public RulesRegistry,
   // ExtensionMsg_WatchPages.
   void InstructRenderProcess(content::RenderProcessHost* process);
 
+  // Adds |pending_condition_sets_| to |url_matcher_|, so that the condition
+  // sets of all rules restored from storage at startup are compiled into the
+  // matcher at once when a page is matched first.
+  void UpdateURLMatcher();
+
   typedef std::map<url_matcher::URLMatcherConditionSet::ID, ContentRule*>
       URLMatcherIdToRule;
   typedef std::map<ContentRule::GlobalRuleId, linked_ptr<ContentRule> >
@@ -134,6 +139,11 @@ class ContentRulesRegistry : public RulesRegistry,
   // Matches URLs for the page_url condition.
   url_matcher::URLMatcher url_matcher_;
 
+  // Condition sets of registered rules that are not in |url_matcher_| yet.
+  // They need to be added before |url_matcher_| is changed otherwise, or its
+  // condition factory forgets their patterns.
+  url_matcher::URLMatcherConditionSet::Vector pending_condition_sets_;
+
   // All CSS selectors any rule's conditions watch for.
   std::vector<std::string> watched_css_selectors_;
 
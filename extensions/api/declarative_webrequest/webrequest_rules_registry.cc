@@ -9,6 +9,7 @@
 #include <utility>
 
 #include "base/bind.h"
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
 #include "chrome/browser/extensions/api/declarative_webrequest/webrequest_condition.h"
 #include "chrome/browser/extensions/api/declarative_webrequest/webrequest_constants.h"
@@ -55,6 +56,8 @@ std::set<const WebRequestRule*> WebRequestRulesRegistry::GetMatches(
     const WebRequestData& request_data_without_ids) const {
   RuleSet result;
 
+  UpdateURLMatcher();
+
   WebRequestDataWithMatchIds request_data(&request_data_without_ids);
   request_data.url_match_ids = url_matcher_.MatchURL(
       request_data.data->request->url());
@@ -197,6 +200,7 @@ std::string WebRequestRulesRegistry::AddRulesImpl(
 
   if (!error.empty()) {
     // Clean up temporary condition sets created during rule creation.
+    UpdateURLMatcher();
     url_matcher_.ClearUnusedConditionSets();
     return error;
   }
@@ -218,15 +222,15 @@ std::string WebRequestRulesRegistry::AddRulesImpl(
   }
 
   // Register url patterns in |url_matcher_| and
-  // |rules_with_untriggered_conditions_|.
-  URLMatcherConditionSet::Vector all_new_condition_sets;
+  // |rules_with_untriggered_conditions_|. The patterns are added to the
+  // matcher when it is used next.
   for (RulesVector::const_iterator i = new_webrequest_rules.begin();
        i != new_webrequest_rules.end(); ++i) {
-    i->second->conditions().GetURLMatcherConditionSets(&all_new_condition_sets);
+    i->second->conditions().GetURLMatcherConditionSets(
+        &pending_condition_sets_);
     if (i->second->conditions().HasConditionsWithoutUrls())
       rules_with_untriggered_conditions_.insert(i->second.get());
   }
-  url_matcher_.AddConditionSets(all_new_condition_sets);
 
   ClearCacheOnNavigation();
 
@@ -265,6 +269,7 @@ std::string WebRequestRulesRegistry::RemoveRulesImpl(
     webrequest_rules_.erase(extension_id);
 
   // Clear URLMatcher based on condition_set_ids that are not needed any more.
+  UpdateURLMatcher();
   url_matcher_.RemoveConditionSets(remove_from_url_matcher);
 
   ClearCacheOnNavigation();
@@ -282,6 +287,7 @@ std::string WebRequestRulesRegistry::RemoveAllRulesImpl(
        ++it) {
     CleanUpAfterRule(it->second.get(), &remove_from_url_matcher);
   }
+  UpdateURLMatcher();
   url_matcher_.RemoveConditionSets(remove_from_url_matcher);
 
   webrequest_rules_.erase(extension_id);
@@ -307,6 +313,8 @@ bool WebRequestRulesRegistry::IsEmpty() const {
   // Easy first.
   if (!rule_triggers_.empty() && url_matcher_.IsEmpty())
     return false;
+  if (!pending_condition_sets_.empty())
+    return false;
 
   // Now all the registered rules for each extensions.
   for (std::map<WebRequestRule::ExtensionId, RulesMap>::const_iterator it =
@@ -321,6 +329,17 @@ bool WebRequestRulesRegistry::IsEmpty() const {
 
 WebRequestRulesRegistry::~WebRequestRulesRegistry() {}
 
+void WebRequestRulesRegistry::UpdateURLMatcher() const {
+  if (pending_condition_sets_.empty())
+    return;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  url_matcher_.AddConditionSets(pending_condition_sets_);
+  pending_condition_sets_.clear();
+  UMA_HISTOGRAM_TIMES("Extensions.DeclarativeWebRequestURLMatcherUpdate",
+                      base::TimeTicks::Now() - start);
+}
+
 base::Time WebRequestRulesRegistry::GetExtensionInstallationTime(
     const std::string& extension_id) const {
   return extension_info_map_->GetInstallTime(extension_id);
@@ -170,6 +170,12 @@ class WebRequestRulesRegistry : public RulesRegistry {
                          const WebRequestCondition::MatchData& request_data,
                          RuleSet* result) const;
 
+  // Adds |pending_condition_sets_| to |url_matcher_|. Every change to the
+  // URLMatcher rebuilds its substring matcher over all patterns, so the
+  // condition sets of rules restored from storage at startup are compiled in
+  // one go when the first request is matched instead of once per extension.
+  void UpdateURLMatcher() const;
+
   // Map that tells us which WebRequestRule may match under the condition that
   // the URLMatcherConditionSet::ID was returned by the |url_matcher_|.
   RuleTriggers rule_triggers_;
@@ -181,7 +187,14 @@ class WebRequestRulesRegistry : public RulesRegistry {
 
   std::map<WebRequestRule::ExtensionId, RulesMap> webrequest_rules_;
 
-  url_matcher::URLMatcher url_matcher_;
+  // Lazily updated from |pending_condition_sets_| by UpdateURLMatcher().
+  mutable url_matcher::URLMatcher url_matcher_;
+
+  // Condition sets of registered rules that are not in |url_matcher_| yet.
+  // These must be added before |url_matcher_| is changed in any other way,
+  // because that makes its condition factory forget the patterns which no
+  // condition set in the matcher uses.
+  mutable url_matcher::URLMatcherConditionSet::Vector pending_condition_sets_;
 
   void* profile_id_;
   scoped_refptr<InfoMap> extension_info_map_;
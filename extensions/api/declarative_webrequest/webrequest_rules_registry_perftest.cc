@@ -0,0 +1,152 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/api/declarative_webrequest/webrequest_rules_registry.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/linked_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/extensions/api/declarative_webrequest/webrequest_constants.h"
+#include "chrome/common/extensions/extension_test_util.h"
+#include "components/url_matcher/url_matcher_constants.h"
+#include "content/public/test/test_browser_thread.h"
+#include "net/base/request_priority.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using extension_test_util::LoadManifestUnchecked;
+
+namespace extensions {
+
+namespace keys = declarative_webrequest_constants;
+namespace keys2 = url_matcher::url_matcher_constants;
+
+namespace {
+
+const char kExtensionId[] = "ext1";
+const int kNumRules = 500;
+
+class TestWebRequestRulesRegistry : public WebRequestRulesRegistry {
+ public:
+  explicit TestWebRequestRulesRegistry(
+      scoped_refptr<InfoMap> extension_info_map)
+      : WebRequestRulesRegistry(NULL /*profile*/,
+                                NULL /* cache_delegate */,
+                                WebViewKey(0, 0)) {
+    SetExtensionInfoMapForTesting(extension_info_map);
+  }
+
+ protected:
+  virtual ~TestWebRequestRulesRegistry() {}
+
+  virtual void ClearCacheOnNavigation() OVERRIDE {}
+};
+
+// Returns rules that each cancel the requests to one of |kNumRules| hosts.
+std::vector<std::vector<linked_ptr<RulesRegistry::Rule> > > CreateRules() {
+  std::vector<std::vector<linked_ptr<RulesRegistry::Rule> > > rules(
+      kNumRules);
+  for (int i = 0; i < kNumRules; ++i) {
+    base::DictionaryValue* url_dict = new base::DictionaryValue();
+    url_dict->SetString(keys2::kHostSuffixKey,
+                        base::StringPrintf("host%d.com", i));
+    base::DictionaryValue condition_dict;
+    condition_dict.SetString(keys::kInstanceTypeKey, keys::kRequestMatcherType);
+    condition_dict.Set(keys::kUrlKey, url_dict);
+
+    base::DictionaryValue action_dict;
+    action_dict.SetString(keys::kInstanceTypeKey, keys::kCancelRequestType);
+
+    linked_ptr<RulesRegistry::Rule> rule(new RulesRegistry::Rule);
+    rule->id.reset(new std::string(base::StringPrintf("rule%d", i)));
+    rule->priority.reset(new int(1));
+    rule->actions.push_back(linked_ptr<base::Value>(action_dict.DeepCopy()));
+    rule->conditions.push_back(
+        linked_ptr<base::Value>(condition_dict.DeepCopy()));
+    rules[i].push_back(rule);
+  }
+  return rules;
+}
+
+}  // namespace
+
+class WebRequestRulesRegistryPerfTest : public testing::Test {
+ public:
+  WebRequestRulesRegistryPerfTest()
+      : ui_(content::BrowserThread::UI, &message_loop_),
+        io_(content::BrowserThread::IO, &message_loop_) {}
+
+  virtual void SetUp() OVERRIDE {
+    std::string error;
+    scoped_refptr<Extension> extension = LoadManifestUnchecked(
+        "permissions",
+        "web_request_all_host_permissions.json",
+        Manifest::INVALID_LOCATION,
+        Extension::NO_FLAGS,
+        kExtensionId,
+        &error);
+    ASSERT_TRUE(extension.get()) << error;
+    extension_info_map_ = new InfoMap;
+    extension_info_map_->AddExtension(extension.get(),
+                                      base::Time(),
+                                      false /*incognito_enabled*/,
+                                      false /*notifications_disabled*/);
+  }
+
+  virtual void TearDown() OVERRIDE {
+    // Make sure that deletion traits of all registries are executed.
+    message_loop_.RunUntilIdle();
+  }
+
+ protected:
+  base::MessageLoopForIO message_loop_;
+  content::TestBrowserThread ui_;
+  content::TestBrowserThread io_;
+  scoped_refptr<InfoMap> extension_info_map_;
+};
+
+// Measures adding rules one call at a time, like restoring the rules of many
+// extensions at startup, with the URLMatcher updated once before the first
+// match and with a match, and so an update, after every call.
+TEST_F(WebRequestRulesRegistryPerfTest, AddManyRulesBeforeFirstMatch) {
+  net::TestURLRequestContext context;
+  net::TestURLRequest request(
+      GURL("http://www.host0.com"), net::DEFAULT_PRIORITY, NULL, &context);
+  WebRequestData request_data(&request, ON_BEFORE_REQUEST);
+
+  scoped_refptr<TestWebRequestRulesRegistry> lazy_registry(
+      new TestWebRequestRulesRegistry(extension_info_map_));
+  std::vector<std::vector<linked_ptr<RulesRegistry::Rule> > > lazy_rules =
+      CreateRules();
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumRules; ++i)
+    EXPECT_EQ("", lazy_registry->AddRules(kExtensionId, lazy_rules[i]));
+  EXPECT_EQ(1u, lazy_registry->GetMatches(request_data).size());
+  base::TimeDelta lazy_time = base::TimeTicks::Now() - start;
+
+  scoped_refptr<TestWebRequestRulesRegistry> eager_registry(
+      new TestWebRequestRulesRegistry(extension_info_map_));
+  std::vector<std::vector<linked_ptr<RulesRegistry::Rule> > > eager_rules =
+      CreateRules();
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumRules; ++i) {
+    EXPECT_EQ("", eager_registry->AddRules(kExtensionId, eager_rules[i]));
+    eager_registry->GetMatches(request_data);
+  }
+  EXPECT_EQ(1u, eager_registry->GetMatches(request_data).size());
+  base::TimeDelta eager_time = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("webrequest_rules_add", "", "one_update",
+                         lazy_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("webrequest_rules_add", "", "update_per_call",
+                         eager_time.InMillisecondsF(), "ms", false);
+}
+
+}  // namespace extensions
@@ -665,6 +665,41 @@ TEST_F(WebRequestRulesRegistryTest, GetMatchesDifferentUrls) {
   }
 }
 
+// Test that rules which were added and removed before the URLMatcher was
+// updated for them don't leave anything behind.
+TEST_F(WebRequestRulesRegistryTest, RemoveRulesBeforeFirstMatch) {
+  scoped_refptr<TestWebRequestRulesRegistry> registry(
+      new TestWebRequestRulesRegistry(extension_info_map_));
+  const std::string kUrlAttribute(
+      "\"url\": { \"hostContains\": \"url\" }, \n");
+  std::vector<const std::string*> attributes;
+  attributes.push_back(&kUrlAttribute);
+
+  std::vector<linked_ptr<RulesRegistry::Rule> > rules(1);
+  rules[0] = CreateRule1();
+  EXPECT_EQ("", registry->AddRules(kExtensionId, rules));
+  rules[0] = CreateCancellingRule(kRuleId3, attributes);
+  EXPECT_EQ("", registry->AddRules(kExtensionId2, rules));
+  EXPECT_EQ("", registry->RemoveAllRules(kExtensionId));
+
+  net::TestURLRequestContext context;
+  net::TestURLRequest example_request(
+      GURL("http://www.example.com"), net::DEFAULT_PRIORITY, NULL, &context);
+  WebRequestData request_data(&example_request, ON_BEFORE_REQUEST);
+  EXPECT_TRUE(registry->GetMatches(request_data).empty());
+
+  net::TestURLRequest url_request(
+      GURL("http://url.example.com"), net::DEFAULT_PRIORITY, NULL, &context);
+  request_data.request = &url_request;
+  std::set<const WebRequestRule*> matches = registry->GetMatches(request_data);
+  ASSERT_EQ(1u, matches.size());
+  EXPECT_EQ(WebRequestRule::GlobalRuleId(kExtensionId2, kRuleId3),
+            (*matches.begin())->id());
+
+  EXPECT_EQ("", registry->RemoveAllRules(kExtensionId2));
+  EXPECT_TRUE(registry->IsEmpty());
+}
+
 TEST(WebRequestRulesRegistrySimpleTest, StageChecker) {
   // The contentType condition can only be evaluated during ON_HEADERS_RECEIVED
   // but the SetRequestHeader action can only be executed during
@@ -30,6 +30,7 @@
 #include "chrome/browser/download/download_file_icon_extractor.h"
 #include "chrome/browser/download/download_prefs.h"
 #include "chrome/browser/download/download_query.h"
+#include "chrome/browser/download/download_query_index.h"
 #include "chrome/browser/download/download_service.h"
 #include "chrome/browser/download/download_service_factory.h"
 #include "chrome/browser/download/download_shelf.h"
@@ -540,20 +541,26 @@ void RunDownloadQuery(
     }
   }
 
-  DownloadQuery::DownloadVector all_items;
+  query_out.AddFilter(base::Bind(&IsNotTemporaryDownloadFilter));
   if (query_in.id.get()) {
+    DownloadQuery::DownloadVector all_items;
     DownloadItem* download_item = manager->GetDownload(*query_in.id.get());
     if (!download_item && incognito_manager)
       download_item = incognito_manager->GetDownload(*query_in.id.get());
     if (download_item)
       all_items.push_back(download_item);
-  } else {
-    manager->GetAllDownloads(&all_items);
-    if (incognito_manager)
-      incognito_manager->GetAllDownloads(&all_items);
+    query_out.Search(all_items.begin(), all_items.end(), results);
+    return;
   }
-  query_out.AddFilter(base::Bind(&IsNotTemporaryDownloadFilter));
-  query_out.Search(all_items.begin(), all_items.end(), results);
+  // Search the indexes of the downloads rather than every download.
+  std::vector<const DownloadQueryIndex*> indexes;
+  indexes.push_back(DownloadServiceFactory::GetForBrowserContext(
+      manager->GetBrowserContext())->GetDownloadQueryIndex());
+  if (incognito_manager) {
+    indexes.push_back(DownloadServiceFactory::GetForBrowserContext(
+        incognito_manager->GetBrowserContext())->GetDownloadQueryIndex());
+  }
+  query_out.Search(indexes, results);
 }
 
 DownloadPathReservationTracker::FilenameConflictAction ConvertConflictAction(
@@ -17,7 +17,9 @@ namespace image_writer {
 
 using content::BrowserThread;
 
-const int kMD5BufferSize = 1024;
+// Large reads keep the number of FILE thread tasks needed to hash a
+// multi-gigabyte image low.
+const int kMD5BufferSize = 1024 * 1024;
 #if defined(OS_CHROMEOS)
 // Chrome OS only has a 1 GB temporary partition.  This is too small to hold our
 // unzipped image. Fortunately we mount part of the temporary partition under
@@ -292,6 +294,8 @@ void Operation::GetMD5SumOfFile(
   }
 
   base::MD5Init(&md5_context_);
+  if (!md5_buffer_)
+    md5_buffer_.reset(new char[kMD5BufferSize]);
 
   base::File file(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ);
   if (!file.IsValid()) {
@@ -331,7 +335,6 @@ void Operation::MD5Chunk(
 
   CHECK_LE(bytes_processed, bytes_total);
 
-  scoped_ptr<char[]> buffer(new char[kMD5BufferSize]);
   int read_size = std::min(bytes_total - bytes_processed,
                            static_cast<int64>(kMD5BufferSize));
 
@@ -341,11 +344,12 @@ void Operation::MD5Chunk(
     base::MD5Final(&digest, &md5_context_);
     callback.Run(base::MD5DigestToBase16(digest));
   } else {
-    int len = file.Read(bytes_processed, buffer.get(), read_size);
+    int len = file.Read(bytes_processed, md5_buffer_.get(), read_size);
 
     if (len == read_size) {
       // Process data.
-      base::MD5Update(&md5_context_, base::StringPiece(buffer.get(), len));
+      base::MD5Update(&md5_context_,
+                      base::StringPiece(md5_buffer_.get(), len));
       int percent_curr =
           ((bytes_processed + len) * progress_scale) / bytes_total +
           progress_offset;
@@ -10,6 +10,7 @@
 #include "base/files/scoped_temp_dir.h"
 #include "base/md5.h"
 #include "base/memory/ref_counted_memory.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/task/cancelable_task_tracker.h"
 #include "base/timer/timer.h"
@@ -207,6 +208,8 @@ class Operation : public base::RefCountedThreadSafe<Operation> {
   // MD5 contexts don't play well with smart pointers.  Just going to allocate
   // memory here.  This requires that we only do one MD5 sum at a time.
   base::MD5Context md5_context_;
+  // Buffer that files being hashed are read into, reused for every chunk.
+  scoped_ptr<char[]> md5_buffer_;
 
   // Zip reader for unzip operations.
   zip::ZipReader zip_reader_;
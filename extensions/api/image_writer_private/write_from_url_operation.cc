@@ -3,17 +3,92 @@
 // found in the LICENSE file.
 
 #include "base/file_util.h"
+#include "base/md5.h"
 #include "chrome/browser/extensions/api/image_writer_private/error_messages.h"
 #include "chrome/browser/extensions/api/image_writer_private/operation_manager.h"
 #include "chrome/browser/extensions/api/image_writer_private/write_from_url_operation.h"
 #include "content/public/browser/browser_thread.h"
+#include "net/base/io_buffer.h"
 #include "net/url_request/url_fetcher.h"
+#include "net/url_request/url_fetcher_response_writer.h"
 
 namespace extensions {
 namespace image_writer {
 
 using content::BrowserThread;
 
+namespace {
+
+// Saves the response to a file like net::URLFetcherFileWriter, and computes
+// the MD5 sum of the response as it is written, so that the download doesn't
+// have to be read back to be verified.  The sum is passed to |hash_callback|
+// on the FILE thread once the response is complete.
+class HashingFileWriter : public net::URLFetcherResponseWriter {
+ public:
+  HashingFileWriter(
+      const base::FilePath& file_path,
+      const base::Callback<void(const std::string&)>& hash_callback)
+      : file_writer_(
+            BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE),
+            file_path),
+        hash_callback_(hash_callback) {}
+  virtual ~HashingFileWriter() {}
+
+  // net::URLFetcherResponseWriter implementation.
+  virtual int Initialize(const net::CompletionCallback& callback) OVERRIDE {
+    base::MD5Init(&md5_context_);
+    return file_writer_.Initialize(callback);
+  }
+
+  virtual int Write(net::IOBuffer* buffer,
+                    int num_bytes,
+                    const net::CompletionCallback& callback) OVERRIDE {
+    // |file_writer_| doesn't run the callback once it is destroyed.
+    int result = file_writer_.Write(
+        buffer,
+        num_bytes,
+        base::Bind(&HashingFileWriter::DidWrite,
+                   base::Unretained(this),
+                   make_scoped_refptr(buffer),
+                   callback));
+    if (result > 0)
+      Hash(buffer, result);
+    return result;
+  }
+
+  virtual int Finish(const net::CompletionCallback& callback) OVERRIDE {
+    base::MD5Digest digest;
+    base::MD5Final(&digest, &md5_context_);
+    BrowserThread::PostTask(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(hash_callback_, base::MD5DigestToBase16(digest)));
+    return file_writer_.Finish(callback);
+  }
+
+ private:
+  void DidWrite(scoped_refptr<net::IOBuffer> buffer,
+                const net::CompletionCallback& callback,
+                int result) {
+    if (result > 0)
+      Hash(buffer.get(), result);
+    callback.Run(result);
+  }
+
+  void Hash(net::IOBuffer* buffer, int num_bytes) {
+    base::MD5Update(&md5_context_,
+                    base::StringPiece(buffer->data(), num_bytes));
+  }
+
+  net::URLFetcherFileWriter file_writer_;
+  base::Callback<void(const std::string&)> hash_callback_;
+  base::MD5Context md5_context_;
+
+  DISALLOW_COPY_AND_ASSIGN(HashingFileWriter);
+};
+
+}  // namespace
+
 WriteFromUrlOperation::WriteFromUrlOperation(
     base::WeakPtr<OperationManager> manager,
     const ExtensionId& extension_id,
@@ -87,9 +162,11 @@ void WriteFromUrlOperation::Download(const base::Closure& continuation) {
   url_fetcher_.reset(net::URLFetcher::Create(url_, net::URLFetcher::GET, this));
 
   url_fetcher_->SetRequestContext(request_context_);
-  url_fetcher_->SaveResponseToFileAtPath(
-      image_path_,
-      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE));
+  download_hash_.clear();
+  url_fetcher_->SaveResponseWithWriter(
+      scoped_ptr<net::URLFetcherResponseWriter>(new HashingFileWriter(
+          image_path_,
+          base::Bind(&WriteFromUrlOperation::OnDownloadHashed, this))));
 
   AddCleanUpFunction(
       base::Bind(&WriteFromUrlOperation::DestroyUrlFetcher, this));
@@ -99,6 +176,11 @@ void WriteFromUrlOperation::Download(const base::Closure& continuation) {
 
 void WriteFromUrlOperation::DestroyUrlFetcher() { url_fetcher_.reset(); }
 
+void WriteFromUrlOperation::OnDownloadHashed(const std::string& hash) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+  download_hash_ = hash;
+}
+
 void WriteFromUrlOperation::OnURLFetchUploadProgress(
     const net::URLFetcher* source,
     int64 current,
@@ -151,6 +233,13 @@ void WriteFromUrlOperation::VerifyDownload(const base::Closure& continuation) {
 
   SetStage(image_writer_api::STAGE_VERIFYDOWNLOAD);
 
+  // Downloads are hashed as they are written, so the image only has to be
+  // read again if it was not downloaded by this operation.
+  if (!download_hash_.empty()) {
+    VerifyDownloadCompare(continuation, download_hash_);
+    return;
+  }
+
   GetMD5SumOfFile(
       image_path_,
       0,
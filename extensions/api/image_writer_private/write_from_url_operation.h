@@ -50,6 +50,9 @@ class WriteFromUrlOperation : public Operation, public net::URLFetcherDelegate {
   // and so we must first delete the URLFetcher on the FILE thread.
   void DestroyUrlFetcher();
 
+  // Receives the MD5 sum of the download, computed while it was written.
+  void OnDownloadHashed(const std::string& hash);
+
   // URLFetcherDelegate implementation.
   virtual void OnURLFetchComplete(const net::URLFetcher* source) OVERRIDE;
   virtual void OnURLFetchDownloadProgress(const net::URLFetcher* source,
@@ -71,6 +74,8 @@ class WriteFromUrlOperation : public Operation, public net::URLFetcherDelegate {
   // Local state
   scoped_ptr<net::URLFetcher> url_fetcher_;
   base::Closure download_continuation_;
+  // The MD5 sum of the download, once it is complete.
+  std::string download_hash_;
 };
 
 } // namespace image_writer
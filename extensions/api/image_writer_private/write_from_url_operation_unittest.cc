@@ -208,6 +208,51 @@ TEST_F(ImageWriterWriteFromUrlOperationTest, VerifyFile) {
   operation->Cancel();
 }
 
+TEST_F(ImageWriterWriteFromUrlOperationTest, VerifyDownloadWithoutRereading) {
+  scoped_ptr<char[]> data_buffer(new char[kTestFileSize]);
+  base::ReadFile(test_utils_.GetImagePath(), data_buffer.get(), kTestFileSize);
+  base::MD5Digest expected_digest;
+  base::MD5Sum(data_buffer.get(), kTestFileSize, &expected_digest);
+  std::string expected_hash = base::MD5DigestToBase16(expected_digest);
+
+  base::RunLoop runloop;
+  base::FilePath download_target_path;
+  scoped_refptr<OperationForTest> operation =
+      CreateOperation(GURL(kTestImageUrl), expected_hash);
+
+  EXPECT_TRUE(base::CreateTemporaryFileInDir(test_utils_.GetTempDir(),
+                                             &download_target_path));
+  operation->SetImagePath(download_target_path);
+
+  EXPECT_CALL(manager_, OnProgress(kDummyExtensionId, _, _))
+      .Times(AnyNumber());
+  EXPECT_CALL(manager_,
+              OnProgress(kDummyExtensionId,
+                         image_writer_api::STAGE_VERIFYDOWNLOAD,
+                         100)).Times(AtLeast(1));
+  EXPECT_CALL(manager_, OnError(kDummyExtensionId, _, _, _)).Times(0);
+
+  content::BrowserThread::PostTask(
+      content::BrowserThread::FILE,
+      FROM_HERE,
+      base::Bind(&OperationForTest::Download, operation,
+                 runloop.QuitClosure()));
+  runloop.Run();
+
+  // The download was hashed as it was written, so verifying it doesn't need
+  // the file.
+  EXPECT_TRUE(base::DeleteFile(operation->GetImagePath(), false));
+  content::BrowserThread::PostTask(content::BrowserThread::FILE,
+                                   FROM_HERE,
+                                   base::Bind(&OperationForTest::VerifyDownload,
+                                              operation,
+                                              base::Bind(&base::DoNothing)));
+
+  base::RunLoop().RunUntilIdle();
+
+  operation->Cancel();
+}
+
 }  // namespace
 
 }  // namespace image_writer
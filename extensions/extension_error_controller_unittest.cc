@@ -9,6 +9,7 @@
 #include "chrome/browser/extensions/extension_service_test_base.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/test/base/testing_profile.h"
+#include "content/public/test/test_utils.h"
 #include "extensions/browser/extension_prefs.h"
 #include "extensions/browser/extension_registry.h"
 #include "extensions/common/extension.h"
@@ -155,6 +156,7 @@ TEST_F(ExtensionErrorControllerUnitTest, ClosingAcknowledgesBlacklisted) {
   ASSERT_TRUE(AddBlacklistedExtension(extension));
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // Make sure that we created an error "ui" to warn about the blacklisted
   // extension.
@@ -184,6 +186,7 @@ TEST_F(ExtensionErrorControllerUnitTest, AcceptingAcknowledgesBlacklisted) {
   ASSERT_TRUE(AddBlacklistedExtension(extension));
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // Make sure that we created an error "ui" to warn about the blacklisted
   // extension.
@@ -205,6 +208,7 @@ TEST_F(ExtensionErrorControllerUnitTest, DontWarnForAcknowledgedBlacklisted) {
   GetPrefs()->AcknowledgeBlacklistedExtension(extension->id());
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // We should never have made an alert, because the extension should already
   // be acknowledged.
@@ -18,6 +18,7 @@
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/plugin_service.h"
 #include "content/public/test/test_browser_thread_bundle.h"
+#include "content/public/test/test_utils.h"
 #include "extensions/browser/extension_prefs.h"
 
 namespace extensions {
@@ -74,6 +75,7 @@ TEST_F(ExtensionGarbageCollectorUnitTest, CleanupOnStartup) {
   }
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   GarbageCollectExtensions();
 
   base::FileEnumerator dirs(extensions_install_dir(),
@@ -110,6 +112,7 @@ TEST_F(ExtensionGarbageCollectorUnitTest, NoCleanupDuringInstall) {
   }
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // Simulate a CRX installation.
   InstallTracker::Get(profile_.get())->OnBeginCrxInstall(kExtensionId);
@@ -179,6 +182,7 @@ TEST_F(ExtensionGarbageCollectorUnitTest, UpdateOnStartup) {
       "hpiknbiabeeppbpihjehijgoemciehgk/3")));
 
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   GarbageCollectExtensions();
 
   // Verify that the pending update for the first extension got installed.
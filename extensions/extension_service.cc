@@ -10,6 +10,7 @@
 
 #include "base/command_line.h"
 #include "base/metrics/histogram.h"
+#include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
@@ -277,6 +278,7 @@ ExtensionService::ExtensionService(Profile* profile,
       update_once_all_providers_are_ready_(false),
       browser_terminating_(false),
       installs_delayed_for_gc_(false),
+      loading_installed_extensions_(false),
       is_first_run_(false),
       shared_module_service_(new extensions::SharedModuleService(profile_)) {
   CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
@@ -411,62 +413,81 @@ void ExtensionService::Init() {
     // extension listens to onStartup and opens a window).
     SetReadyAndNotifyListeners();
   } else {
-    // LoadAllExtensions() calls OnLoadedInstalledExtensions().
+    // LoadAllExtensions() calls OnLoadedInstalledExtensions(), and then
+    // FinishInit() once the installed extensions have been added.
     component_loader_->LoadAll();
-    extensions::InstalledLoader(this).LoadAllExtensions();
-
-    // Attempt to re-enable extensions whose only disable reason is reloading.
-    std::vector<std::string> extensions_to_enable;
-    const ExtensionSet& disabled_extensions = registry_->disabled_extensions();
-    for (ExtensionSet::const_iterator iter = disabled_extensions.begin();
-        iter != disabled_extensions.end(); ++iter) {
-      const Extension* e = iter->get();
-      if (extension_prefs_->GetDisableReasons(e->id()) ==
-          Extension::DISABLE_RELOAD) {
-        extensions_to_enable.push_back(e->id());
-      }
+    loading_installed_extensions_ = true;
+    extensions::InstalledLoader(this).LoadAllExtensions(
+        base::Bind(&ExtensionService::FinishInit, AsWeakPtr(), begin_time));
+    return;
+  }
+
+  UMA_HISTOGRAM_TIMES("Extensions.ExtensionServiceInitTime",
+                      base::Time::Now() - begin_time);
+}
+
+void ExtensionService::FinishInit(base::Time begin_time) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  loading_installed_extensions_ = false;
+
+  // Attempt to re-enable extensions whose only disable reason is reloading.
+  std::vector<std::string> extensions_to_enable;
+  const ExtensionSet& disabled_extensions = registry_->disabled_extensions();
+  for (ExtensionSet::const_iterator iter = disabled_extensions.begin();
+      iter != disabled_extensions.end(); ++iter) {
+    const Extension* e = iter->get();
+    if (extension_prefs_->GetDisableReasons(e->id()) ==
+        Extension::DISABLE_RELOAD) {
+      extensions_to_enable.push_back(e->id());
     }
-    for (std::vector<std::string>::iterator it = extensions_to_enable.begin();
-         it != extensions_to_enable.end(); ++it) {
-      EnableExtension(*it);
+  }
+  for (std::vector<std::string>::iterator it = extensions_to_enable.begin();
+       it != extensions_to_enable.end(); ++it) {
+    EnableExtension(*it);
+  }
+
+  // Finish install (if possible) of extensions that were still delayed while
+  // the browser was shut down.
+  scoped_ptr<extensions::ExtensionPrefs::ExtensionsInfo> delayed_info(
+      extension_prefs_->GetAllDelayedInstallInfo());
+  for (size_t i = 0; i < delayed_info->size(); ++i) {
+    ExtensionInfo* info = delayed_info->at(i).get();
+    scoped_refptr<const Extension> extension(NULL);
+    if (info->extension_manifest) {
+      std::string error;
+      extension = Extension::Create(
+          info->extension_path,
+          info->extension_location,
+          *info->extension_manifest,
+          extension_prefs_->GetDelayedInstallCreationFlags(
+              info->extension_id),
+          info->extension_id,
+          &error);
+      if (extension.get())
+        delayed_installs_.Insert(extension);
     }
+  }
+  MaybeFinishDelayedInstallations();
 
-    // Finish install (if possible) of extensions that were still delayed while
-    // the browser was shut down.
-    scoped_ptr<extensions::ExtensionPrefs::ExtensionsInfo> delayed_info(
-        extension_prefs_->GetAllDelayedInstallInfo());
-    for (size_t i = 0; i < delayed_info->size(); ++i) {
-      ExtensionInfo* info = delayed_info->at(i).get();
-      scoped_refptr<const Extension> extension(NULL);
-      if (info->extension_manifest) {
-        std::string error;
-        extension = Extension::Create(
-            info->extension_path,
-            info->extension_location,
-            *info->extension_manifest,
-            extension_prefs_->GetDelayedInstallCreationFlags(
-                info->extension_id),
-            info->extension_id,
-            &error);
-        if (extension.get())
-          delayed_installs_.Insert(extension);
-      }
-    }
-    MaybeFinishDelayedInstallations();
+  scoped_ptr<extensions::ExtensionPrefs::ExtensionsInfo> delayed_info2(
+      extension_prefs_->GetAllDelayedInstallInfo());
+  UMA_HISTOGRAM_COUNTS_100("Extensions.UpdateOnLoad",
+                           delayed_info2->size() - delayed_info->size());
 
-    scoped_ptr<extensions::ExtensionPrefs::ExtensionsInfo> delayed_info2(
-        extension_prefs_->GetAllDelayedInstallInfo());
-    UMA_HISTOGRAM_COUNTS_100("Extensions.UpdateOnLoad",
-                             delayed_info2->size() - delayed_info->size());
+  // Finish the installs that arrived while the installed extensions were
+  // loading, such as the extensions loaded from the command line.
+  std::vector<base::Closure> installs;
+  installs.swap(installs_delayed_for_init_);
+  for (size_t i = 0; i < installs.size(); ++i)
+    installs[i].Run();
 
-    SetReadyAndNotifyListeners();
+  SetReadyAndNotifyListeners();
 
-    // TODO(erikkay) this should probably be deferred to a future point
-    // rather than running immediately at startup.
-    CheckForExternalUpdates();
+  // TODO(erikkay) this should probably be deferred to a future point
+  // rather than running immediately at startup.
+  CheckForExternalUpdates();
 
-    LoadGreylistFromPrefs();
-  }
+  LoadGreylistFromPrefs();
 
   UMA_HISTOGRAM_TIMES("Extensions.ExtensionServiceInitTime",
                       base::Time::Now() - begin_time);
@@ -1327,7 +1348,10 @@ void ExtensionService::ReloadExtensionsForTest() {
   // warning about calling test code in production.
   UnloadAllExtensionsInternal();
   component_loader_->LoadAll();
-  extensions::InstalledLoader(this).LoadAllExtensions();
+  // Tests expect the installed extensions to be loaded on return.
+  base::RunLoop run_loop;
+  extensions::InstalledLoader(this).LoadAllExtensions(run_loop.QuitClosure());
+  run_loop.Run();
   // Don't call SetReadyAndNotifyListeners() since tests call this multiple
   // times.
 }
@@ -1595,6 +1619,19 @@ void ExtensionService::OnExtensionInstalled(
     int install_flags) {
   CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
 
+  if (loading_installed_extensions_) {
+    void (ExtensionService::*on_extension_installed)(
+        const Extension*, const syncer::StringOrdinal&, int) =
+        &ExtensionService::OnExtensionInstalled;
+    installs_delayed_for_init_.push_back(
+        base::Bind(on_extension_installed,
+                   base::Unretained(this),
+                   make_scoped_refptr(extension),
+                   page_ordinal,
+                   install_flags));
+    return;
+  }
+
   const std::string& id = extension->id();
   bool initial_enable = ShouldEnableOnInstall(extension);
   std::string install_parameter;
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
@@ -249,7 +250,11 @@ class ExtensionService
   virtual void OnExternalProviderReady(
       const extensions::ExternalProviderInterface* provider) OVERRIDE;
 
-  // Initialize and start all installed extensions.
+  // Initialize and start all installed extensions.  The installed
+  // extensions are loaded asynchronously; is_ready() becomes true, and
+  // NOTIFICATION_EXTENSIONS_READY_DEPRECATED is sent, once they have been.
+  // Extensions installed in the meantime, including the ones loaded from the
+  // command line, are added after the installed extensions.
   void Init();
 
   // Called when the associated Profile is going to be destroyed.
@@ -483,6 +488,10 @@ class ExtensionService
   // externally managed extension.  If so, uninstall it.
   void CheckExternalUninstall(const std::string& id);
 
+  // Finishes Init() once the installed extensions have been loaded.
+  // |begin_time| is when Init() was called.
+  void FinishInit(base::Time begin_time);
+
   // Populates greylist_.
   void LoadGreylistFromPrefs();
 
@@ -677,6 +686,14 @@ class ExtensionService
   // reinstallation.
   bool installs_delayed_for_gc_;
 
+  // Set while Init() is loading the installed extensions.
+  bool loading_installed_extensions_;
+
+  // Installs that arrived while the installed extensions were loading.  They
+  // are finished by FinishInit(), so that the installed extensions, which
+  // were read from the prefs beforehand, don't replace them.
+  std::vector<base::Closure> installs_delayed_for_init_;
+
   // Set to true if this is the first time this ExtensionService has run.
   // Used for specially handling external extensions that are installed the
   // first time.
@@ -1188,6 +1188,7 @@ TEST_F(ExtensionServiceTest, LoadAllExtensionsFromDirectorySuccess) {
   InitPluginService();
   InitializeGoodInstalledExtensionService();
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   uint32 expected_num_extensions = 3u;
   ASSERT_EQ(expected_num_extensions, loaded_.size());
@@ -1288,6 +1289,50 @@ TEST_F(ExtensionServiceTest, LoadAllExtensionsFromDirectorySuccess) {
   EXPECT_EQ(Manifest::INTERNAL, loaded_[index]->location());
 };
 
+// Test that the installed extensions are added in the order of the prefs,
+// whichever order the blocking pool finishes creating them in.
+TEST_F(ExtensionServiceTest, LoadAllExtensionsAddsInPrefsOrder) {
+  InitializeGoodInstalledExtensionService();
+  service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
+
+  scoped_ptr<ExtensionPrefs::ExtensionsInfo> extensions_info(
+      ExtensionPrefs::Get(profile())->GetInstalledExtensionsInfo());
+  ASSERT_EQ(extensions_info->size(), loaded_.size());
+  for (size_t i = 0; i < loaded_.size(); ++i)
+    EXPECT_EQ(extensions_info->at(i)->extension_id, loaded_[i]->id());
+}
+
+// An extension installed while the installed extensions are being loaded is
+// added after them, instead of being replaced by the version in the prefs.
+TEST_F(ExtensionServiceTest, InstallWhileLoadingInstalledExtensions) {
+  InitializeGoodInstalledExtensionService();
+  service()->Init();
+
+  scoped_refptr<Extension> update = extensions::ExtensionBuilder()
+      .SetManifest(extensions::DictionaryBuilder()
+          .Set("name", "My extension 1")
+          .Set("version", "99.0")
+          .Set("manifest_version", 2).Build())
+      .SetLocation(Manifest::INTERNAL)
+      .SetID(good0)
+      .Build();
+  ASSERT_TRUE(update.get());
+  service()->OnExtensionInstalled(update.get(),
+                                  syncer::StringOrdinal(),
+                                  extensions::kInstallFlagInstallImmediately);
+  EXPECT_FALSE(service()->GetInstalledExtension(good0));
+
+  content::RunAllBlockingPoolTasksUntilIdle();
+
+  EXPECT_TRUE(service()->is_ready());
+  ASSERT_EQ(3u, registry()->enabled_extensions().size());
+  const Extension* extension =
+      registry()->enabled_extensions().GetByID(good0);
+  ASSERT_TRUE(extension);
+  EXPECT_EQ("99.0", extension->VersionString());
+}
+
 // Test loading bad extensions from the profile directory.
 TEST_F(ExtensionServiceTest, LoadAllExtensionsFromDirectoryFail) {
   // Initialize the test dir with a bad Preferences/extensions.
@@ -1299,6 +1344,7 @@ TEST_F(ExtensionServiceTest, LoadAllExtensionsFromDirectoryFail) {
   InitializeInstalledExtensionService(pref_path, source_install_dir);
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   ASSERT_EQ(4u, GetErrors().size());
   ASSERT_EQ(0u, loaded_.size());
@@ -1341,7 +1387,7 @@ TEST_F(ExtensionServiceTest, PendingImports) {
 
   service()->Init();
   // Wait for GarbageCollectExtensions task to complete.
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // These extensions are used by the extensions we test below, they must be
   // installed.
@@ -1614,6 +1660,7 @@ TEST_F(ExtensionServiceTest, UninstallingNotLoadedExtension) {
   InitializeInstalledExtensionService(pref_path, source_install_dir);
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // Check and try to uninstall it.
   // If we don't check whether the extension is loaded before we uninstall it
@@ -3182,6 +3229,7 @@ TEST_F(ExtensionServiceTest, SetUnsetBlacklistInPrefs) {
   InitializeGoodInstalledExtensionService();
   test_blacklist.Attach(service()->blacklist_);
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   const extensions::ExtensionSet& enabled_extensions =
       registry()->enabled_extensions();
@@ -3315,10 +3363,12 @@ TEST_F(ExtensionServiceTest, WillNotLoadBlacklistedExtensionsFromDirectory) {
 
   // Load extensions.
   service()->Init();
-  ASSERT_EQ(3u, loaded_.size());  // hasn't had time to blacklist yet
-
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
+  // good1 was loaded before the blacklist check unloaded it.
+  EXPECT_EQ(good1, unloaded_id_);
+  EXPECT_EQ(UnloadedExtensionInfo::REASON_BLACKLIST, unloaded_reason_);
+  ASSERT_EQ(2u, loaded_.size());
   ASSERT_EQ(1u, registry()->blacklisted_extensions().size());
   ASSERT_EQ(2u, registry()->enabled_extensions().size());
 
@@ -3349,6 +3399,7 @@ TEST_F(ExtensionServiceTest, BlacklistedInPrefsFromStartup) {
   EXPECT_TRUE(service()->IsExtensionEnabled(good2));
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   EXPECT_EQ(2u, registry()->blacklisted_extensions().size());
   EXPECT_EQ(1u, registry()->enabled_extensions().size());
@@ -3378,6 +3429,7 @@ TEST_F(ExtensionServiceTest, GreylistedExtensionDisabled) {
   InitializeGoodInstalledExtensionService();
   test_blacklist.Attach(service()->blacklist_);
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   const extensions::ExtensionSet& enabled_extensions =
       registry()->enabled_extensions();
@@ -3443,6 +3495,7 @@ TEST_F(ExtensionServiceTest, GreylistDontEnableManuallyDisabled) {
   InitializeGoodInstalledExtensionService();
   test_blacklist.Attach(service()->blacklist_);
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   const extensions::ExtensionSet& enabled_extensions =
       registry()->enabled_extensions();
@@ -3507,6 +3560,7 @@ TEST_F(ExtensionServiceTest, GreylistUnknownDontChange) {
   InitializeGoodInstalledExtensionService();
   test_blacklist.Attach(service()->blacklist_);
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   const extensions::ExtensionSet& enabled_extensions =
       registry()->enabled_extensions();
@@ -3554,6 +3608,7 @@ TEST_F(ExtensionServiceTest, ReloadBlacklistedExtension) {
   test_blacklist.SetBlacklistState(
       good1, extensions::BLACKLISTED_MALWARE, false);
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   test_blacklist.SetBlacklistState(
       good2, extensions::BLACKLISTED_MALWARE, false);
   base::RunLoop().RunUntilIdle();
@@ -4751,8 +4806,9 @@ void ExtensionServiceTest::TestExternalProvider(
 
     // Should still be at 0.
     loaded_.clear();
-    extensions::InstalledLoader(service()).LoadAllExtensions();
-    base::RunLoop().RunUntilIdle();
+    extensions::InstalledLoader(service()).LoadAllExtensions(
+        base::Closure());
+    content::RunAllBlockingPoolTasksUntilIdle();
     ASSERT_EQ(0u, loaded_.size());
     ValidatePrefKeyCount(1);
 
@@ -4837,6 +4893,7 @@ TEST_F(ExtensionServiceTest, ExternalUninstall) {
   service()->set_extensions_enabled(false);
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   ASSERT_EQ(0u, GetErrors().size());
   ASSERT_EQ(0u, loaded_.size());
@@ -5108,6 +5165,7 @@ TEST_F(ExtensionServiceTest, LoadAndRelocalizeExtensions) {
   InitializeInstalledExtensionService(pref_path, source_install_dir);
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   ASSERT_EQ(3u, loaded_.size());
 
@@ -5192,7 +5250,7 @@ TEST(ExtensionServiceTestSimple, Enabledness) {
           false);
   EXPECT_TRUE(service->extensions_enabled());
   service->Init();
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
   EXPECT_TRUE(recorder.ready());
 #if defined OS_CHROMEOS
   user_manager.reset();
@@ -5210,7 +5268,7 @@ TEST(ExtensionServiceTestSimple, Enabledness) {
           false);
   EXPECT_FALSE(service->extensions_enabled());
   service->Init();
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
   EXPECT_TRUE(recorder.ready());
 
   recorder.set_ready(false);
@@ -5224,7 +5282,7 @@ TEST(ExtensionServiceTestSimple, Enabledness) {
           false);
   EXPECT_FALSE(service->extensions_enabled());
   service->Init();
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
   EXPECT_TRUE(recorder.ready());
 
   recorder.set_ready(false);
@@ -5239,7 +5297,7 @@ TEST(ExtensionServiceTestSimple, Enabledness) {
           false);
   EXPECT_FALSE(service->extensions_enabled());
   service->Init();
-  base::RunLoop().RunUntilIdle();
+  content::RunAllBlockingPoolTasksUntilIdle();
   EXPECT_TRUE(recorder.ready());
 
   // Explicitly delete all the resources used in this test.
@@ -5365,6 +5423,7 @@ TEST_F(ExtensionServiceTest, DeferredSyncStartupPreInstalledNormal) {
 
   ASSERT_FALSE(service()->is_ready());
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   ASSERT_EQ(3u, loaded_.size());
   ASSERT_TRUE(service()->is_ready());
 
@@ -5427,6 +5486,7 @@ TEST_F(ExtensionServiceTest, DisableExtensionFromSync) {
   sync_service->SetSyncSetupCompleted();
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   ASSERT_TRUE(service()->is_ready());
 
   ASSERT_EQ(3u, loaded_.size());
@@ -5466,6 +5526,7 @@ TEST_F(ExtensionServiceTest, DontDisableExtensionWithPendingEnableFromSync) {
   sync_service->SetSyncSetupCompleted();
 
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
   ASSERT_TRUE(service()->is_ready());
   ASSERT_EQ(3u, loaded_.size());
 
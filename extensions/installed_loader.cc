@@ -4,7 +4,10 @@
 
 #include "chrome/browser/extensions/installed_loader.h"
 
+#include "base/barrier_closure.h"
+#include "base/bind.h"
 #include "base/files/file_path.h"
+#include "base/memory/scoped_vector.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/sparse_histogram.h"
 #include "base/strings/stringprintf.h"
@@ -156,6 +159,64 @@ void RecordDisableReasons(int reasons) {
   }
 }
 
+// Creates an extension from the manifest stored in the prefs for it.
+scoped_refptr<const Extension> CreateFromPrefs(const ExtensionInfo& info,
+                                               int creation_flags,
+                                               std::string* error) {
+  if (!info.extension_manifest) {
+    *error = errors::kManifestUnreadable;
+    return NULL;
+  }
+  return Extension::Create(info.extension_path,
+                           info.extension_location,
+                           *info.extension_manifest,
+                           creation_flags,
+                           error);
+}
+
+// An installed extension being created off the UI thread.
+struct PendingExtension {
+  PendingExtension(const ExtensionInfo* info,
+                   ManifestReloadReason reload_reason,
+                   int creation_flags)
+      : info(info),
+        reload_reason(reload_reason),
+        creation_flags(creation_flags),
+        reloaded(false) {}
+
+  const ExtensionInfo* info;
+  ManifestReloadReason reload_reason;
+  int creation_flags;
+
+  // Set by CreatePendingExtension().
+  scoped_refptr<const Extension> extension;
+  std::string error;
+  // Whether |extension| was reloaded from disk, or why reloading it failed.
+  bool reloaded;
+  std::string reload_error;
+  base::TimeDelta load_time;
+};
+
+// Creates |pending->extension|, reading its manifest and message bundles from
+// disk first if they need to be reloaded.  If reloading fails, the manifest
+// in the prefs is used instead.  Runs on the blocking pool.
+void CreatePendingExtension(PendingExtension* pending) {
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  const ExtensionInfo& info = *pending->info;
+  if (pending->reload_reason != NOT_NEEDED) {
+    pending->extension = file_util::LoadExtension(info.extension_path,
+                                                  info.extension_location,
+                                                  pending->creation_flags,
+                                                  &pending->reload_error);
+    pending->reloaded = pending->extension.get() != NULL;
+  }
+  if (!pending->extension.get()) {
+    pending->extension =
+        CreateFromPrefs(info, pending->creation_flags, &pending->error);
+  }
+  pending->load_time = base::TimeTicks::Now() - start_time;
+}
+
 }  // namespace
 
 InstalledLoader::InstalledLoader(ExtensionService* extension_service)
@@ -168,17 +229,17 @@ InstalledLoader::~InstalledLoader() {
 
 void InstalledLoader::Load(const ExtensionInfo& info, bool write_to_prefs) {
   std::string error;
-  scoped_refptr<const Extension> extension(NULL);
-  if (info.extension_manifest) {
-    extension = Extension::Create(
-        info.extension_path,
-        info.extension_location,
-        *info.extension_manifest,
-        GetCreationFlags(&info),
-        &error);
-  } else {
-    error = errors::kManifestUnreadable;
-  }
+  scoped_refptr<const Extension> extension(
+      CreateFromPrefs(info, GetCreationFlags(&info), &error));
+  AddExtension(info, extension.get(), error, write_to_prefs);
+}
+
+void InstalledLoader::AddExtension(const ExtensionInfo& info,
+                                   const Extension* created_extension,
+                                   const std::string& load_error,
+                                   bool write_to_prefs) {
+  std::string error = load_error;
+  scoped_refptr<const Extension> extension(created_extension);
 
   // Once installed, non-unpacked extensions cannot change their IDs (e.g., by
   // updating the 'key' field in their manifest).
@@ -226,20 +287,24 @@ void InstalledLoader::Load(const ExtensionInfo& info, bool write_to_prefs) {
   extension_service_->AddExtension(extension.get());
 }
 
-void InstalledLoader::LoadAllExtensions() {
-  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+struct InstalledLoader::PendingLoad {
+  PendingLoad() : reload_reason_counts(NUM_MANIFEST_RELOAD_REASONS, 0) {}
 
-  base::TimeTicks start_time = base::TimeTicks::Now();
+  base::TimeTicks start_time;
+  scoped_ptr<ExtensionPrefs::ExtensionsInfo> extensions_info;
+  ScopedVector<PendingExtension> pending_extensions;
+  std::vector<int> reload_reason_counts;
+};
 
-  Profile* profile = extension_service_->profile();
-  scoped_ptr<ExtensionPrefs::ExtensionsInfo> extensions_info(
-      extension_prefs_->GetInstalledExtensionsInfo());
+void InstalledLoader::LoadAllExtensions(const base::Closure& callback) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
 
-  std::vector<int> reload_reason_counts(NUM_MANIFEST_RELOAD_REASONS, 0);
-  bool should_write_prefs = false;
+  PendingLoad* load = new PendingLoad;
+  load->start_time = base::TimeTicks::Now();
+  load->extensions_info = extension_prefs_->GetInstalledExtensionsInfo();
 
-  for (size_t i = 0; i < extensions_info->size(); ++i) {
-    ExtensionInfo* info = extensions_info->at(i).get();
+  for (size_t i = 0; i < load->extensions_info->size(); ++i) {
+    ExtensionInfo* info = load->extensions_info->at(i).get();
 
     // Skip extensions that were loaded from the command-line because we don't
     // want those to persist across browser restart.
@@ -247,43 +312,83 @@ void InstalledLoader::LoadAllExtensions() {
       continue;
 
     ManifestReloadReason reload_reason = ShouldReloadExtensionManifest(*info);
-    ++reload_reason_counts[reload_reason];
-
-    if (reload_reason != NOT_NEEDED) {
-      // Reloading an extension reads files from disk.  We do this on the
-      // UI thread because reloads should be very rare, and the complexity
-      // added by delaying the time when the extensions service knows about
-      // all extensions is significant.  See crbug.com/37548 for details.
-      // |allow_io| disables tests that file operations run on the file
-      // thread.
+    ++load->reload_reason_counts[reload_reason];
+    load->pending_extensions.push_back(
+        new PendingExtension(info, reload_reason, GetCreationFlags(info)));
+  }
+
+  // Creating the extensions, and reloading their manifests from disk where
+  // needed, is independent for each extension, so it is spread over the
+  // blocking pool.  Each task replies to the UI thread, and the extensions
+  // are added once all of them have replied.  The replies own |load|, so it
+  // outlives the tasks.
+  base::Closure created = base::BarrierClosure(
+      static_cast<int>(load->pending_extensions.size()),
+      base::Bind(&InstalledLoader::OnAllExtensionsCreated,
+                 extension_service_->AsWeakPtr(),
+                 base::Owned(load),
+                 callback));
+  for (size_t i = 0; i < load->pending_extensions.size(); ++i) {
+    base::Closure task =
+        base::Bind(&CreatePendingExtension, load->pending_extensions[i]);
+    if (!BrowserThread::PostBlockingPoolTaskAndReply(
+            FROM_HERE, task, created)) {
       base::ThreadRestrictions::ScopedAllowIO allow_io;
+      task.Run();
+      created.Run();
+    }
+  }
+}
 
-      std::string error;
-      scoped_refptr<const Extension> extension(
-          file_util::LoadExtension(info->extension_path,
-                                   info->extension_location,
-                                   GetCreationFlags(info),
-                                   &error));
-
-      if (!extension.get()) {
-        ExtensionErrorReporter::GetInstance()->ReportLoadError(
-            info->extension_path,
-            error,
-            profile,
-            false);  // Be quiet.
-        continue;
-      }
+// static
+void InstalledLoader::OnAllExtensionsCreated(
+    base::WeakPtr<ExtensionService> extension_service,
+    PendingLoad* load,
+    const base::Closure& callback) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (!extension_service.get())
+    return;
+  InstalledLoader(extension_service.get()).AddAllExtensions(load);
+  if (!callback.is_null())
+    callback.Run();
+}
+
+void InstalledLoader::AddAllExtensions(PendingLoad* load) {
+  Profile* profile = extension_service_->profile();
+  const ScopedVector<PendingExtension>& pending_extensions =
+      load->pending_extensions;
+  const std::vector<int>& reload_reason_counts = load->reload_reason_counts;
 
-      extensions_info->at(i)->extension_manifest.reset(
-          static_cast<base::DictionaryValue*>(
-              extension->manifest()->value()->DeepCopy()));
+  bool should_write_prefs = false;
+  for (size_t i = 0; i < pending_extensions.size(); ++i) {
+    PendingExtension* pending = pending_extensions[i];
+    if (pending->reloaded) {
       should_write_prefs = true;
+    } else if (pending->reload_reason != NOT_NEEDED) {
+      ExtensionErrorReporter::GetInstance()->ReportLoadError(
+          pending->info->extension_path,
+          pending->reload_error,
+          profile,
+          false);  // Be quiet.
     }
   }
 
-  for (size_t i = 0; i < extensions_info->size(); ++i) {
-    if (extensions_info->at(i)->extension_location != Manifest::COMMAND_LINE)
-      Load(*extensions_info->at(i), should_write_prefs);
+  // Extensions are added in the order of the prefs, however the blocking pool
+  // ran the tasks.
+  for (size_t i = 0; i < pending_extensions.size(); ++i) {
+    PendingExtension* pending = pending_extensions[i];
+    // An extension that was added while the extensions were being created is
+    // at least as recent as the prefs read by LoadAllExtensions().
+    if (extension_service_->GetInstalledExtension(
+            pending->info->extension_id)) {
+      continue;
+    }
+    base::TimeTicks add_start_time = base::TimeTicks::Now();
+    AddExtension(*pending->info, pending->extension.get(), pending->error,
+                 should_write_prefs);
+    UMA_HISTOGRAM_TIMES(
+        "Extensions.InstalledLoaderLoadTime",
+        pending->load_time + (base::TimeTicks::Now() - add_start_time));
   }
 
   extension_service_->OnLoadedInstalledExtensions();
@@ -303,7 +408,7 @@ void InstalledLoader::LoadAllExtensions() {
                            extension_registry_->disabled_extensions().size());
 
   UMA_HISTOGRAM_TIMES("Extensions.LoadAllTime",
-                      base::TimeTicks::Now() - start_time);
+                      base::TimeTicks::Now() - load->start_time);
 
   int app_user_count = 0;
   int app_external_count = 0;
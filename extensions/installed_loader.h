@@ -5,10 +5,16 @@
 #ifndef CHROME_BROWSER_EXTENSIONS_INSTALLED_LOADER_H_
 #define CHROME_BROWSER_EXTENSIONS_INSTALLED_LOADER_H_
 
+#include <string>
+
+#include "base/callback_forward.h"
+#include "base/memory/weak_ptr.h"
+
 class ExtensionService;
 
 namespace extensions {
 
+class Extension;
 class ExtensionPrefs;
 class ExtensionRegistry;
 struct ExtensionInfo;
@@ -22,10 +28,36 @@ class InstalledLoader {
   // Loads extension from prefs.
   void Load(const ExtensionInfo& info, bool write_to_prefs);
 
-  // Loads all installed extensions (used by startup and testing code).
-  void LoadAllExtensions();
+  // Loads all installed extensions (used by startup and testing code).  The
+  // manifests are parsed, and reloaded from disk where needed, on the
+  // blocking pool; the extensions are then added on the UI thread in the
+  // order of the prefs, and |callback| is run.  Neither happens if the
+  // ExtensionService is destroyed first.  This InstalledLoader does not need
+  // to outlive the call.
+  void LoadAllExtensions(const base::Closure& callback);
 
  private:
+  // The extensions being created for LoadAllExtensions().
+  struct PendingLoad;
+
+  // Adds the extensions of |load| once they have all been created, then runs
+  // |callback|.
+  static void OnAllExtensionsCreated(
+      base::WeakPtr<ExtensionService> extension_service,
+      PendingLoad* load,
+      const base::Closure& callback);
+
+  // Adds the extensions of |load| in the order of the prefs, and records
+  // the metrics about the installed extensions.
+  void AddAllExtensions(PendingLoad* load);
+
+  // Checks |extension|, which was created from |info| or failed to be with
+  // |error|, against policy and adds it to the ExtensionService.
+  void AddExtension(const ExtensionInfo& info,
+                    const Extension* extension,
+                    const std::string& error,
+                    bool write_to_prefs);
+
   // Returns the flags that should be used with Extension::Create() for an
   // extension that is already installed.
   int GetCreationFlags(const ExtensionInfo* info);
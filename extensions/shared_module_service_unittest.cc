@@ -12,6 +12,7 @@
 #include "chrome/browser/extensions/shared_module_service.h"
 #include "chrome/common/extensions/features/feature_channel.h"
 #include "components/crx_file/id_util.h"
+#include "content/public/test/test_utils.h"
 #include "extensions/browser/extension_registry.h"
 #include "extensions/browser/install_flag.h"
 #include "extensions/browser/uninstall_reason.h"
@@ -66,6 +67,7 @@ void SharedModuleServiceUnitTest::SetUp() {
   ExtensionServiceTestBase::SetUp();
   InitializeGoodInstalledExtensionService();
   service()->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 }
 
 testing::AssertionResult SharedModuleServiceUnitTest::InstallExtension(
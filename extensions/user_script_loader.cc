@@ -12,6 +12,7 @@
 #include "base/file_util.h"
 #include "base/files/file_path.h"
 #include "base/memory/shared_memory.h"
+#include "base/pickle.h"
 #include "base/version.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/profiles/profile.h"
@@ -153,28 +154,33 @@ void LoadUserScripts(UserScriptList* user_scripts,
   }
 }
 
-// Pickle user scripts and return pointer to the shared memory.
-scoped_ptr<base::SharedMemory> Serialize(const UserScriptList& scripts) {
-  Pickle pickle;
-  pickle.WriteUInt64(scripts.size());
+// Pickles the user scripts, with their contents, into |pickle|.
+void SerializeScripts(const UserScriptList& scripts, Pickle* pickle) {
+  pickle->WriteUInt64(scripts.size());
   for (UserScriptList::const_iterator script = scripts.begin();
        script != scripts.end();
        ++script) {
     // TODO(aa): This can be replaced by sending content script metadata to
     // renderers along with other extension data in ExtensionMsg_Loaded.
     // See crbug.com/70516.
-    script->Pickle(&pickle);
+    script->Pickle(pickle);
     // Write scripts as 'data' so that we can read it out in the slave without
     // allocating a new string.
     for (size_t j = 0; j < script->js_scripts().size(); j++) {
       base::StringPiece contents = script->js_scripts()[j].GetContent();
-      pickle.WriteData(contents.data(), contents.length());
+      pickle->WriteData(contents.data(), contents.length());
     }
     for (size_t j = 0; j < script->css_scripts().size(); j++) {
       base::StringPiece contents = script->css_scripts()[j].GetContent();
-      pickle.WriteData(contents.data(), contents.length());
+      pickle->WriteData(contents.data(), contents.length());
     }
   }
+}
+
+// Pickle user scripts and return pointer to the shared memory.
+scoped_ptr<base::SharedMemory> Serialize(const UserScriptList& scripts) {
+  Pickle pickle;
+  SerializeScripts(scripts, &pickle);
 
   // Create the shared memory object.
   base::SharedMemory shared_memory;
@@ -343,6 +349,13 @@ void UserScriptLoader::LoadScriptsForTest(UserScriptList* user_scripts) {
       user_scripts, info, added_script_ids, NULL /* no verifier for testing */);
 }
 
+// static
+void UserScriptLoader::SerializeScriptsForTest(
+    const UserScriptList& user_scripts,
+    Pickle* pickle) {
+  SerializeScripts(user_scripts, pickle);
+}
+
 UserScriptLoader::UserScriptLoader(Profile* profile,
                                    const ExtensionId& owner_extension_id,
                                    bool listen_for_extension_system_loaded)
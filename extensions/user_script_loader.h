@@ -28,6 +28,7 @@ class BrowserContext;
 class RenderProcessHost;
 }
 
+class Pickle;
 class Profile;
 
 namespace extensions {
@@ -56,6 +57,11 @@ class UserScriptLoader : public content::NotificationObserver,
   // the file thread. Exposed only for tests.
   static void LoadScriptsForTest(UserScriptList* user_scripts);
 
+  // Pickles |user_scripts| into |pickle| the way they are sent to renderers.
+  // Exposed only for tests.
+  static void SerializeScriptsForTest(const UserScriptList& user_scripts,
+                                      Pickle* pickle);
+
   UserScriptLoader(Profile* profile,
                    const ExtensionId& owner_extension_id,
                    bool listen_for_extension_system_loaded);
@@ -0,0 +1,73 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/extensions/user_script_loader.h"
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/pickle.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "extensions/common/user_script.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace extensions {
+
+namespace {
+
+const int kNumExtensions = 40;
+const int kScriptsPerExtension = 2;
+const size_t kScriptSize = 64 * 1024;
+const int kNumIterations = 20;
+
+// Returns |kScriptsPerExtension| content scripts of |kScriptSize| bytes for
+// each of |kNumExtensions| extensions.
+UserScriptList CreateContentScripts() {
+  UserScriptList user_scripts;
+  for (int i = 0; i < kNumExtensions; ++i) {
+    for (int j = 0; j < kScriptsPerExtension; ++j) {
+      UserScript user_script;
+      user_script.set_id(i * kScriptsPerExtension + j);
+      user_script.set_extension_id(base::StringPrintf("extension%d", i));
+      user_script.js_scripts().push_back(UserScript::File(
+          base::FilePath(), base::FilePath(FILE_PATH_LITERAL("script.js")),
+          GURL()));
+      user_script.js_scripts().back().set_content(
+          std::string(kScriptSize, static_cast<char>('a' + j % 26)));
+      user_scripts.push_back(user_script);
+    }
+  }
+  return user_scripts;
+}
+
+// Measures the serialization that every load does when the content scripts
+// of any of 40 extensions change.
+TEST(UserScriptLoaderPerfTest, SerializeManyExtensions) {
+  UserScriptList user_scripts = CreateContentScripts();
+
+  size_t pickle_size = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    Pickle pickle;
+    UserScriptLoader::SerializeScriptsForTest(user_scripts, &pickle);
+    pickle_size = pickle.size();
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  EXPECT_LT(static_cast<size_t>(kNumExtensions) * kScriptsPerExtension *
+                kScriptSize,
+            pickle_size);
+
+  perf_test::PrintResult("user_script_serialize", "", "40_extensions",
+                         elapsed.InMillisecondsF() / kNumIterations, "ms",
+                         true);
+  perf_test::PrintResult("user_script_serialize_size", "", "40_extensions",
+                         pickle_size, "bytes", false);
+}
+
+}  // namespace
+
+}  // namespace extensions
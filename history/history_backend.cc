@@ -1161,6 +1161,17 @@ void HistoryBackend::UpdateDownload(const history::DownloadRow& data) {
   ScheduleCommit();
 }
 
+void HistoryBackend::UpdateDownloads(
+    const std::vector<history::DownloadRow>& data) {
+  if (!db_)
+    return;
+  for (std::vector<history::DownloadRow>::const_iterator it = data.begin();
+       it != data.end(); ++it) {
+    db_->UpdateDownload(*it);
+  }
+  ScheduleCommit();
+}
+
 bool HistoryBackend::CreateDownload(const history::DownloadRow& history_info) {
   if (!db_)
     return false;
@@ -281,6 +281,7 @@ class HistoryBackend : public base::RefCountedThreadSafe<HistoryBackend>,
   uint32 GetNextDownloadId();
   void QueryDownloads(std::vector<DownloadRow>* rows);
   void UpdateDownload(const DownloadRow& data);
+  void UpdateDownloads(const std::vector<DownloadRow>& data);
   bool CreateDownload(const history::DownloadRow& history_info);
   void RemoveDownloads(const std::set<uint32>& ids);
 
@@ -784,6 +784,13 @@ void HistoryService::UpdateDownload(const history::DownloadRow& data) {
   ScheduleAndForget(PRIORITY_NORMAL, &HistoryBackend::UpdateDownload, data);
 }
 
+void HistoryService::UpdateDownloads(
+    const std::vector<history::DownloadRow>& data) {
+  DCHECK(thread_) << "History service being called after cleanup";
+  DCHECK(thread_checker_.CalledOnValidThread());
+  ScheduleAndForget(PRIORITY_NORMAL, &HistoryBackend::UpdateDownloads, data);
+}
+
 void HistoryService::RemoveDownloads(const std::set<uint32>& ids) {
   DCHECK(thread_) << "History service being called after cleanup";
   DCHECK(thread_checker_.CalledOnValidThread());
@@ -410,6 +410,10 @@ class HistoryService : public content::NotificationObserver,
   // the database with no need for a callback.
   void UpdateDownload(const history::DownloadRow& data);
 
+  // Like UpdateDownload(), for several downloads at once in a single history
+  // task.
+  void UpdateDownloads(const std::vector<history::DownloadRow>& data);
+
   // Permanently remove some downloads from the history system. This is a 'fire
   // and forget' operation.
   void RemoveDownloads(const std::set<uint32>& ids);
@@ -5,7 +5,9 @@
 #include "chrome/browser/media_galleries/fileapi/readahead_file_stream_reader.h"
 
 #include <algorithm>
+#include <cmath>
 
+#include "base/bind.h"
 #include "base/message_loop/message_loop.h"
 #include "base/numerics/safe_conversions.h"
 #include "net/base/io_buffer.h"
@@ -15,15 +17,42 @@ using storage::FileStreamReader;
 
 namespace {
 
-const size_t kDesiredNumberOfBuffers = 2;  // So we are always one buffer ahead.
 const int kBufferSize = 1024*1024;  // 1MB to minimize transaction costs.
 
+// The readahead window, in buffers. Two buffers keep us always one buffer
+// ahead; more are used for consumers that stream quickly.
+const size_t kMinReadaheadBuffers = 2;
+const size_t kMaxReadaheadBuffers = 16;
+
+// The readahead window is sized to hold this much of the consumed data.
+const int kReadaheadTimeMs = 1000;
+
+// The consumption rate is measured over samples at least this long, and
+// each new sample counts for this much of the smoothed rate.
+const int kRateSampleIntervalMs = 100;
+const double kRateSmoothing = 0.25;
+
 }  // namespace
 
+ReadaheadFileStreamReader::FilledBuffer::FilledBuffer(net::IOBuffer* buffer,
+                                                      int size)
+    : buffer(buffer),
+      offset(0),
+      size(size) {
+}
+
+ReadaheadFileStreamReader::FilledBuffer::~FilledBuffer() {}
+
 ReadaheadFileStreamReader::ReadaheadFileStreamReader(FileStreamReader* source)
     : source_(source),
       source_error_(0),
       source_has_pending_read_(false),
+      readahead_buffers_(kMinReadaheadBuffers),
+      consumption_rate_(-1),
+      bytes_consumed_in_sample_(0),
+      buffers_allocated_(0),
+      pending_sink_len_(0),
+      clock_(&default_tick_clock_),
       weak_factory_(this) {
 }
 
@@ -34,17 +63,17 @@ int ReadaheadFileStreamReader::Read(
   DCHECK(!pending_sink_buffer_.get());
   DCHECK(pending_read_callback_.is_null());
 
+  UpdateReadaheadWindow();
   ReadFromSourceIfNeeded();
 
-  scoped_refptr<net::DrainableIOBuffer> sink =
-      new net::DrainableIOBuffer(buf, buf_len);
-  int result = FinishReadFromCacheOrStoredError(sink);
+  int result = FinishReadFromCacheOrStoredError(buf, buf_len);
 
   // We are waiting for an source read to complete, so save the request.
   if (result == net::ERR_IO_PENDING) {
     DCHECK(!pending_sink_buffer_.get());
     DCHECK(pending_read_callback_.is_null());
-    pending_sink_buffer_ = sink;
+    pending_sink_buffer_ = buf;
+    pending_sink_len_ = buf_len;
     pending_read_callback_ = callback;
   }
 
@@ -57,7 +86,7 @@ int64 ReadaheadFileStreamReader::GetLength(
 }
 
 int ReadaheadFileStreamReader::FinishReadFromCacheOrStoredError(
-    net::DrainableIOBuffer* sink) {
+    net::IOBuffer* sink, int sink_len) {
   // If we don't have any ready cache, return the pending read code, or
   // the stored error code.
   if (buffers_.empty()) {
@@ -69,39 +98,51 @@ int ReadaheadFileStreamReader::FinishReadFromCacheOrStoredError(
     }
   }
 
-  while (sink->BytesRemaining() > 0 && !buffers_.empty()) {
-    net::DrainableIOBuffer* source_buffer = buffers_.front().get();
+  int bytes_copied = 0;
+  while (bytes_copied < sink_len && !buffers_.empty()) {
+    FilledBuffer& source_buffer = buffers_.front();
 
-    DCHECK(source_buffer->BytesRemaining() > 0);
+    DCHECK_LT(source_buffer.offset, source_buffer.size);
 
-    int copy_len = std::min(source_buffer->BytesRemaining(),
-                            sink->BytesRemaining());
-    std::copy(source_buffer->data(), source_buffer->data() + copy_len,
-              sink->data());
+    int copy_len = std::min(source_buffer.size - source_buffer.offset,
+                            sink_len - bytes_copied);
+    const char* source_data =
+        source_buffer.buffer->data() + source_buffer.offset;
+    std::copy(source_data, source_data + copy_len,
+              sink->data() + bytes_copied);
 
-    source_buffer->DidConsume(copy_len);
-    sink->DidConsume(copy_len);
+    source_buffer.offset += copy_len;
+    bytes_copied += copy_len;
 
-    if (source_buffer->BytesRemaining() == 0) {
-      buffers_.pop();
+    if (source_buffer.offset == source_buffer.size) {
+      ReleaseBuffer(source_buffer.buffer.get());
+      buffers_.pop_front();
 
-      // Get a new buffer to replace the one we just used up.
+      // Refill the buffer we just used up.
       ReadFromSourceIfNeeded();
     }
   }
 
-  return sink->BytesConsumed();
+  bytes_consumed_in_sample_ += bytes_copied;
+  return bytes_copied;
 }
 
 void ReadaheadFileStreamReader::ReadFromSourceIfNeeded() {
   if (!source_.get() || source_has_pending_read_ ||
-      buffers_.size() >= kDesiredNumberOfBuffers) {
+      buffers_.size() >= readahead_buffers_) {
     return;
   }
 
   source_has_pending_read_ = true;
 
-  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kBufferSize));
+  scoped_refptr<net::IOBuffer> buf;
+  if (free_buffers_.empty()) {
+    buf = new net::IOBuffer(kBufferSize);
+    ++buffers_allocated_;
+  } else {
+    buf = free_buffers_.back();
+    free_buffers_.pop_back();
+  }
   int result = source_->Read(
       buf,
       kBufferSize,
@@ -120,13 +161,12 @@ void ReadaheadFileStreamReader::OnFinishReadFromSource(net::IOBuffer* buf,
 
   // Either store the data read from |source_|, or store the error code.
   if (result > 0) {
-    scoped_refptr<net::DrainableIOBuffer> drainable_buffer(
-        new net::DrainableIOBuffer(buf, result));
-    buffers_.push(drainable_buffer);
+    buffers_.push_back(FilledBuffer(buf, result));
     ReadFromSourceIfNeeded();
   } else {
     source_.reset();
     source_error_ = result;
+    free_buffers_.clear();
   }
 
   // If there's a read request waiting for the source FileStreamReader to
@@ -136,11 +176,48 @@ void ReadaheadFileStreamReader::OnFinishReadFromSource(net::IOBuffer* buf,
 
     // Free the pending callback before running it, as the callback often
     // dispatches another read.
-    scoped_refptr<net::DrainableIOBuffer> sink = pending_sink_buffer_;
+    scoped_refptr<net::IOBuffer> sink = pending_sink_buffer_;
     pending_sink_buffer_ = NULL;
     net::CompletionCallback completion_callback = pending_read_callback_;
     pending_read_callback_.Reset();
 
-    completion_callback.Run(FinishReadFromCacheOrStoredError(sink));
+    completion_callback.Run(
+        FinishReadFromCacheOrStoredError(sink, pending_sink_len_));
+  }
+}
+
+void ReadaheadFileStreamReader::ReleaseBuffer(net::IOBuffer* buffer) {
+  // Only the buffers that are about to be refilled are worth keeping.
+  if (source_.get() && free_buffers_.size() < readahead_buffers_)
+    free_buffers_.push_back(buffer);
+}
+
+void ReadaheadFileStreamReader::UpdateReadaheadWindow() {
+  base::TimeTicks now = clock_->NowTicks();
+  if (sample_start_time_.is_null()) {
+    sample_start_time_ = now;
+    return;
+  }
+  base::TimeDelta elapsed = now - sample_start_time_;
+  if (elapsed < base::TimeDelta::FromMilliseconds(kRateSampleIntervalMs))
+    return;
+
+  double rate = bytes_consumed_in_sample_ / elapsed.InSecondsF();
+  if (consumption_rate_ < 0) {
+    consumption_rate_ = rate;
+  } else {
+    consumption_rate_ =
+        kRateSmoothing * rate + (1 - kRateSmoothing) * consumption_rate_;
   }
+  bytes_consumed_in_sample_ = 0;
+  sample_start_time_ = now;
+
+  double window = consumption_rate_ * kReadaheadTimeMs / 1000;
+  double buffers = std::ceil(window / kBufferSize);
+  readahead_buffers_ = std::max(
+      kMinReadaheadBuffers,
+      static_cast<size_t>(std::min(
+          buffers, static_cast<double>(kMaxReadaheadBuffers))));
+  if (free_buffers_.size() > readahead_buffers_)
+    free_buffers_.resize(readahead_buffers_);
 }
@@ -5,13 +5,22 @@
 #ifndef CHROME_BROWSER_MEDIA_GALLERIES_FILEAPI_READAHEAD_FILE_STREAM_READER_H_
 #define CHROME_BROWSER_MEDIA_GALLERIES_FILEAPI_READAHEAD_FILE_STREAM_READER_H_
 
-#include <queue>
+#include <deque>
+#include <vector>
 
 #include "base/memory/weak_ptr.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/time.h"
 #include "net/base/io_buffer.h"
 #include "webkit/browser/blob/file_stream_reader.h"
 
 // Wraps a source FileStreamReader with a readahead buffer.
+//
+// The readahead window grows and shrinks with the rate at which the data is
+// consumed, so that about a second of data is buffered: a few buffers for a
+// slow consumer, and many for one that streams as fast as it can. Drained
+// buffers are kept in a pool and refilled from the source instead of being
+// freed.
 class ReadaheadFileStreamReader
     : public NON_EXPORTED_BASE(storage::FileStreamReader) {
  public:
@@ -27,16 +36,37 @@ class ReadaheadFileStreamReader
       const net::Int64CompletionCallback& callback) OVERRIDE;
 
  private:
+  friend class ReadaheadFileStreamReaderPerfTest;
+  friend class ReadaheadFileStreamReaderTest;
+
+  // A buffer filled from |source_|, of which the first |offset| bytes were
+  // consumed.
+  struct FilledBuffer {
+    FilledBuffer(net::IOBuffer* buffer, int size);
+    ~FilledBuffer();
+
+    scoped_refptr<net::IOBuffer> buffer;
+    int offset;
+    int size;
+  };
+
   // Returns the number of bytes consumed from the internal cache into |sink|.
   // Returns an error code if we are out of cache, hit an error, or hit EOF.
-  int FinishReadFromCacheOrStoredError(net::DrainableIOBuffer* sink);
+  int FinishReadFromCacheOrStoredError(net::IOBuffer* sink, int sink_len);
 
-  // Reads into a new buffer from the source reader. This calls
-  // OnFinishReadFromSource when it completes (either synchronously or
-  // asynchronously).
+  // Reads into a buffer from the pool, or a new one, from the source reader.
+  // This calls OnFinishReadFromSource when it completes (either synchronously
+  // or asynchronously).
   void ReadFromSourceIfNeeded();
   void OnFinishReadFromSource(net::IOBuffer* buffer, int result);
 
+  // Returns a drained buffer to the pool, if the pool is not full.
+  void ReleaseBuffer(net::IOBuffer* buffer);
+
+  // Updates |consumption_rate_| and |readahead_buffers_| with the bytes
+  // consumed since the last sample.
+  void UpdateReadaheadWindow();
+
   // This is reset to NULL upon encountering a read error or EOF.
   scoped_ptr<storage::FileStreamReader> source_;
 
@@ -47,13 +77,33 @@ class ReadaheadFileStreamReader
 
   // This contains a queue of buffers filled from |source_|, waiting to be
   // consumed.
-  std::queue<scoped_refptr<net::DrainableIOBuffer> > buffers_;
+  std::deque<FilledBuffer> buffers_;
+
+  // Drained buffers, ready to be filled again.
+  std::vector<scoped_refptr<net::IOBuffer> > free_buffers_;
+
+  // The number of buffers that |buffers_| is topped up to.
+  size_t readahead_buffers_;
+
+  // The number of bytes consumed per second, smoothed over the samples.
+  double consumption_rate_;
+  int64 bytes_consumed_in_sample_;
+  base::TimeTicks sample_start_time_;
+
+  // The number of buffers allocated so far. Used for testing.
+  int buffers_allocated_;
 
   // The read buffer waiting for the source FileStreamReader to finish
   // reading and fill the cache.
-  scoped_refptr<net::DrainableIOBuffer> pending_sink_buffer_;
+  scoped_refptr<net::IOBuffer> pending_sink_buffer_;
+  int pending_sink_len_;
   net::CompletionCallback pending_read_callback_;
 
+  // Note: |clock_| is always |&default_tick_clock_|, except during unit
+  // testing.
+  base::DefaultTickClock default_tick_clock_;
+  base::TickClock* clock_;
+
   base::WeakPtrFactory<ReadaheadFileStreamReader> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(ReadaheadFileStreamReader);
@@ -0,0 +1,105 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/media_galleries/fileapi/readahead_file_stream_reader.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/time/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+const int kMB = 1024 * 1024;
+const int kReadSize = 64 * 1024;
+const int kFileSize = 256 * kMB;
+
+}  // namespace
+
+class ReadaheadFileStreamReaderPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    file_path_ = temp_dir_.path().AppendASCII("media.avi");
+    std::string data(kFileSize, 0);
+    for (int i = 0; i < kFileSize; ++i)
+      data[i] = static_cast<char>((i * 7 + i / 4099) % 256);
+    ASSERT_EQ(kFileSize,
+              base::WriteFile(file_path_, data.data(), data.size()));
+  }
+
+  storage::FileStreamReader* CreateLocalReader() {
+    return storage::FileStreamReader::CreateForLocalFile(
+        message_loop_.message_loop_proxy().get(), file_path_, 0,
+        base::Time());
+  }
+
+  // Reads |reader| to the end and returns the number of bytes read.
+  int ReadAll(storage::FileStreamReader* reader) {
+    scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kReadSize));
+    int total = 0;
+    int result;
+    do {
+      net::TestCompletionCallback callback;
+      result = reader->Read(buf.get(), kReadSize, callback.callback());
+      if (result == net::ERR_IO_PENDING)
+        result = callback.WaitForResult();
+      if (result > 0)
+        total += result;
+    } while (result > 0);
+    EXPECT_EQ(0, result);
+    return total;
+  }
+
+  size_t readahead_buffers(ReadaheadFileStreamReader* reader) const {
+    return reader->readahead_buffers_;
+  }
+
+  int buffers_allocated(ReadaheadFileStreamReader* reader) const {
+    return reader->buffers_allocated_;
+  }
+
+  base::MessageLoopForIO message_loop_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath file_path_;
+};
+
+// Compares the throughput of reading a local file directly and through the
+// readahead reader.
+TEST_F(ReadaheadFileStreamReaderPerfTest, LocalFileThroughput) {
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  scoped_ptr<storage::FileStreamReader> local_reader(CreateLocalReader());
+  EXPECT_EQ(kFileSize, ReadAll(local_reader.get()));
+  base::TimeDelta local_time = base::TimeTicks::Now() - start_time;
+
+  start_time = base::TimeTicks::Now();
+  scoped_ptr<ReadaheadFileStreamReader> reader(
+      new ReadaheadFileStreamReader(CreateLocalReader()));
+  EXPECT_EQ(kFileSize, ReadAll(reader.get()));
+  base::TimeDelta readahead_time = base::TimeTicks::Now() - start_time;
+
+  double megabytes = static_cast<double>(kFileSize) / kMB;
+  perf_test::PrintResult("readahead_file_stream_reader_throughput", "",
+                         "local_file", megabytes / local_time.InSecondsF(),
+                         "MB/s", false);
+  perf_test::PrintResult("readahead_file_stream_reader_throughput", "",
+                         "readahead",
+                         megabytes / readahead_time.InSecondsF(), "MB/s",
+                         true);
+  perf_test::PrintResult("readahead_file_stream_reader_buffers", "",
+                         "window", readahead_buffers(reader.get()),
+                         "buffers", false);
+  perf_test::PrintResult("readahead_file_stream_reader_buffers", "",
+                         "allocated",
+                         static_cast<size_t>(buffers_allocated(reader.get())),
+                         "buffers", false);
+}
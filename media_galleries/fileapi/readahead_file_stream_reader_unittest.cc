@@ -0,0 +1,145 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/media_galleries/fileapi/readahead_file_stream_reader.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "base/time/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kMB = 1024 * 1024;
+const int kReadSize = 64 * 1024;
+
+// Returns |size| bytes that do not repeat every buffer.
+std::string CreateTestData(int size) {
+  std::string data(size, 0);
+  for (int i = 0; i < size; ++i)
+    data[i] = static_cast<char>((i * 7 + i / 4099) % 256);
+  return data;
+}
+
+}  // namespace
+
+class ReadaheadFileStreamReaderTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    file_path_ = temp_dir_.path().AppendASCII("media.avi");
+    // Start |clock_| at non-zero.
+    clock_.Advance(base::TimeDelta::FromSeconds(1000));
+  }
+
+  void CreateFile(const std::string& data) {
+    ASSERT_EQ(static_cast<int>(data.size()),
+              base::WriteFile(file_path_, data.data(), data.size()));
+  }
+
+  storage::FileStreamReader* CreateLocalReader() {
+    return storage::FileStreamReader::CreateForLocalFile(
+        message_loop_.message_loop_proxy().get(), file_path_, 0,
+        base::Time());
+  }
+
+  ReadaheadFileStreamReader* CreateReader(bool use_test_clock) {
+    ReadaheadFileStreamReader* reader =
+        new ReadaheadFileStreamReader(CreateLocalReader());
+    if (use_test_clock)
+      reader->clock_ = &clock_;
+    return reader;
+  }
+
+  // Reads up to |read_size| bytes and appends them to |data|. Returns the
+  // result of the read.
+  int ReadChunk(storage::FileStreamReader* reader,
+                int read_size,
+                std::string* data) {
+    scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(read_size));
+    net::TestCompletionCallback callback;
+    int result = reader->Read(buf.get(), read_size, callback.callback());
+    if (result == net::ERR_IO_PENDING)
+      result = callback.WaitForResult();
+    if (result > 0)
+      data->append(buf->data(), result);
+    return result;
+  }
+
+  std::string ReadAll(storage::FileStreamReader* reader, int read_size) {
+    std::string data;
+    int result;
+    while ((result = ReadChunk(reader, read_size, &data)) > 0) {}
+    EXPECT_EQ(0, result);
+    return data;
+  }
+
+  size_t readahead_buffers(ReadaheadFileStreamReader* reader) const {
+    return reader->readahead_buffers_;
+  }
+
+  int buffers_allocated(ReadaheadFileStreamReader* reader) const {
+    return reader->buffers_allocated_;
+  }
+
+  base::MessageLoopForIO message_loop_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath file_path_;
+  base::SimpleTestTickClock clock_;
+};
+
+TEST_F(ReadaheadFileStreamReaderTest, ReadsWholeFile) {
+  std::string expected = CreateTestData(5 * kMB + 123);
+  CreateFile(expected);
+
+  const int kReadSizes[] = { 1000, kReadSize, 3 * kMB };
+  for (size_t i = 0; i < arraysize(kReadSizes); ++i) {
+    scoped_ptr<ReadaheadFileStreamReader> reader(CreateReader(false));
+    EXPECT_TRUE(expected == ReadAll(reader.get(), kReadSizes[i]))
+        << "read size " << kReadSizes[i];
+  }
+}
+
+TEST_F(ReadaheadFileStreamReaderTest, ReusesBuffers) {
+  std::string expected = CreateTestData(10 * kMB);
+  CreateFile(expected);
+
+  // The clock does not move, so the window stays at its smallest.
+  scoped_ptr<ReadaheadFileStreamReader> reader(CreateReader(true));
+  EXPECT_TRUE(expected == ReadAll(reader.get(), kReadSize));
+  EXPECT_EQ(2U, readahead_buffers(reader.get()));
+  EXPECT_GE(3, buffers_allocated(reader.get()));
+}
+
+TEST_F(ReadaheadFileStreamReaderTest, WindowFollowsConsumptionRate) {
+  std::string expected = CreateTestData(8 * kMB);
+  CreateFile(expected);
+  scoped_ptr<ReadaheadFileStreamReader> reader(CreateReader(true));
+
+  // 64 KB every 10 ms, about 6.5 MB per second.
+  std::string data;
+  for (int i = 0; i < 51; ++i) {
+    ASSERT_EQ(kReadSize, ReadChunk(reader.get(), kReadSize, &data));
+    clock_.Advance(base::TimeDelta::FromMilliseconds(10));
+  }
+  EXPECT_EQ(7U, readahead_buffers(reader.get()));
+
+  // 64 KB every 100 ms, below the smallest window.
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_EQ(kReadSize, ReadChunk(reader.get(), kReadSize, &data));
+    clock_.Advance(base::TimeDelta::FromMilliseconds(100));
+  }
+  EXPECT_EQ(2U, readahead_buffers(reader.get()));
+
+  data += ReadAll(reader.get(), kReadSize);
+  EXPECT_TRUE(expected == data);
+}
@@ -13,6 +13,7 @@
 #include "base/sequence_checker.h"
 #include "base/stl_util.h"
 #include "base/strings/string_util.h"
+#include "base/synchronization/cancellation_flag.h"
 #include "base/task_runner_util.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "chrome/browser/extensions/api/file_system/file_system_api.h"
@@ -29,7 +30,8 @@
 using storage_monitor::StorageInfo;
 using storage_monitor::StorageMonitor;
 
-typedef base::Callback<void(const std::vector<base::FilePath>& /*roots*/)>
+typedef base::Callback<void(const std::vector<base::FilePath>& /*roots*/,
+                            const std::vector<std::string>& /*devices*/)>
     DefaultScanRootsCallback;
 using content::BrowserThread;
 
@@ -39,6 +41,16 @@ const int64 kMinimumImageSize = 200 * 1024;    // 200 KB
 const int64 kMinimumAudioSize = 500 * 1024;    // 500 KB
 const int64 kMinimumVideoSize = 1024 * 1024;   // 1 MB
 
+// The number of folders scanned at once, across all roots.
+const size_t kMaxConcurrentScans = 4;
+
+// The number of folders scanned at once on one device. A spinning disk gets
+// slower, not faster, with more directories read from it at once.
+const int kMaxConcurrentScansPerDevice = 2;
+
+// The number of folders scanned between two progress reports.
+const int kFoldersPerProgressReport = 100;
+
 const int kPrunedPaths[] = {
 #if defined(OS_WIN)
   base::DIR_IE_INTERNET_CACHE,
@@ -126,15 +138,42 @@ base::FilePath GetPlatformSpecificDefaultScanRoot() {
   return root;
 }
 
+// Returns the device ID of the storage |path| is on, which is the one of the
+// |storages| with the deepest location containing |path|. A path on none of
+// them is a device of its own.
+std::string GetStorageDeviceId(const base::FilePath& path,
+                               const std::vector<StorageInfo>& storages) {
+  std::string device_id = path.AsUTF8Unsafe();
+  base::FilePath device_location;
+  for (size_t i = 0; i < storages.size(); ++i) {
+    base::FilePath location(storages[i].location());
+    if ((location == path || location.IsParent(path)) &&
+        (device_location.empty() || device_location.IsParent(location))) {
+      device_id = storages[i].device_id();
+      device_location = location;
+    }
+  }
+  return device_id;
+}
+
 // Find the likely locations with user media files and pass them to
-// |callback|. Locations are platform specific.
+// |callback|, along with the device each is on. Locations are platform
+// specific.
 void GetDefaultScanRoots(const DefaultScanRootsCallback& callback,
                          bool has_override,
-                         const std::vector<base::FilePath>& override_paths) {
+                         const std::vector<base::FilePath>& override_paths,
+                         const std::vector<std::string>& override_devices) {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
 
   if (has_override) {
-    callback.Run(override_paths);
+    if (!override_devices.empty()) {
+      callback.Run(override_paths, override_devices);
+      return;
+    }
+    std::vector<std::string> devices;
+    for (size_t i = 0; i < override_paths.size(); ++i)
+      devices.push_back(override_paths[i].AsUTF8Unsafe());
+    callback.Run(override_paths, devices);
     return;
   }
 
@@ -142,6 +181,7 @@ void GetDefaultScanRoots(const DefaultScanRootsCallback& callback,
   DCHECK(monitor->IsInitialized());
 
   std::vector<base::FilePath> roots;
+  std::vector<std::string> devices;
   std::vector<StorageInfo> storages = monitor->GetAllAvailableStorages();
   for (size_t i = 0; i < storages.size(); ++i) {
     StorageInfo::Type type;
@@ -154,12 +194,17 @@ void GetDefaultScanRoots(const DefaultScanRootsCallback& callback,
     if (ShouldIgnoreScanRoot(path))
       continue;
     roots.push_back(path);
+    devices.push_back(storages[i].device_id());
   }
 
+  // The platform root is usually on one of the storages, e.g. the home
+  // directory on the one mounted at /, even if that storage is not scanned.
   base::FilePath platform_root = GetPlatformSpecificDefaultScanRoot();
-  if (!platform_root.empty())
+  if (!platform_root.empty()) {
     roots.push_back(platform_root);
-  callback.Run(roots);
+    devices.push_back(GetStorageDeviceId(platform_root, storages));
+  }
+  callback.Run(roots, devices);
 }
 
 }  // namespace
@@ -178,9 +223,17 @@ class MediaFolderFinder::Worker {
   // Scans |path| and return the results.
   WorkerReply ScanFolder(const base::FilePath& path);
 
+  // Makes the scan in progress, if any, and the ones after it stop early. Must
+  // be called on the UI thread.
+  void Cancel();
+
  private:
   void MakeFolderPathsAbsolute();
 
+  // Created on the UI thread, where it is set, and read on the worker's
+  // sequence.
+  base::CancellationFlag cancelled_;
+
   bool folder_paths_are_absolute_;
   std::vector<base::FilePath> graylisted_folders_;
   std::vector<base::FilePath> pruned_folders_;
@@ -221,6 +274,9 @@ MediaFolderFinder::WorkerReply MediaFolderFinder::Worker::ScanFolder(
     MakeFolderPathsAbsolute();
 
   WorkerReply reply;
+  if (cancelled_.IsSet())
+    return reply;
+
   bool folder_meets_size_requirement = false;
   bool is_graylisted_folder = false;
   base::FilePath abspath = base::MakeAbsoluteFilePath(path);
@@ -244,6 +300,9 @@ MediaFolderFinder::WorkerReply MediaFolderFinder::Worker::ScanFolder(
 #endif
       );  // NOLINT
   while (!enumerator.Next().empty()) {
+    if (cancelled_.IsSet())
+      return WorkerReply();
+
     base::FileEnumerator::FileInfo file_info = enumerator.GetInfo();
     base::FilePath full_path = path.Append(file_info.GetName());
     if (MediaPathFilter::ShouldSkip(full_path))
@@ -289,6 +348,11 @@ MediaFolderFinder::WorkerReply MediaFolderFinder::Worker::ScanFolder(
   return reply;
 }
 
+void MediaFolderFinder::Worker::Cancel() {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  cancelled_.Set();
+}
+
 void MediaFolderFinder::Worker::MakeFolderPathsAbsolute() {
   DCHECK(sequence_checker_.CalledOnValidSequencedThread());
   DCHECK(!folder_paths_are_absolute_);
@@ -310,25 +374,31 @@ void MediaFolderFinder::Worker::MakeFolderPathsAbsolute() {
   pruned_folders_ = abs_paths;
 }
 
+MediaFolderFinder::ScanRoot::ScanRoot() : device(0) {}
+
+MediaFolderFinder::ScanRoot::~ScanRoot() {}
+
 MediaFolderFinder::MediaFolderFinder(
     const MediaFolderFinderResultsCallback& callback)
     : results_callback_(callback),
+      folders_scanned_since_progress_(0),
       graylisted_folders_(
           extensions::file_system_api::GetGrayListedDirectories()),
       scan_state_(SCAN_STATE_NOT_STARTED),
-      worker_(new Worker(graylisted_folders_)),
+      max_concurrent_scans_(kMaxConcurrentScans),
+      max_concurrent_scans_per_device_(kMaxConcurrentScansPerDevice),
       has_roots_for_testing_(false),
       weak_factory_(this) {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
-
-  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
-  worker_task_runner_ = pool->GetSequencedTaskRunner(pool->GetSequenceToken());
 }
 
 MediaFolderFinder::~MediaFolderFinder() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
 
-  worker_task_runner_->DeleteSoon(FROM_HERE, worker_);
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->Cancel();
+    worker_task_runners_[i]->DeleteSoon(FROM_HERE, workers_[i]);
+  }
 
   if (scan_state_ == SCAN_STATE_FINISHED)
     return;
@@ -347,7 +417,15 @@ void MediaFolderFinder::StartScan() {
   GetDefaultScanRoots(
       base::Bind(&MediaFolderFinder::OnInitialized, weak_factory_.GetWeakPtr()),
       has_roots_for_testing_,
-      roots_for_testing_);
+      roots_for_testing_,
+      root_devices_for_testing_);
+}
+
+void MediaFolderFinder::set_progress_callback(
+    const MediaFolderFinderProgressCallback& progress_callback) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  DCHECK_EQ(SCAN_STATE_NOT_STARTED, scan_state_);
+  progress_callback_ = progress_callback;
 }
 
 const std::vector<base::FilePath>&
@@ -364,9 +442,37 @@ void MediaFolderFinder::SetRootsForTesting(
   roots_for_testing_ = roots;
 }
 
+void MediaFolderFinder::SetRootDevicesForTesting(
+    const std::vector<std::string>& devices) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  DCHECK_EQ(SCAN_STATE_NOT_STARTED, scan_state_);
+  DCHECK(has_roots_for_testing_);
+  DCHECK_EQ(roots_for_testing_.size(), devices.size());
+
+  root_devices_for_testing_ = devices;
+}
+
+void MediaFolderFinder::SetConcurrencyForTesting(
+    size_t max_concurrent_scans,
+    int max_concurrent_scans_per_device) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  DCHECK_EQ(SCAN_STATE_NOT_STARTED, scan_state_);
+  DCHECK_LT(0U, max_concurrent_scans);
+  DCHECK_LT(0, max_concurrent_scans_per_device);
+
+  max_concurrent_scans_ = max_concurrent_scans;
+  max_concurrent_scans_per_device_ = max_concurrent_scans_per_device;
+}
+
 void MediaFolderFinder::OnInitialized(
-    const std::vector<base::FilePath>& roots) {
+    const std::vector<base::FilePath>& roots,
+    const std::vector<std::string>& devices) {
   DCHECK_EQ(SCAN_STATE_STARTED, scan_state_);
+  DCHECK_EQ(roots.size(), devices.size());
+
+  std::map<base::FilePath, std::string> root_devices;
+  for (size_t i = 0; i < roots.size(); ++i)
+    root_devices.insert(std::make_pair(roots[i], devices[i]));
 
   std::set<base::FilePath> valid_roots;
   for (size_t i = 0; i < roots.size(); ++i) {
@@ -399,46 +505,129 @@ void MediaFolderFinder::OnInitialized(
     valid_roots.insert(path);
   }
 
-  std::copy(valid_roots.begin(), valid_roots.end(),
-            std::back_inserter(folders_to_scan_));
-  ScanFolder();
+  // Numbers the devices of the roots in order of appearance.
+  std::map<std::string, size_t> device_indexes;
+  roots_.resize(valid_roots.size());
+  size_t root = 0;
+  for (std::set<base::FilePath>::const_iterator it = valid_roots.begin();
+       it != valid_roots.end(); ++it, ++root) {
+    roots_[root].folders_to_scan.push_back(*it);
+    const std::string& device = root_devices[*it];
+    if (!ContainsKey(device_indexes, device)) {
+      size_t device_index = device_indexes.size();
+      device_indexes[device] = device_index;
+    }
+    roots_[root].device = device_indexes[device];
+  }
+  device_scans_in_flight_.resize(device_indexes.size());
+
+  // No more workers than the devices can keep busy at once.
+  size_t worker_count = std::min(
+      max_concurrent_scans_,
+      device_scans_in_flight_.size() *
+          static_cast<size_t>(max_concurrent_scans_per_device_));
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.push_back(new Worker(graylisted_folders_));
+    worker_task_runners_.push_back(
+        pool->GetSequencedTaskRunner(pool->GetSequenceToken()));
+    idle_workers_.push_back(i);
+  }
+  ScanFolders();
 }
 
-void MediaFolderFinder::ScanFolder() {
+void MediaFolderFinder::ScanFolders() {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
   DCHECK_EQ(SCAN_STATE_STARTED, scan_state_);
 
-  if (folders_to_scan_.empty()) {
-    scan_state_ = SCAN_STATE_FINISHED;
-    results_callback_.Run(true /* success? */, results_);
-    return;
+  while (!idle_workers_.empty()) {
+    int root = GetNextRootToScan();
+    if (root < 0)
+      break;
+
+    ScanRoot& scan_root = roots_[root];
+    base::FilePath folder_to_scan = scan_root.folders_to_scan.back();
+    scan_root.folders_to_scan.pop_back();
+    ++device_scans_in_flight_[scan_root.device];
+
+    size_t worker = idle_workers_.back();
+    idle_workers_.pop_back();
+    base::PostTaskAndReplyWithResult(
+        worker_task_runners_[worker], FROM_HERE,
+        base::Bind(&Worker::ScanFolder,
+                   base::Unretained(workers_[worker]),
+                   folder_to_scan),
+        base::Bind(&MediaFolderFinder::GotScanResults,
+                   weak_factory_.GetWeakPtr(),
+                   static_cast<size_t>(root),
+                   worker,
+                   folder_to_scan));
   }
 
-  base::FilePath folder_to_scan = folders_to_scan_.back();
-  folders_to_scan_.pop_back();
-  base::PostTaskAndReplyWithResult(
-      worker_task_runner_, FROM_HERE,
-      base::Bind(&Worker::ScanFolder,
-                 base::Unretained(worker_),
-                 folder_to_scan),
-      base::Bind(&MediaFolderFinder::GotScanResults,
-                 weak_factory_.GetWeakPtr(),
-                 folder_to_scan));
+  // The scan is done once every worker is idle with nothing left to scan.
+  if (idle_workers_.size() < workers_.size() || GetNextRootToScan() >= 0)
+    return;
+
+  scan_state_ = SCAN_STATE_FINISHED;
+  results_callback_.Run(true /* success? */, results_);
+}
+
+int MediaFolderFinder::GetNextRootToScan() const {
+  // Take from the root with the most folders left, so that roots with few
+  // folders do not keep workers away from one with a large tree.
+  int next_root = -1;
+  for (size_t i = 0; i < roots_.size(); ++i) {
+    const ScanRoot& scan_root = roots_[i];
+    if (scan_root.folders_to_scan.empty() ||
+        device_scans_in_flight_[scan_root.device] >=
+            max_concurrent_scans_per_device_) {
+      continue;
+    }
+    if (next_root < 0 ||
+        scan_root.folders_to_scan.size() >
+            roots_[next_root].folders_to_scan.size()) {
+      next_root = static_cast<int>(i);
+    }
+  }
+  return next_root;
 }
 
-void MediaFolderFinder::GotScanResults(const base::FilePath& path,
+void MediaFolderFinder::GotScanResults(size_t root,
+                                       size_t worker,
+                                       const base::FilePath& path,
                                        const WorkerReply& reply) {
   DCHECK_CURRENTLY_ON(BrowserThread::UI);
   DCHECK_EQ(SCAN_STATE_STARTED, scan_state_);
   DCHECK(!path.empty());
   CHECK(!ContainsKey(results_, path));
 
-  if (!IsEmptyScanResult(reply.scan_result))
+  ScanRoot& scan_root = roots_[root];
+  DCHECK_LT(0, device_scans_in_flight_[scan_root.device]);
+  --device_scans_in_flight_[scan_root.device];
+  idle_workers_.push_back(worker);
+
+  if (!IsEmptyScanResult(reply.scan_result)) {
     results_[path] = reply.scan_result;
+    if (!progress_callback_.is_null())
+      new_results_[path] = reply.scan_result;
+  }
 
-  // Push new folders to the |folders_to_scan_| in reverse order.
+  // Push new folders to the |folders_to_scan| in reverse order.
   std::copy(reply.new_folders.rbegin(), reply.new_folders.rend(),
-            std::back_inserter(folders_to_scan_));
+            std::back_inserter(scan_root.folders_to_scan));
+
+  if (++folders_scanned_since_progress_ >= kFoldersPerProgressReport) {
+    folders_scanned_since_progress_ = 0;
+    if (!new_results_.empty()) {
+      MediaFolderFinderResults new_results;
+      new_results.swap(new_results_);
+      // The callback may delete |this|.
+      base::WeakPtr<MediaFolderFinder> weak_this = weak_factory_.GetWeakPtr();
+      progress_callback_.Run(new_results);
+      if (!weak_this)
+        return;
+    }
+  }
 
-  ScanFolder();
+  ScanFolders();
 }
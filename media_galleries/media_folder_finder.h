@@ -6,6 +6,7 @@
 #define CHROME_BROWSER_MEDIA_GALLERIES_MEDIA_FOLDER_FINDER_H_
 
 #include <map>
+#include <string>
 #include <vector>
 
 #include "base/callback.h"
@@ -17,6 +18,12 @@
 
 // MediaFolderFinder scans local hard drives and look for folders that contain
 // media files.
+//
+// Folders are scanned in parallel by several workers on the blocking pool.
+// Scan roots are grouped by the StorageMonitor storage they are on, and only a
+// few folders of each storage are scanned at once, which keeps spinning disks
+// from seeking back and forth. Idle workers take folders from whichever root
+// has the most left to scan.
 class MediaFolderFinder {
  public:
   // Key: path to a folder
@@ -30,6 +37,11 @@ class MediaFolderFinder {
                               const MediaFolderFinderResults& /*results*/)>
       MediaFolderFinderResultsCallback;
 
+  // Gets the results found since the previous call while the scan runs.
+  // These results are also passed to the MediaFolderFinderResultsCallback.
+  typedef base::Callback<void(const MediaFolderFinderResults& /*results*/)>
+      MediaFolderFinderProgressCallback;
+
   // |callback| will get called when the scan finishes. If the object is deleted
   // before it finishes, the scan will stop and |callback| will get called with
   // success = false.
@@ -41,9 +53,14 @@ class MediaFolderFinder {
   // Start the scan.
   virtual void StartScan();
 
+  // Must be called before StartScan().
+  void set_progress_callback(
+      const MediaFolderFinderProgressCallback& progress_callback);
+
   const std::vector<base::FilePath>& graylisted_folders() const;
 
  private:
+  friend class MediaFolderFinderPerfTest;
   friend class MediaFolderFinderTest;
   friend class MediaGalleriesPlatformAppBrowserTest;
 
@@ -62,31 +79,78 @@ class MediaFolderFinder {
     SCAN_STATE_FINISHED,
   };
 
+  // The folders left to scan under one of the roots.
+  struct ScanRoot {
+    ScanRoot();
+    ~ScanRoot();
+
+    std::vector<base::FilePath> folders_to_scan;
+    // Index of the root's device in |device_scans_in_flight_|.
+    size_t device;
+  };
+
+  // Each root is on a device of its own, unless SetRootDevicesForTesting() is
+  // called.
   void SetRootsForTesting(const std::vector<base::FilePath>& roots);
 
-  void OnInitialized(const std::vector<base::FilePath>& roots);
+  // Sets the device of each of the roots set with SetRootsForTesting(). Roots
+  // with the same |devices| entry are on the same device.
+  void SetRootDevicesForTesting(const std::vector<std::string>& devices);
+
+  // Sets how many folders are scanned at once, in total and per device.
+  void SetConcurrencyForTesting(size_t max_concurrent_scans,
+                                int max_concurrent_scans_per_device);
 
-  // Scan a folder from |folders_to_scan_|.
-  void ScanFolder();
+  // |devices| has an entry for each of the |roots|, which identifies the
+  // device it is on.
+  void OnInitialized(const std::vector<base::FilePath>& roots,
+                     const std::vector<std::string>& devices);
 
-  // Callback that handles the |reply| from |worker_| for a scanned |path|.
-  void GotScanResults(const base::FilePath& path, const WorkerReply& reply);
+  // Hands folders from |roots_| to the idle workers, or finishes the scan if
+  // there are none left.
+  void ScanFolders();
+
+  // Returns the index of the root to scan a folder from next, or -1 if every
+  // root is either done or on a device at its concurrency cap.
+  int GetNextRootToScan() const;
+
+  // Callback that handles the |reply| from |workers_[worker]| for a scanned
+  // |path| under |roots_[root]|.
+  void GotScanResults(size_t root,
+                      size_t worker,
+                      const base::FilePath& path,
+                      const WorkerReply& reply);
 
   const MediaFolderFinderResultsCallback results_callback_;
+  MediaFolderFinderProgressCallback progress_callback_;
   MediaFolderFinderResults results_;
 
+  // The results found since the last progress report.
+  MediaFolderFinderResults new_results_;
+  int folders_scanned_since_progress_;
+
   std::vector<base::FilePath> graylisted_folders_;
-  std::vector<base::FilePath> folders_to_scan_;
+  std::vector<ScanRoot> roots_;
   ScanState scan_state_;
 
-  scoped_refptr<base::SequencedTaskRunner> worker_task_runner_;
+  // The number of folders being scanned on each of the devices of |roots_|.
+  std::vector<int> device_scans_in_flight_;
+
+  size_t max_concurrent_scans_;
+  int max_concurrent_scans_per_device_;
+
+  // Owned by MediaFolderFinder, but each lives on the task runner with the
+  // same index.
+  std::vector<Worker*> workers_;
+  std::vector<scoped_refptr<base::SequencedTaskRunner> > worker_task_runners_;
 
-  // Owned by MediaFolderFinder, but lives on |worker_task_runner_|.
-  Worker* worker_;
+  // Indexes of the |workers_| without a folder to scan.
+  std::vector<size_t> idle_workers_;
 
   // Set of roots to scan for testing.
   bool has_roots_for_testing_;
   std::vector<base::FilePath> roots_for_testing_;
+  std::vector<std::string> root_devices_for_testing_;
 
   base::WeakPtrFactory<MediaFolderFinder> weak_factory_;
 
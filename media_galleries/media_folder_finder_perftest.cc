@@ -0,0 +1,106 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/media_galleries/media_folder_finder.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/format_macros.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+const size_t kRootCount = 2;
+const size_t kFoldersPerRoot = 500;
+const size_t kFilesPerFolder = 1000;
+
+}  // namespace
+
+class MediaFolderFinderPerfTest : public testing::Test {
+ public:
+  MediaFolderFinderPerfTest() : received_results_(false) {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(fake_dir_.CreateUniqueTempDir());
+  }
+
+ protected:
+  // Creates a synthetic tree of |kRootCount| roots holding |kFoldersPerRoot|
+  // folders of |kFilesPerFolder| files each, and returns the roots.
+  std::vector<base::FilePath> CreateTree() {
+    std::vector<base::FilePath> roots;
+    for (size_t i = 0; i < kRootCount; ++i) {
+      base::FilePath root =
+          fake_dir_.path().AppendASCII(base::StringPrintf("root%" PRIuS, i));
+      roots.push_back(root);
+      for (size_t j = 0; j < kFoldersPerRoot; ++j) {
+        base::FilePath dir =
+            root.AppendASCII(base::StringPrintf("dir%" PRIuS, j));
+        EXPECT_TRUE(base::CreateDirectory(dir));
+        for (size_t k = 0; k < kFilesPerFolder; ++k) {
+          base::FilePath file =
+              dir.AppendASCII(base::StringPrintf("file%" PRIuS ".txt", k));
+          EXPECT_EQ(0, base::WriteFile(file, "", 0));
+        }
+      }
+    }
+    return roots;
+  }
+
+  // Scans |roots|, with a single worker or with the default concurrency, and
+  // reports the time it took as |trace|.
+  void TimeScan(const std::vector<base::FilePath>& roots,
+                bool single_worker,
+                const std::string& trace) {
+    received_results_ = false;
+    MediaFolderFinder finder(
+        base::Bind(&MediaFolderFinderPerfTest::OnGotResults,
+                   base::Unretained(this)));
+    finder.SetRootsForTesting(roots);
+    if (single_worker)
+      finder.SetConcurrencyForTesting(1, 1);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    finder.StartScan();
+    while (!received_results_) {
+      base::RunLoop().RunUntilIdle();
+      content::BrowserThread::GetBlockingPool()->FlushForTesting();
+    }
+    base::TimeDelta scan_time = base::TimeTicks::Now() - start;
+
+    perf_test::PrintResult("media_folder_finder_scan", "", trace,
+                           scan_time.InMillisecondsF(), "ms", true);
+  }
+
+ private:
+  void OnGotResults(
+      bool success,
+      const MediaFolderFinder::MediaFolderFinderResults& results) {
+    EXPECT_TRUE(success);
+    received_results_ = true;
+  }
+
+  content::TestBrowserThreadBundle thread_bundle_;
+  base::ScopedTempDir fake_dir_;
+  bool received_results_;
+};
+
+// Scans a synthetic tree of a million files spread over two roots on
+// different devices, once with a single worker and once in parallel.
+TEST_F(MediaFolderFinderPerfTest, ScanLargeTree) {
+  std::vector<base::FilePath> roots = CreateTree();
+  TimeScan(roots, true, "one_worker");
+  TimeScan(roots, false, "parallel");
+}
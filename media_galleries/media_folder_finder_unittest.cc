@@ -11,7 +11,9 @@
 #include "base/bind.h"
 #include "base/file_util.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/format_macros.h"
 #include "base/run_loop.h"
+#include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/test/scoped_path_override.h"
 #include "base/threading/sequenced_worker_pool.h"
@@ -52,6 +54,27 @@ class MediaFolderFinderTest : public testing::Test {
     media_folder_finder_->SetRootsForTesting(roots);
   }
 
+  void SetRootDevices(const std::vector<std::string>& devices) {
+    media_folder_finder_->SetRootDevicesForTesting(devices);
+  }
+
+  void SetConcurrency(size_t max_concurrent_scans,
+                      int max_concurrent_scans_per_device) {
+    media_folder_finder_->SetConcurrencyForTesting(
+        max_concurrent_scans, max_concurrent_scans_per_device);
+  }
+
+  // Collects the progress reports in |progress_results()|. The finder is
+  // deleted on the first report if |delete_on_progress|.
+  void ListenForProgress(bool delete_on_progress) {
+    delete_on_progress_ = delete_on_progress;
+    progress_count_ = 0;
+    progress_results_.clear();
+    media_folder_finder_->set_progress_callback(
+        base::Bind(&MediaFolderFinderTest::OnGotProgress,
+                   base::Unretained(this)));
+  }
+
   void StartScan() {
     media_folder_finder_->StartScan();
   }
@@ -65,6 +88,14 @@ class MediaFolderFinderTest : public testing::Test {
     return received_results_;
   }
 
+  int progress_count() const {
+    return progress_count_;
+  }
+
+  const MediaFolderFinder::MediaFolderFinderResults& progress_results() const {
+    return progress_results_;
+  }
+
   const base::FilePath& fake_dir() const {
     return fake_dir_.path();
   }
@@ -77,6 +108,14 @@ class MediaFolderFinderTest : public testing::Test {
     ASSERT_TRUE(base::CreateDirectory(parent_dir));
   }
 
+  // Creates |count| empty folders in |parent_dir|.
+  void CreateTestDirs(const base::FilePath& parent_dir, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      CreateTestDir(
+          parent_dir.AppendASCII(base::StringPrintf("dir%" PRIuS, i)));
+    }
+  }
+
   void CreateTestFile(const base::FilePath& parent_dir,
                       MediaGalleryScanFileType type,
                       size_t count,
@@ -147,6 +186,19 @@ class MediaFolderFinderTest : public testing::Test {
   }
 
  private:
+  void OnGotProgress(
+      const MediaFolderFinder::MediaFolderFinderResults& results) {
+    ++progress_count_;
+    for (MediaFolderFinder::MediaFolderFinderResults::const_iterator it =
+             results.begin();
+         it != results.end(); ++it) {
+      EXPECT_FALSE(ContainsKey(progress_results_, it->first));
+      progress_results_.insert(*it);
+    }
+    if (delete_on_progress_)
+      DeleteMediaFolderFinder();
+  }
+
   void OnGotResults(
       bool success,
       const MediaFolderFinder::MediaFolderFinderResults& results) {
@@ -191,6 +243,10 @@ class MediaFolderFinderTest : public testing::Test {
   MediaFolderFinder::MediaFolderFinderResults expected_results_;
   bool received_results_;
 
+  bool delete_on_progress_;
+  int progress_count_;
+  MediaFolderFinder::MediaFolderFinderResults progress_results_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaFolderFinderTest);
 };
 
@@ -409,3 +465,99 @@ TEST_F(MediaFolderFinderTest, Graylist) {
   RunLoopUntilReceivedCallback();
   DeleteMediaFolderFinder();
 }
+
+TEST_F(MediaFolderFinderTest, ScanMultipleRoots) {
+  MediaFolderFinder::MediaFolderFinderResults expected_results;
+  std::vector<base::FilePath> folders;
+
+  // Several roots, each with folders to keep more than one worker busy.
+  for (int i = 0; i < 3; ++i) {
+    base::FilePath root =
+        fake_dir().AppendASCII(base::StringPrintf("root%d", i));
+    folders.push_back(root);
+    CreateTestDir(root);
+    CreateTestDirs(root, 10);
+    for (int j = 0; j < 3; ++j) {
+      base::FilePath dir = root.AppendASCII(base::StringPrintf("dir%d", j));
+      CreateTestFile(dir.AppendASCII("media"),
+                     MEDIA_GALLERY_SCAN_FILE_TYPE_AUDIO, i + j + 1, true,
+                     &expected_results);
+    }
+  }
+
+  CreateMediaFolderFinder(folders, true, expected_results);
+  StartScan();
+  RunLoopUntilReceivedCallback();
+  DeleteMediaFolderFinder();
+
+  // The same results with a single worker.
+  CreateMediaFolderFinder(folders, true, expected_results);
+  SetConcurrency(1, 1);
+  StartScan();
+  RunLoopUntilReceivedCallback();
+  DeleteMediaFolderFinder();
+}
+
+TEST_F(MediaFolderFinderTest, ScanRootsOnOneDevice) {
+  MediaFolderFinder::MediaFolderFinderResults expected_results;
+  std::vector<base::FilePath> folders;
+  std::vector<std::string> devices;
+
+  // Two roots on one device and one on another.
+  for (int i = 0; i < 3; ++i) {
+    base::FilePath root =
+        fake_dir().AppendASCII(base::StringPrintf("root%d", i));
+    folders.push_back(root);
+    devices.push_back(i < 2 ? "fixed:disk" : "removable:stick");
+    CreateTestDirs(root, 10);
+    CreateTestFile(root.AppendASCII("dir0"),
+                   MEDIA_GALLERY_SCAN_FILE_TYPE_IMAGE, i + 1, true,
+                   &expected_results);
+  }
+
+  CreateMediaFolderFinder(folders, true, expected_results);
+  SetRootDevices(devices);
+  SetConcurrency(4, 1);
+  StartScan();
+  RunLoopUntilReceivedCallback();
+  DeleteMediaFolderFinder();
+}
+
+TEST_F(MediaFolderFinderTest, ReportsProgress) {
+  MediaFolderFinder::MediaFolderFinderResults expected_results;
+  std::vector<base::FilePath> folders;
+  folders.push_back(fake_dir());
+
+  // The root is scanned first, and a report is due after 100 more folders.
+  CreateTestFile(fake_dir(), MEDIA_GALLERY_SCAN_FILE_TYPE_IMAGE, 1, true,
+                 &expected_results);
+  CreateTestDirs(fake_dir(), 150);
+
+  CreateMediaFolderFinder(folders, true, expected_results);
+  ListenForProgress(false);
+  StartScan();
+  RunLoopUntilReceivedCallback();
+  DeleteMediaFolderFinder();
+
+  EXPECT_EQ(1, progress_count());
+  ASSERT_EQ(1U, progress_results().size());
+  EXPECT_EQ(1, progress_results().find(fake_dir())->second.image_count);
+}
+
+TEST_F(MediaFolderFinderTest, CancelOnProgress) {
+  MediaFolderFinder::MediaFolderFinderResults expected_results;
+  std::vector<base::FilePath> folders;
+  folders.push_back(fake_dir());
+
+  MediaFolderFinder::MediaFolderFinderResults media_results;
+  CreateTestFile(fake_dir(), MEDIA_GALLERY_SCAN_FILE_TYPE_IMAGE, 1, true,
+                 &media_results);
+  CreateTestDirs(fake_dir(), 150);
+
+  CreateMediaFolderFinder(folders, false, expected_results);
+  ListenForProgress(true);
+  StartScan();
+  RunLoopUntilReceivedCallback();
+  EXPECT_EQ(1, progress_count());
+  RunLoop();
+}
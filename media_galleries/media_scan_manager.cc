@@ -233,6 +233,48 @@ int CountScanResultsForExtension(MediaGalleriesPreferences* preferences,
   return gallery_count;
 }
 
+// Adds the media files in the |new_folders| that are not in a gallery the
+// |extension| can already see to |file_counts|, the way
+// CountScanResultsForExtension() leaves them out of the final counts.
+void AddScanProgressForExtension(
+    MediaGalleriesPreferences* preferences,
+    const extensions::Extension* extension,
+    const MediaFolderFinder::MediaFolderFinderResults& new_folders,
+    MediaGalleryScanResult* file_counts) {
+  std::vector<base::FilePath> permitted_paths;
+  MediaGalleryPrefIdSet permitted_galleries =
+      preferences->GalleriesForExtension(*extension);
+  const MediaGalleriesPrefInfoMap& known_galleries =
+      preferences->known_galleries();
+  for (MediaGalleryPrefIdSet::const_iterator it = permitted_galleries.begin();
+       it != permitted_galleries.end();
+       ++it) {
+    MediaGalleriesPrefInfoMap::const_iterator gallery =
+        known_galleries.find(*it);
+    if (gallery != known_galleries.end())
+      permitted_paths.push_back(gallery->second.AbsolutePath());
+  }
+
+  for (MediaFolderFinder::MediaFolderFinderResults::const_iterator it =
+           new_folders.begin();
+       it != new_folders.end();
+       ++it) {
+    bool is_permitted = false;
+    for (size_t i = 0; i < permitted_paths.size(); ++i) {
+      if (permitted_paths[i] == it->first ||
+          permitted_paths[i].IsParent(it->first)) {
+        is_permitted = true;
+        break;
+      }
+    }
+    if (is_permitted)
+      continue;
+    file_counts->audio_count += it->second.audio_count;
+    file_counts->image_count += it->second.image_count;
+    file_counts->video_count += it->second.video_count;
+  }
+}
+
 int CountDirectoryEntries(const base::FilePath& path) {
   base::FileEnumerator dir_counter(
       path, false /*recursive*/, base::FileEnumerator::DIRECTORIES);
@@ -284,6 +326,7 @@ void MediaScanManager::RemoveObserver(Profile* profile) {
 void MediaScanManager::CancelScansForProfile(Profile* profile) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   observers_[profile].scanning_extensions.clear();
+  observers_[profile].scan_progress.clear();
 
   if (!ScanInProgress())
     folder_finder_.reset();
@@ -328,6 +371,8 @@ void MediaScanManager::StartScan(Profile* profile,
     scoped_extension_registry_observer_.Add(ExtensionRegistry::Get(profile));
 
   scanning_extensions->insert(extension->id());
+  scans_for_profile->second.scan_progress[extension->id()] =
+      MediaGalleryScanResult();
   scans_for_profile->second.observer->OnScanStarted(extension->id());
 
   if (folder_finder_)
@@ -341,6 +386,9 @@ void MediaScanManager::StartScan(Profile* profile,
   } else {
     folder_finder_.reset(testing_folder_finder_factory_.Run(callback));
   }
+  folder_finder_->set_progress_callback(
+      base::Bind(&MediaScanManager::OnScanProgress,
+                 weak_factory_.GetWeakPtr()));
   scan_start_time_ = base::Time::Now();
   folder_finder_->StartScan();
 }
@@ -355,6 +403,7 @@ void MediaScanManager::CancelScan(Profile* profile,
       !scans_for_profile->second.scanning_extensions.erase(extension->id())) {
     return;
   }
+  scans_for_profile->second.scan_progress.erase(extension->id());
 
   scans_for_profile->second.observer->OnScanCancelled(extension->id());
 
@@ -481,6 +530,42 @@ bool MediaScanManager::ScanInProgress() const {
   return false;
 }
 
+void MediaScanManager::OnScanProgress(
+    const MediaFolderFinder::MediaFolderFinderResults& new_folders) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  for (ScanObserverMap::iterator scans_for_profile = observers_.begin();
+       scans_for_profile != observers_.end();
+       ++scans_for_profile) {
+    if (scans_for_profile->second.scanning_extensions.empty())
+      continue;
+    Profile* profile = scans_for_profile->first;
+    MediaGalleriesPreferences* preferences =
+        MediaGalleriesPreferencesFactory::GetForProfile(profile);
+    ExtensionService* extension_service =
+        extensions::ExtensionSystem::Get(profile)->extension_service();
+    if (!extension_service)
+      continue;
+
+    const ScanningExtensionIdSet& scanning_extensions =
+        scans_for_profile->second.scanning_extensions;
+    for (ScanningExtensionIdSet::const_iterator extension_id_it =
+             scanning_extensions.begin();
+         extension_id_it != scanning_extensions.end();
+         ++extension_id_it) {
+      const extensions::Extension* extension =
+          extension_service->GetExtensionById(*extension_id_it, false);
+      if (!extension)
+        continue;
+      MediaGalleryScanResult& file_counts =
+          scans_for_profile->second.scan_progress[*extension_id_it];
+      AddScanProgressForExtension(preferences, extension, new_folders,
+                                  &file_counts);
+      scans_for_profile->second.observer->OnScanProgress(*extension_id_it,
+                                                         file_counts);
+    }
+  }
+}
+
 void MediaScanManager::OnScanCompleted(
     bool success,
     const MediaFolderFinder::MediaFolderFinderResults& found_folders) {
@@ -547,6 +632,7 @@ void MediaScanManager::OnFoundContainerDirectories(
       }
     }
     scanning_extensions->clear();
+    scans_for_profile->second.scan_progress.clear();
     preferences->SetLastScanCompletionTime(base::Time::Now());
   }
   scoped_extension_registry_observer_.RemoveAll();
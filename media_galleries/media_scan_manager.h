@@ -72,6 +72,10 @@ class MediaScanManager : public extensions::ExtensionRegistryObserver {
     ~ScanObservers();
     MediaScanManagerObserver* observer;
     std::set<std::string /*extension id*/> scanning_extensions;
+    // The media files found so far by |folder_finder_| outside of the
+    // galleries each of the |scanning_extensions| can already see.
+    std::map<std::string /*extension id*/, MediaGalleryScanResult>
+        scan_progress;
   };
   typedef std::map<Profile*, ScanObservers> ScanObserverMap;
 
@@ -83,6 +87,9 @@ class MediaScanManager : public extensions::ExtensionRegistryObserver {
 
   bool ScanInProgress() const;
 
+  void OnScanProgress(
+      const MediaFolderFinder::MediaFolderFinderResults& new_folders);
+
   void OnScanCompleted(
       bool success,
       const MediaFolderFinder::MediaFolderFinderResults& found_folders);
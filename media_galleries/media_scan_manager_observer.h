@@ -14,6 +14,12 @@ class MediaScanManagerObserver {
  public:
   virtual void OnScanStarted(const std::string& extension_id) {}
   virtual void OnScanCancelled(const std::string& extension_id) {}
+  // Reported from time to time while the scan runs. |file_counts| are the
+  // media files found so far outside of the galleries the extension can
+  // already see.
+  virtual void OnScanProgress(
+      const std::string& extension_id,
+      const MediaGalleryScanResult& file_counts) {}
   virtual void OnScanFinished(
       const std::string& extension_id,
       int gallery_count,
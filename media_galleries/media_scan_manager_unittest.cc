@@ -97,6 +97,7 @@ class MediaScanManagerTest : public MediaScanManagerObserver,
         find_folders_destroy_count_(0),
         find_folders_success_(false),
         expected_gallery_count_(0),
+        progress_count_(0),
         profile_(new TestingProfile()) {}
 
   virtual ~MediaScanManagerTest() {
@@ -217,6 +218,14 @@ class MediaScanManagerTest : public MediaScanManagerObserver,
     return find_folders_destroy_count_;
   }
 
+  int progress_count() const {
+    return progress_count_;
+  }
+
+  const MediaGalleryScanResult& progress_file_counts() const {
+    return progress_file_counts_;
+  }
+
   void CheckFileCounts(MediaGalleryPrefId pref_id, int audio_count,
                        int image_count, int video_count) {
     if (!ContainsKey(known_galleries(), pref_id)) {
@@ -231,6 +240,14 @@ class MediaScanManagerTest : public MediaScanManagerObserver,
   }
 
   // MediaScanManagerObserver implementation.
+  virtual void OnScanProgress(
+      const std::string& extension_id,
+      const MediaGalleryScanResult& file_counts) OVERRIDE {
+    EXPECT_EQ(extension_->id(), extension_id);
+    ++progress_count_;
+    progress_file_counts_ = file_counts;
+  }
+
   virtual void OnScanFinished(
       const std::string& extension_id,
       int gallery_count,
@@ -251,6 +268,12 @@ class MediaScanManagerTest : public MediaScanManagerObserver,
                                                       sensitive_locations);
   }
 
+  // Reports |new_folders| as found by the running scan.
+  void ReportScanProgress(
+      const MediaFolderFinder::MediaFolderFinderResults& new_folders) {
+    media_scan_manager_->OnScanProgress(new_folders);
+  }
+
  private:
   void OnFindFoldersStarted(
       MediaFolderFinder::MediaFolderFinderResultsCallback callback) {
@@ -272,6 +295,9 @@ class MediaScanManagerTest : public MediaScanManagerObserver,
   int expected_gallery_count_;
   MediaGalleryScanResult expected_file_counts_;
 
+  int progress_count_;
+  MediaGalleryScanResult progress_file_counts_;
+
   base::ScopedTempDir test_results_dir_;
 
   // Needed for extension service & friends to work.
@@ -315,6 +341,44 @@ TEST_F(MediaScanManagerTest, SingleResult) {
   EXPECT_EQ(galleries_before + 1, gallery_count());
 }
 
+// Progress reports leave out the folders in galleries the extension can
+// already see, like the final counts do.
+TEST_F(MediaScanManagerTest, ProgressLeavesOutPermittedGalleries) {
+  MediaGalleryPrefId permitted_id =
+      AddGallery("permitted", MediaGalleryPrefInfo::kUserAdded, 0, 0, 0);
+  ASSERT_TRUE(gallery_prefs()->SetGalleryPermissionForExtension(
+      *extension(), permitted_id, true));
+  base::FilePath permitted_path =
+      known_galleries().find(permitted_id)->second.AbsolutePath();
+  base::FilePath found_path;
+  MakeTestFolder("found_media_folder", &found_path);
+
+  // The scan is still running until the container directories are found.
+  SetFindFoldersResults(true, MediaFolderFinder::MediaFolderFinderResults());
+  SetExpectedScanResults(0 /*gallery_count*/, MediaGalleryScanResult());
+  StartScan();
+
+  MediaGalleryScanResult file_counts;
+  file_counts.image_count = 2;
+  MediaFolderFinder::MediaFolderFinderResults new_folders;
+  new_folders[found_path] = file_counts;
+  new_folders[permitted_path] = file_counts;
+  new_folders[permitted_path.AppendASCII("photos")] = file_counts;
+  ReportScanProgress(new_folders);
+  EXPECT_EQ(1, progress_count());
+  EXPECT_EQ(2, progress_file_counts().image_count);
+
+  // The counts add up over the reports.
+  new_folders.clear();
+  new_folders[found_path.AppendASCII("more")] = file_counts;
+  ReportScanProgress(new_folders);
+  EXPECT_EQ(2, progress_count());
+  EXPECT_EQ(4, progress_file_counts().image_count);
+
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, FindFolderDestroyCount());
+}
+
 // Generally test that it includes directories with sufficient density
 // and excludes others.
 //
@@ -0,0 +1,178 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/metrics/task_flight_recorder.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/pending_task.h"
+#include "base/strings/stringprintf.h"
+
+namespace {
+
+// Durations longer than this are recorded as this, so they fit in 32 bits.
+const int64 kMaxMilliseconds = kint32max;
+
+int32 ClampMilliseconds(int64 milliseconds) {
+  return static_cast<int32>(
+      std::max(static_cast<int64>(0),
+               std::min(milliseconds, kMaxMilliseconds)));
+}
+
+}  // namespace
+
+TaskFlightRecorder::Entry::Entry()
+    : function_name(NULL),
+      file_name(NULL),
+      line_number(0),
+      running(false) {
+}
+
+TaskFlightRecorder::TaskFlightRecorder()
+    : origin_(base::TimeTicks::Now()),
+      next_sequence_(1),
+      recording_(false) {
+  COMPILE_ASSERT((kCapacity & (kCapacity - 1)) == 0,
+                 capacity_must_be_a_power_of_two);
+  memset(slots_, 0, sizeof(slots_));
+}
+
+TaskFlightRecorder::~TaskFlightRecorder() {}
+
+void TaskFlightRecorder::StartRecording() {
+  if (recording_)
+    return;
+  recording_ = true;
+  base::MessageLoop::current()->AddTaskObserver(this);
+}
+
+void TaskFlightRecorder::StopRecording() {
+  if (!recording_)
+    return;
+  recording_ = false;
+  running_.clear();
+  base::MessageLoop::current()->RemoveTaskObserver(this);
+}
+
+void TaskFlightRecorder::GetEntries(base::TimeTicks now,
+                                    std::vector<Entry>* entries) const {
+  entries->clear();
+  base::subtle::Atomic32 next = base::subtle::Acquire_Load(&next_sequence_);
+  base::subtle::Atomic32 first =
+      std::max(static_cast<base::subtle::Atomic32>(1),
+               next - static_cast<base::subtle::Atomic32>(kCapacity));
+  int32 now_ms = ToMilliseconds(now);
+  for (base::subtle::Atomic32 sequence = first; sequence < next; ++sequence) {
+    const Slot& slot = slots_[sequence & (kCapacity - 1)];
+    if (base::subtle::Acquire_Load(&slot.sequence) != sequence)
+      continue;
+    Entry entry;
+    entry.function_name = reinterpret_cast<const char*>(
+        base::subtle::NoBarrier_Load(&slot.function_name));
+    entry.file_name = reinterpret_cast<const char*>(
+        base::subtle::NoBarrier_Load(&slot.file_name));
+    entry.line_number = base::subtle::NoBarrier_Load(&slot.line_number);
+    entry.queue_delay = base::TimeDelta::FromMilliseconds(
+        base::subtle::NoBarrier_Load(&slot.queue_delay_ms));
+    int32 start_time_ms = base::subtle::NoBarrier_Load(&slot.start_time_ms);
+    int32 run_time_ms = base::subtle::Acquire_Load(&slot.run_time_ms);
+    // Skip the slot if it was reused while it was read.
+    base::subtle::MemoryBarrier();
+    if (base::subtle::NoBarrier_Load(&slot.sequence) != sequence)
+      continue;
+    entry.running = run_time_ms < 0;
+    entry.run_time = base::TimeDelta::FromMilliseconds(
+        entry.running ? std::max(0, now_ms - start_time_ms) : run_time_ms);
+    entries->push_back(entry);
+  }
+}
+
+// static
+int TaskFlightRecorder::GetBlockingEntry(const std::vector<Entry>& entries) {
+  int longest = -1;
+  for (int i = static_cast<int>(entries.size()) - 1; i >= 0; --i) {
+    if (entries[i].running)
+      return i;
+    if (longest < 0 || entries[i].run_time > entries[longest].run_time)
+      longest = i;
+  }
+  return longest;
+}
+
+// static
+std::string TaskFlightRecorder::FormatEntries(
+    const std::vector<Entry>& entries) {
+  std::string result;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const Entry& entry = entries[i];
+    base::StringAppendF(
+        &result, "%s %s:%d queued %" PRId64 " ms, %s %" PRId64 " ms\n",
+        entry.function_name ? entry.function_name : "?",
+        entry.file_name ? entry.file_name : "?",
+        entry.line_number,
+        entry.queue_delay.InMilliseconds(),
+        entry.running ? "running for" : "ran",
+        entry.run_time.InMilliseconds());
+  }
+  return result;
+}
+
+void TaskFlightRecorder::WillProcessTask(
+    const base::PendingTask& pending_task) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeTicks due = std::max(pending_task.time_posted,
+                                 pending_task.delayed_run_time);
+
+  base::subtle::Atomic32 sequence = next_sequence_;
+  Slot& slot = slots_[sequence & (kCapacity - 1)];
+  base::subtle::NoBarrier_Store(&slot.sequence, 0);
+  base::subtle::MemoryBarrier();
+  base::subtle::NoBarrier_Store(
+      &slot.function_name,
+      reinterpret_cast<base::subtle::AtomicWord>(
+          pending_task.posted_from.function_name()));
+  base::subtle::NoBarrier_Store(
+      &slot.file_name,
+      reinterpret_cast<base::subtle::AtomicWord>(
+          pending_task.posted_from.file_name()));
+  base::subtle::NoBarrier_Store(&slot.line_number,
+                                pending_task.posted_from.line_number());
+  base::subtle::NoBarrier_Store(
+      &slot.queue_delay_ms,
+      ClampMilliseconds(due.is_null() ? 0 : (now - due).InMilliseconds()));
+  base::subtle::NoBarrier_Store(&slot.start_time_ms, ToMilliseconds(now));
+  base::subtle::NoBarrier_Store(&slot.run_time_ms, -1);
+  base::subtle::Release_Store(&slot.sequence, sequence);
+
+  running_.push_back(sequence);
+  // Sequence numbers start over at one, as zero marks slots that are being
+  // written. The tasks from before are left out until the buffer refills.
+  base::subtle::Release_Store(&next_sequence_,
+                              sequence == kint32max ? 1 : sequence + 1);
+}
+
+void TaskFlightRecorder::DidProcessTask(
+    const base::PendingTask& pending_task) {
+  // Recording may have started while this task was running.
+  if (running_.empty())
+    return;
+  base::subtle::Atomic32 sequence = running_.back();
+  running_.pop_back();
+  Slot& slot = slots_[sequence & (kCapacity - 1)];
+  // Nested tasks may have wrapped around the buffer and reused the slot.
+  if (base::subtle::NoBarrier_Load(&slot.sequence) != sequence)
+    return;
+  int32 run_time_ms = ClampMilliseconds(
+      ToMilliseconds(base::TimeTicks::Now()) -
+      base::subtle::NoBarrier_Load(&slot.start_time_ms));
+  base::subtle::Release_Store(&slot.run_time_ms, run_time_ms);
+}
+
+int32 TaskFlightRecorder::ToMilliseconds(base::TimeTicks time) const {
+  return ClampMilliseconds((time - origin_).InMilliseconds());
+}
@@ -0,0 +1,110 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_METRICS_TASK_FLIGHT_RECORDER_H_
+#define CHROME_BROWSER_METRICS_TASK_FLIGHT_RECORDER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time.h"
+
+// Keeps the last |kCapacity| tasks run by the message loop of one thread, with
+// where they were posted from, how long they waited in the queue and how long
+// they ran. ThreadWatcher installs one on each watched thread so that the
+// tasks that led up to a hang can be reported from the WatchDog thread.
+//
+// The watched thread is the only writer. Each slot of the ring buffer carries
+// a sequence number that is cleared while the slot is written, so readers on
+// other threads never take a lock and just skip the slots that changed under
+// them.
+class TaskFlightRecorder
+    : public base::MessageLoop::TaskObserver,
+      public base::RefCountedThreadSafe<TaskFlightRecorder> {
+ public:
+  // The number of tasks kept. Must be a power of two.
+  static const size_t kCapacity = 64;
+
+  struct Entry {
+    Entry();
+
+    const char* function_name;
+    const char* file_name;
+    int line_number;
+    // The time from when the task was posted, or became due if it was
+    // delayed, until it started to run.
+    base::TimeDelta queue_delay;
+    // How long the task ran, or has been running if |running|.
+    base::TimeDelta run_time;
+    bool running;
+  };
+
+  TaskFlightRecorder();
+
+  // Starts and stops recording the tasks run by the current message loop. Must
+  // be called on the recorded thread.
+  void StartRecording();
+  void StopRecording();
+
+  // Copies the recorded tasks into |entries|, oldest first. The run time of
+  // tasks that are still running is measured up to |now|. Can be called on
+  // any thread.
+  void GetEntries(base::TimeTicks now, std::vector<Entry>* entries) const;
+
+  // Returns the index of the task in |entries| that is most likely blocking
+  // the thread: the innermost task that is still running, or else the one
+  // that ran the longest. Returns -1 if |entries| is empty.
+  static int GetBlockingEntry(const std::vector<Entry>& entries);
+
+  // Returns one line per entry, for hang trace files.
+  static std::string FormatEntries(const std::vector<Entry>& entries);
+
+  // base::MessageLoop::TaskObserver implementation.
+  virtual void WillProcessTask(const base::PendingTask& pending_task) OVERRIDE;
+  virtual void DidProcessTask(const base::PendingTask& pending_task) OVERRIDE;
+
+ private:
+  friend class base::RefCountedThreadSafe<TaskFlightRecorder>;
+
+  // All fields are atomic so that reading a slot while it is rewritten is not
+  // a data race. Times are in milliseconds, relative to |origin_| for the
+  // start time.
+  struct Slot {
+    // Zero while the slot is written, otherwise the number of the task.
+    base::subtle::Atomic32 sequence;
+    base::subtle::AtomicWord function_name;
+    base::subtle::AtomicWord file_name;
+    base::subtle::Atomic32 line_number;
+    base::subtle::Atomic32 queue_delay_ms;
+    base::subtle::Atomic32 start_time_ms;
+    // -1 while the task is running.
+    base::subtle::Atomic32 run_time_ms;
+  };
+
+  virtual ~TaskFlightRecorder();
+
+  int32 ToMilliseconds(base::TimeTicks time) const;
+
+  const base::TimeTicks origin_;
+
+  Slot slots_[kCapacity];
+
+  // The number of the next task. Only changed on the recorded thread.
+  base::subtle::Atomic32 next_sequence_;
+
+  // The numbers of the tasks that are running, innermost last. Nested message
+  // loops run tasks from within tasks. Only used on the recorded thread.
+  std::vector<base::subtle::Atomic32> running_;
+
+  // Only used on the recorded thread.
+  bool recording_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskFlightRecorder);
+};
+
+#endif  // CHROME_BROWSER_METRICS_TASK_FLIGHT_RECORDER_H_
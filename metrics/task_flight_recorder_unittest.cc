@@ -0,0 +1,118 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/metrics/task_flight_recorder.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+void Sleep(int milliseconds) {
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(milliseconds));
+}
+
+void GetEntries(TaskFlightRecorder* recorder,
+                std::vector<TaskFlightRecorder::Entry>* entries) {
+  recorder->GetEntries(base::TimeTicks::Now(), entries);
+}
+
+}  // namespace
+
+class TaskFlightRecorderTest : public testing::Test {
+ protected:
+  TaskFlightRecorderTest() : recorder_(new TaskFlightRecorder()) {}
+
+  virtual void SetUp() OVERRIDE {
+    recorder_->StartRecording();
+  }
+
+  virtual void TearDown() OVERRIDE {
+    recorder_->StopRecording();
+  }
+
+  base::MessageLoop message_loop_;
+  scoped_refptr<TaskFlightRecorder> recorder_;
+};
+
+TEST_F(TaskFlightRecorderTest, RecordsTasks) {
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 0));
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 30));
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 0));
+  base::RunLoop().RunUntilIdle();
+
+  std::vector<TaskFlightRecorder::Entry> entries;
+  GetEntries(recorder_.get(), &entries);
+  ASSERT_EQ(3U, entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_FALSE(entries[i].running);
+    EXPECT_NE(std::string::npos,
+              std::string(entries[i].file_name).find(
+                  "task_flight_recorder_unittest.cc"));
+    EXPECT_STREQ("TestBody", entries[i].function_name);
+  }
+  EXPECT_LT(entries[0].line_number, entries[1].line_number);
+  EXPECT_LE(30, entries[1].run_time.InMilliseconds());
+  EXPECT_EQ(1, TaskFlightRecorder::GetBlockingEntry(entries));
+
+  std::string formatted = TaskFlightRecorder::FormatEntries(entries);
+  EXPECT_NE(std::string::npos, formatted.find("TestBody"));
+  EXPECT_NE(std::string::npos, formatted.find(" ran "));
+}
+
+TEST_F(TaskFlightRecorderTest, RunningTaskIsBlocking) {
+  std::vector<TaskFlightRecorder::Entry> entries;
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 30));
+  message_loop_.PostTask(FROM_HERE,
+                         base::Bind(&GetEntries, recorder_, &entries));
+  base::RunLoop().RunUntilIdle();
+
+  ASSERT_EQ(2U, entries.size());
+  EXPECT_FALSE(entries[0].running);
+  EXPECT_TRUE(entries[1].running);
+  // The running task is blocking, even if an earlier task ran longer.
+  EXPECT_EQ(1, TaskFlightRecorder::GetBlockingEntry(entries));
+  EXPECT_NE(std::string::npos,
+            TaskFlightRecorder::FormatEntries(entries).find("running for"));
+}
+
+TEST_F(TaskFlightRecorderTest, QueueDelay) {
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 30));
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 0));
+  base::RunLoop().RunUntilIdle();
+
+  std::vector<TaskFlightRecorder::Entry> entries;
+  GetEntries(recorder_.get(), &entries);
+  ASSERT_EQ(2U, entries.size());
+  // The second task waited for the first one to finish.
+  EXPECT_LE(30, entries[1].queue_delay.InMilliseconds());
+}
+
+TEST_F(TaskFlightRecorderTest, KeepsLastTasks) {
+  for (size_t i = 0; i < TaskFlightRecorder::kCapacity + 10; ++i)
+    message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 0));
+  base::RunLoop().RunUntilIdle();
+
+  std::vector<TaskFlightRecorder::Entry> entries;
+  GetEntries(recorder_.get(), &entries);
+  EXPECT_EQ(TaskFlightRecorder::kCapacity, entries.size());
+}
+
+TEST_F(TaskFlightRecorderTest, StopRecording) {
+  recorder_->StopRecording();
+  message_loop_.PostTask(FROM_HERE, base::Bind(&Sleep, 0));
+  base::RunLoop().RunUntilIdle();
+
+  std::vector<TaskFlightRecorder::Entry> entries;
+  GetEntries(recorder_.get(), &entries);
+  EXPECT_TRUE(entries.empty());
+  EXPECT_EQ(-1, TaskFlightRecorder::GetBlockingEntry(entries));
+}
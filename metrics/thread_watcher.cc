@@ -11,8 +11,13 @@
 #include "base/debug/alias.h"
 #include "base/debug/debugger.h"
 #include "base/debug/dump_without_crashing.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/hash.h"
 #include "base/lazy_instance.h"
 #include "base/metrics/field_trial.h"
+#include "base/metrics/sparse_histogram.h"
+#include "base/path_service.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_tokenizer.h"
@@ -20,6 +25,7 @@
 #include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 #include "chrome/browser/chrome_notification_types.h"
+#include "chrome/common/chrome_paths.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/chrome_version_info.h"
 #include "chrome/common/logging_chrome.h"
@@ -121,6 +127,18 @@ void CrashBecauseThreadWasUnresponsive(BrowserThread::ID thread_id) {
   CHECK(false) << "Unknown thread was unresponsive.";  // Shouldn't be reached.
 }
 
+// Writes |trace| to the hang trace file for |thread_name| in the user data
+// directory, replacing the trace of any earlier hang of that thread. This
+// method is called on the blocking pool.
+void WriteHangTrace(const std::string& thread_name, const std::string& trace) {
+  base::FilePath user_data_dir;
+  if (!PathService::Get(chrome::DIR_USER_DATA, &user_data_dir))
+    return;
+  base::FilePath path =
+      user_data_dir.AppendASCII("Thread Hang " + thread_name + ".txt");
+  base::WriteFile(path, trace.data(), trace.size());
+}
+
 }  // namespace
 
 // ThreadWatcher methods and members.
@@ -138,6 +156,11 @@ ThreadWatcher::ThreadWatcher(const WatchingParams& params)
       ping_count_(params.unresponsive_threshold),
       response_time_histogram_(NULL),
       unresponsive_time_histogram_(NULL),
+      responsive_count_histogram_(NULL),
+      unresponsive_count_histogram_(NULL),
+      hung_task_histogram_(NULL),
+      hung_task_run_time_histogram_(NULL),
+      flight_recorder_(new TaskFlightRecorder()),
       unresponsive_count_(0),
       hung_processing_complete_(false),
       unresponsive_threshold_(params.unresponsive_threshold),
@@ -148,7 +171,13 @@ ThreadWatcher::ThreadWatcher(const WatchingParams& params)
   Initialize();
 }
 
-ThreadWatcher::~ThreadWatcher() {}
+ThreadWatcher::~ThreadWatcher() {
+  // The recorder has to be removed from the watched thread's message loop on
+  // that thread. The task keeps it alive until then.
+  watched_loop_->PostTask(
+      FROM_HERE,
+      base::Bind(&TaskFlightRecorder::StopRecording, flight_recorder_));
+}
 
 // static
 void ThreadWatcher::StartWatching(const WatchingParams& params) {
@@ -184,6 +213,9 @@ void ThreadWatcher::ActivateThreadWatching() {
   active_ = true;
   ping_count_ = unresponsive_threshold_;
   ResetHangCounters();
+  watched_loop_->PostTask(
+      FROM_HERE,
+      base::Bind(&TaskFlightRecorder::StartRecording, flight_recorder_));
   base::MessageLoop::current()->PostTask(
       FROM_HERE,
       base::Bind(&ThreadWatcher::PostPingMessage,
@@ -195,6 +227,9 @@ void ThreadWatcher::DeActivateThreadWatching() {
   active_ = false;
   ping_count_ = 0;
   weak_ptr_factory_.InvalidateWeakPtrs();
+  watched_loop_->PostTask(
+      FROM_HERE,
+      base::Bind(&TaskFlightRecorder::StopRecording, flight_recorder_));
 }
 
 void ThreadWatcher::WakeUp() {
@@ -344,6 +379,20 @@ void ThreadWatcher::Initialize() {
   unresponsive_count_histogram_ = base::LinearHistogram::FactoryGet(
       unresponsive_count_histogram_name, 1, 10, 11,
       base::Histogram::kUmaTargetedHistogramFlag);
+
+  const std::string hung_task_histogram_name =
+      "ThreadWatcher.HungTask." + thread_name_;
+  hung_task_histogram_ = base::SparseHistogram::FactoryGet(
+      hung_task_histogram_name,
+      base::HistogramBase::kUmaTargetedHistogramFlag);
+
+  const std::string hung_task_run_time_histogram_name =
+      "ThreadWatcher.HungTaskRunTime." + thread_name_;
+  hung_task_run_time_histogram_ = base::Histogram::FactoryTimeGet(
+      hung_task_run_time_histogram_name,
+      base::TimeDelta::FromMilliseconds(1),
+      base::TimeDelta::FromSeconds(100), 50,
+      base::Histogram::kUmaTargetedHistogramFlag);
 }
 
 // static
@@ -387,6 +436,9 @@ void ThreadWatcher::GotNoResponse() {
   // Record how many watched threads are not responding.
   unresponsive_count_histogram_->Add(unresponding_thread_count);
 
+  // Record what the watched thread was doing before it hung.
+  RecordHungTasks();
+
   // Crash the browser if the watched thread is to be crashed on hang and if the
   // number of other threads responding is less than or equal to
   // live_threads_threshold_ and at least one other thread is responding.
@@ -408,6 +460,37 @@ bool ThreadWatcher::IsVeryUnresponsive() {
   return unresponsive_count_ >= unresponsive_threshold_;
 }
 
+void ThreadWatcher::RecordHungTasks() {
+  DCHECK(WatchDogThread::CurrentlyOnWatchDogThread());
+  base::TimeTicks now = base::TimeTicks::Now();
+  std::vector<TaskFlightRecorder::Entry> entries;
+  flight_recorder_->GetEntries(now, &entries);
+  int blocking = TaskFlightRecorder::GetBlockingEntry(entries);
+  if (blocking < 0)
+    return;
+
+  // Only numbers can be uploaded, so the location the blocking task was
+  // posted from is hashed. The hashes can be matched offline against the
+  // locations in the source.
+  const TaskFlightRecorder::Entry& entry = entries[blocking];
+  std::string location = base::StringPrintf(
+      "%s@%s:%d",
+      entry.function_name ? entry.function_name : "",
+      entry.file_name ? entry.file_name : "",
+      entry.line_number);
+  hung_task_histogram_->Add(static_cast<int>(base::Hash(location)));
+  hung_task_run_time_histogram_->AddTime(entry.run_time);
+
+  std::string trace = base::StringPrintf(
+      "%s thread unresponsive for %" PRId64 " ms. Last %" PRIuS " tasks, "
+      "oldest first:\n",
+      thread_name_.c_str(), (now - pong_time_).InMilliseconds(),
+      entries.size());
+  trace += TaskFlightRecorder::FormatEntries(entries);
+  BrowserThread::PostBlockingPoolTask(
+      FROM_HERE, base::Bind(&WriteHangTrace, thread_name_, trace));
+}
+
 // ThreadWatcherList methods and members.
 //
 // static
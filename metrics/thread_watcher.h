@@ -16,6 +16,11 @@
 // detected, we should probably just crash, and allow the crash system to gather
 // then stack trace.
 //
+// Each ThreadWatcher also keeps a TaskFlightRecorder of the last tasks run on
+// the watched thread. When the thread becomes very unresponsive, the task that
+// is blocking it is recorded in a histogram, and all of the recorded tasks are
+// written to a hang trace file in the user data directory.
+//
 // Example Usage:
 //
 //   The following is an example for watching responsiveness of watched (IO)
@@ -58,6 +63,7 @@
 #include "base/threading/thread.h"
 #include "base/threading/watchdog.h"
 #include "base/time/time.h"
+#include "chrome/browser/metrics/task_flight_recorder.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_observer.h"
 #include "content/public/browser/notification_registrar.h"
@@ -134,6 +140,9 @@ class ThreadWatcher {
   // Returns |ping_sequence_number_| (used by unit tests).
   uint64 ping_sequence_number() const { return ping_sequence_number_; }
 
+  // Returns the recorder of the tasks run on the watched thread.
+  TaskFlightRecorder* flight_recorder() const { return flight_recorder_.get(); }
+
  protected:
   // Construct a ThreadWatcher for the given |thread_id|. |sleep_time| is the
   // wait time between ping messages. |unresponsive_time| is the wait time after
@@ -211,6 +220,11 @@ class ThreadWatcher {
   // pong message for |unresponsive_threshold_| number of ping messages.
   bool IsVeryUnresponsive();
 
+  // This method records the task that is blocking the watched thread in
+  // histograms, and writes the tasks in |flight_recorder_| to the hang trace
+  // file on the blocking pool, as the FILE thread may be the hung one.
+  void RecordHungTasks();
+
   // The |thread_id_| of the thread being watched. Only one instance can exist
   // for the given |thread_id_| of the thread being watched.
   const content::BrowserThread::ID thread_id_;
@@ -265,6 +279,18 @@ class ThreadWatcher {
   // the thread that got no response.
   base::HistogramBase* unresponsive_count_histogram_;
 
+  // Sparse histogram of the hashed locations of the tasks that were blocking
+  // the watched thread when it became very unresponsive.
+  base::HistogramBase* hung_task_histogram_;
+
+  // Histogram that keeps track of how long the blocking task had been running
+  // when the watched thread became very unresponsive.
+  base::HistogramBase* hung_task_run_time_histogram_;
+
+  // Records the last tasks run on the watched thread. It is added to the
+  // watched thread's message loop while the thread is watched.
+  scoped_refptr<TaskFlightRecorder> flight_recorder_;
+
   // This counter tracks the unresponsiveness of watched thread. If this value
   // is zero then watched thread has responded with a pong message. This is
   // incremented by 1 when we got no response (GotNoResponse()) from the watched
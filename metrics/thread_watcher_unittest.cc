@@ -4,6 +4,8 @@
 
 #include <math.h>
 
+#include <vector>
+
 #include "base/basictypes.h"
 #include "base/bind.h"
 #include "base/logging.h"
@@ -473,6 +475,12 @@ TEST_F(ThreadWatcherTest, ThreadResponding) {
   EXPECT_GE(io_watcher_->saved_ping_time_, time_before_ping);
   EXPECT_GE(io_watcher_->saved_ping_sequence_number_, static_cast<uint64>(0));
 
+  // The flight recorder was added to the watched thread before the ping
+  // message was posted to it, so it has recorded at least that task.
+  std::vector<TaskFlightRecorder::Entry> entries;
+  io_watcher_->flight_recorder()->GetEntries(TimeTicks::Now(), &entries);
+  EXPECT_FALSE(entries.empty());
+
   // Verify watched thread is responding with ping/pong messaging.
   io_watcher_->WaitForCheckResponse(
       kUnresponsiveTime + TimeDelta::FromMinutes(1), SUCCESSFUL);
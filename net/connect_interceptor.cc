@@ -27,6 +27,8 @@ void ConnectInterceptor::WitnessURLRequest(net::URLRequest* request) {
 
   // Learn what URLs are likely to be needed during next startup.
   predictor_->LearnAboutInitialNavigation(request_scheme_host);
+  // Credit any speculative resolution of this host.
+  predictor_->LearnAboutHostUse(request_scheme_host);
 
   bool redirected_host = false;
   bool is_subresource = !(request->load_flags() & net::LOAD_MAIN_FRAME);
@@ -9,6 +9,7 @@
 #include <set>
 #include <sstream>
 
+#include "base/base64.h"
 #include "base/basictypes.h"
 #include "base/bind.h"
 #include "base/compiler_specific.h"
@@ -54,6 +55,7 @@ namespace chrome_browser_net {
 
 // static
 const int Predictor::kPredictorReferrerVersion = 2;
+const int Predictor::kPredictorCompactReferrerVersion = 3;
 const double Predictor::kPreconnectWorthyExpectedValue = 0.8;
 const double Predictor::kDNSPreresolutionWorthyExpectedValue = 0.1;
 const double Predictor::kDiscardableExpectedValue = 0.05;
@@ -69,9 +71,10 @@ const double Predictor::kDiscardableExpectedValue = 0.05;
 // static
 const double Predictor::kReferrerTrimRatio = 0.97153;
 const int64 Predictor::kDurationBetweenTrimmingsHours = 1;
-const int64 Predictor::kDurationBetweenTrimmingIncrementsSeconds = 15;
-const size_t Predictor::kUrlsTrimmedPerIncrement = 5u;
+const size_t Predictor::kMaxReferrers = 1000u;
 const size_t Predictor::kMaxSpeculativeParallelResolves = 3;
+const size_t Predictor::kMaxParallelResolvesGrowth = 2;
+const size_t Predictor::kMaxResolverParallelism = 8;
 const int Predictor::kMaxUnusedSocketLifetimeSecondsWithoutAGet = 10;
 // To control our congestion avoidance system, which discards a queue when
 // resolutions are "taking too long," we need an expected resolution time.
@@ -142,7 +145,15 @@ Predictor::Predictor(bool preconnect_enabled, bool predictor_enabled)
       profile_io_data_(NULL),
       peak_pending_lookups_(0),
       shutdown_(false),
-      max_concurrent_dns_lookups_(g_max_parallel_resolves),
+      // The controller starts at the configured limit and may grow it to
+      // kMaxParallelResolvesGrowth times that, but never past the resolver's
+      // own limit so that navigational resolutions aren't starved.
+      max_concurrent_dns_lookups_(
+          std::min(g_max_parallel_resolves * kMaxParallelResolvesGrowth,
+                   kMaxResolverParallelism)),
+      preresolve_controller_(
+          std::min(g_max_parallel_resolves, max_concurrent_dns_lookups_),
+          max_concurrent_dns_lookups_),
       max_dns_queue_delay_(
           TimeDelta::FromMilliseconds(g_max_queueing_delay_ms)),
       host_resolver_(NULL),
@@ -150,8 +161,10 @@ Predictor::Predictor(bool preconnect_enabled, bool predictor_enabled)
       ssl_config_service_(NULL),
       preconnect_enabled_(preconnect_enabled),
       consecutive_omnibox_preconnect_count_(0),
-      next_trim_time_(base::TimeTicks::Now() +
-                      TimeDelta::FromHours(kDurationBetweenTrimmingsHours)),
+      referrers_(kMaxReferrers,
+                 TimeDelta::FromHours(kDurationBetweenTrimmingsHours),
+                 kReferrerTrimRatio,
+                 kDiscardableExpectedValue),
       observer_(NULL) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
 }
@@ -408,7 +421,7 @@ void Predictor::Shutdown() {
 void Predictor::DiscardAllResults() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   // Delete anything listed so far in this session that shows in about:dns.
-  referrers_.clear();
+  referrers_.Clear();
 
 
   // Try to delete anything in our work queue.
@@ -474,9 +487,8 @@ void Predictor::LearnFromNavigation(const GURL& referring_url,
   DCHECK_EQ(target_url, Predictor::CanonicalizeUrl(target_url));
   DCHECK_NE(target_url, GURL::EmptyGURL());
 
-  referrers_[referring_url].SuggestHost(target_url);
-  // Possibly do some referrer trimming.
-  TrimReferrers();
+  referrers_.GetOrCreate(referring_url, base::TimeTicks::Now())
+      ->SuggestHost(target_url);
 }
 
 //-----------------------------------------------------------------------------
@@ -533,7 +545,7 @@ void Predictor::GetHtmlReferrerLists(std::string* output) {
       SortedNames;
   SortedNames sorted_names;
 
-  for (Referrers::iterator it = referrers_.begin();
+  for (ReferrerStore::const_iterator it = referrers_.begin();
        referrers_.end() != it; ++it)
     sorted_names.insert(it->first);
 
@@ -549,9 +561,9 @@ void Predictor::GetHtmlReferrerLists(std::string* output) {
 
   for (SortedNames::iterator it = sorted_names.begin();
        sorted_names.end() != it; ++it) {
-    Referrer* referrer = &(referrers_[*it]);
+    const Referrer* referrer = referrers_.Peek(*it);
     bool first_set_of_futures = true;
-    for (Referrer::iterator future_url = referrer->begin();
+    for (Referrer::const_iterator future_url = referrer->begin();
          future_url != referrer->end(); ++future_url) {
       output->append("<tr align=right>");
       if (first_set_of_futures) {
@@ -619,17 +631,16 @@ void Predictor::GetHtmlInfo(std::string* output) {
 
 void Predictor::TrimReferrersNow() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  // Just finish up work if an incremental trim is in progress.
-  if (urls_being_trimmed_.empty())
-    LoadUrlsForTrimming();
-  IncrementalTrimReferrers(true);  // Do everything now.
+  UMA_HISTOGRAM_COUNTS("Net.PredictionTrimSize",
+                       static_cast<int>(referrers_.size()));
+  referrers_.TrimAll();
 }
 
 void Predictor::SerializeReferrers(base::ListValue* referral_list) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   referral_list->Clear();
   referral_list->Append(new base::FundamentalValue(kPredictorReferrerVersion));
-  for (Referrers::const_iterator it = referrers_.begin();
+  for (ReferrerStore::const_iterator it = referrers_.begin();
        it != referrers_.end(); ++it) {
     // Serialize the list of subresource names.
     base::Value* subresource_list(it->second.Serialize());
@@ -643,12 +654,39 @@ void Predictor::SerializeReferrers(base::ListValue* referral_list) {
   }
 }
 
+void Predictor::SerializeReferrersCompactly(base::ListValue* referral_list) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  referral_list->Clear();
+  if (referrers_.empty())
+    return;
+  std::string encoded;
+  base::Base64Encode(referrers_.Encode(), &encoded);
+  referral_list->Append(
+      new base::FundamentalValue(kPredictorCompactReferrerVersion));
+  referral_list->Append(new base::StringValue(encoded));
+  UMA_HISTOGRAM_COUNTS("Net.PredictorReferrersSerializedSize",
+                       static_cast<int>(encoded.size()));
+}
+
 void Predictor::DeserializeReferrers(const base::ListValue& referral_list) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   int format_version = -1;
   if (referral_list.GetSize() > 0 &&
       referral_list.GetInteger(0, &format_version) &&
-      format_version == kPredictorReferrerVersion) {
+      format_version == kPredictorCompactReferrerVersion) {
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    std::string encoded;
+    std::string data;
+    if (!referral_list.GetString(1, &encoded) ||
+        !base::Base64Decode(encoded, &data) ||
+        !referrers_.Decode(data)) {
+      LOG(WARNING) << "Discarding malformed predictor referrer list.";
+      return;
+    }
+    UMA_HISTOGRAM_TIMES("Net.PredictorReferrersDeserializeTime",
+                        base::TimeTicks::Now() - start_time);
+  } else if (referral_list.GetSize() > 0 &&
+             format_version == kPredictorReferrerVersion) {
     for (size_t i = 1; i < referral_list.GetSize(); ++i) {
       const base::ListValue* motivator;
       if (!referral_list.GetList(i, &motivator)) {
@@ -667,7 +705,9 @@ void Predictor::DeserializeReferrers(const base::ListValue& referral_list) {
         return;
       }
 
-      referrers_[GURL(motivating_url_spec)].Deserialize(*subresource_list);
+      referrers_.GetOrCreate(GURL(motivating_url_spec),
+                             base::TimeTicks::Now())
+          ->Deserialize(*subresource_list);
     }
   }
 }
@@ -728,6 +768,11 @@ void Predictor::LearnAboutInitialNavigation(const GURL& url) {
   initial_observer_->Append(url, this);
 }
 
+void Predictor::LearnAboutHostUse(const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  preresolve_controller_.OnHostUsed(url.host(), base::TimeTicks::Now());
+}
+
 // This API is only used in the browser process.
 // It is called from an IPC message originating in the renderer.  It currently
 // includes both Page-Scan, and Link-Hover prefetching.
@@ -837,7 +882,7 @@ void Predictor::SaveDnsPrefetchStateForNextStartupAndTrim(
   // Do at least one trim at shutdown, in case the user wasn't running long
   // enough to do any regular trimming of referrers.
   TrimReferrersNow();
-  SerializeReferrers(referral_list);
+  SerializeReferrersCompactly(referral_list);
 
   completion->Signal();
 }
@@ -958,8 +1003,8 @@ void Predictor::PrepareFrameSubresources(const GURL& original_url,
 
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   DCHECK_EQ(url.GetWithEmptyPath(), url);
-  Referrers::iterator it = referrers_.find(url);
-  if (referrers_.end() == it) {
+  Referrer* referrer = referrers_.Get(url, base::TimeTicks::Now());
+  if (!referrer) {
     // Only when we don't know anything about this url, make 2 connections
     // available.  We could do this completely via learning (by prepopulating
     // the referrer_ list with this expected value), but it would swell the
@@ -973,7 +1018,6 @@ void Predictor::PrepareFrameSubresources(const GURL& original_url,
     return;
   }
 
-  Referrer* referrer = &(it->second);
   referrer->IncrementUseCount();
   const UrlInfo::ResolutionMotivation motivation =
       UrlInfo::LEARNED_REFERAL_MOTIVATED;
@@ -1012,6 +1056,15 @@ void Predictor::OnLookupFinished(LookupRequest* request, const GURL& url,
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
 
   LookupFinished(request, url, found);
+  // Only lookups that went out to the network say anything about resolver
+  // latency, and only those are worth crediting when the host is used.
+  Results::const_iterator it = results_.find(url);
+  if (it != results_.end()) {
+    preresolve_controller_.OnResolveFinished(
+        url.host(), it->second.motivation(), found,
+        it->second.resolve_duration(), !work_queue_.IsEmpty(),
+        base::TimeTicks::Now());
+  }
   pending_lookups_.erase(request);
   delete request;
 
@@ -1054,6 +1107,11 @@ UrlInfo* Predictor::AppendToResolutionQueue(
     return NULL;
   }
 
+  if (!preresolve_controller_.ShouldResolve(motivation)) {
+    info->DLogResultsStats("DNS PrefetchRarelyUsed");
+    return NULL;
+  }
+
   AdviseProxy(url, motivation, false /* is_preconnect */);
   if (proxy_advisor_ && proxy_advisor_->WouldProxyURL(url)) {
     info->DLogResultsStats("DNS PrefetchForProxiedRequest");
@@ -1074,6 +1132,7 @@ bool Predictor::CongestionControlPerformed(UrlInfo* info) {
   // We need to discard all entries in our queue, as we're keeping them waiting
   // too long.  By doing this, we'll have a chance to quickly service urgent
   // resolutions, and not have a bogged down system.
+  preresolve_controller_.OnCongestion();
   while (true) {
     info->RemoveFromQueue();
     if (work_queue_.IsEmpty())
@@ -1088,7 +1147,7 @@ void Predictor::StartSomeQueuedResolutions() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
 
   while (!work_queue_.IsEmpty() &&
-         pending_lookups_.size() < max_concurrent_dns_lookups_) {
+         pending_lookups_.size() < preresolve_controller_.parallel_resolves()) {
     const GURL url(work_queue_.Pop());
     UrlInfo* info = &results_[url];
     DCHECK(info->HasUrl(url));
@@ -1116,56 +1175,6 @@ void Predictor::StartSomeQueuedResolutions() {
   }
 }
 
-void Predictor::TrimReferrers() {
-  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  if (!urls_being_trimmed_.empty())
-    return;   // There is incremental trimming in progress already.
-
-  // Check to see if it is time to trim yet.
-  base::TimeTicks now = base::TimeTicks::Now();
-  if (now < next_trim_time_)
-    return;
-  next_trim_time_ = now + TimeDelta::FromHours(kDurationBetweenTrimmingsHours);
-
-  LoadUrlsForTrimming();
-  PostIncrementalTrimTask();
-}
-
-void Predictor::LoadUrlsForTrimming() {
-  DCHECK(urls_being_trimmed_.empty());
-  for (Referrers::const_iterator it = referrers_.begin();
-       it != referrers_.end(); ++it)
-    urls_being_trimmed_.push_back(it->first);
-  UMA_HISTOGRAM_COUNTS("Net.PredictionTrimSize", urls_being_trimmed_.size());
-}
-
-void Predictor::PostIncrementalTrimTask() {
-  if (urls_being_trimmed_.empty())
-    return;
-  const TimeDelta kDurationBetweenTrimmingIncrements =
-      TimeDelta::FromSeconds(kDurationBetweenTrimmingIncrementsSeconds);
-  base::MessageLoop::current()->PostDelayedTask(
-      FROM_HERE,
-      base::Bind(&Predictor::IncrementalTrimReferrers,
-                 weak_factory_->GetWeakPtr(), false),
-      kDurationBetweenTrimmingIncrements);
-}
-
-void Predictor::IncrementalTrimReferrers(bool trim_all_now) {
-  size_t trim_count = urls_being_trimmed_.size();
-  if (!trim_all_now)
-    trim_count = std::min(trim_count, kUrlsTrimmedPerIncrement);
-  while (trim_count-- != 0) {
-    Referrers::iterator it = referrers_.find(urls_being_trimmed_.back());
-    urls_being_trimmed_.pop_back();
-    if (it == referrers_.end())
-      continue;  // Defensive code: It got trimmed away already.
-    if (!it->second.Trim(kReferrerTrimRatio, kDiscardableExpectedValue))
-      referrers_.erase(it);
-  }
-  PostIncrementalTrimTask();
-}
-
 void Predictor::AdviseProxyOnIOThread(const GURL& url,
                                       UrlInfo::ResolutionMotivation motivation,
                                       bool is_preconnect) {
@@ -29,7 +29,9 @@
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "chrome/browser/net/prediction_options.h"
+#include "chrome/browser/net/preresolve_controller.h"
 #include "chrome/browser/net/referrer.h"
+#include "chrome/browser/net/referrer_store.h"
 #include "chrome/browser/net/spdyproxy/proxy_advisor.h"
 #include "chrome/browser/net/timed_cache.h"
 #include "chrome/browser/net/url_info.h"
@@ -86,12 +88,21 @@ class Predictor {
   // we change the format so that we discard old data.
   static const int kPredictorReferrerVersion;
 
+  // The version of the compact format in which the referrers are persisted in
+  // prefs.  See SerializeReferrersCompactly().
+  static const int kPredictorCompactReferrerVersion;
+
   // Given that the underlying Chromium resolver defaults to a total maximum of
   // 8 paralell resolutions, we will avoid any chance of starving navigational
   // resolutions by limiting the number of paralell speculative resolutions.
+  // This is the initial limit; while the resolver is fast, the limit may grow
+  // to kMaxParallelResolvesGrowth times the configured initial limit, but
+  // never past kMaxResolverParallelism.
   // This is used in the field trials and testing.
   // TODO(jar): Move this limitation into the resolver.
   static const size_t kMaxSpeculativeParallelResolves;
+  static const size_t kMaxParallelResolvesGrowth;
+  static const size_t kMaxResolverParallelism;
 
   // To control the congestion avoidance system, we need an estimate of how
   // many speculative requests may arrive at once.  Since we currently only
@@ -203,9 +214,16 @@ class Predictor {
   // so that it can be persisted in a pref.
   void SerializeReferrers(base::ListValue* referral_list);
 
+  // Like SerializeReferrers(), but stores the referrers as the version number
+  // followed by a single base64 string holding ReferrerStore::Encode().  This
+  // is the form written to prefs, since it is much smaller and faster to
+  // parse than one list per referrer.
+  void SerializeReferrersCompactly(base::ListValue* referral_list);
+
   // Process a ListValue that contains all the data from a previous reference
-  // list, as constructed by SerializeReferrers(), and add all the identified
-  // values into the current referrer list.
+  // list, as constructed by SerializeReferrers() or
+  // SerializeReferrersCompactly(), and add all the identified values into the
+  // current referrer list.
   void DeserializeReferrers(const base::ListValue& referral_list);
 
   void DeserializeReferrersThenDelete(base::ListValue* referral_list);
@@ -222,6 +240,10 @@ class Predictor {
   // resolve the associated hosts ASAP during our next startup.
   void LearnAboutInitialNavigation(const GURL& url);
 
+  // Notes that |url| is being fetched, so that a recent speculative
+  // resolution of its host is credited as useful.
+  void LearnAboutHostUse(const GURL& url);
+
   // Renderer bundles up list and sends to this browser API via IPC.
   // TODO(jar): Use UrlList instead to include port and scheme.
   void DnsPrefetchList(const NameList& hostnames);
@@ -381,10 +403,9 @@ class Predictor {
     static const size_t kStartupResolutionCount = 10;
   };
 
-  // A map that is keyed with the host/port that we've learned were the cause
-  // of loading additional URLs.  The list of additional targets is held
-  // in a Referrer instance, which is a value in this map.
-  typedef std::map<GURL, Referrer> Referrers;
+  // The maximum number of referring URLs that are remembered.  When more are
+  // learned about, the least recently used ones are dropped.
+  static const size_t kMaxReferrers;
 
   // Depending on the expected_subresource_use_, we may either make a TCP/IP
   // preconnection, or merely pre-resolve the hostname via DNS (or even do
@@ -400,14 +421,10 @@ class Predictor {
   // This number should always be less than 1, an more than 0.
   static const double kReferrerTrimRatio;
 
-  // Interval between periodic trimming of our whole referrer list.
-  // We only do a major trimming about once an hour, and then only when the user
-  // is actively browsing.
+  // Interval between trimmings of each referrer.  A referrer is trimmed
+  // when it is next used after the interval has passed, rather than by
+  // periodically sweeping through the whole referrer list.
   static const int64 kDurationBetweenTrimmingsHours;
-  // Interval between incremental trimmings (to avoid inducing Jank).
-  static const int64 kDurationBetweenTrimmingIncrementsSeconds;
-  // Number of referring URLs processed in an incremental trimming.
-  static const size_t kUrlsTrimmedPerIncrement;
 
   // Only for testing. Returns true if hostname has been successfully resolved
   // (name found).
@@ -480,21 +497,6 @@ class Predictor {
   // asynchronously, provided we don't exceed concurrent resolution limit.
   void StartSomeQueuedResolutions();
 
-  // Performs trimming similar to TrimReferrersNow(), except it does it as a
-  // series of short tasks by posting continuations again an again until done.
-  void TrimReferrers();
-
-  // Loads urls_being_trimmed_ from keys of current referrers_.
-  void LoadUrlsForTrimming();
-
-  // Posts a task to do additional incremental trimming of referrers_.
-  void PostIncrementalTrimTask();
-
-  // Calls Trim() on some or all of urls_being_trimmed_.
-  // If it does not process all the URLs in that vector, it posts a task to
-  // continue with them shortly (i.e., it yeilds and continues).
-  void IncrementalTrimReferrers(bool trim_all_now);
-
   // If a proxy advisor is defined, let it know that |url| will be prefetched or
   // preconnected to.
   void AdviseProxyOnIOThread(const GURL& url,
@@ -538,12 +540,17 @@ class Predictor {
   // When true, we don't make new lookup requests.
   bool shutdown_;
 
-  // The number of concurrent speculative lookups currently allowed to be sent
-  // to the resolver.  Any additional lookups will be queued to avoid exceeding
-  // this value.  The queue is a priority queue that will accelerate
+  // The largest number of concurrent speculative lookups that may be sent to
+  // the resolver.  The number actually allowed is tuned below this by
+  // |preresolve_controller_|, and any additional lookups will be queued to
+  // avoid exceeding it.  The queue is a priority queue that will accelerate
   // sub-resource speculation, and retard resolutions suggested by page scans.
   const size_t max_concurrent_dns_lookups_;
 
+  // Tunes the number of concurrent lookups, and skips speculative lookups
+  // that are rarely used.
+  PreresolveController preresolve_controller_;
+
   // The maximum queueing delay that is acceptable before we enter congestion
   // reduction mode, and discard all queued (but not yet assigned) resolutions.
   const base::TimeDelta max_dns_queue_delay_;
@@ -580,14 +587,7 @@ class Predictor {
   // we have a Referrer list. Each Referrer list has all hostnames we might
   // need to pre-resolve or pre-connect to when there is a navigation to the
   // orginial hostname.
-  Referrers referrers_;
-
-  // List of URLs in referrers_ currently being trimmed (scaled down to
-  // eventually be aged out of use).
-  std::vector<GURL> urls_being_trimmed_;
-
-  // A time after which we need to do more trimming of referrers.
-  base::TimeTicks next_trim_time_;
+  ReferrerStore referrers_;
 
   scoped_ptr<base::WeakPtrFactory<Predictor> > weak_factory_;
 
@@ -133,6 +133,15 @@ TEST_F(PredictorTest, StartupShutdownTest) {
 }
 
 
+// A large configured limit may not grow past the resolver's own limit.
+TEST_F(PredictorTest, MaxConcurrentLookupsClampedTest) {
+  Predictor::set_max_parallel_resolves(Predictor::kMaxResolverParallelism);
+  Predictor testing_master(true, true);
+  EXPECT_EQ(Predictor::kMaxResolverParallelism,
+            testing_master.max_concurrent_dns_lookups());
+  testing_master.Shutdown();
+}
+
 TEST_F(PredictorTest, ShutdownWhenResolutionIsPendingTest) {
   scoped_ptr<net::HostResolver> host_resolver(new net::HangingHostResolver());
 
@@ -400,6 +409,47 @@ TEST_F(PredictorTest, ReferrerSerializationSingleReferrerTest) {
   predictor.Shutdown();
 }
 
+// Make sure that referrers survive a round trip through the compact form that
+// is persisted in prefs.
+TEST_F(PredictorTest, ReferrerCompactSerializationTest) {
+  Predictor predictor(true, true);
+  predictor.SetHostResolver(host_resolver_.get());
+  const GURL motivation_url("http://www.google.com:91");
+  const GURL subresource_url("http://icons.google.com:90");
+  const GURL other_subresource_url("http://img.google.com:90");
+  const double kUseRate = 23.5;
+  scoped_ptr<base::ListValue> referral_list(NewEmptySerializationList());
+  AddToSerializedList(motivation_url, subresource_url,
+      kUseRate, referral_list.get());
+  AddToSerializedList(motivation_url, other_subresource_url,
+      kUseRate / 2, referral_list.get());
+  predictor.DeserializeReferrers(*referral_list.get());
+
+  base::ListValue compact_referral_list;
+  predictor.SerializeReferrersCompactly(&compact_referral_list);
+  EXPECT_EQ(2U, compact_referral_list.GetSize());
+  int format_version = -1;
+  EXPECT_TRUE(compact_referral_list.GetInteger(0, &format_version));
+  EXPECT_EQ(Predictor::kPredictorCompactReferrerVersion, format_version);
+  predictor.Shutdown();
+
+  Predictor restored_predictor(true, true);
+  restored_predictor.SetHostResolver(host_resolver_.get());
+  restored_predictor.DeserializeReferrers(compact_referral_list);
+  base::ListValue recovered_referral_list;
+  restored_predictor.SerializeReferrers(&recovered_referral_list);
+  EXPECT_EQ(2U, recovered_referral_list.GetSize());
+  double rate;
+  EXPECT_TRUE(GetDataFromSerialization(
+      motivation_url, subresource_url, recovered_referral_list, &rate));
+  EXPECT_EQ(kUseRate, rate);
+  EXPECT_TRUE(GetDataFromSerialization(
+      motivation_url, other_subresource_url, recovered_referral_list, &rate));
+  EXPECT_EQ(kUseRate / 2, rate);
+
+  restored_predictor.Shutdown();
+}
+
 // Check that GetHtmlReferrerLists() doesn't crash when given duplicated
 // domains for referring URL, and that it sorts the results in the
 // correct order.
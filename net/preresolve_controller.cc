@@ -0,0 +1,189 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/preresolve_controller.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+// The weight given to each new outcome in the smoothed hit rate.
+const double kHitRateWeight = 0.1;
+
+// The number of outcomes summarized by each Net.PreresolveHitRate sample.
+const int kHitRateReportInterval = 100;
+
+// Only guesses can be skipped.  Resolutions the user asked for more directly,
+// such as by hovering over a link or typing in the omnibox, are always
+// performed.
+bool IsSkippable(UrlInfo::ResolutionMotivation motivation) {
+  switch (motivation) {
+    case UrlInfo::PAGE_SCAN_MOTIVATED:
+    case UrlInfo::STARTUP_LIST_MOTIVATED:
+    case UrlInfo::STATIC_REFERAL_MOTIVATED:
+    case UrlInfo::LEARNED_REFERAL_MOTIVATED:
+    case UrlInfo::SELF_REFERAL_MOTIVATED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+// static
+const int PreresolveController::kExpectedResolutionTimeMs = 500;
+const int PreresolveController::kMinOutcomesForSkipping = 20;
+const double PreresolveController::kMinUsefulRate = 0.05;
+const int PreresolveController::kProbeInterval = 10;
+const size_t PreresolveController::kMaxUnusedResolutions = 500u;
+
+PreresolveController::MotivationStats::MotivationStats()
+    : hit_rate(1.0),
+      outcomes(0),
+      skipped(0) {
+}
+
+PreresolveController::PreresolveController(size_t initial_parallel_resolves,
+                                           size_t max_parallel_resolves)
+    : max_parallel_resolves_(max_parallel_resolves),
+      parallel_resolves_(initial_parallel_resolves),
+      resolves_since_adjustment_(0),
+      total_used_(0),
+      total_outcomes_(0) {
+  DCHECK_GE(initial_parallel_resolves, 1u);
+  DCHECK_LE(initial_parallel_resolves, max_parallel_resolves);
+}
+
+PreresolveController::~PreresolveController() {}
+
+bool PreresolveController::ShouldResolve(
+    UrlInfo::ResolutionMotivation motivation) {
+  DCHECK_LT(motivation, UrlInfo::MAX_MOTIVATED);
+  if (!IsSkippable(motivation))
+    return true;
+  MotivationStats& stats = stats_[motivation];
+  if (stats.outcomes < kMinOutcomesForSkipping ||
+      stats.hit_rate >= kMinUsefulRate) {
+    return true;
+  }
+  if (++stats.skipped % kProbeInterval == 0)
+    return true;
+  UMA_HISTOGRAM_ENUMERATION("Net.PreresolveSkipped", motivation,
+                            UrlInfo::MAX_MOTIVATED);
+  return false;
+}
+
+void PreresolveController::OnResolveFinished(
+    const std::string& host,
+    UrlInfo::ResolutionMotivation motivation,
+    bool found,
+    base::TimeDelta resolve_duration,
+    bool backlogged,
+    base::TimeTicks now) {
+  ExpireUnusedResolutions(now);
+
+  if (average_resolve_duration_ == base::TimeDelta()) {
+    average_resolve_duration_ = resolve_duration;
+  } else {
+    average_resolve_duration_ = base::TimeDelta::FromMicroseconds(
+        (3 * average_resolve_duration_.InMicroseconds() +
+         resolve_duration.InMicroseconds()) / 4);
+  }
+  AdjustParallelResolves(backlogged);
+
+  if (!found)
+    return;
+  if (unused_resolutions_.size() >= kMaxUnusedResolutions &&
+      unused_resolutions_.find(host) == unused_resolutions_.end()) {
+    return;
+  }
+  UnusedResolution& resolution = unused_resolutions_[host];
+  resolution.motivation = motivation;
+  resolution.resolve_time = now;
+}
+
+void PreresolveController::OnCongestion() {
+  parallel_resolves_ = std::max<size_t>(1u, parallel_resolves_ / 2);
+  resolves_since_adjustment_ = 0;
+}
+
+void PreresolveController::OnHostUsed(const std::string& host,
+                                      base::TimeTicks now) {
+  UnusedResolutions::iterator it = unused_resolutions_.find(host);
+  if (it == unused_resolutions_.end())
+    return;
+  bool used =
+      now - it->second.resolve_time < UrlInfo::get_cache_expiration();
+  RecordOutcome(it->second.motivation, used);
+  unused_resolutions_.erase(it);
+}
+
+double PreresolveController::GetHitRate(
+    UrlInfo::ResolutionMotivation motivation) const {
+  DCHECK_LT(motivation, UrlInfo::MAX_MOTIVATED);
+  return stats_[motivation].hit_rate;
+}
+
+void PreresolveController::ExpireUnusedResolutions(base::TimeTicks now) {
+  const base::TimeDelta expiration = UrlInfo::get_cache_expiration();
+  UnusedResolutions::iterator it = unused_resolutions_.begin();
+  while (it != unused_resolutions_.end()) {
+    if (now - it->second.resolve_time < expiration) {
+      ++it;
+      continue;
+    }
+    RecordOutcome(it->second.motivation, false);
+    unused_resolutions_.erase(it++);
+  }
+}
+
+void PreresolveController::RecordOutcome(
+    UrlInfo::ResolutionMotivation motivation,
+    bool used) {
+  DCHECK_LT(motivation, UrlInfo::MAX_MOTIVATED);
+  MotivationStats& stats = stats_[motivation];
+  stats.hit_rate += kHitRateWeight * ((used ? 1.0 : 0.0) - stats.hit_rate);
+  stats.outcomes = std::min(stats.outcomes + 1, kMinOutcomesForSkipping);
+
+  if (used) {
+    UMA_HISTOGRAM_ENUMERATION("Net.PreresolveUsed", motivation,
+                              UrlInfo::MAX_MOTIVATED);
+    ++total_used_;
+  } else {
+    UMA_HISTOGRAM_ENUMERATION("Net.PreresolveWasted", motivation,
+                              UrlInfo::MAX_MOTIVATED);
+  }
+  if (++total_outcomes_ == kHitRateReportInterval) {
+    UMA_HISTOGRAM_PERCENTAGE("Net.PreresolveHitRate",
+                             100 * total_used_ / total_outcomes_);
+    total_used_ = 0;
+    total_outcomes_ = 0;
+  }
+}
+
+void PreresolveController::AdjustParallelResolves(bool backlogged) {
+  if (++resolves_since_adjustment_ < parallel_resolves_)
+    return;
+  resolves_since_adjustment_ = 0;
+
+  const base::TimeDelta expected =
+      base::TimeDelta::FromMilliseconds(kExpectedResolutionTimeMs);
+  if (average_resolve_duration_ > expected * 2) {
+    if (parallel_resolves_ > 1)
+      --parallel_resolves_;
+  } else if (average_resolve_duration_ <= expected && backlogged) {
+    if (parallel_resolves_ < max_parallel_resolves_)
+      ++parallel_resolves_;
+  }
+  UMA_HISTOGRAM_COUNTS_100("Net.PreresolveParallelLimit",
+                           static_cast<int>(parallel_resolves_));
+}
+
+}  // namespace chrome_browser_net
@@ -0,0 +1,120 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Feedback control for the Predictor's speculative DNS resolutions.  The
+// controller watches how long resolutions take, and adjusts how many of them
+// may run in parallel: fewer when the resolver is slow, more when it is fast
+// and resolutions are waiting in the queue.  It also watches whether each
+// resolved host is fetched before the resolution expires from the cache, and
+// stops speculating for motivations whose resolutions are rarely used.
+
+// All access to this class is performed via the Predictor class, which only
+// operates on the IO thread.
+
+#ifndef CHROME_BROWSER_NET_PRERESOLVE_CONTROLLER_H_
+#define CHROME_BROWSER_NET_PRERESOLVE_CONTROLLER_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/time/time.h"
+#include "chrome/browser/net/url_info.h"
+
+namespace chrome_browser_net {
+
+class PreresolveController {
+ public:
+  // Resolutions with an expected latency at or below this are considered
+  // fast, and ones above twice this are considered slow.
+  static const int kExpectedResolutionTimeMs;
+  // Speculation for a motivation is skipped once at least
+  // |kMinOutcomesForSkipping| of its resolutions were used or wasted, and the
+  // fraction used has fallen below |kMinUsefulRate|.
+  static const int kMinOutcomesForSkipping;
+  static const double kMinUsefulRate;
+  // One in this many skipped resolutions is performed anyway, so that the
+  // hit rate of a skipped motivation can recover.
+  static const int kProbeInterval;
+  // The largest number of resolved hosts waiting to be used.
+  static const size_t kMaxUnusedResolutions;
+
+  // Allows |initial_parallel_resolves| resolutions to run in parallel at
+  // first, and between one and |max_parallel_resolves| later on.
+  PreresolveController(size_t initial_parallel_resolves,
+                       size_t max_parallel_resolves);
+  ~PreresolveController();
+
+  // The number of resolutions that may currently run in parallel.
+  size_t parallel_resolves() const { return parallel_resolves_; }
+
+  // Returns false if a resolution with |motivation| is predicted to be
+  // useless, and should not be queued.
+  bool ShouldResolve(UrlInfo::ResolutionMotivation motivation);
+
+  // Records that the resolver finished resolving |host| after
+  // |resolve_duration|.  |backlogged| tells whether other resolutions are
+  // waiting in the queue.
+  void OnResolveFinished(const std::string& host,
+                         UrlInfo::ResolutionMotivation motivation,
+                         bool found,
+                         base::TimeDelta resolve_duration,
+                         bool backlogged,
+                         base::TimeTicks now);
+
+  // Records that queued resolutions were discarded because they waited too
+  // long, which cuts the parallelism in half.
+  void OnCongestion();
+
+  // Records that |host| is being fetched, which makes a recent resolution of
+  // it useful.
+  void OnHostUsed(const std::string& host, base::TimeTicks now);
+
+  // The smoothed fraction of resolutions with |motivation| that were used.
+  double GetHitRate(UrlInfo::ResolutionMotivation motivation) const;
+
+ private:
+  struct UnusedResolution {
+    UrlInfo::ResolutionMotivation motivation;
+    base::TimeTicks resolve_time;
+  };
+  typedef std::map<std::string, UnusedResolution> UnusedResolutions;
+
+  struct MotivationStats {
+    MotivationStats();
+
+    double hit_rate;
+    int outcomes;
+    int skipped;
+  };
+
+  // Counts the resolutions that expired from the cache without being used as
+  // wasted.
+  void ExpireUnusedResolutions(base::TimeTicks now);
+
+  // Folds one used or wasted resolution into the stats of |motivation|.
+  void RecordOutcome(UrlInfo::ResolutionMotivation motivation, bool used);
+
+  // Nudges the parallelism once per round of resolutions.
+  void AdjustParallelResolves(bool backlogged);
+
+  const size_t max_parallel_resolves_;
+  size_t parallel_resolves_;
+
+  // Exponentially weighted moving average of the resolution latency, and the
+  // number of resolutions seen since the parallelism was last adjusted.
+  base::TimeDelta average_resolve_duration_;
+  size_t resolves_since_adjustment_;
+
+  UnusedResolutions unused_resolutions_;
+  MotivationStats stats_[UrlInfo::MAX_MOTIVATED];
+  int total_used_;
+  int total_outcomes_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreresolveController);
+};
+
+}  // namespace chrome_browser_net
+
+#endif  // CHROME_BROWSER_NET_PRERESOLVE_CONTROLLER_H_
@@ -0,0 +1,127 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/preresolve_controller.h"
+
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+base::TimeDelta FastResolution() {
+  return base::TimeDelta::FromMilliseconds(
+      PreresolveController::kExpectedResolutionTimeMs / 2);
+}
+
+base::TimeDelta SlowResolution() {
+  return base::TimeDelta::FromMilliseconds(
+      PreresolveController::kExpectedResolutionTimeMs * 4);
+}
+
+// Resolves |count| distinct hosts with |motivation|.
+void ResolveHosts(PreresolveController* controller,
+                  UrlInfo::ResolutionMotivation motivation,
+                  int count,
+                  base::TimeTicks now) {
+  for (int i = 0; i < count; ++i) {
+    controller->OnResolveFinished(base::IntToString(motivation) + ".host" +
+                                      base::IntToString(i) + ".com",
+                                  motivation, true, FastResolution(), false,
+                                  now);
+  }
+}
+
+}  // namespace
+
+TEST(PreresolveControllerTest, GrowsWhileFastAndBacklogged) {
+  PreresolveController controller(2, 4);
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  // Without a backlog there is no reason to grow.
+  for (int i = 0; i < 10; ++i) {
+    controller.OnResolveFinished("a.com", UrlInfo::PAGE_SCAN_MOTIVATED, true,
+                                 FastResolution(), false, now);
+  }
+  EXPECT_EQ(2u, controller.parallel_resolves());
+
+  for (int i = 0; i < 20; ++i) {
+    controller.OnResolveFinished("a.com", UrlInfo::PAGE_SCAN_MOTIVATED, true,
+                                 FastResolution(), true, now);
+  }
+  EXPECT_EQ(4u, controller.parallel_resolves());
+}
+
+TEST(PreresolveControllerTest, ShrinksWhileSlow) {
+  PreresolveController controller(3, 6);
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  for (int i = 0; i < 20; ++i) {
+    controller.OnResolveFinished("a.com", UrlInfo::PAGE_SCAN_MOTIVATED, true,
+                                 SlowResolution(), true, now);
+  }
+  EXPECT_EQ(1u, controller.parallel_resolves());
+
+  PreresolveController congested(6, 6);
+  congested.OnCongestion();
+  EXPECT_EQ(3u, congested.parallel_resolves());
+  congested.OnCongestion();
+  congested.OnCongestion();
+  EXPECT_EQ(1u, congested.parallel_resolves());
+}
+
+TEST(PreresolveControllerTest, CreditsUsedHosts) {
+  PreresolveController controller(3, 6);
+  base::TimeTicks now = base::TimeTicks::Now();
+  const base::TimeDelta expiration = UrlInfo::get_cache_expiration();
+
+  controller.OnResolveFinished("used.com", UrlInfo::PAGE_SCAN_MOTIVATED, true,
+                               FastResolution(), false, now);
+  controller.OnHostUsed("used.com", now + expiration / 2);
+  EXPECT_EQ(1.0, controller.GetHitRate(UrlInfo::PAGE_SCAN_MOTIVATED));
+
+  // A host used after its resolution expired doesn't count.
+  controller.OnResolveFinished("late.com", UrlInfo::PAGE_SCAN_MOTIVATED, true,
+                               FastResolution(), false, now);
+  controller.OnHostUsed("late.com", now + expiration * 2);
+  EXPECT_GT(1.0, controller.GetHitRate(UrlInfo::PAGE_SCAN_MOTIVATED));
+
+  // Hosts that were not found are never credited.
+  double hit_rate = controller.GetHitRate(UrlInfo::PAGE_SCAN_MOTIVATED);
+  controller.OnResolveFinished("missing.com", UrlInfo::PAGE_SCAN_MOTIVATED,
+                               false, FastResolution(), false, now);
+  controller.OnHostUsed("missing.com", now);
+  EXPECT_EQ(hit_rate, controller.GetHitRate(UrlInfo::PAGE_SCAN_MOTIVATED));
+}
+
+TEST(PreresolveControllerTest, SkipsRarelyUsedMotivations) {
+  PreresolveController controller(3, 6);
+  base::TimeTicks now = base::TimeTicks::Now();
+  const base::TimeDelta expiration = UrlInfo::get_cache_expiration();
+
+  ResolveHosts(&controller, UrlInfo::PAGE_SCAN_MOTIVATED, 100, now);
+  ResolveHosts(&controller, UrlInfo::MOUSE_OVER_MOTIVATED, 100, now);
+  // Expire all of them unused.
+  controller.OnResolveFinished("other.com", UrlInfo::OMNIBOX_MOTIVATED, true,
+                               FastResolution(), false, now + expiration);
+  EXPECT_GT(PreresolveController::kMinUsefulRate,
+            controller.GetHitRate(UrlInfo::PAGE_SCAN_MOTIVATED));
+
+  // Page scans are skipped, but probed now and then.
+  int performed = 0;
+  for (int i = 0; i < PreresolveController::kProbeInterval * 3; ++i) {
+    if (controller.ShouldResolve(UrlInfo::PAGE_SCAN_MOTIVATED))
+      ++performed;
+  }
+  EXPECT_EQ(3, performed);
+
+  // Resolutions asked for more directly are always performed.
+  EXPECT_TRUE(controller.ShouldResolve(UrlInfo::MOUSE_OVER_MOTIVATED));
+  EXPECT_TRUE(controller.ShouldResolve(UrlInfo::OMNIBOX_MOTIVATED));
+  // As are those whose outcomes are still unknown.
+  EXPECT_TRUE(controller.ShouldResolve(UrlInfo::LEARNED_REFERAL_MOTIVATED));
+}
+
+}  // namespace chrome_browser_net
@@ -50,7 +50,10 @@ static const double kWeightingForOldConnectsExpectedValue = 0.66;
 // a starting point.
 static const double kInitialConnectsExpectedValue = 2.0;
 
-Referrer::Referrer() : use_count_(1) {}
+Referrer::Referrer()
+    : use_count_(1),
+      trim_time_(base::TimeTicks::Now()) {
+}
 
 void Referrer::SuggestHost(const GURL& url) {
   // Limit how large our list can get, in case we make mistakes about what
@@ -114,6 +114,11 @@ class Referrer : public SubresourceMap {
   // Returns true if expected use rate is greater than the threshold.
   bool Trim(double reduce_rate, double threshold);
 
+  // The time up to which periodic trimming has been applied to this Referrer.
+  // See ReferrerStore.
+  base::TimeTicks trim_time() const { return trim_time_; }
+  void set_trim_time(base::TimeTicks trim_time) { trim_time_ = trim_time; }
+
   // Provide methods for persisting, and restoring contents into a Value class.
   base::Value* Serialize() const;
   void Deserialize(const base::Value& referrers);
@@ -131,6 +136,8 @@ class Referrer : public SubresourceMap {
   // preconnection or DNS preresolution.
   int64 use_count_;
 
+  base::TimeTicks trim_time_;
+
   // We put these into a std::map<>, so we need copy constructors.
   // DISALLOW_COPY_AND_ASSIGN(Referrer);
   // TODO(jar): Consider optimization to use pointers to these instances, and
@@ -0,0 +1,198 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/referrer_store.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/pickle.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+// Assigns consecutive ids to URLs in the order they are first seen.
+class UrlTable {
+ public:
+  uint32 Intern(const GURL& url) {
+    std::pair<std::map<GURL, uint32>::iterator, bool> result =
+        ids_.insert(std::make_pair(url, static_cast<uint32>(urls_.size())));
+    if (result.second)
+      urls_.push_back(&result.first->first);
+    return result.first->second;
+  }
+
+  void Write(Pickle* pickle) const {
+    pickle->WriteUInt32(static_cast<uint32>(urls_.size()));
+    for (size_t i = 0; i < urls_.size(); ++i)
+      pickle->WriteString(urls_[i]->spec());
+  }
+
+ private:
+  std::map<GURL, uint32> ids_;
+  std::vector<const GURL*> urls_;
+};
+
+// A referrer read back from an encoded graph, with URLs given by their ids.
+struct DecodedReferrer {
+  uint32 url_id;
+  std::vector<std::pair<uint32, float> > subresources;
+};
+
+}  // namespace
+
+ReferrerStore::ReferrerStore(size_t max_referrers,
+                             base::TimeDelta trim_period,
+                             double trim_ratio,
+                             double discard_threshold)
+    : referrers_(max_referrers),
+      trim_period_(trim_period),
+      trim_ratio_(trim_ratio),
+      discard_threshold_(discard_threshold) {
+  DCHECK_GT(trim_period_, base::TimeDelta());
+}
+
+ReferrerStore::~ReferrerStore() {}
+
+Referrer* ReferrerStore::Get(const GURL& url, base::TimeTicks now) {
+  iterator it = referrers_.Get(url);
+  if (it == referrers_.end() || !TrimIfDue(it, now))
+    return NULL;
+  return &it->second;
+}
+
+Referrer* ReferrerStore::GetOrCreate(const GURL& url, base::TimeTicks now) {
+  Referrer* referrer = Get(url, now);
+  if (referrer)
+    return referrer;
+  return &referrers_.Put(url, Referrer())->second;
+}
+
+const Referrer* ReferrerStore::Peek(const GURL& url) const {
+  const_iterator it = referrers_.Peek(url);
+  return it == referrers_.end() ? NULL : &it->second;
+}
+
+void ReferrerStore::TrimAll() {
+  iterator it = referrers_.begin();
+  while (it != referrers_.end()) {
+    if (it->second.Trim(trim_ratio_, discard_threshold_))
+      ++it;
+    else
+      it = referrers_.Erase(it);
+  }
+}
+
+void ReferrerStore::Clear() {
+  referrers_.Clear();
+}
+
+// The encoding is a table of all URLs, followed by the referrers from the
+// least to the most recently used.  Each referrer is the id of its URL and the
+// number of its subresources, followed by one (URL id, expected use) record
+// per subresource.
+std::string ReferrerStore::Encode() const {
+  UrlTable url_table;
+  for (const_reverse_iterator it = referrers_.rbegin();
+       it != referrers_.rend(); ++it) {
+    url_table.Intern(it->first);
+    for (Referrer::const_iterator subresource = it->second.begin();
+         subresource != it->second.end(); ++subresource) {
+      url_table.Intern(subresource->first);
+    }
+  }
+
+  Pickle pickle;
+  url_table.Write(&pickle);
+  pickle.WriteUInt32(static_cast<uint32>(referrers_.size()));
+  for (const_reverse_iterator it = referrers_.rbegin();
+       it != referrers_.rend(); ++it) {
+    pickle.WriteUInt32(url_table.Intern(it->first));
+    pickle.WriteUInt32(static_cast<uint32>(it->second.size()));
+    for (Referrer::const_iterator subresource = it->second.begin();
+         subresource != it->second.end(); ++subresource) {
+      pickle.WriteUInt32(url_table.Intern(subresource->first));
+      pickle.WriteFloat(
+          static_cast<float>(subresource->second.subresource_use_rate()));
+    }
+  }
+
+  return std::string(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+bool ReferrerStore::Decode(const std::string& data) {
+  Pickle pickle(data.data(), static_cast<int>(data.size()));
+  PickleIterator iter(pickle);
+
+  uint32 url_count;
+  if (!iter.ReadUInt32(&url_count))
+    return false;
+  std::vector<GURL> urls;
+  for (uint32 i = 0; i < url_count; ++i) {
+    std::string spec;
+    if (!iter.ReadString(&spec))
+      return false;
+    urls.push_back(GURL(spec));
+  }
+
+  uint32 referrer_count;
+  if (!iter.ReadUInt32(&referrer_count))
+    return false;
+  std::vector<DecodedReferrer> decoded;
+  for (uint32 i = 0; i < referrer_count; ++i) {
+    DecodedReferrer referrer;
+    uint32 subresource_count;
+    if (!iter.ReadUInt32(&referrer.url_id) || referrer.url_id >= url_count ||
+        !iter.ReadUInt32(&subresource_count)) {
+      return false;
+    }
+    for (uint32 j = 0; j < subresource_count; ++j) {
+      uint32 url_id;
+      float rate;
+      if (!iter.ReadUInt32(&url_id) || url_id >= url_count ||
+          !iter.ReadFloat(&rate)) {
+        return false;
+      }
+      referrer.subresources.push_back(std::make_pair(url_id, rate));
+    }
+    decoded.push_back(referrer);
+  }
+
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    const GURL& url = urls[decoded[i].url_id];
+    iterator it = referrers_.Get(url);
+    if (it == referrers_.end())
+      it = referrers_.Put(url, Referrer());
+    Referrer* referrer = &it->second;
+    for (size_t j = 0; j < decoded[i].subresources.size(); ++j) {
+      const GURL& subresource_url = urls[decoded[i].subresources[j].first];
+      // As in Referrer::Deserialize(), suggesting the host gives all restored
+      // subresources the same birth date.
+      referrer->SuggestHost(subresource_url);
+      Referrer::iterator subresource = referrer->find(subresource_url);
+      if (subresource != referrer->end()) {
+        subresource->second.SetSubresourceUseRate(
+            decoded[i].subresources[j].second);
+      }
+    }
+  }
+  return true;
+}
+
+bool ReferrerStore::TrimIfDue(iterator it, base::TimeTicks now) {
+  Referrer* referrer = &it->second;
+  while (now - referrer->trim_time() >= trim_period_) {
+    referrer->set_trim_time(referrer->trim_time() + trim_period_);
+    if (!referrer->Trim(trim_ratio_, discard_threshold_)) {
+      referrers_.Erase(it);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace chrome_browser_net
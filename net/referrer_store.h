@@ -0,0 +1,95 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The referrer graph learned by the Predictor: for each referring URL, the
+// Referrer that lists its subresources.  The graph is bounded in size, keeping
+// the most recently used referrers, and is aged lazily as referrers are used
+// rather than by periodically sweeping through all of them.  It is persisted
+// in a compact binary form, with every URL stored only once and fixed-size
+// records for the edges between referrers and subresources.
+
+// All access to this class is performed via the Predictor class, which only
+// operates on the IO thread.
+
+#ifndef CHROME_BROWSER_NET_REFERRER_STORE_H_
+#define CHROME_BROWSER_NET_REFERRER_STORE_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/time/time.h"
+#include "chrome/browser/net/referrer.h"
+#include "url/gurl.h"
+
+namespace chrome_browser_net {
+
+class ReferrerStore {
+ public:
+  typedef base::MRUCache<GURL, Referrer> ReferrerMap;
+  typedef ReferrerMap::iterator iterator;
+  typedef ReferrerMap::const_iterator const_iterator;
+  typedef ReferrerMap::const_reverse_iterator const_reverse_iterator;
+
+  // At most |max_referrers| referrers are kept.  Every |trim_period| a
+  // referrer has not been trimmed, the expected use of its subresources is
+  // scaled by |trim_ratio|, and subresources whose expected use falls to
+  // |discard_threshold| or below are dropped.
+  ReferrerStore(size_t max_referrers,
+                base::TimeDelta trim_period,
+                double trim_ratio,
+                double discard_threshold);
+  ~ReferrerStore();
+
+  // Returns the referrer for |url|, or NULL if there is none, and marks it as
+  // the most recently used one.  Any trimming that became due before |now| is
+  // applied first, which may discard the referrer.
+  Referrer* Get(const GURL& url, base::TimeTicks now);
+
+  // Like Get(), but adds an empty referrer for |url| if there is none.  This
+  // may evict the least recently used referrer.
+  Referrer* GetOrCreate(const GURL& url, base::TimeTicks now);
+
+  // Returns the referrer for |url| without changing its recency or trimming
+  // it, or NULL if there is none.
+  const Referrer* Peek(const GURL& url) const;
+
+  // Trims every referrer once, discarding those that are left without
+  // subresources.
+  void TrimAll();
+
+  void Clear();
+
+  size_t size() const { return referrers_.size(); }
+  bool empty() const { return referrers_.empty(); }
+
+  // Iterates from the most to the least recently used referrer.
+  const_iterator begin() const { return referrers_.begin(); }
+  const_iterator end() const { return referrers_.end(); }
+
+  // Returns the compact encoding of the whole graph.
+  std::string Encode() const;
+
+  // Adds the referrers in |data|, as produced by Encode(), keeping their
+  // relative recency.  Returns false, and adds nothing, if |data| is
+  // malformed.
+  bool Decode(const std::string& data);
+
+ private:
+  // Applies the trimming that became due for |it| before |now|.  Returns false
+  // if the referrer was discarded, in which case |it| is no longer valid.
+  bool TrimIfDue(iterator it, base::TimeTicks now);
+
+  ReferrerMap referrers_;
+
+  const base::TimeDelta trim_period_;
+  const double trim_ratio_;
+  const double discard_threshold_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReferrerStore);
+};
+
+}  // namespace chrome_browser_net
+
+#endif  // CHROME_BROWSER_NET_REFERRER_STORE_H_
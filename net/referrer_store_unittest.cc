@@ -0,0 +1,118 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/referrer_store.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace chrome_browser_net {
+
+namespace {
+
+const double kTrimRatio = 0.5;
+const double kDiscardThreshold = 0.3;
+
+base::TimeDelta TrimPeriod() {
+  return base::TimeDelta::FromHours(1);
+}
+
+}  // namespace
+
+TEST(ReferrerStoreTest, EvictsLeastRecentlyUsed) {
+  ReferrerStore store(2, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  base::TimeTicks now = base::TimeTicks::Now();
+  const GURL a("http://a.com/");
+  const GURL b("http://b.com/");
+  const GURL c("http://c.com/");
+  const GURL subresource("http://cdn.com/");
+
+  store.GetOrCreate(a, now)->SuggestHost(subresource);
+  store.GetOrCreate(b, now)->SuggestHost(subresource);
+  // Using |a| makes |b| the least recently used referrer.
+  EXPECT_TRUE(store.Get(a, now));
+  store.GetOrCreate(c, now)->SuggestHost(subresource);
+
+  EXPECT_EQ(2u, store.size());
+  EXPECT_TRUE(store.Peek(a));
+  EXPECT_FALSE(store.Peek(b));
+  EXPECT_TRUE(store.Peek(c));
+}
+
+TEST(ReferrerStoreTest, TrimsWhenUsed) {
+  ReferrerStore store(10, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  base::TimeTicks now = base::TimeTicks::Now();
+  const GURL referrer_url("http://a.com/");
+  const GURL subresource("http://cdn.com/");
+
+  Referrer* referrer = store.GetOrCreate(referrer_url, now);
+  referrer->SuggestHost(subresource);
+  (*referrer)[subresource].SetSubresourceUseRate(1.0);
+
+  // Nothing is due before a full period has passed.
+  referrer = store.Get(referrer_url, now + base::TimeDelta::FromMinutes(59));
+  ASSERT_TRUE(referrer);
+  EXPECT_EQ(1.0, (*referrer)[subresource].subresource_use_rate());
+
+  // Two periods have passed, so the rate is scaled twice.
+  referrer = store.Get(referrer_url, now + base::TimeDelta::FromMinutes(121));
+  ASSERT_TRUE(referrer);
+  EXPECT_EQ(0.25, (*referrer)[subresource].subresource_use_rate());
+
+  // Peek() doesn't trim, but the next use discards the referrer.
+  const base::TimeTicks later = now + base::TimeDelta::FromHours(4);
+  EXPECT_TRUE(store.Peek(referrer_url));
+  EXPECT_FALSE(store.Get(referrer_url, later));
+  EXPECT_TRUE(store.empty());
+}
+
+TEST(ReferrerStoreTest, EncodeDecode) {
+  ReferrerStore store(10, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  base::TimeTicks now = base::TimeTicks::Now();
+  const GURL a("http://a.com/");
+  const GURL b("http://b.com/");
+  const GURL shared("http://cdn.com/");
+  const GURL other("http://other.com/");
+
+  Referrer* referrer = store.GetOrCreate(a, now);
+  referrer->SuggestHost(shared);
+  (*referrer)[shared].SetSubresourceUseRate(1.5);
+  referrer = store.GetOrCreate(b, now);
+  referrer->SuggestHost(shared);
+  referrer->SuggestHost(other);
+  (*referrer)[shared].SetSubresourceUseRate(0.5);
+  (*referrer)[other].SetSubresourceUseRate(2.0);
+
+  ReferrerStore restored(10, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  ASSERT_TRUE(restored.Decode(store.Encode()));
+  ASSERT_EQ(2u, restored.size());
+  // Recency is preserved.
+  EXPECT_EQ(b, restored.begin()->first);
+
+  const Referrer* restored_referrer = restored.Peek(a);
+  ASSERT_TRUE(restored_referrer);
+  ASSERT_EQ(1u, restored_referrer->size());
+  EXPECT_EQ(1.5,
+            restored_referrer->find(shared)->second.subresource_use_rate());
+  restored_referrer = restored.Peek(b);
+  ASSERT_TRUE(restored_referrer);
+  ASSERT_EQ(2u, restored_referrer->size());
+  EXPECT_EQ(0.5,
+            restored_referrer->find(shared)->second.subresource_use_rate());
+  EXPECT_EQ(2.0,
+            restored_referrer->find(other)->second.subresource_use_rate());
+}
+
+TEST(ReferrerStoreTest, DecodeMalformed) {
+  ReferrerStore store(10, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  store.GetOrCreate(GURL("http://a.com/"), base::TimeTicks::Now())
+      ->SuggestHost(GURL("http://cdn.com/"));
+  std::string data = store.Encode();
+
+  ReferrerStore restored(10, TrimPeriod(), kTrimRatio, kDiscardThreshold);
+  EXPECT_FALSE(restored.Decode(std::string()));
+  EXPECT_FALSE(restored.Decode(data.substr(0, data.size() - 4)));
+  EXPECT_TRUE(restored.empty());
+}
+
+}  // namespace chrome_browser_net
@@ -0,0 +1,139 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "chrome/browser/net/sqlite_channel_id_store.h"
+#include "chrome/common/chrome_constants.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+const int kNumChannelIDs = 2000;
+
+std::string GetServerIdentifier(int i) {
+  return base::StringPrintf("host%d.com", i);
+}
+
+}  // namespace
+
+class SQLiteChannelIDStorePerfTest : public testing::Test {
+ public:
+  void OnLoaded(
+      base::RunLoop* run_loop,
+      base::TimeTicks* loaded_time,
+      ScopedVector<net::DefaultChannelIDStore::ChannelID>* loaded,
+      scoped_ptr<ScopedVector<
+          net::DefaultChannelIDStore::ChannelID> > channel_ids) {
+    *loaded_time = base::TimeTicks::Now();
+    loaded->swap(*channel_ids);
+    run_loop->Quit();
+  }
+
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  void CreateStore() {
+    store_ = new SQLiteChannelIDStore(
+        temp_dir_.path().Append(chrome::kChannelIDFilename),
+        base::MessageLoopProxy::current(),
+        NULL);
+  }
+
+  // Releases the store, which commits the pending operations.
+  void CloseStore() {
+    store_ = NULL;
+    base::RunLoop().RunUntilIdle();
+  }
+
+  content::TestBrowserThreadBundle thread_bundle_;
+  base::ScopedTempDir temp_dir_;
+  scoped_refptr<SQLiteChannelIDStore> store_;
+};
+
+// Measures committing channel IDs in batches of the commit threshold.
+TEST_F(SQLiteChannelIDStorePerfTest, BatchCommit) {
+  CreateStore();
+  ScopedVector<net::DefaultChannelIDStore::ChannelID> channel_ids;
+  base::TimeTicks loaded_time;
+  base::RunLoop run_loop;
+  store_->Load(base::Bind(&SQLiteChannelIDStorePerfTest::OnLoaded,
+                          base::Unretained(this), &run_loop, &loaded_time,
+                          &channel_ids));
+  run_loop.Run();
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumChannelIDs; ++i) {
+    store_->AddChannelID(
+        net::DefaultChannelIDStore::ChannelID(
+            GetServerIdentifier(i),
+            base::Time::FromInternalValue(1),
+            base::Time::FromInternalValue(2),
+            "a", "b"));
+  }
+  // Runs the commits of the full batches, but not the one of the remainder,
+  // which is on a timer.
+  base::RunLoop().RunUntilIdle();
+  base::TimeDelta batch_commit_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  CloseStore();
+  base::TimeDelta close_time = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("channel_id_store_commit", "", "full_batches",
+                         batch_commit_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("channel_id_store_commit", "", "close",
+                         close_time.InMillisecondsF(), "ms", false);
+}
+
+// Measures how long a connection waits for its channel ID at startup, which
+// is until the whole table is loaded.
+TEST_F(SQLiteChannelIDStorePerfTest, LoadLatency) {
+  CreateStore();
+  {
+    ScopedVector<net::DefaultChannelIDStore::ChannelID> channel_ids;
+    base::TimeTicks loaded_time;
+    base::RunLoop run_loop;
+    store_->Load(base::Bind(&SQLiteChannelIDStorePerfTest::OnLoaded,
+                            base::Unretained(this), &run_loop, &loaded_time,
+                            &channel_ids));
+    run_loop.Run();
+  }
+  for (int i = 0; i < kNumChannelIDs; ++i) {
+    store_->AddChannelID(
+        net::DefaultChannelIDStore::ChannelID(
+            GetServerIdentifier(i),
+            base::Time::FromInternalValue(1),
+            base::Time::FromInternalValue(2),
+            "a", "b"));
+  }
+  CloseStore();
+
+  CreateStore();
+  ScopedVector<net::DefaultChannelIDStore::ChannelID> channel_ids;
+  base::TimeTicks loaded_time;
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::RunLoop run_loop;
+  store_->Load(base::Bind(&SQLiteChannelIDStorePerfTest::OnLoaded,
+                          base::Unretained(this), &run_loop, &loaded_time,
+                          &channel_ids));
+  run_loop.Run();
+
+  EXPECT_EQ(static_cast<size_t>(kNumChannelIDs), channel_ids.size());
+
+  perf_test::PrintResult("channel_id_store_load", "", "all",
+                         (loaded_time - start).InMillisecondsF(), "ms",
+                         true);
+  CloseStore();
+}
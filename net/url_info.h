@@ -99,6 +99,8 @@ class UrlInfo {
 
   bool was_linked() const { return was_linked_; }
 
+  ResolutionMotivation motivation() const { return motivation_; }
+
   GURL referring_url() const { return referring_url_; }
   void SetReferringHostname(const GURL& url) {
     referring_url_ = url;
@@ -4,6 +4,8 @@
 
 #include "chrome/browser/performance_monitor/database.h"
 
+#include <algorithm>
+
 #include "base/file_util.h"
 #include "base/files/file_path.h"
 #include "base/json/json_reader.h"
@@ -30,6 +32,7 @@ const char kEventDb[] = "Events";
 const char kStateDb[] = "Configuration";
 const char kActiveIntervalDb[] = "Active Interval";
 const char kMetricDb[] = "Metrics";
+const char kRollupDb[] = "Rollup Metrics";
 const double kDefaultMaxValue = 0.0;
 
 // If the db is quiet for this number of minutes, then it is considered down.
@@ -37,6 +40,71 @@ const base::TimeDelta kActiveIntervalTimeout() {
   return base::TimeDelta::FromMinutes(5);
 }
 
+// Raw statistics are kept for this number of days by default.
+const base::TimeDelta kDefaultRawMetricRetention() {
+  return base::TimeDelta::FromDays(7);
+}
+
+// Per-minute aggregates are kept for this number of days. Hourly and daily
+// aggregates are small enough to be kept forever.
+const base::TimeDelta kMinuteRollupRetention() {
+  return base::TimeDelta::FromDays(30);
+}
+
+// Expired metrics are removed at most once in this number of minutes.
+const base::TimeDelta kExpirationInterval() {
+  return base::TimeDelta::FromMinutes(60);
+}
+
+base::TimeDelta RollupTierToInterval(RollupTier tier) {
+  switch (tier) {
+    case ROLLUP_TIER_MINUTE:
+      return base::TimeDelta::FromMinutes(1);
+    case ROLLUP_TIER_HOUR:
+      return base::TimeDelta::FromHours(1);
+    case ROLLUP_TIER_DAY:
+      return base::TimeDelta::FromDays(1);
+    case ROLLUP_TIER_NUMBER_OF_TIERS:
+      break;
+  }
+  NOTREACHED();
+  return base::TimeDelta();
+}
+
+// Returns the beginning of the interval of |tier| which contains |time|.
+base::Time GetRollupIntervalStart(RollupTier tier, const base::Time& time) {
+  int64 interval = RollupTierToInterval(tier).InMicroseconds();
+  int64 value = time.ToInternalValue();
+  return base::Time::FromInternalValue(value - value % interval);
+}
+
+// Returns the coarsest tier whose interval does not exceed |resolution|, or
+// false if |resolution| is finer than every tier.
+bool GetRollupTierForResolution(const base::TimeDelta& resolution,
+                                RollupTier* tier) {
+  for (int i = ROLLUP_TIER_NUMBER_OF_TIERS - 1; i >= 0; --i) {
+    if (RollupTierToInterval(static_cast<RollupTier>(i)) <= resolution) {
+      *tier = static_cast<RollupTier>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Adds a deletion of every key in [|start_key|, |end_key|) of |db| to |batch|.
+void DeleteRange(leveldb::DB* db,
+                 const leveldb::ReadOptions& read_options,
+                 const std::string& start_key,
+                 const std::string& end_key,
+                 leveldb::WriteBatch* batch) {
+  scoped_ptr<leveldb::Iterator> it(db->NewIterator(read_options));
+  for (it->Seek(start_key);
+       it->Valid() && it->key().ToString() < end_key;
+       it->Next()) {
+    batch->Delete(it->key());
+  }
+}
+
 TimeRange ActiveIntervalToTimeRange(const std::string& start_time,
                                     const std::string& end_time) {
   int64 start_time_int = 0;
@@ -239,7 +307,10 @@ bool Database::AddMetric(const std::string& activity,
 
   bool max_value_success =
       UpdateMaxValue(activity, metric.type, metric.ValueAsString());
-  return recent_status.ok() && metric_status.ok() && max_value_success;
+  bool rollup_success = UpdateRollups(activity, metric);
+  MaybeExpireMetrics();
+  return recent_status.ok() && metric_status.ok() && max_value_success &&
+         rollup_success;
 }
 
 bool Database::UpdateMaxValue(const std::string& activity,
@@ -257,6 +328,72 @@ bool Database::UpdateMaxValue(const std::string& activity,
   return true;
 }
 
+bool Database::UpdateRollups(const std::string& activity,
+                             const Metric& metric) {
+  leveldb::WriteBatch updates;
+  for (int i = 0; i < ROLLUP_TIER_NUMBER_OF_TIERS; ++i) {
+    RollupTier tier = static_cast<RollupTier>(i);
+    base::Time interval_start = GetRollupIntervalStart(tier, metric.time);
+    std::string rollup_key = key_builder_->CreateRollupKey(
+        tier, interval_start, metric.type, activity);
+    std::string rollup_map_key =
+        key_builder_->CreateRollupMapKey(tier, metric.type, activity);
+
+    AggregatedMetric& aggregate = rollup_map_[rollup_map_key];
+    if (aggregate.count == 0 || aggregate.time != interval_start) {
+      // The interval may have been started before the database was reopened,
+      // or |metric| may arrive out of order.
+      aggregate = AggregatedMetric(metric.type, interval_start);
+      std::string value;
+      if (rollup_db_->Get(read_options_, rollup_key, &value).ok() &&
+          !aggregate.ValueFromString(value)) {
+        aggregate = AggregatedMetric(metric.type, interval_start);
+      }
+    }
+    aggregate.AddSample(metric.value);
+    updates.Put(rollup_key, aggregate.ValueAsString());
+  }
+  return rollup_db_->Write(write_options_, &updates).ok();
+}
+
+void Database::MaybeExpireMetrics() {
+  // UpdateActiveInterval() has just stamped the time of the transaction.
+  base::Time current_time = last_update_time_;
+  if (!last_expiration_time_.is_null() &&
+      current_time - last_expiration_time_ < kExpirationInterval()) {
+    return;
+  }
+  last_expiration_time_ = current_time;
+
+  base::Time raw_cutoff = current_time - raw_metric_retention_;
+  base::Time minute_cutoff = current_time - kMinuteRollupRetention();
+  leveldb::WriteBatch expired_metrics;
+  leveldb::WriteBatch expired_rollups;
+  for (int i = METRIC_UNDEFINED; i < METRIC_NUMBER_OF_METRICS; ++i) {
+    MetricType type = static_cast<MetricType>(i);
+    if (raw_cutoff > base::Time()) {
+      DeleteRange(metric_db_.get(), read_options_,
+                  key_builder_->CreateMetricKey(base::Time(), type,
+                                                std::string()),
+                  key_builder_->CreateMetricKey(raw_cutoff, type,
+                                                std::string()),
+                  &expired_metrics);
+    }
+    if (minute_cutoff > base::Time()) {
+      DeleteRange(rollup_db_.get(), read_options_,
+                  key_builder_->CreateRollupKey(ROLLUP_TIER_MINUTE,
+                                                base::Time(), type,
+                                                std::string()),
+                  key_builder_->CreateRollupKey(ROLLUP_TIER_MINUTE,
+                                                minute_cutoff, type,
+                                                std::string()),
+                  &expired_rollups);
+    }
+  }
+  metric_db_->Write(write_options_, &expired_metrics);
+  rollup_db_->Write(write_options_, &expired_rollups);
+}
+
 Database::MetricTypeSet Database::GetActiveMetrics(const base::Time& start,
                                                    const base::Time& end) {
   CHECK(!content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
@@ -389,6 +526,100 @@ scoped_ptr<Database::MetricVector> Database::GetStatsForActivityAndMetric(
   return results.Pass();
 }
 
+scoped_ptr<Database::AggregatedMetricVector>
+Database::GetAggregatedStatsForActivityAndMetric(
+    const std::string& activity,
+    MetricType metric_type,
+    const base::Time& start,
+    const base::Time& end,
+    const base::TimeDelta& resolution) {
+  CHECK(!content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
+  scoped_ptr<AggregatedMetricVector> results(new AggregatedMetricVector());
+
+  RollupTier tier = ROLLUP_TIER_MINUTE;
+  if (!GetRollupTierForResolution(resolution, &tier)) {
+    scoped_ptr<MetricVector> metrics =
+        GetStatsForActivityAndMetric(activity, metric_type, start, end);
+    for (MetricVector::const_iterator it = metrics->begin();
+         it != metrics->end(); ++it) {
+      AggregatedMetric aggregate(metric_type, it->time);
+      aggregate.AddSample(it->value);
+      results->push_back(aggregate);
+    }
+    return results.Pass();
+  }
+
+  // Include the interval which |start| falls into.
+  std::string start_key = key_builder_->CreateRollupKey(
+      tier, GetRollupIntervalStart(tier, start), metric_type, activity);
+  std::string end_key =
+      key_builder_->CreateRollupKey(tier, end, metric_type, activity);
+  leveldb::WriteBatch invalid_entries;
+  scoped_ptr<leveldb::Iterator> it(rollup_db_->NewIterator(read_options_));
+  for (it->Seek(start_key);
+       it->Valid() && it->key().ToString() <= end_key;
+       it->Next()) {
+    RollupKey split_key = key_builder_->SplitRollupKey(it->key().ToString());
+    if (split_key.activity != activity)
+      continue;
+    int64 interval_start = 0;
+    base::StringToInt64(split_key.time, &interval_start);
+    AggregatedMetric aggregate(metric_type,
+                               base::Time::FromInternalValue(interval_start));
+    if (!aggregate.ValueFromString(it->value().ToString())) {
+      invalid_entries.Delete(it->key());
+      LOG(ERROR) << "Found bad aggregated metric in the database. Type: "
+                 << metric_type << ", Time: " << interval_start
+                 << ", Value: " << it->value().ToString()
+                 << ". Erasing aggregated metric from database.";
+      continue;
+    }
+    results->push_back(aggregate);
+  }
+  rollup_db_->Write(write_options_, &invalid_entries);
+  return results.Pass();
+}
+
+scoped_ptr<Database::MetricVector> Database::GetStatsForActivityAndMetric(
+    const std::string& activity,
+    MetricType metric_type,
+    const base::Time& start,
+    const base::Time& end,
+    const base::TimeDelta& resolution) {
+  scoped_ptr<AggregatedMetricVector> aggregates =
+      GetAggregatedStatsForActivityAndMetric(activity, metric_type, start, end,
+                                             resolution);
+  scoped_ptr<MetricVector> results(new MetricVector());
+  for (AggregatedMetricVector::const_iterator it = aggregates->begin();
+       it != aggregates->end(); ++it) {
+    results->push_back(Metric(metric_type, it->time, it->mean()));
+  }
+  return results.Pass();
+}
+
+scoped_ptr<Database::MetricVector> Database::GetRawStatsForActivityAndMetric(
+    const std::string& activity,
+    MetricType metric_type,
+    const base::Time& start,
+    const base::Time& end,
+    const base::TimeDelta& resolution) {
+  base::Time raw_cutoff = clock_->GetTime() - raw_metric_retention_;
+  if (start >= raw_cutoff)
+    return GetStatsForActivityAndMetric(activity, metric_type, start, end);
+
+  scoped_ptr<MetricVector> results = GetStatsForActivityAndMetric(
+      activity, metric_type, start,
+      std::min(end, raw_cutoff - base::TimeDelta::FromMicroseconds(1)),
+      resolution);
+  if (end < raw_cutoff)
+    return results.Pass();
+
+  scoped_ptr<MetricVector> raw_metrics =
+      GetStatsForActivityAndMetric(activity, metric_type, raw_cutoff, end);
+  results->insert(results->end(), raw_metrics->begin(), raw_metrics->end());
+  return results.Pass();
+}
+
 Database::MetricVectorMap Database::GetStatsForMetricByActivity(
     MetricType metric_type,
     const base::Time& start,
@@ -427,6 +658,7 @@ Database::MetricVectorMap Database::GetStatsForMetricByActivity(
 Database::Database(const base::FilePath& path)
     : key_builder_(new KeyBuilder()),
       path_(path),
+      raw_metric_retention_(kDefaultRawMetricRetention()),
       read_options_(leveldb::ReadOptions()),
       write_options_(leveldb::WriteOptions()),
       valid_(false) {
@@ -466,8 +698,11 @@ bool Database::InitDBs() {
   event_db_ = SafelyOpenDatabase(open_options,
                                  kEventDb,
                                  true);  // fix if damaged
+  rollup_db_ = SafelyOpenDatabase(open_options,
+                                  kRollupDb,
+                                  true);  // fix if damaged
   return recent_db_ && max_value_db_ && state_db_ &&
-         active_interval_db_ && metric_db_ && event_db_;
+         active_interval_db_ && metric_db_ && event_db_ && rollup_db_;
 }
 
 scoped_ptr<leveldb::DB> Database::SafelyOpenDatabase(
@@ -538,12 +773,14 @@ scoped_ptr<leveldb::DB> Database::SafelyOpenDatabase(
 bool Database::Close() {
   CHECK(!content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
   metric_db_.reset();
+  rollup_db_.reset();
   event_db_.reset();
   recent_db_.reset();
   max_value_db_.reset();
   state_db_.reset();
   active_interval_db_.reset();
   start_time_key_.clear();
+  rollup_map_.clear();
   return true;
 }
 
@@ -96,6 +96,17 @@ class DatabaseTestHelper;
 // interval.
 // Key: Metric - Time - Activity
 // Value: Statistic
+// Raw statistics older than the raw metric retention period are expired.
+//
+// Rollup DB:
+// Stores the aggregates (count, min, max and sum) of the statistics per minute,
+// per hour and per day. They are maintained on insert, with |rollup_map_|
+// caching the aggregate of the latest interval for each (tier, metric,
+// activity) triple. Range queries at a coarse resolution read the coarsest
+// tier that satisfies the resolution instead of scanning the Metric DB.
+// Per-minute aggregates expire like raw statistics, after a longer period.
+// Key: Tier - Metric - Time - Activity
+// Value: Aggregated Statistic
 class Database {
  public:
   typedef std::set<EventType> EventTypeSet;
@@ -103,6 +114,7 @@ class Database {
   typedef std::set<MetricType> MetricTypeSet;
   typedef std::vector<Metric> MetricVector;
   typedef std::map<std::string, linked_ptr<MetricVector> > MetricVectorMap;
+  typedef std::vector<AggregatedMetric> AggregatedMetricVector;
 
   static const char kDatabaseSequenceToken[];
 
@@ -214,6 +226,35 @@ class Database {
                                         base::Time(), clock_->GetTime());
   }
 
+  // Query given |metric_type| and |activity| at a resolution of at least
+  // |resolution|. The coarsest aggregation tier whose interval does not exceed
+  // |resolution| is read; if |resolution| is finer than every tier, each raw
+  // statistic is returned as an aggregate of its own.
+  scoped_ptr<AggregatedMetricVector> GetAggregatedStatsForActivityAndMetric(
+      const std::string& activity,
+      MetricType metric_type,
+      const base::Time& start,
+      const base::Time& end,
+      const base::TimeDelta& resolution);
+
+  // Same as above, but returns the mean of each aggregate.
+  scoped_ptr<MetricVector> GetStatsForActivityAndMetric(
+      const std::string& activity,
+      MetricType metric_type,
+      const base::Time& start,
+      const base::Time& end,
+      const base::TimeDelta& resolution);
+
+  // Query the raw statistics of given |metric_type| and |activity|. Only the
+  // part of the range whose raw statistics have expired is read from the
+  // aggregates at |resolution|, so that recent data keeps every sample.
+  scoped_ptr<MetricVector> GetRawStatsForActivityAndMetric(
+      const std::string& activity,
+      MetricType metric_type,
+      const base::Time& start,
+      const base::Time& end,
+      const base::TimeDelta& resolution);
+
   // Query given |metric_type|. The returned map is keyed by activity.
   MetricVectorMap GetStatsForMetricByActivity(MetricType metric_type,
                                               const base::Time& start,
@@ -235,11 +276,17 @@ class Database {
     clock_ = clock.Pass();
   }
 
+  // Raw statistics older than |retention| are removed from the Metric DB.
+  void set_raw_metric_retention(const base::TimeDelta& retention) {
+    raw_metric_retention_ = retention;
+  }
+
  private:
   friend class DatabaseTestHelper;
 
   typedef std::map<std::string, std::string> RecentMap;
   typedef std::map<std::string, double> MaxValueMap;
+  typedef std::map<std::string, AggregatedMetric> RollupMap;
 
   // By default, the database uses a clock that simply returns the current time.
   class SystemClock : public Clock {
@@ -275,6 +322,11 @@ class Database {
   bool UpdateMaxValue(const std::string& activity,
                       MetricType metric,
                       const std::string& value);
+  // Folds |metric| into the aggregates of every rollup tier.
+  bool UpdateRollups(const std::string& activity, const Metric& metric);
+  // Removes the raw statistics and per-minute aggregates which are older than
+  // their retention period. This is a no-op if it ran recently.
+  void MaybeExpireMetrics();
 
   scoped_ptr<KeyBuilder> key_builder_;
 
@@ -285,6 +337,10 @@ class Database {
 
   MaxValueMap max_value_map_;
 
+  // A mapping of tier,id,metric to the aggregate of the latest interval for
+  // those parameters, to avoid reading the rollup db on every insert.
+  RollupMap rollup_map_;
+
   // The directory where all the databases will reside.
   base::FilePath path_;
 
@@ -294,6 +350,11 @@ class Database {
   // The last time the database had a transaction.
   base::Time last_update_time_;
 
+  // The last time expired metrics were removed.
+  base::Time last_expiration_time_;
+
+  base::TimeDelta raw_metric_retention_;
+
   scoped_ptr<Clock> clock_;
 
   scoped_ptr<leveldb::DB> recent_db_;
@@ -306,6 +367,8 @@ class Database {
 
   scoped_ptr<leveldb::DB> metric_db_;
 
+  scoped_ptr<leveldb::DB> rollup_db_;
+
   scoped_ptr<leveldb::DB> event_db_;
 
   leveldb::ReadOptions read_options_;
@@ -79,6 +79,21 @@ class DatabaseTestHelper {
   Database* database_;
 };
 
+// A clock that only moves when advanced explicitly.
+class ManualClock : public Database::Clock {
+ public:
+  explicit ManualClock(const base::Time& now) : now_(now) {}
+  virtual ~ManualClock() {}
+  virtual base::Time GetTime() OVERRIDE {
+    return now_;
+  }
+  void Advance(const base::TimeDelta& delta) {
+    now_ += delta;
+  }
+ private:
+  base::Time now_;
+};
+
 // A clock that increments every access. Great for testing.
 class TestingClock : public Database::Clock {
  public:
@@ -531,4 +546,110 @@ TEST_F(PerformanceMonitorDatabaseMetricTest, GetRange) {
   ASSERT_EQ(9, stats[1].value);
 }
 
+TEST_F(PerformanceMonitorDatabaseMetricTest, GetAggregatedStats) {
+  db_->AddMetric(activity_, Metric(METRIC_CPU_USAGE, clock_->GetTime(), 6.9));
+  db_->AddMetric(activity_, Metric(METRIC_CPU_USAGE, clock_->GetTime(), 20.0));
+
+  // All the stats fall into the same interval of every tier.
+  Database::AggregatedMetricVector aggregates =
+      *db_->GetAggregatedStatsForActivityAndMetric(
+          activity_, METRIC_CPU_USAGE, base::Time(), clock_->GetTime(),
+          base::TimeDelta::FromHours(1));
+  ASSERT_EQ(1u, aggregates.size());
+  EXPECT_EQ(3, aggregates[0].count);
+  EXPECT_DOUBLE_EQ(6.9, aggregates[0].min);
+  EXPECT_DOUBLE_EQ(20.0, aggregates[0].max);
+  EXPECT_DOUBLE_EQ(40.0 / 3, aggregates[0].mean());
+
+  Database::MetricVector stats = *db_->GetStatsForActivityAndMetric(
+      activity_, METRIC_CPU_USAGE, base::Time(), clock_->GetTime(),
+      base::TimeDelta::FromDays(7));
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_DOUBLE_EQ(40.0 / 3, stats[0].value);
+
+  // A resolution finer than a minute reads the raw stats.
+  stats = *db_->GetStatsForActivityAndMetric(
+      activity_, METRIC_CPU_USAGE, base::Time(), clock_->GetTime(),
+      base::TimeDelta::FromSeconds(1));
+  ASSERT_EQ(3u, stats.size());
+  EXPECT_EQ(13.1, stats[0].value);
+  EXPECT_EQ(6.9, stats[1].value);
+  EXPECT_EQ(20, stats[2].value);
+
+  // Other activities are not aggregated together.
+  aggregates = *db_->GetAggregatedStatsForActivityAndMetric(
+      kProcessChromeAggregate, METRIC_CPU_USAGE, base::Time(),
+      clock_->GetTime(), base::TimeDelta::FromMinutes(1));
+  ASSERT_EQ(1u, aggregates.size());
+  EXPECT_EQ(1, aggregates[0].count);
+  EXPECT_EQ(50.5, aggregates[0].max);
+}
+
+TEST(PerformanceMonitorDatabaseRollupTest, RawMetricRetention) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  scoped_ptr<Database> db = Database::Create(temp_dir.path());
+  ASSERT_TRUE(db.get());
+  base::Time start =
+      base::Time::FromInternalValue(0) + base::TimeDelta::FromDays(100);
+  ManualClock* clock = new ManualClock(start);
+  db->set_clock(scoped_ptr<Database::Clock>(clock));
+  db->set_raw_metric_retention(base::TimeDelta::FromDays(1));
+
+  db->AddMetric(Metric(METRIC_CPU_USAGE, clock->GetTime(), 10.0));
+  clock->Advance(base::TimeDelta::FromDays(2));
+  db->AddMetric(Metric(METRIC_CPU_USAGE, clock->GetTime(), 20.0));
+
+  // The first stat has expired from the raw stats.
+  Database::MetricVector stats = *db->GetStatsForActivityAndMetric(
+      METRIC_CPU_USAGE, base::Time(), clock->GetTime());
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(20, stats[0].value);
+
+  // But it is still in the aggregates.
+  stats = *db->GetStatsForActivityAndMetric(
+      kProcessChromeAggregate, METRIC_CPU_USAGE, start, clock->GetTime(),
+      base::TimeDelta::FromHours(1));
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ(10, stats[0].value);
+  EXPECT_EQ(20, stats[1].value);
+}
+
+TEST(PerformanceMonitorDatabaseRollupTest, RawStatsWithinRetention) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  scoped_ptr<Database> db = Database::Create(temp_dir.path());
+  ASSERT_TRUE(db.get());
+  base::Time start =
+      base::Time::FromInternalValue(0) + base::TimeDelta::FromDays(100);
+  ManualClock* clock = new ManualClock(start);
+  db->set_clock(scoped_ptr<Database::Clock>(clock));
+  db->set_raw_metric_retention(base::TimeDelta::FromDays(1));
+
+  db->AddMetric(Metric(METRIC_CPU_USAGE, clock->GetTime(), 10.0));
+  clock->Advance(base::TimeDelta::FromDays(2));
+  db->AddMetric(Metric(METRIC_CPU_USAGE, clock->GetTime(), 20.0));
+  clock->Advance(base::TimeDelta::FromMinutes(1));
+  db->AddMetric(Metric(METRIC_CPU_USAGE, clock->GetTime(), 30.0));
+
+  // The expired stat comes from the aggregates, while the retained stats are
+  // returned one by one instead of as the mean of their hour.
+  Database::MetricVector stats = *db->GetRawStatsForActivityAndMetric(
+      kProcessChromeAggregate, METRIC_CPU_USAGE, start, clock->GetTime(),
+      base::TimeDelta::FromHours(1));
+  ASSERT_EQ(3u, stats.size());
+  EXPECT_EQ(10, stats[0].value);
+  EXPECT_EQ(20, stats[1].value);
+  EXPECT_EQ(30, stats[2].value);
+
+  // A range within the retention period only reads the raw stats.
+  stats = *db->GetRawStatsForActivityAndMetric(
+      kProcessChromeAggregate, METRIC_CPU_USAGE,
+      clock->GetTime() - base::TimeDelta::FromHours(1), clock->GetTime(),
+      base::TimeDelta::FromHours(1));
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ(20, stats[0].value);
+  EXPECT_EQ(30, stats[1].value);
+}
+
 }  // namespace performance_monitor
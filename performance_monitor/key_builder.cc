@@ -60,6 +60,12 @@ EVENT_UNCLEAN_EXIT_KEY_CHAR = 44,
 EVENT_NUMBER_OF_EVENTS_KEY_CHAR = 255,
 };
 
+enum RollupTierKeyChar {
+ROLLUP_TIER_MINUTE_KEY_CHAR = 35,
+ROLLUP_TIER_HOUR_KEY_CHAR = 36,
+ROLLUP_TIER_DAY_KEY_CHAR = 37,
+};
+
 // The position of different elements in the key for the event db.
 enum EventKeyPosition {
   EVENT_TIME,  // The time the event was generated.
@@ -86,6 +92,14 @@ enum MetricKeyPosition {
   METRIC_ACTIVITY  // The unique identifier for the activity.
 };
 
+// The position of different elements in the key for the rollup db.
+enum RollupKeyPosition {
+  ROLLUP_TIER,  // The resolution of the aggregate.
+  ROLLUP_TYPE,  // The unique identifier for the metric.
+  ROLLUP_TIME,  // The beginning of the aggregated interval.
+  ROLLUP_ACTIVITY  // The unique identifier for the activity.
+};
+
 }  // namespace
 
 RecentKey::RecentKey(const std::string& recent_time,
@@ -106,6 +120,19 @@ MetricKey::MetricKey(const std::string& metric_time,
 MetricKey::~MetricKey() {
 }
 
+RollupKey::RollupKey(RollupTier rollup_tier,
+                     const std::string& rollup_time,
+                     MetricType rollup_type,
+                     const std::string& rollup_activity)
+    : tier(rollup_tier),
+      time(rollup_time),
+      type(rollup_type),
+      activity(rollup_activity) {
+}
+
+RollupKey::~RollupKey() {
+}
+
 KeyBuilder::KeyBuilder() {
   PopulateKeyMaps();
 }
@@ -171,6 +198,20 @@ void KeyBuilder::PopulateKeyMaps() {
     metric_key_char_to_metric_type_[metric_type_to_metric_key_char_[
         static_cast<MetricType>(i)]] = static_cast<MetricType>(i);
   }
+
+  // And for rollup tiers.
+  rollup_tier_to_rollup_key_char_[ROLLUP_TIER_MINUTE] =
+      ROLLUP_TIER_MINUTE_KEY_CHAR;
+  rollup_tier_to_rollup_key_char_[ROLLUP_TIER_HOUR] =
+      ROLLUP_TIER_HOUR_KEY_CHAR;
+  rollup_tier_to_rollup_key_char_[ROLLUP_TIER_DAY] = ROLLUP_TIER_DAY_KEY_CHAR;
+  DCHECK(rollup_tier_to_rollup_key_char_.size() ==
+         ROLLUP_TIER_NUMBER_OF_TIERS);
+
+  for (int i = 0; i < static_cast<int>(ROLLUP_TIER_NUMBER_OF_TIERS); ++i) {
+    rollup_key_char_to_rollup_tier_[rollup_tier_to_rollup_key_char_[
+        static_cast<RollupTier>(i)]] = static_cast<RollupTier>(i);
+  }
 }
 
 std::string KeyBuilder::CreateActiveIntervalKey(const base::Time& time) {
@@ -216,6 +257,26 @@ std::string KeyBuilder::CreateMaxValueKey(const MetricType type,
                             kDelimiter, activity.c_str());
 }
 
+std::string KeyBuilder::CreateRollupKey(const RollupTier tier,
+                                        const base::Time& time,
+                                        const MetricType type,
+                                        const std::string& activity) {
+  return base::StringPrintf("%c%c%c%c%016" PRId64 "%c%s",
+                            rollup_tier_to_rollup_key_char_[tier],
+                            kDelimiter, metric_type_to_metric_key_char_[type],
+                            kDelimiter, time.ToInternalValue(),
+                            kDelimiter, activity.c_str());
+}
+
+std::string KeyBuilder::CreateRollupMapKey(const RollupTier tier,
+                                           const MetricType type,
+                                           const std::string& activity) {
+  return base::StringPrintf("%c%c%s",
+                            rollup_tier_to_rollup_key_char_[tier],
+                            kDelimiter,
+                            CreateRecentMapKey(type, activity).c_str());
+}
+
 EventType KeyBuilder::EventKeyToEventType(const std::string& event_key) {
   std::vector<std::string> split;
   base::SplitString(event_key, kDelimiter, &split);
@@ -244,4 +305,17 @@ MetricKey KeyBuilder::SplitMetricKey(const std::string& key) {
                    split[METRIC_ACTIVITY]);
 }
 
+RollupKey KeyBuilder::SplitRollupKey(const std::string& key) {
+  std::vector<std::string> split;
+  base::SplitString(key, kDelimiter, &split);
+  DCHECK(split[ROLLUP_TIER].size() == 1);
+  DCHECK(split[ROLLUP_TYPE].size() == 1);
+  return RollupKey(rollup_key_char_to_rollup_tier_[
+                       static_cast<int>(split[ROLLUP_TIER].at(0))],
+                   split[ROLLUP_TIME],
+                   metric_key_char_to_metric_type_[
+                       static_cast<int>(split[ROLLUP_TYPE].at(0))],
+                   split[ROLLUP_ACTIVITY]);
+}
+
 }  // namespace performance_monitor
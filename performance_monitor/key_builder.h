@@ -12,6 +12,15 @@
 
 namespace performance_monitor {
 
+// The resolutions at which the database keeps aggregated metrics, from the
+// finest to the coarsest.
+enum RollupTier {
+  ROLLUP_TIER_MINUTE,
+  ROLLUP_TIER_HOUR,
+  ROLLUP_TIER_DAY,
+  ROLLUP_TIER_NUMBER_OF_TIERS
+};
+
 struct RecentKey {
   RecentKey(const std::string& recent_time,
             MetricType recent_type,
@@ -45,6 +54,19 @@ struct MetricKey {
   const std::string activity;
 };
 
+struct RollupKey {
+  RollupKey(RollupTier rollup_tier,
+            const std::string& rollup_time,
+            MetricType rollup_type,
+            const std::string& rollup_activity);
+  ~RollupKey();
+
+  const RollupTier tier;
+  const std::string time;
+  const MetricType type;
+  const std::string activity;
+};
+
 // This class is responsible for building the keys which are used internally by
 // PerformanceMonitor's database. These keys should only be referenced by the
 // database, and should not be used externally.
@@ -79,9 +101,21 @@ class KeyBuilder {
   std::string CreateMaxValueKey(const MetricType type,
                                 const std::string& activity);
 
+  // Key Schema: <Tier>-<Metric>-<Time>-<Activity>
+  std::string CreateRollupKey(const RollupTier tier,
+                              const base::Time& time,
+                              const MetricType type,
+                              const std::string& activity);
+
+  // Key Schema: <Tier>-<Activity>-<Metric>
+  std::string CreateRollupMapKey(const RollupTier tier,
+                                 const MetricType type,
+                                 const std::string& activity);
+
   EventType EventKeyToEventType(const std::string& key);
   RecentKey SplitRecentKey(const std::string& key);
   MetricKey SplitMetricKey(const std::string& key);
+  RollupKey SplitRollupKey(const std::string& key);
 
  private:
   // Populate the maps from [Event, Metric]Type to key characters.
@@ -91,6 +125,8 @@ class KeyBuilder {
   std::map<int, EventType> event_key_char_to_event_type_;
   std::map<MetricType, int> metric_type_to_metric_key_char_;
   std::map<int, MetricType> metric_key_char_to_metric_type_;
+  std::map<RollupTier, int> rollup_tier_to_rollup_key_char_;
+  std::map<int, RollupTier> rollup_key_char_to_rollup_tier_;
 };
 
 }  // namespace performance_monitor
@@ -4,9 +4,13 @@
 
 #include "chrome/browser/performance_monitor/metric.h"
 
+#include <vector>
+
 #include "base/basictypes.h"
 #include "base/logging.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "chrome/browser/performance_monitor/constants.h"
 
@@ -64,6 +68,18 @@ const MetricBound kMetricBounds[] = {
 COMPILE_ASSERT(ARRAYSIZE_UNSAFE(kMetricBounds) == METRIC_NUMBER_OF_METRICS,
                metric_bounds_size_doesnt_match_metric_count);
 
+// The delimiter between the fields of a serialized AggregatedMetric.
+const char kAggregateDelimiter = ' ';
+
+// The position of the fields in a serialized AggregatedMetric.
+enum AggregatePosition {
+  AGGREGATE_COUNT,
+  AGGREGATE_MIN,
+  AGGREGATE_MAX,
+  AGGREGATE_SUM,
+  AGGREGATE_NUMBER_OF_FIELDS
+};
+
 }  // namespace
 
 Metric::Metric() : type(METRIC_UNDEFINED), value(0.0) {
@@ -98,4 +114,58 @@ std::string Metric::ValueAsString() const {
   return base::DoubleToString(value);
 }
 
+AggregatedMetric::AggregatedMetric()
+    : type(METRIC_UNDEFINED), count(0), min(0.0), max(0.0), sum(0.0) {
+}
+
+AggregatedMetric::AggregatedMetric(MetricType metric_type,
+                                   const base::Time& interval_start)
+    : type(metric_type),
+      time(interval_start),
+      count(0),
+      min(0.0),
+      max(0.0),
+      sum(0.0) {
+}
+
+AggregatedMetric::~AggregatedMetric() {
+}
+
+void AggregatedMetric::AddSample(double value) {
+  if (count == 0 || value < min)
+    min = value;
+  if (count == 0 || value > max)
+    max = value;
+  sum += value;
+  ++count;
+}
+
+double AggregatedMetric::mean() const {
+  DCHECK_GT(count, 0);
+  return count ? sum / count : 0.0;
+}
+
+std::string AggregatedMetric::ValueAsString() const {
+  return base::StringPrintf("%s%c%s%c%s%c%s",
+                            base::Int64ToString(count).c_str(),
+                            kAggregateDelimiter,
+                            base::DoubleToString(min).c_str(),
+                            kAggregateDelimiter,
+                            base::DoubleToString(max).c_str(),
+                            kAggregateDelimiter,
+                            base::DoubleToString(sum).c_str());
+}
+
+bool AggregatedMetric::ValueFromString(const std::string& value) {
+  std::vector<std::string> split;
+  base::SplitString(value, kAggregateDelimiter, &split);
+  if (split.size() != AGGREGATE_NUMBER_OF_FIELDS)
+    return false;
+  return base::StringToInt64(split[AGGREGATE_COUNT], &count) &&
+         base::StringToDouble(split[AGGREGATE_MIN], &min) &&
+         base::StringToDouble(split[AGGREGATE_MAX], &max) &&
+         base::StringToDouble(split[AGGREGATE_SUM], &sum) &&
+         count > 0;
+}
+
 }  // namespace performance_monitor
@@ -65,6 +65,36 @@ struct Metric {
   double value;
 };
 
+// The aggregate of all the samples of a metric which fall into one interval.
+// The database maintains these on insert so that range queries over a long
+// time span don't need to scan every raw sample.
+struct AggregatedMetric {
+ public:
+  AggregatedMetric();
+  AggregatedMetric(MetricType metric_type, const base::Time& interval_start);
+  ~AggregatedMetric();
+
+  // Folds |value| into the aggregate.
+  void AddSample(double value);
+
+  // The mean of all the samples in the interval; only meaningful if |count| is
+  // greater than zero.
+  double mean() const;
+
+  // Serializes the aggregate to the format stored in the database, and parses
+  // it back. ValueFromString() returns false if |value| is malformed.
+  std::string ValueAsString() const;
+  bool ValueFromString(const std::string& value);
+
+  MetricType type;
+  // The beginning of the interval.
+  base::Time time;
+  int64 count;
+  double min;
+  double max;
+  double sum;
+};
+
 }  // namespace performance_monitor
 
 #endif  // CHROME_BROWSER_PERFORMANCE_MONITOR_METRIC_H_
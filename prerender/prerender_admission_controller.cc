@@ -0,0 +1,152 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/prerender/prerender_admission_controller.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "url/gurl.h"
+
+namespace prerender {
+
+namespace {
+
+// The weight given to each new measurement in the smoothed cost of a host.
+const double kCostWeight = 0.25;
+
+// Indices of prerenders, ordered from the least to the most useful.
+class LessUseful {
+ public:
+  explicit LessUseful(
+      const std::vector<PrerenderAdmissionController::Candidate>& running)
+      : running_(running) {}
+
+  bool operator()(size_t a, size_t b) const {
+    return running_[a].benefit < running_[b].benefit;
+  }
+
+ private:
+  const std::vector<PrerenderAdmissionController::Candidate>& running_;
+};
+
+// Running prerenders already hold much of their memory, so it is not counted
+// as available, but it would be if they were destroyed.
+int64 GetBudget(int64 available_bytes, int64 committed) {
+  return static_cast<int64>(
+      (available_bytes + committed) *
+      PrerenderAdmissionController::kMaxAvailableMemoryFraction);
+}
+
+}  // namespace
+
+// static
+const double PrerenderAdmissionController::kMaxAvailableMemoryFraction = 0.5;
+const size_t PrerenderAdmissionController::kMaxHistorySize = 100u;
+
+PrerenderAdmissionController::Candidate::Candidate(double benefit, int64 cost)
+    : benefit(benefit),
+      cost(cost) {
+}
+
+PrerenderAdmissionController::PrerenderAdmissionController()
+    : cost_history_(kMaxHistorySize) {
+}
+
+PrerenderAdmissionController::~PrerenderAdmissionController() {}
+
+// static
+double PrerenderAdmissionController::GetBenefit(Origin origin, double score) {
+  switch (origin) {
+    case ORIGIN_INSTANT:
+      return 1.0;
+    case ORIGIN_GWS_PRERENDER:
+      return 0.9;
+    case ORIGIN_OMNIBOX:
+      return 0.8;
+    case ORIGIN_LINK_REL_PRERENDER_SAMEDOMAIN:
+    case ORIGIN_LINK_REL_PRERENDER_CROSSDOMAIN:
+    case ORIGIN_EXTERNAL_REQUEST:
+      return 0.5;
+    case ORIGIN_LINK_REL_NEXT:
+      return 0.3;
+    case ORIGIN_LOCAL_PREDICTOR:
+      return std::max(0.0, std::min(1.0, score));
+    default:
+      return 0.5;
+  }
+}
+
+int64 PrerenderAdmissionController::PredictCost(const GURL& url,
+                                                int64 default_cost) const {
+  CostHistory::const_iterator it = cost_history_.Peek(url.host());
+  return it == cost_history_.end() ? default_cost : it->second;
+}
+
+void PrerenderAdmissionController::RecordMemoryUse(const GURL& url,
+                                                   int64 private_bytes) {
+  CostHistory::iterator it = cost_history_.Get(url.host());
+  if (it == cost_history_.end()) {
+    cost_history_.Put(url.host(), private_bytes);
+    return;
+  }
+  it->second += static_cast<int64>(kCostWeight * (private_bytes - it->second));
+}
+
+// static
+PrerenderAdmissionController::Decision PrerenderAdmissionController::Decide(
+    const Candidate& candidate,
+    const std::vector<Candidate>& running,
+    int64 available_bytes,
+    std::vector<size_t>* evict) {
+  DCHECK(evict);
+  evict->clear();
+
+  int64 committed = 0;
+  for (size_t i = 0; i < running.size(); ++i)
+    committed += running[i].cost;
+  const int64 budget = GetBudget(available_bytes, committed);
+  if (committed + candidate.cost <= budget)
+    return ADMIT;
+
+  // Evict the least useful prerenders first, but only ones that are less
+  // useful than the candidate.
+  std::vector<size_t> order;
+  for (size_t i = 0; i < running.size(); ++i) {
+    if (running[i].benefit < candidate.benefit)
+      order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), LessUseful(running));
+  for (size_t i = 0; i < order.size(); ++i) {
+    evict->push_back(order[i]);
+    committed -= running[order[i]].cost;
+    if (committed + candidate.cost <= budget)
+      return ADMIT_AFTER_EVICTION;
+  }
+  evict->clear();
+  return DEFER;
+}
+
+// static
+std::vector<size_t> PrerenderAdmissionController::GetOverBudget(
+    const std::vector<Candidate>& running,
+    int64 available_bytes) {
+  int64 committed = 0;
+  std::vector<size_t> order;
+  for (size_t i = 0; i < running.size(); ++i) {
+    committed += running[i].cost;
+    order.push_back(i);
+  }
+  const int64 budget = GetBudget(available_bytes, committed);
+  std::stable_sort(order.begin(), order.end(), LessUseful(running));
+
+  std::vector<size_t> over_budget;
+  for (size_t i = 0; i < order.size() && committed > budget; ++i) {
+    over_budget.push_back(order[i]);
+    committed -= running[order[i]].cost;
+  }
+  return over_budget;
+}
+
+}  // namespace prerender
@@ -0,0 +1,96 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_PRERENDER_PRERENDER_ADMISSION_CONTROLLER_H_
+#define CHROME_BROWSER_PRERENDER_PRERENDER_ADMISSION_CONTROLLER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "chrome/browser/prerender/prerender_origin.h"
+
+class GURL;
+
+namespace prerender {
+
+// Decides whether a new prerender fits in memory before it is started, rather
+// than only killing prerenders once they have grown too large.  The cost of a
+// prerender is predicted from the memory earlier prerenders of the same host
+// used, and prerenders are only admitted while their predicted costs fit in a
+// share of the physical memory that is currently available.  When a new
+// prerender doesn't fit, running prerenders that are expected to be less
+// useful may be evicted to make room for it.
+class PrerenderAdmissionController {
+ public:
+  enum Decision {
+    // There is enough memory for the prerender.
+    ADMIT,
+    // There is enough memory for the prerender once the prerenders listed in
+    // |evict| are destroyed.
+    ADMIT_AFTER_EVICTION,
+    // There is not enough memory for the prerender now.
+    DEFER,
+    DECISION_MAX,
+  };
+
+  // A running or requested prerender.
+  struct Candidate {
+    Candidate(double benefit, int64 cost);
+
+    // How likely the prerender is to be used, between 0 and 1.
+    double benefit;
+    // The predicted private bytes of the prerender.
+    int64 cost;
+  };
+
+  // Prerenders may use at most this fraction of the physical memory that
+  // would be available without them.
+  static const double kMaxAvailableMemoryFraction;
+
+  // The number of hosts whose memory use is remembered.
+  static const size_t kMaxHistorySize;
+
+  PrerenderAdmissionController();
+  ~PrerenderAdmissionController();
+
+  // Returns the expected benefit of a prerender from |origin|.  For the
+  // PrerenderLocalPredictor, this is its |score| for the URL.
+  static double GetBenefit(Origin origin, double score);
+
+  // Returns the predicted private bytes of a prerender of |url|, or
+  // |default_cost| if no prerender of its host was measured yet.
+  int64 PredictCost(const GURL& url, int64 default_cost) const;
+
+  // Records that a prerender of |url| was measured using |private_bytes|.
+  void RecordMemoryUse(const GURL& url, int64 private_bytes);
+
+  // Decides whether |candidate| may be started next to the |running|
+  // prerenders, when |available_bytes| of physical memory are available.  On
+  // ADMIT_AFTER_EVICTION, |evict| lists the indices of the |running|
+  // prerenders to destroy first, which are all less useful than |candidate|.
+  static Decision Decide(const Candidate& candidate,
+                         const std::vector<Candidate>& running,
+                         int64 available_bytes,
+                         std::vector<size_t>* evict);
+
+  // Returns the indices of the least useful |running| prerenders that must be
+  // destroyed for the rest to fit when |available_bytes| are available.
+  static std::vector<size_t> GetOverBudget(
+      const std::vector<Candidate>& running,
+      int64 available_bytes);
+
+ private:
+  typedef base::MRUCache<std::string, int64> CostHistory;
+
+  // Smoothed private bytes of the prerenders of each host.
+  CostHistory cost_history_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrerenderAdmissionController);
+};
+
+}  // namespace prerender
+
+#endif  // CHROME_BROWSER_PRERENDER_PRERENDER_ADMISSION_CONTROLLER_H_
@@ -0,0 +1,96 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/prerender/prerender_admission_controller.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace prerender {
+
+namespace {
+
+const int64 kMB = 1024 * 1024;
+
+typedef PrerenderAdmissionController::Candidate Candidate;
+
+}  // namespace
+
+TEST(PrerenderAdmissionControllerTest, PredictsCostFromHostHistory) {
+  PrerenderAdmissionController controller;
+  const GURL url("http://www.example.com/a");
+  const GURL same_host_url("http://www.example.com/b");
+
+  EXPECT_EQ(100 * kMB, controller.PredictCost(url, 100 * kMB));
+  controller.RecordMemoryUse(url, 40 * kMB);
+  EXPECT_EQ(40 * kMB, controller.PredictCost(same_host_url, 100 * kMB));
+  // Later measurements are smoothed in.
+  controller.RecordMemoryUse(same_host_url, 80 * kMB);
+  EXPECT_EQ(50 * kMB, controller.PredictCost(url, 100 * kMB));
+  EXPECT_EQ(100 * kMB,
+            controller.PredictCost(GURL("http://other.com/"), 100 * kMB));
+}
+
+TEST(PrerenderAdmissionControllerTest, Decide) {
+  std::vector<Candidate> running;
+  running.push_back(Candidate(0.5, 100 * kMB));
+  running.push_back(Candidate(0.2, 100 * kMB));
+  running.push_back(Candidate(0.9, 100 * kMB));
+  std::vector<size_t> evict;
+
+  // With 500 MB available, 400 MB may be used for prerenders.
+  EXPECT_EQ(PrerenderAdmissionController::ADMIT,
+            PrerenderAdmissionController::Decide(
+                Candidate(0.1, 100 * kMB), running, 500 * kMB, &evict));
+  EXPECT_TRUE(evict.empty());
+
+  // Evicts the least useful prerenders first.
+  EXPECT_EQ(PrerenderAdmissionController::ADMIT_AFTER_EVICTION,
+            PrerenderAdmissionController::Decide(
+                Candidate(0.8, 200 * kMB), running, 500 * kMB, &evict));
+  ASSERT_EQ(1u, evict.size());
+  EXPECT_EQ(1u, evict[0]);
+  EXPECT_EQ(PrerenderAdmissionController::ADMIT_AFTER_EVICTION,
+            PrerenderAdmissionController::Decide(
+                Candidate(0.8, 300 * kMB), running, 500 * kMB, &evict));
+  ASSERT_EQ(2u, evict.size());
+  EXPECT_EQ(1u, evict[0]);
+  EXPECT_EQ(0u, evict[1]);
+
+  // Never evicts more useful prerenders.
+  EXPECT_EQ(PrerenderAdmissionController::DEFER,
+            PrerenderAdmissionController::Decide(
+                Candidate(0.3, 300 * kMB), running, 500 * kMB, &evict));
+  EXPECT_TRUE(evict.empty());
+}
+
+TEST(PrerenderAdmissionControllerTest, GetOverBudget) {
+  std::vector<Candidate> running;
+  running.push_back(Candidate(0.5, 100 * kMB));
+  running.push_back(Candidate(0.2, 100 * kMB));
+  running.push_back(Candidate(0.9, 100 * kMB));
+
+  EXPECT_TRUE(
+      PrerenderAdmissionController::GetOverBudget(running, 300 * kMB).empty());
+
+  // With 100 MB available, only 200 MB may be used for prerenders.
+  std::vector<size_t> over_budget =
+      PrerenderAdmissionController::GetOverBudget(running, 100 * kMB);
+  ASSERT_EQ(1u, over_budget.size());
+  EXPECT_EQ(1u, over_budget[0]);
+}
+
+TEST(PrerenderAdmissionControllerTest, GetBenefit) {
+  EXPECT_GT(PrerenderAdmissionController::GetBenefit(ORIGIN_INSTANT, 0.0),
+            PrerenderAdmissionController::GetBenefit(
+                ORIGIN_LINK_REL_PRERENDER_CROSSDOMAIN, 0.0));
+  EXPECT_EQ(0.7, PrerenderAdmissionController::GetBenefit(
+      ORIGIN_LOCAL_PREDICTOR, 0.7));
+  EXPECT_EQ(1.0, PrerenderAdmissionController::GetBenefit(
+      ORIGIN_LOCAL_PREDICTOR, 3.0));
+}
+
+}  // namespace prerender
@@ -10,6 +10,7 @@ Config::Config() : max_bytes(150 * 1024 * 1024),
                    max_link_concurrency(1),
                    max_link_concurrency_per_launcher(1),
                    rate_limit_enabled(true),
+                   memory_admission_enabled(false),
                    max_wait_to_launch(base::TimeDelta::FromMinutes(4)),
                    time_to_live(base::TimeDelta::FromMinutes(5)),
                    abandon_time_to_live(base::TimeDelta::FromSeconds(30)),
@@ -30,6 +30,11 @@ struct Config {
   // Is rate limiting enabled?
   bool rate_limit_enabled;
 
+  // Are prerenders only started when they are predicted to fit in memory?
+  // Enforced by PrerenderManager, and by PrerenderLinkManager for link
+  // elements.
+  bool memory_admission_enabled;
+
   // The maximum time that a prerender can wait for launch in the
   // PrerenderLinkManager.
   base::TimeDelta max_wait_to_launch;
@@ -739,10 +739,13 @@ void PrerenderContents::DestroyWhenUsingTooManyResources() {
     return;
 
   size_t private_bytes, shared_bytes;
-  if (metrics->GetMemoryBytes(&private_bytes, &shared_bytes) &&
-      private_bytes > prerender_manager_->config().max_bytes) {
+  if (!metrics->GetMemoryBytes(&private_bytes, &shared_bytes))
+    return;
+  // Remember how much memory prerenders of this URL's host use, so that the
+  // cost of the next ones can be predicted before they start.
+  prerender_manager_->RecordPrerenderMemoryUse(prerender_url_, private_bytes);
+  if (private_bytes > prerender_manager_->config().max_bytes)
     Destroy(FINAL_STATUS_MEMORY_LIMIT_EXCEEDED);
-  }
 }
 
 WebContents* PrerenderContents::ReleasePrerenderContents() {
@@ -82,6 +82,7 @@ const char kSkipPrerenderServiceCanadidates[] =
 const char kDisableSessionStorageNamespaceMerging[] =
     "DisableSessionStorageNamespaceMerging";
 const char kPrerenderCookieStore[] = "PrerenderCookieStore";
+const char kPrerenderMemoryAdmissionTrialName[] = "PrerenderMemoryAdmission";
 
 void SetupPrerenderFieldTrial() {
   const FieldTrial::Probability divisor = 1000;
@@ -470,4 +471,9 @@ bool IsPrerenderCookieStoreEnabled() {
       FieldTrialList::FindFullName(kPrerenderCookieStore) != kDisabledGroup;
 }
 
+bool IsPrerenderMemoryAdmissionEnabled() {
+  return FieldTrialList::FindFullName(kPrerenderMemoryAdmissionTrialName) ==
+      kEnabledGroup;
+}
+
 }  // namespace prerender
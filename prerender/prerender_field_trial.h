@@ -103,6 +103,10 @@ bool SkipLocalPredictorServiceCandidates();
 // Indicates whether no prerender cookie stores should be used for prerendering.
 bool IsPrerenderCookieStoreEnabled();
 
+// Indicates whether prerenders should only be started when they are predicted
+// to fit in memory.
+bool IsPrerenderMemoryAdmissionEnabled();
+
 }  // namespace prerender
 
 #endif  // CHROME_BROWSER_PRERENDER_PRERENDER_FIELD_TRIAL_H_
@@ -63,6 +63,8 @@ const char* kFinalStatusNames[] = {
   "Cookie Conflict",
   "Non-Empty Browsing Instance",
   "Navigation Intercepted",
+  "Insufficient Memory",
+  "Evicted For Memory",
   "Max",
 };
 COMPILE_ASSERT(arraysize(kFinalStatusNames) == FINAL_STATUS_MAX + 1,
@@ -64,6 +64,8 @@ enum FinalStatus {
   FINAL_STATUS_COOKIE_CONFLICT = 49,
   FINAL_STATUS_NON_EMPTY_BROWSING_INSTANCE = 50,
   FINAL_STATUS_NAVIGATION_INTERCEPTED = 51,
+  FINAL_STATUS_INSUFFICIENT_MEMORY = 52,
+  FINAL_STATUS_EVICTED_FOR_MEMORY = 53,
   FINAL_STATUS_MAX,
 };
 
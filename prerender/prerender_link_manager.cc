@@ -10,6 +10,7 @@
 #include <string>
 #include <utility>
 
+#include "base/bind.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram.h"
@@ -144,7 +145,11 @@ class PrerenderLinkManager::PendingPrerenderManager
 PrerenderLinkManager::PrerenderLinkManager(PrerenderManager* manager)
     : has_shutdown_(false),
       manager_(manager),
-      pending_prerender_manager_(new PendingPrerenderManager(this)) {}
+      pending_prerender_manager_(new PendingPrerenderManager(this)) {
+  admission_retry_subscription_ = manager_->RegisterAdmissionRetryCallback(
+      base::Bind(&PrerenderLinkManager::StartPrerenders,
+                 base::Unretained(this)));
+}
 
 PrerenderLinkManager::~PrerenderLinkManager() {
   for (std::list<LinkPrerender>::iterator i = prerenders_.begin();
@@ -381,6 +386,14 @@ void PrerenderLinkManager::StartPrerenders() {
       continue;
     }
 
+    if (manager_->ShouldDeferLinkPrerender((*i)->launcher_child_id,
+                                           (*i)->render_view_route_id,
+                                           (*i)->url, (*i)->rel_types)) {
+      // There is not enough memory for this prerender now. It stays pending
+      // until memory is freed, or until it has waited too long to launch.
+      continue;
+    }
+
     PrerenderHandle* handle = manager_->AddPrerenderFromLinkRelPrerender(
         (*i)->launcher_child_id, (*i)->render_view_route_id,
         (*i)->url, (*i)->rel_types, (*i)->referrer, (*i)->size);
@@ -483,6 +496,7 @@ void PrerenderLinkManager::CancelPendingPrerendersForLauncher(
 
 void PrerenderLinkManager::Shutdown() {
   has_shutdown_ = true;
+  admission_retry_subscription_.reset();
 }
 
 // In practice, this is always called from PrerenderLinkManager::OnAddPrerender.
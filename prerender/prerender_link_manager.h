@@ -8,6 +8,7 @@
 #include <list>
 
 #include "base/basictypes.h"
+#include "base/callback_list.h"
 #include "base/gtest_prod_util.h"
 #include "base/time/time.h"
 #include "chrome/browser/prerender/prerender_handle.h"
@@ -169,6 +170,10 @@ class PrerenderLinkManager : public KeyedService,
   // and must be deferred until the launcher is swapped in.
   scoped_ptr<PendingPrerenderManager> pending_prerender_manager_;
 
+  // Retries the prerenders that were deferred for lack of memory.
+  scoped_ptr<base::CallbackList<void(void)>::Subscription>
+      admission_retry_subscription_;
+
   DISALLOW_COPY_AND_ASSIGN(PrerenderLinkManager);
 };
 
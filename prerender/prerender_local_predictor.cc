@@ -67,7 +67,6 @@ namespace prerender {
 namespace {
 
 static const size_t kURLHashSize = 5;
-static const int kNumPrerenderCandidates = 5;
 static const int kInvalidProcessId = -1;
 static const int kInvalidFrameId = -1;
 static const int kMaxPrefetchItems = 100;
@@ -242,8 +241,6 @@ const int kMaxVisitHistory = 100 * 1000;
 const int kVisitHistoryPruneThreshold = 120 * 1000;
 const int kVisitHistoryPruneAmount = 20 * 1000;
 
-const int kMinLocalPredictionTimeMs = 500;
-
 int GetMaxLocalPredictionTimeMs() {
   return GetLocalPredictorTTLSeconds() * 1000;
 }
@@ -270,10 +267,6 @@ bool ShouldExcludeTransitionForPrediction(PageTransition transition) {
       IsIntermediateRedirect(transition);
 }
 
-base::Time GetCurrentTime() {
-  return base::Time::Now();
-}
-
 bool StringContainsIgnoringCase(string haystack, string needle) {
   std::transform(haystack.begin(), haystack.end(), haystack.begin(), ::tolower);
   std::transform(needle.begin(), needle.end(), needle.begin(), ::tolower);
@@ -365,7 +358,7 @@ struct PrerenderLocalPredictor::PrerenderProperties {
       : priority(0.0), would_have_matched(false) {
   }
 
-  double GetCurrentDecayedPriority() {
+  double GetCurrentDecayedPriority(base::Time now) {
     // If we are no longer prerendering, the priority is 0.
     if (!prerender_handle || !prerender_handle->IsPrerendering())
       return 0.0;
@@ -374,7 +367,7 @@ struct PrerenderLocalPredictor::PrerenderProperties {
     if (half_life_time_seconds < 1)
       return priority;
     double multiple_elapsed =
-        (GetCurrentTime() - actual_start_time).InMillisecondsF() /
+        (now - actual_start_time).InMillisecondsF() /
         base::TimeDelta::FromSeconds(half_life_time_seconds).InMillisecondsF();
     // Decay factor: 2 ^ (-multiple_elapsed)
     double decay_factor = exp(- multiple_elapsed * log(2.0));
@@ -408,7 +401,8 @@ class PrerenderLocalPredictor::PrefetchList {
     SEEN_MAX_VALUE
   };
 
-  PrefetchList() {}
+  explicit PrefetchList(PrerenderManager* prerender_manager)
+      : prerender_manager_(prerender_manager) {}
   ~PrefetchList() {
     STLDeleteValues(&entries_);
   }
@@ -429,7 +423,8 @@ class PrerenderLocalPredictor::PrefetchList {
         return false;
       }
     }
-    ListEntry* entry = new ListEntry(url_string);
+    ListEntry* entry = new ListEntry(url_string,
+                                     prerender_manager_->GetCurrentTime());
     entries_[entry->url_] = entry;
     entry_list_.push_back(entry);
     ExpireOldItems();
@@ -472,7 +467,7 @@ class PrerenderLocalPredictor::PrefetchList {
     base::hash_map<string, ListEntry*>::iterator it =
         entries_.find(url.spec().c_str());
     if (it == entries_.end() || it->second->seen_plt_ ||
-        it->second->add_time_ > GetCurrentTime() - plt) {
+        it->second->add_time_ > prerender_manager_->GetCurrentTime() - plt) {
       return false;
     }
     it->second->seen_plt_ = true;
@@ -488,9 +483,9 @@ class PrerenderLocalPredictor::PrefetchList {
 
  private:
   struct ListEntry {
-    explicit ListEntry(const string& url)
+    ListEntry(const string& url, base::Time add_time)
         : url_(url),
-          add_time_(GetCurrentTime()),
+          add_time_(add_time),
           seen_tabcontents_(false),
           seen_history_(false),
           seen_plt_(false) {
@@ -503,7 +498,7 @@ class PrerenderLocalPredictor::PrefetchList {
   };
 
   void ExpireOldItems() {
-    base::Time expiry_cutoff = GetCurrentTime() -
+    base::Time expiry_cutoff = prerender_manager_->GetCurrentTime() -
         base::TimeDelta::FromSeconds(GetPrerenderPrefetchListTimeoutSeconds());
     while (!entry_list_.empty() &&
            (entry_list_.front()->add_time_ < expiry_cutoff ||
@@ -520,6 +515,7 @@ class PrerenderLocalPredictor::PrefetchList {
     }
   }
 
+  PrerenderManager* prerender_manager_;
   base::hash_map<string, ListEntry*> entries_;
   std::list<ListEntry*> entry_list_;
   DISALLOW_COPY_AND_ASSIGN(PrefetchList);
@@ -530,7 +526,7 @@ PrerenderLocalPredictor::PrerenderLocalPredictor(
     : prerender_manager_(prerender_manager),
       is_visit_database_observer_(false),
       weak_factory_(this),
-      prefetch_list_(new PrefetchList()) {
+      prefetch_list_(new PrefetchList(prerender_manager)) {
   RecordEvent(EVENT_CONSTRUCTED);
   if (base::MessageLoop::current()) {
     timer_.Start(FROM_HERE,
@@ -581,56 +577,28 @@ PrerenderLocalPredictor::~PrerenderLocalPredictor() {
       outstanding_prerender_service_requests_.end());
 }
 
-void PrerenderLocalPredictor::Shutdown() {
-  timer_.Stop();
-  if (is_visit_database_observer_) {
-    HistoryService* history = GetHistoryIfExists();
-    CHECK(history);
-    history->RemoveVisitDatabaseObserver(this);
-    is_visit_database_observer_ = false;
-  }
+PrerenderLocalPredictor::LocalHistoryCandidate::LocalHistoryCandidate(
+    URLID url_id,
+    double priority)
+    : url_id(url_id),
+      priority(priority) {
 }
 
-void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
-  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
-  RecordEvent(EVENT_ADD_VISIT);
-  if (!visit_history_.get())
-    return;
-  visit_history_->push_back(info);
-  if (static_cast<int>(visit_history_->size()) > kVisitHistoryPruneThreshold) {
-    visit_history_->erase(visit_history_->begin(),
-                          visit_history_->begin() + kVisitHistoryPruneAmount);
-  }
-  RecordEvent(EVENT_ADD_VISIT_INITIALIZED);
-  if (current_prerender_.get() &&
-      current_prerender_->url_id == info.url_id &&
-      IsPrerenderStillValid(current_prerender_.get())) {
-    UMA_HISTOGRAM_CUSTOM_TIMES(
-        "Prerender.LocalPredictorTimeUntilUsed",
-        GetCurrentTime() - current_prerender_->actual_start_time,
-        base::TimeDelta::FromMilliseconds(10),
-        base::TimeDelta::FromMilliseconds(GetMaxLocalPredictionTimeMs()),
-        50);
-    last_swapped_in_prerender_.reset(current_prerender_.release());
-    RecordEvent(EVENT_ADD_VISIT_PRERENDER_IDENTIFIED);
-  }
-  if (ShouldExcludeTransitionForPrediction(info.transition))
-    return;
-  RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION);
-  base::TimeDelta max_age =
-      base::TimeDelta::FromMilliseconds(GetMaxLocalPredictionTimeMs());
-  base::TimeDelta min_age =
-      base::TimeDelta::FromMilliseconds(kMinLocalPredictionTimeMs);
+// static
+int PrerenderLocalPredictor::GetLocalHistoryCandidates(
+    const vector<history::BriefVisitInfo>& visits,
+    URLID url_id,
+    base::TimeDelta min_age,
+    base::TimeDelta max_age,
+    vector<LocalHistoryCandidate>* candidates) {
+  candidates->clear();
   std::set<URLID> next_urls_currently_found;
   std::map<URLID, int> next_urls_num_found;
   int num_occurrences_of_current_visit = 0;
   base::Time last_visited;
-  scoped_ptr<CandidatePrerenderInfo> lookup_info(
-      new CandidatePrerenderInfo(info.url_id));
-  const vector<history::BriefVisitInfo>& visits = *(visit_history_.get());
   for (int i = 0; i < static_cast<int>(visits.size()); i++) {
     if (!ShouldExcludeTransitionForPrediction(visits[i].transition)) {
-      if (visits[i].url_id == info.url_id) {
+      if (visits[i].url_id == url_id) {
         last_visited = visits[i].time;
         num_occurrences_of_current_visit++;
         next_urls_currently_found.clear();
@@ -644,7 +612,7 @@ void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
       }
     }
     if (i == static_cast<int>(visits.size()) - 1 ||
-        visits[i+1].url_id == info.url_id) {
+        visits[i+1].url_id == url_id) {
       for (std::set<URLID>::iterator it = next_urls_currently_found.begin();
            it != next_urls_currently_found.end();
            ++it) {
@@ -656,12 +624,6 @@ void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
     }
   }
 
-  if (num_occurrences_of_current_visit > 1) {
-    RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION_REPEAT_URL);
-  } else {
-    RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION_NEW_URL);
-  }
-
   for (std::map<URLID, int>::const_iterator it = next_urls_num_found.begin();
        it != next_urls_num_found.end();
        ++it) {
@@ -670,12 +632,29 @@ void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
     if (num_occurrences_of_current_visit > 0 &&
         it->second > 1 &&
         it->second * 10 >= num_occurrences_of_current_visit) {
-      RecordEvent(EVENT_ADD_VISIT_IDENTIFIED_PRERENDER_CANDIDATE);
       double priority = static_cast<double>(it->second) /
           static_cast<double>(num_occurrences_of_current_visit);
-      lookup_info->MaybeAddCandidateURLFromLocalData(it->first, priority);
+      candidates->push_back(LocalHistoryCandidate(it->first, priority));
     }
   }
+  return num_occurrences_of_current_visit;
+}
+
+void PrerenderLocalPredictor::Shutdown() {
+  timer_.Stop();
+  if (is_visit_database_observer_) {
+    HistoryService* history = GetHistoryIfExists();
+    CHECK(history);
+    history->RemoveVisitDatabaseObserver(this);
+    is_visit_database_observer_ = false;
+  }
+}
+
+void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  scoped_ptr<CandidatePrerenderInfo> lookup_info(RecordVisit(info));
+  if (!lookup_info.get())
+    return;
 
   RecordEvent(EVENT_START_URL_LOOKUP);
   HistoryService* history = GetHistoryIfExists();
@@ -693,6 +672,80 @@ void PrerenderLocalPredictor::OnAddVisit(const history::BriefVisitInfo& info) {
   }
 }
 
+void PrerenderLocalPredictor::ReplayVisitForTesting(
+    const history::BriefVisitInfo& info,
+    const base::Callback<GURL(URLID)>& url_for_id) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  scoped_ptr<CandidatePrerenderInfo> lookup_info(RecordVisit(info));
+  if (!lookup_info.get())
+    return;
+
+  // Stand in for the history and logged-in lookups.
+  lookup_info->source_url_.url = url_for_id.Run(lookup_info->source_url_.id);
+  lookup_info->source_url_.url_lookup_success = true;
+  for (size_t i = 0; i < lookup_info->candidate_urls_.size(); ++i) {
+    LocalPredictorURLInfo* url_info = &lookup_info->candidate_urls_[i];
+    url_info->url = url_for_id.Run(url_info->id);
+    url_info->url_lookup_success = true;
+    url_info->logged_in = false;
+    url_info->logged_in_lookup_ok = true;
+  }
+  lookup_info->size_.reset(
+      new gfx::Size(prerender_manager_->config().default_tab_bounds.size()));
+  lookup_info->start_time_ = base::Time::Now();
+  ContinuePrerenderCheck(lookup_info.Pass());
+}
+
+scoped_ptr<PrerenderLocalPredictor::CandidatePrerenderInfo>
+PrerenderLocalPredictor::RecordVisit(const history::BriefVisitInfo& info) {
+  RecordEvent(EVENT_ADD_VISIT);
+  if (!visit_history_.get())
+    return scoped_ptr<CandidatePrerenderInfo>();
+  visit_history_->push_back(info);
+  if (static_cast<int>(visit_history_->size()) > kVisitHistoryPruneThreshold) {
+    visit_history_->erase(visit_history_->begin(),
+                          visit_history_->begin() + kVisitHistoryPruneAmount);
+  }
+  RecordEvent(EVENT_ADD_VISIT_INITIALIZED);
+  if (current_prerender_.get() &&
+      current_prerender_->url_id == info.url_id &&
+      IsPrerenderStillValid(current_prerender_.get())) {
+    UMA_HISTOGRAM_CUSTOM_TIMES(
+        "Prerender.LocalPredictorTimeUntilUsed",
+        prerender_manager_->GetCurrentTime() -
+            current_prerender_->actual_start_time,
+        base::TimeDelta::FromMilliseconds(10),
+        base::TimeDelta::FromMilliseconds(GetMaxLocalPredictionTimeMs()),
+        50);
+    last_swapped_in_prerender_.reset(current_prerender_.release());
+    RecordEvent(EVENT_ADD_VISIT_PRERENDER_IDENTIFIED);
+  }
+  if (ShouldExcludeTransitionForPrediction(info.transition))
+    return scoped_ptr<CandidatePrerenderInfo>();
+  RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION);
+  scoped_ptr<CandidatePrerenderInfo> lookup_info(
+      new CandidatePrerenderInfo(info.url_id));
+  vector<LocalHistoryCandidate> candidates;
+  int num_occurrences_of_current_visit = GetLocalHistoryCandidates(
+      *visit_history_, info.url_id,
+      base::TimeDelta::FromMilliseconds(kMinLocalPredictionTimeMs),
+      base::TimeDelta::FromMilliseconds(GetMaxLocalPredictionTimeMs()),
+      &candidates);
+
+  if (num_occurrences_of_current_visit > 1) {
+    RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION_REPEAT_URL);
+  } else {
+    RecordEvent(EVENT_ADD_VISIT_RELEVANT_TRANSITION_NEW_URL);
+  }
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    RecordEvent(EVENT_ADD_VISIT_IDENTIFIED_PRERENDER_CANDIDATE);
+    lookup_info->MaybeAddCandidateURLFromLocalData(candidates[i].url_id,
+                                                   candidates[i].priority);
+  }
+  return lookup_info.Pass();
+}
+
 void PrerenderLocalPredictor::OnLookupURL(
     scoped_ptr<CandidatePrerenderInfo> info) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
@@ -1172,7 +1225,8 @@ void PrerenderLocalPredictor::OnPLTEventForURL(const GURL& url,
                                base::TimeDelta::FromSeconds(60),
                                100);
 
-    base::TimeDelta prerender_age = GetCurrentTime() - prerender->start_time;
+    base::TimeDelta prerender_age =
+        prerender_manager_->GetCurrentTime() - prerender->start_time;
     if (prerender_age > page_load_time) {
       base::TimeDelta new_plt;
       if (prerender_age <  2 * page_load_time)
@@ -1191,7 +1245,7 @@ bool PrerenderLocalPredictor::IsPrerenderStillValid(
   return (prerender &&
           (prerender->start_time +
            base::TimeDelta::FromMilliseconds(GetMaxLocalPredictionTimeMs()))
-          > GetCurrentTime());
+          > prerender_manager_->GetCurrentTime());
 }
 
 void PrerenderLocalPredictor::RecordEvent(
@@ -1204,7 +1258,8 @@ bool PrerenderLocalPredictor::DoesPrerenderMatchPLTRecord(
     PrerenderProperties* prerender,
     const GURL& url,
     base::TimeDelta plt) const {
-  if (prerender && prerender->start_time < GetCurrentTime() - plt) {
+  if (prerender &&
+      prerender->start_time < prerender_manager_->GetCurrentTime() - plt) {
     if (prerender->url.is_empty())
       RecordEvent(EVENT_ERROR_NO_PRERENDER_URL_FOR_PLT);
     return (prerender->url == url);
@@ -1217,6 +1272,7 @@ PrerenderLocalPredictor::PrerenderProperties*
 PrerenderLocalPredictor::GetIssuedPrerenderSlotForPriority(const GURL& url,
                                                            double priority) {
   int num_prerenders = GetLocalPredictorMaxConcurrentPrerenders();
+  base::Time now = prerender_manager_->GetCurrentTime();
   while (static_cast<int>(issued_prerenders_.size()) < num_prerenders)
     issued_prerenders_.push_back(new PrerenderProperties());
   // First, check if we already have a prerender for the same URL issued.
@@ -1239,11 +1295,11 @@ PrerenderLocalPredictor::GetIssuedPrerenderSlotForPriority(const GURL& url,
     DCHECK(p != NULL);
     if (!p->prerender_handle || !p->prerender_handle->IsPrerendering())
       return p;
-    double decayed_priority = p->GetCurrentDecayedPriority();
+    double decayed_priority = p->GetCurrentDecayedPriority(now);
     if (decayed_priority > priority)
       continue;
     if (lowest_priority_prerender == NULL ||
-        lowest_priority_prerender->GetCurrentDecayedPriority() >
+        lowest_priority_prerender->GetCurrentDecayedPriority(now) >
         decayed_priority) {
       lowest_priority_prerender = p;
     }
@@ -1263,8 +1319,11 @@ void PrerenderLocalPredictor::ContinuePrerenderCheck(
   }
   scoped_ptr<LocalPredictorURLInfo> url_info;
 #if defined(FULL_SAFE_BROWSING)
-  scoped_refptr<SafeBrowsingDatabaseManager> sb_db_manager =
-      g_browser_process->safe_browsing_service()->database_manager();
+  scoped_refptr<SafeBrowsingDatabaseManager> sb_db_manager;
+  if (g_browser_process->safe_browsing_service()) {
+    sb_db_manager =
+        g_browser_process->safe_browsing_service()->database_manager();
+  }
 #endif
   int num_issued = 0;
   for (int i = 0; i < static_cast<int>(info->candidate_urls_.size()); i++) {
@@ -1401,13 +1460,14 @@ void PrerenderLocalPredictor::IssuePrerender(
   URLID url_id = url_info->id;
   const GURL& url = url_info->url;
   double priority = url_info->priority;
-  base::Time current_time = GetCurrentTime();
+  base::Time current_time = prerender_manager_->GetCurrentTime();
   RecordEvent(EVENT_ISSUING_PRERENDER);
 
   // Issue the prerender and obtain a new handle.
   scoped_ptr<prerender::PrerenderHandle> new_prerender_handle(
       prerender_manager_->AddPrerenderFromLocalPredictor(
-          url, info->session_storage_namespace_.get(), *(info->size_)));
+          url, info->session_storage_namespace_.get(), *(info->size_),
+          priority));
 
   // Check if this is a duplicate of an existing prerender. If yes, clean up
   // the new handle.
@@ -8,6 +8,7 @@
 #include <map>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/containers/hash_tables.h"
 #include "base/memory/scoped_vector.h"
 #include "base/memory/weak_ptr.h"
@@ -145,17 +146,53 @@ class PrerenderLocalPredictor : public history::VisitDatabaseObserver,
     EVENT_MAX_VALUE
   };
 
+  // A page that followed earlier visits of the current page in the local
+  // browsing history, and the fraction of those visits it followed.
+  struct LocalHistoryCandidate {
+    LocalHistoryCandidate(history::URLID url_id, double priority);
+
+    history::URLID url_id;
+    double priority;
+  };
+
+  // Pages visited sooner than this after the current page are not considered
+  // to follow it.
+  static const int kMinLocalPredictionTimeMs = 500;
+
+  // The maximum number of candidates considered for each visit.
+  static const int kNumPrerenderCandidates = 5;
+
   // A PrerenderLocalPredictor is owned by the PrerenderManager specified
   // in the constructor.  It will be destoryed at the time its owning
   // PrerenderManager is destroyed.
   explicit PrerenderLocalPredictor(PrerenderManager* prerender_manager);
   virtual ~PrerenderLocalPredictor();
 
+  // Finds the pages in the local browsing history |visits| that followed at
+  // least two, and at least 10%, of the visits of |url_id|, between |min_age|
+  // and |max_age| after them.  Candidates are ordered by URLID.  Returns the
+  // number of visits of |url_id|.  This is the local history part of
+  // OnAddVisit().
+  static int GetLocalHistoryCandidates(
+      const std::vector<history::BriefVisitInfo>& visits,
+      history::URLID url_id,
+      base::TimeDelta min_age,
+      base::TimeDelta max_age,
+      std::vector<LocalHistoryCandidate>* candidates);
+
   void Shutdown();
 
   // history::VisitDatabaseObserver implementation
   virtual void OnAddVisit(const history::BriefVisitInfo& info) OVERRIDE;
 
+  // Handles |info| like OnAddVisit(), but resolves URLIDs with |url_for_id|
+  // and treats every candidate as not logged in, instead of looking them up
+  // in the history and logged-in databases, so that a visit log can be
+  // replayed against a stubbed PrerenderManager.
+  void ReplayVisitForTesting(
+      const history::BriefVisitInfo& info,
+      const base::Callback<GURL(history::URLID)>& url_for_id);
+
   void OnGetInitialVisitHistory(
       scoped_ptr<std::vector<history::BriefVisitInfo> > visit_history);
 
@@ -176,6 +213,12 @@ class PrerenderLocalPredictor : public history::VisitDatabaseObserver,
                                    base::TimeDelta plt) const;
   void RecordEvent(Event event) const;
 
+  // Adds |info| to the visit history and returns the prerender candidates
+  // that followed earlier visits of its URL, or NULL if no prediction is made
+  // for the visit.
+  scoped_ptr<CandidatePrerenderInfo> RecordVisit(
+      const history::BriefVisitInfo& info);
+
   void OnLookupURL(scoped_ptr<CandidatePrerenderInfo> info);
 
   // Lookup the prerender candidate in the Prerender Service (if applicable).
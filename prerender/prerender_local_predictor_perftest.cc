@@ -0,0 +1,280 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/prerender/prerender_local_predictor.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/metrics/field_trial.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "chrome/browser/prerender/prerender_contents.h"
+#include "chrome/browser/prerender/prerender_manager.h"
+#include "chrome/browser/prerender/prerender_origin.h"
+#include "chrome/test/base/testing_browser_process.h"
+#include "chrome/test/base/testing_profile.h"
+#include "content/public/common/page_transition_types.h"
+#include "content/public/test/test_browser_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+using base::Time;
+using base::TimeDelta;
+using base::TimeTicks;
+using content::BrowserThread;
+using history::BriefVisitInfo;
+using history::URLID;
+
+namespace prerender {
+
+namespace {
+
+// Every page of the synthetic logs is a root page, which the predictor
+// prerenders without consulting the whitelists.
+GURL GetURLForURLID(URLID url_id) {
+  return GURL(base::StringPrintf("http://www.site%d.com/",
+                                 static_cast<int>(url_id)));
+}
+
+// Appends a link visit to |url_id| |seconds| after the previous visit.
+void AddVisit(std::vector<BriefVisitInfo>* visits,
+              URLID url_id,
+              int seconds) {
+  BriefVisitInfo visit;
+  visit.url_id = url_id;
+  visit.time = visits->empty() ?
+      Time::Now() :
+      visits->back().time + TimeDelta::FromSeconds(seconds);
+  visit.transition = content::PageTransitionFromInt(
+      content::PAGE_TRANSITION_LINK | content::PAGE_TRANSITION_CHAIN_START |
+      content::PAGE_TRANSITION_CHAIN_END);
+  visits->push_back(visit);
+}
+
+// A prerender that starts without creating a WebContents.
+class StubPrerenderContents : public PrerenderContents {
+ public:
+  StubPrerenderContents(PrerenderManager* prerender_manager,
+                        const GURL& url,
+                        Origin origin)
+      : PrerenderContents(prerender_manager, NULL, url, content::Referrer(),
+                          origin, PrerenderManager::kNoExperiment) {
+  }
+
+  virtual void StartPrerendering(
+      int ALLOW_UNUSED creator_child_id,
+      const gfx::Size& ALLOW_UNUSED size,
+      content::SessionStorageNamespace* ALLOW_UNUSED session_storage_namespace,
+      net::URLRequestContextGetter* ALLOW_UNUSED request_context)
+      OVERRIDE {
+    load_start_time_ = prerender_manager()->GetCurrentTimeTicks();
+    prerendering_has_started_ = true;
+    NotifyPrerenderStart();
+  }
+
+  virtual bool GetChildId(int* child_id) const OVERRIDE {
+    *child_id = -1;
+    return true;
+  }
+
+  virtual bool GetRouteId(int* route_id) const OVERRIDE {
+    *route_id = -1;
+    return true;
+  }
+};
+
+}  // namespace
+
+// A PrerenderManager whose clocks follow the visit log being replayed, and
+// which counts the prerenders it starts and throws away.
+class ReplayPrerenderManager : public PrerenderManager {
+ public:
+  ReplayPrerenderManager(Profile* profile,
+                         PrerenderTracker* prerender_tracker)
+      : PrerenderManager(profile, prerender_tracker),
+        time_ticks_(TimeTicks::Now()),
+        prerenders_started_(0),
+        prerenders_wasted_(0) {
+    mutable_config().rate_limit_enabled = false;
+    OnCookieStoreLoaded();
+  }
+
+  virtual ~ReplayPrerenderManager() {
+  }
+
+  // Moves both clocks to |time|.
+  void SetTime(Time time) {
+    if (!time_.is_null())
+      time_ticks_ += time - time_;
+    time_ = time;
+  }
+
+  // Swaps in the prerender of |url|, as a navigation to it would. Returns
+  // false if |url| is not being prerendered.
+  bool UsePrerender(const GURL& url) {
+    DeleteOldEntries();
+    PrerenderData* prerender_data = FindPrerenderData(url, NULL);
+    if (!prerender_data)
+      return false;
+    ScopedVector<PrerenderData>::iterator to_erase =
+        FindIteratorForPrerenderContents(prerender_data->contents());
+    CHECK(to_erase != active_prerenders_.end());
+    scoped_ptr<PrerenderContents> prerender_contents(
+        prerender_data->ReleaseContents());
+    active_prerenders_.erase(to_erase);
+    prerender_contents->PrepareForUse();
+    return true;
+  }
+
+  int prerenders_started() const { return prerenders_started_; }
+  int prerenders_wasted() const { return prerenders_wasted_; }
+
+  // From PrerenderManager:
+  virtual void MoveEntryToPendingDelete(PrerenderContents* entry,
+                                        FinalStatus final_status) OVERRIDE {
+    // Prerenders that are used do not get here, so this prerender expired or
+    // was replaced by the predictor.
+    ++prerenders_wasted_;
+    PrerenderManager::MoveEntryToPendingDelete(entry, final_status);
+  }
+
+  virtual Time GetCurrentTime() const OVERRIDE {
+    return time_;
+  }
+
+  virtual TimeTicks GetCurrentTimeTicks() const OVERRIDE {
+    return time_ticks_;
+  }
+
+  virtual int64 GetAvailablePhysicalMemory() const OVERRIDE {
+    return static_cast<int64>(8) * 1024 * 1024 * 1024;
+  }
+
+ protected:
+  virtual net::URLRequestContextGetter* GetURLRequestContext() OVERRIDE {
+    return NULL;
+  }
+
+ private:
+  virtual PrerenderContents* CreatePrerenderContents(
+      const GURL& url,
+      const content::Referrer& referrer,
+      Origin origin,
+      uint8 experiment_id) OVERRIDE {
+    ++prerenders_started_;
+    return new StubPrerenderContents(this, url, origin);
+  }
+
+  Time time_;
+  TimeTicks time_ticks_;
+  int prerenders_started_;
+  int prerenders_wasted_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReplayPrerenderManager);
+};
+
+class PrerenderLocalPredictorPerfTest : public testing::Test {
+ protected:
+  PrerenderLocalPredictorPerfTest()
+      : ui_thread_(BrowserThread::UI, &message_loop_),
+        field_trial_list_(NULL) {
+    base::FieldTrialList::CreateFieldTrial(
+        "PrerenderLocalPredictorSpec",
+        "MaxConcurrentPrerenders=2:MaxLaunchPrerenders=2");
+  }
+
+  // Replays |visits| through a PrerenderLocalPredictor, and reports its hit
+  // rate, wasted prerenders and decision time as |trace|.
+  void ReplayVisits(const std::vector<BriefVisitInfo>& visits,
+                    const std::string& trace) {
+    ReplayPrerenderManager prerender_manager(
+        &profile_, g_browser_process->prerender_tracker());
+    scoped_ptr<PrerenderLocalPredictor> predictor(
+        new PrerenderLocalPredictor(&prerender_manager));
+    predictor->OnGetInitialVisitHistory(
+        make_scoped_ptr(new std::vector<BriefVisitInfo>()));
+
+    int hits = 0;
+    TimeDelta decision_time;
+    for (size_t i = 0; i < visits.size(); ++i) {
+      prerender_manager.SetTime(visits[i].time);
+      if (prerender_manager.UsePrerender(GetURLForURLID(visits[i].url_id)))
+        ++hits;
+      TimeTicks start = TimeTicks::Now();
+      predictor->ReplayVisitForTesting(visits[i],
+                                       base::Bind(&GetURLForURLID));
+      decision_time += TimeTicks::Now() - start;
+    }
+    base::RunLoop().RunUntilIdle();
+
+    perf_test::PrintResult("prerender_local_predictor_hit_rate", "", trace,
+                           100.0 * hits / visits.size(), "%", true);
+    perf_test::PrintResult("prerender_local_predictor_started", "", trace,
+                           static_cast<size_t>(
+                               prerender_manager.prerenders_started()),
+                           "prerenders", false);
+    perf_test::PrintResult("prerender_local_predictor_wasted", "", trace,
+                           static_cast<size_t>(
+                               prerender_manager.prerenders_wasted()),
+                           "prerenders", true);
+    perf_test::PrintResult("prerender_local_predictor_decision_time", "",
+                           trace,
+                           decision_time.InMicroseconds() /
+                               static_cast<double>(visits.size()),
+                           "us", true);
+
+    predictor.reset();
+    prerender_manager.Shutdown();
+    base::RunLoop().RunUntilIdle();
+  }
+
+ private:
+  // Needed to pass PrerenderManager's DCHECKs.
+  TestingProfile profile_;
+  base::MessageLoop message_loop_;
+  content::TestBrowserThread ui_thread_;
+  base::FieldTrialList field_trial_list_;
+};
+
+// The user follows the same path over and over.
+TEST_F(PrerenderLocalPredictorPerfTest, RepeatedNavigation) {
+  std::vector<BriefVisitInfo> visits;
+  for (int i = 0; i < 500; ++i) {
+    AddVisit(&visits, 1, 60);
+    AddVisit(&visits, 2, 10);
+    AddVisit(&visits, 3, 10);
+  }
+  ReplayVisits(visits, "repeated");
+}
+
+// The user visits pages at random, so predictions rarely come true.
+TEST_F(PrerenderLocalPredictorPerfTest, RandomNavigation) {
+  std::vector<BriefVisitInfo> visits;
+  // A fixed linear congruential generator keeps the log reproducible.
+  uint32 seed = 1;
+  for (int i = 0; i < 3000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    AddVisit(&visits, 1 + ((seed & 0x7fffffff) >> 16) % 50, 10);
+  }
+  ReplayVisits(visits, "random");
+}
+
+// The page that follows the start page changes halfway through the log.
+TEST_F(PrerenderLocalPredictorPerfTest, ChangedHabits) {
+  std::vector<BriefVisitInfo> visits;
+  for (int i = 0; i < 200; ++i) {
+    AddVisit(&visits, 1, 300);
+    AddVisit(&visits, i < 100 ? 2 : 4, 10);
+  }
+  ReplayVisits(visits, "changed_habits");
+}
+
+}  // namespace prerender
@@ -0,0 +1,65 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/prerender/prerender_local_predictor.h"
+
+#include <vector>
+
+#include "base/time/time.h"
+#include "content/public/common/page_transition_types.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using history::BriefVisitInfo;
+using history::URLID;
+
+namespace prerender {
+
+namespace {
+
+// Appends a link visit to |url_id| |seconds| after the previous visit.
+void AddVisit(std::vector<BriefVisitInfo>* visits,
+              URLID url_id,
+              int seconds) {
+  BriefVisitInfo visit;
+  visit.url_id = url_id;
+  visit.time = visits->empty() ?
+      base::Time::Now() :
+      visits->back().time + base::TimeDelta::FromSeconds(seconds);
+  visit.transition = content::PageTransitionFromInt(
+      content::PAGE_TRANSITION_LINK | content::PAGE_TRANSITION_CHAIN_START |
+      content::PAGE_TRANSITION_CHAIN_END);
+  visits->push_back(visit);
+}
+
+}  // namespace
+
+TEST(PrerenderLocalPredictorTest, GetLocalHistoryCandidates) {
+  std::vector<BriefVisitInfo> visits;
+  for (int i = 0; i < 3; ++i) {
+    AddVisit(&visits, 1, 300);
+    AddVisit(&visits, 2, 10);
+    if (i < 2)
+      AddVisit(&visits, 3, 10);
+  }
+
+  std::vector<PrerenderLocalPredictor::LocalHistoryCandidate> candidates;
+  EXPECT_EQ(3, PrerenderLocalPredictor::GetLocalHistoryCandidates(
+      visits, 1, base::TimeDelta::FromMilliseconds(
+          PrerenderLocalPredictor::kMinLocalPredictionTimeMs),
+      base::TimeDelta::FromSeconds(180), &candidates));
+  ASSERT_EQ(2u, candidates.size());
+  EXPECT_EQ(2, candidates[0].url_id);
+  EXPECT_DOUBLE_EQ(1.0, candidates[0].priority);
+  EXPECT_EQ(3, candidates[1].url_id);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, candidates[1].priority);
+
+  // Pages visited much later don't follow the visit.
+  EXPECT_EQ(3, PrerenderLocalPredictor::GetLocalHistoryCandidates(
+      visits, 1, base::TimeDelta::FromMilliseconds(
+          PrerenderLocalPredictor::kMinLocalPredictionTimeMs),
+      base::TimeDelta::FromSeconds(5), &candidates));
+  EXPECT_TRUE(candidates.empty());
+}
+
+}  // namespace prerender
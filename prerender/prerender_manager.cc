@@ -17,6 +17,7 @@
 #include "base/prefs/pref_service.h"
 #include "base/stl_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/sys_info.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
 #include "base/values.h"
@@ -276,6 +277,8 @@ PrerenderManager::PrerenderManager(Profile* profile,
     }
   }
 
+  config_.memory_admission_enabled = IsPrerenderMemoryAdmissionEnabled();
+
   // Certain experiments override our default config_ values.
   switch (PrerenderManager::GetMode()) {
     case PrerenderManager::PRERENDER_MODE_EXPERIMENT_MULTI_PRERENDER_GROUP:
@@ -336,32 +339,22 @@ PrerenderHandle* PrerenderManager::AddPrerenderFromLinkRelPrerender(
     const uint32 rel_types,
     const content::Referrer& referrer,
     const gfx::Size& size) {
-  Origin origin = rel_types & PrerenderRelTypePrerender ?
-                      ORIGIN_LINK_REL_PRERENDER_CROSSDOMAIN :
-                      ORIGIN_LINK_REL_NEXT;
   SessionStorageNamespace* session_storage_namespace = NULL;
+  WebContents* source_web_contents = NULL;
   // Unit tests pass in a process_id == -1.
   if (process_id != -1) {
-    RenderViewHost* source_render_view_host =
-        RenderViewHost::FromID(process_id, route_id);
-    if (!source_render_view_host)
-      return NULL;
-    WebContents* source_web_contents =
-        WebContents::FromRenderViewHost(source_render_view_host);
+    source_web_contents = GetSourceWebContents(process_id, route_id);
     if (!source_web_contents)
       return NULL;
-    if (origin == ORIGIN_LINK_REL_PRERENDER_CROSSDOMAIN &&
-        source_web_contents->GetURL().host() == url.host()) {
-      origin = ORIGIN_LINK_REL_PRERENDER_SAMEDOMAIN;
-    }
     // TODO(ajwong): This does not correctly handle storage for isolated apps.
     session_storage_namespace =
         source_web_contents->GetController()
             .GetDefaultSessionStorageNamespace();
   }
 
-  return AddPrerender(origin, process_id, url, referrer, size,
-                      session_storage_namespace);
+  return AddPrerender(
+      GetLinkRelPrerenderOrigin(url, rel_types, source_web_contents),
+      process_id, url, referrer, size, session_storage_namespace, 0.0);
 }
 
 PrerenderHandle* PrerenderManager::AddPrerenderFromOmnibox(
@@ -371,15 +364,16 @@ PrerenderHandle* PrerenderManager::AddPrerenderFromOmnibox(
   if (!IsOmniboxEnabled(profile_))
     return NULL;
   return AddPrerender(ORIGIN_OMNIBOX, -1, url, content::Referrer(), size,
-                      session_storage_namespace);
+                      session_storage_namespace, 0.0);
 }
 
 PrerenderHandle* PrerenderManager::AddPrerenderFromLocalPredictor(
     const GURL& url,
     SessionStorageNamespace* session_storage_namespace,
-    const gfx::Size& size) {
+    const gfx::Size& size,
+    double priority) {
   return AddPrerender(ORIGIN_LOCAL_PREDICTOR, -1, url, content::Referrer(),
-                      size, session_storage_namespace);
+                      size, session_storage_namespace, priority);
 }
 
 PrerenderHandle* PrerenderManager::AddPrerenderFromExternalRequest(
@@ -388,7 +382,7 @@ PrerenderHandle* PrerenderManager::AddPrerenderFromExternalRequest(
     SessionStorageNamespace* session_storage_namespace,
     const gfx::Size& size) {
   return AddPrerender(ORIGIN_EXTERNAL_REQUEST, -1, url, referrer, size,
-                      session_storage_namespace);
+                      session_storage_namespace, 0.0);
 }
 
 PrerenderHandle* PrerenderManager::AddPrerenderForInstant(
@@ -397,7 +391,7 @@ PrerenderHandle* PrerenderManager::AddPrerenderForInstant(
     const gfx::Size& size) {
   DCHECK(chrome::ShouldPrefetchSearchResults());
   return AddPrerender(ORIGIN_INSTANT, -1, url, content::Referrer(), size,
-                      session_storage_namespace);
+                      session_storage_namespace, 0.0);
 }
 
 void PrerenderManager::CancelAllPrerenders() {
@@ -994,7 +988,8 @@ PrerenderManager::PrerenderData::PrerenderData(PrerenderManager* manager,
     : manager_(manager),
       contents_(contents),
       handle_count_(0),
-      expiry_time_(expiry_time) {
+      expiry_time_(expiry_time),
+      benefit_(0.0) {
   DCHECK_NE(static_cast<PrerenderContents*>(NULL), contents_);
 }
 
@@ -1252,7 +1247,8 @@ PrerenderHandle* PrerenderManager::AddPrerender(
     const GURL& url_arg,
     const content::Referrer& referrer,
     const gfx::Size& size,
-    SessionStorageNamespace* session_storage_namespace) {
+    SessionStorageNamespace* session_storage_namespace,
+    double score) {
   DCHECK(CalledOnValidThread());
 
   if (!IsEnabled())
@@ -1320,12 +1316,23 @@ PrerenderHandle* PrerenderManager::AddPrerender(
     return NULL;
   }
 
+  // Only start the prerender if it is predicted to fit in memory, possibly
+  // after evicting less useful prerenders.
+  const double benefit =
+      PrerenderAdmissionController::GetBenefit(origin, score);
+  if (!AdmitPrerender(url, benefit)) {
+    RecordFinalStatusWithoutCreatingPrerenderContents(
+        url, origin, experiment, FINAL_STATUS_INSUFFICIENT_MEMORY);
+    return NULL;
+  }
+
   PrerenderContents* prerender_contents = CreatePrerenderContents(
       url, referrer, origin, experiment);
   DCHECK(prerender_contents);
   active_prerenders_.push_back(
       new PrerenderData(this, prerender_contents,
                         GetExpiryTimeForNewPrerender(origin)));
+  active_prerenders_.back()->set_benefit(benefit);
   if (!prerender_contents->Init()) {
     DCHECK(active_prerenders_.end() ==
            FindIteratorForPrerenderContents(prerender_contents));
@@ -1411,6 +1418,9 @@ void PrerenderManager::PeriodicCleanup() {
                 std::mem_fun(
                     &PrerenderContents::DestroyWhenUsingTooManyResources));
 
+  // Memory may have become scarce since the prerenders were admitted.
+  EvictPrerendersOverMemoryBudget();
+
   // Measure how long the resource checks took. http://crbug.com/305419.
   UMA_HISTOGRAM_TIMES("Prerender.PeriodicCleanupResourceCheckTime",
                       resource_timer.Elapsed());
@@ -1428,6 +1438,11 @@ void PrerenderManager::PeriodicCleanup() {
   // Measure how long a the various cleanup tasks took. http://crbug.com/305419.
   UMA_HISTOGRAM_TIMES("Prerender.PeriodicCleanupDeleteContentsTime",
                       cleanup_timer.Elapsed());
+
+  // This runs after every prerender that ends or is evicted, so prerenders
+  // that were deferred for lack of memory may fit now.
+  if (config_.memory_admission_enabled)
+    admission_retry_callbacks_.Notify();
 }
 
 void PrerenderManager::PostCleanupTask() {
@@ -1471,6 +1486,144 @@ base::TimeTicks PrerenderManager::GetCurrentTimeTicks() const {
   return base::TimeTicks::Now();
 }
 
+int64 PrerenderManager::GetAvailablePhysicalMemory() const {
+  return base::SysInfo::AmountOfAvailablePhysicalMemory();
+}
+
+bool PrerenderManager::ShouldDeferLinkPrerender(int process_id,
+                                                int route_id,
+                                                const GURL& url,
+                                                uint32 rel_types) const {
+  DCHECK(CalledOnValidThread());
+  if (!config_.memory_admission_enabled)
+    return false;
+  WebContents* source_web_contents = NULL;
+  if (process_id != -1) {
+    source_web_contents = GetSourceWebContents(process_id, route_id);
+    // AddPrerenderFromLinkRelPrerender() drops the prerender.
+    if (!source_web_contents)
+      return false;
+  }
+  // Score the link the same way AddPrerender() will, so that a link that is
+  // not deferred here is not refused there.
+  PrerenderAdmissionController::Candidate candidate = GetAdmissionCandidate(
+      url,
+      PrerenderAdmissionController::GetBenefit(
+          GetLinkRelPrerenderOrigin(url, rel_types, source_web_contents),
+          0.0));
+  std::vector<PrerenderAdmissionController::Candidate> running;
+  GetRunningPrerenders(&running, NULL);
+  std::vector<size_t> evict;
+  return PrerenderAdmissionController::Decide(
+             candidate, running, GetAvailablePhysicalMemory(), &evict) ==
+         PrerenderAdmissionController::DEFER;
+}
+
+scoped_ptr<PrerenderManager::AdmissionRetrySubscription>
+PrerenderManager::RegisterAdmissionRetryCallback(
+    const base::Closure& callback) {
+  DCHECK(CalledOnValidThread());
+  return admission_retry_callbacks_.Add(callback);
+}
+
+// static
+Origin PrerenderManager::GetLinkRelPrerenderOrigin(
+    const GURL& url,
+    uint32 rel_types,
+    WebContents* source_web_contents) {
+  if (!(rel_types & PrerenderRelTypePrerender))
+    return ORIGIN_LINK_REL_NEXT;
+  if (source_web_contents &&
+      source_web_contents->GetURL().host() == url.host()) {
+    return ORIGIN_LINK_REL_PRERENDER_SAMEDOMAIN;
+  }
+  return ORIGIN_LINK_REL_PRERENDER_CROSSDOMAIN;
+}
+
+// static
+WebContents* PrerenderManager::GetSourceWebContents(int process_id,
+                                                    int route_id) {
+  RenderViewHost* source_render_view_host =
+      RenderViewHost::FromID(process_id, route_id);
+  if (!source_render_view_host)
+    return NULL;
+  return WebContents::FromRenderViewHost(source_render_view_host);
+}
+
+PrerenderAdmissionController::Candidate
+PrerenderManager::GetAdmissionCandidate(const GURL& url,
+                                        double benefit) const {
+  // The default cost is read from |config_| on every decision, so that later
+  // changes to the configuration apply.
+  return PrerenderAdmissionController::Candidate(
+      benefit, admission_controller_.PredictCost(url, config_.max_bytes));
+}
+
+void PrerenderManager::GetRunningPrerenders(
+    std::vector<PrerenderAdmissionController::Candidate>* candidates,
+    std::vector<PrerenderContents*>* contents) const {
+  for (ScopedVector<PrerenderData>::const_iterator it =
+           active_prerenders_.begin();
+       it != active_prerenders_.end(); ++it) {
+    PrerenderContents* prerender_contents = (*it)->contents();
+    // Match complete replacements are placeholders without a renderer.
+    if (prerender_contents->match_complete_status() !=
+        PrerenderContents::MATCH_COMPLETE_DEFAULT) {
+      continue;
+    }
+    candidates->push_back(GetAdmissionCandidate(
+        prerender_contents->prerender_url(), (*it)->benefit()));
+    if (contents)
+      contents->push_back(prerender_contents);
+  }
+}
+
+bool PrerenderManager::AdmitPrerender(const GURL& url, double benefit) {
+  DCHECK(CalledOnValidThread());
+  if (!config_.memory_admission_enabled)
+    return true;
+  PrerenderAdmissionController::Candidate candidate =
+      GetAdmissionCandidate(url, benefit);
+  std::vector<PrerenderAdmissionController::Candidate> running;
+  std::vector<PrerenderContents*> running_contents;
+  GetRunningPrerenders(&running, &running_contents);
+  std::vector<size_t> evict;
+  PrerenderAdmissionController::Decision decision =
+      PrerenderAdmissionController::Decide(
+          candidate, running, GetAvailablePhysicalMemory(), &evict);
+  UMA_HISTOGRAM_ENUMERATION("Prerender.AdmissionDecision", decision,
+                            PrerenderAdmissionController::DECISION_MAX);
+  if (decision == PrerenderAdmissionController::DEFER)
+    return false;
+  EvictPrerenders(evict, running_contents);
+  return true;
+}
+
+void PrerenderManager::EvictPrerendersOverMemoryBudget() {
+  DCHECK(CalledOnValidThread());
+  if (!config_.memory_admission_enabled)
+    return;
+  std::vector<PrerenderAdmissionController::Candidate> running;
+  std::vector<PrerenderContents*> running_contents;
+  GetRunningPrerenders(&running, &running_contents);
+  EvictPrerenders(PrerenderAdmissionController::GetOverBudget(
+                      running, GetAvailablePhysicalMemory()),
+                  running_contents);
+}
+
+void PrerenderManager::EvictPrerenders(
+    const std::vector<size_t>& indices,
+    const std::vector<PrerenderContents*>& contents) {
+  for (size_t i = 0; i < indices.size(); ++i)
+    contents[indices[i]]->Destroy(FINAL_STATUS_EVICTED_FOR_MEMORY);
+}
+
+void PrerenderManager::RecordPrerenderMemoryUse(const GURL& url,
+                                                size_t private_bytes) {
+  DCHECK(CalledOnValidThread());
+  admission_controller_.RecordMemoryUse(url, private_bytes);
+}
+
 PrerenderContents* PrerenderManager::CreatePrerenderContents(
     const GURL& url,
     const content::Referrer& referrer,
@@ -11,6 +11,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/callback_list.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/scoped_vector.h"
@@ -22,6 +23,7 @@
 #include "chrome/browser/history/history_service.h"
 #include "chrome/browser/media/media_capture_devices_dispatcher.h"
 #include "chrome/browser/predictors/logged_in_predictor_table.h"
+#include "chrome/browser/prerender/prerender_admission_controller.h"
 #include "chrome/browser/prerender/prerender_config.h"
 #include "chrome/browser/prerender/prerender_contents.h"
 #include "chrome/browser/prerender/prerender_events.h"
@@ -141,10 +143,13 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
       content::SessionStorageNamespace* session_storage_namespace,
       const gfx::Size& size);
 
+  // Adds a prerender for |url| suggested by the PrerenderLocalPredictor,
+  // which estimates the prerender will be used with probability |priority|.
   PrerenderHandle* AddPrerenderFromLocalPredictor(
       const GURL& url,
       content::SessionStorageNamespace* session_storage_namespace,
-      const gfx::Size& size);
+      const gfx::Size& size,
+      double priority);
 
   PrerenderHandle* AddPrerenderFromExternalRequest(
       const GURL& url,
@@ -332,6 +337,26 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   virtual base::Time GetCurrentTime() const;
   virtual base::TimeTicks GetCurrentTimeTicks() const;
 
+  // Returns the physical memory currently available, in bytes.  Virtual so
+  // that tests can simulate memory pressure.
+  virtual int64 GetAvailablePhysicalMemory() const;
+
+  // Returns true if a prerender of |url| from a link element should stay
+  // pending, as there is not enough memory to start it now. The arguments are
+  // the same as for AddPrerenderFromLinkRelPrerender().
+  bool ShouldDeferLinkPrerender(int process_id,
+                                int route_id,
+                                const GURL& url,
+                                uint32 rel_types) const;
+
+  // Registers |callback| to run when prerenders that were deferred for lack of
+  // memory may fit: after prerenders end or are evicted, and periodically
+  // while prerenders are running.
+  typedef base::CallbackList<void(void)>::Subscription
+      AdmissionRetrySubscription;
+  scoped_ptr<AdmissionRetrySubscription> RegisterAdmissionRetryCallback(
+      const base::Closure& callback);
+
   scoped_refptr<predictors::LoggedInPredictorTable>
   logged_in_predictor_table() {
     return logged_in_predictor_table_;
@@ -432,6 +457,9 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
       expiry_time_ = expiry_time;
     }
 
+    double benefit() const { return benefit_; }
+    void set_benefit(double benefit) { benefit_ = benefit; }
+
     void ClearPendingSwap();
 
     PendingSwap* pending_swap() { return pending_swap_.get(); }
@@ -457,6 +485,10 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
     // removed.
     base::TimeTicks expiry_time_;
 
+    // How likely the prerender is to be used, as estimated by
+    // PrerenderAdmissionController::GetBenefit() when it was added.
+    double benefit_;
+
     // If a session storage namespace merge is in progress for this object,
     // we need to keep track of various state associated with it.
     scoped_ptr<PendingSwap> pending_swap_;
@@ -543,6 +575,7 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   friend class PrerenderBrowserTest;
   friend class PrerenderContents;
   friend class PrerenderHandle;
+  friend class ReplayPrerenderManager;
   friend class UnitTestPrerenderManager;
 
   class OnCloseWebContentsDeleter;
@@ -559,15 +592,58 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   // Adds a prerender for |url| from |referrer| initiated from the process
   // |child_id|. The |origin| specifies how the prerender was added. If |size|
   // is empty, then PrerenderContents::StartPrerendering will instead use a
-  // default from PrerenderConfig. Returns a PrerenderHandle*, owned by the
-  // caller, or NULL.
+  // default from PrerenderConfig. |score| is the PrerenderLocalPredictor's
+  // estimate that the prerender will be used, and is ignored for other
+  // origins. Returns a PrerenderHandle*, owned by the caller, or NULL.
   PrerenderHandle* AddPrerender(
       Origin origin,
       int child_id,
       const GURL& url,
       const content::Referrer& referrer,
       const gfx::Size& size,
-      content::SessionStorageNamespace* session_storage_namespace);
+      content::SessionStorageNamespace* session_storage_namespace,
+      double score);
+
+  // Returns the origin of a prerender of |url| from a link element with
+  // |rel_types|, launched from |source_web_contents| if not NULL.
+  static Origin GetLinkRelPrerenderOrigin(
+      const GURL& url,
+      uint32 rel_types,
+      content::WebContents* source_web_contents);
+
+  // Returns the WebContents of the render view |route_id| in |process_id|, or
+  // NULL if it is gone.
+  static content::WebContents* GetSourceWebContents(int process_id,
+                                                    int route_id);
+
+  // Returns the candidate the PrerenderAdmissionController sees for a
+  // prerender of |url| with |benefit|.
+  PrerenderAdmissionController::Candidate GetAdmissionCandidate(
+      const GURL& url,
+      double benefit) const;
+
+  // Fills |candidates| with the running prerenders, as the
+  // PrerenderAdmissionController sees them, and |contents|, if not NULL, with
+  // their PrerenderContents in the same order.
+  void GetRunningPrerenders(
+      std::vector<PrerenderAdmissionController::Candidate>* candidates,
+      std::vector<PrerenderContents*>* contents) const;
+
+  // Returns true if there is memory for a prerender of |url| with |benefit|,
+  // destroying less useful prerenders to make room if necessary.
+  bool AdmitPrerender(const GURL& url, double benefit);
+
+  // Destroys the least useful prerenders while the running prerenders no
+  // longer fit in memory, e.g. because other tabs have grown.
+  void EvictPrerendersOverMemoryBudget();
+
+  // Destroys the prerenders at |indices| in |contents|, as filled by
+  // GetRunningPrerenders().
+  void EvictPrerenders(const std::vector<size_t>& indices,
+                       const std::vector<PrerenderContents*>& contents);
+
+  // Called by PrerenderContents with the memory used by a prerender of |url|.
+  void RecordPrerenderMemoryUse(const GURL& url, size_t private_bytes);
 
   void StartSchedulingPeriodicCleanups();
   void StopSchedulingPeriodicCleanups();
@@ -677,6 +753,13 @@ class PrerenderManager : public base::SupportsWeakPtr<PrerenderManager>,
   // The configuration.
   Config config_;
 
+  // Decides whether new prerenders fit in memory, if
+  // |config_.memory_admission_enabled|.
+  PrerenderAdmissionController admission_controller_;
+
+  // Run when deferred prerenders should be retried.
+  base::CallbackList<void(void)> admission_retry_callbacks_;
+
   // Specifies whether prerendering is currently enabled for this
   // manager. The value can change dynamically during the lifetime
   // of the PrerenderManager.
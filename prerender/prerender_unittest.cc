@@ -10,6 +10,7 @@
 #include "base/memory/scoped_vector.h"
 #include "base/message_loop/message_loop.h"
 #include "base/metrics/field_trial.h"
+#include "base/run_loop.h"
 #include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "chrome/browser/prerender/prerender_contents.h"
@@ -88,6 +89,10 @@ const gfx::Size kSize(640, 480);
 
 const uint32 kDefaultRelTypes = PrerenderRelTypePrerender;
 
+// Enough memory for every prerender in these tests.
+const int64 kDefaultAvailablePhysicalMemory =
+    static_cast<int64>(8) * 1024 * 1024 * 1024;
+
 }  // namespace
 
 class UnitTestPrerenderManager : public PrerenderManager {
@@ -100,6 +105,7 @@ class UnitTestPrerenderManager : public PrerenderManager {
       : PrerenderManager(profile, prerender_tracker),
         time_(Time::Now()),
         time_ticks_(TimeTicks::Now()),
+        available_physical_memory_(kDefaultAvailablePhysicalMemory),
         prerender_tracker_(prerender_tracker) {
     set_rate_limit_enabled(false);
     OnCookieStoreLoaded();
@@ -209,6 +215,14 @@ class UnitTestPrerenderManager : public PrerenderManager {
     return time_ticks_;
   }
 
+  virtual int64 GetAvailablePhysicalMemory() const OVERRIDE {
+    return available_physical_memory_;
+  }
+
+  void set_available_physical_memory(int64 available_physical_memory) {
+    available_physical_memory_ = available_physical_memory;
+  }
+
   virtual PrerenderContents* GetPrerenderContentsForRoute(
       int child_id, int route_id) const OVERRIDE {
     // Overridden for the PrerenderLinkManager's pending prerender logic.
@@ -263,6 +277,7 @@ class UnitTestPrerenderManager : public PrerenderManager {
 
   Time time_;
   TimeTicks time_ticks_;
+  int64 available_physical_memory_;
   scoped_ptr<PrerenderContents> next_prerender_contents_;
   // PrerenderContents with an |expected_final_status| of FINAL_STATUS_USED,
   // tracked so they will be automatically deleted.
@@ -1568,4 +1583,106 @@ TEST_F(PrerenderTest, PrerenderContentsForInstantSearch) {
   EXPECT_FALSE(prerender_handle->IsPrerendering());
 }
 
+// Ensure that link prerenders wait while there is not enough memory for them.
+TEST_F(PrerenderTest, LinkPrerenderDeferredUnderMemoryPressure) {
+  prerender_manager()->mutable_config().memory_admission_enabled = true;
+  const int64 default_cost = prerender_manager()->config().max_bytes;
+  prerender_manager()->set_available_physical_memory(default_cost);
+
+  GURL url("http://www.google.com/");
+  DummyPrerenderContents* prerender_contents =
+      prerender_manager()->CreateNextPrerenderContents(
+          url, FINAL_STATUS_MANAGER_SHUTDOWN);
+  EXPECT_FALSE(AddSimplePrerender(url));
+  EXPECT_FALSE(prerender_contents->prerendering_has_started());
+  EXPECT_TRUE(LauncherHasScheduledPrerender(kDefaultChildId,
+                                            last_prerender_id()));
+  EXPECT_FALSE(LauncherHasRunningPrerender(kDefaultChildId,
+                                           last_prerender_id()));
+  prerender_link_manager()->OnCancelPrerender(kDefaultChildId,
+                                              last_prerender_id());
+}
+
+// Ensure that a new prerender evicts less useful ones when memory is short,
+// and is refused if only more useful ones are running.
+TEST_F(PrerenderTest, MemoryAdmissionEvictsLessUseful) {
+  prerender_manager()->mutable_config().memory_admission_enabled = true;
+  const int64 default_cost = prerender_manager()->config().max_bytes;
+  // Enough memory for a single prerender.
+  prerender_manager()->set_available_physical_memory(default_cost * 7 / 3);
+
+  GURL predicted_url("http://www.predicted.com/");
+  prerender_manager()->CreateNextPrerenderContents(
+      predicted_url, ORIGIN_LOCAL_PREDICTOR, FINAL_STATUS_EVICTED_FOR_MEMORY);
+  scoped_ptr<PrerenderHandle> predicted_handle(
+      prerender_manager()->AddPrerenderFromLocalPredictor(
+          predicted_url, NULL, kSize, 0.1));
+  ASSERT_TRUE(predicted_handle.get());
+  EXPECT_TRUE(predicted_handle->IsPrerendering());
+
+  GURL omnibox_url("http://www.omnibox.com/");
+  DummyPrerenderContents* omnibox_contents =
+      prerender_manager()->CreateNextPrerenderContents(
+          omnibox_url, ORIGIN_OMNIBOX, FINAL_STATUS_USED);
+  scoped_ptr<PrerenderHandle> omnibox_handle(
+      prerender_manager()->AddPrerenderFromOmnibox(omnibox_url, NULL, kSize));
+  ASSERT_TRUE(omnibox_handle.get());
+  EXPECT_TRUE(omnibox_handle->IsPrerendering());
+  EXPECT_FALSE(predicted_handle->IsPrerendering());
+
+  GURL unlikely_url("http://www.unlikely.com/");
+  prerender_manager()->CreateNextPrerenderContents(
+      unlikely_url, ORIGIN_LOCAL_PREDICTOR, FINAL_STATUS_MANAGER_SHUTDOWN);
+  EXPECT_FALSE(prerender_manager()->AddPrerenderFromLocalPredictor(
+      unlikely_url, NULL, kSize, 0.05));
+
+  ASSERT_EQ(omnibox_contents,
+            prerender_manager()->FindAndUseEntry(omnibox_url));
+}
+
+// Ensure that a deferred link prerender starts once another prerender ends.
+TEST_F(PrerenderTest, DeferredLinkPrerenderStartsWhenPrerenderEnds) {
+  prerender_manager()->mutable_config().memory_admission_enabled = true;
+  const int64 default_cost = prerender_manager()->config().max_bytes;
+  // Enough memory for a single prerender.
+  prerender_manager()->set_available_physical_memory(default_cost * 7 / 3);
+
+  GURL omnibox_url("http://www.omnibox.com/");
+  prerender_manager()->CreateNextPrerenderContents(
+      omnibox_url, ORIGIN_OMNIBOX, FINAL_STATUS_CANCELLED);
+  scoped_ptr<PrerenderHandle> omnibox_handle(
+      prerender_manager()->AddPrerenderFromOmnibox(omnibox_url, NULL, kSize));
+  ASSERT_TRUE(omnibox_handle.get());
+  EXPECT_TRUE(omnibox_handle->IsPrerendering());
+
+  // The link is less useful than the omnibox prerender, so it has to wait.
+  GURL url("http://www.google.com/");
+  DummyPrerenderContents* prerender_contents =
+      prerender_manager()->CreateNextPrerenderContents(
+          url, FINAL_STATUS_MANAGER_SHUTDOWN);
+  EXPECT_FALSE(AddSimplePrerender(url));
+  EXPECT_TRUE(LauncherHasScheduledPrerender(kDefaultChildId,
+                                            last_prerender_id()));
+
+  omnibox_handle->OnCancel();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(LauncherHasRunningPrerender(kDefaultChildId,
+                                          last_prerender_id()));
+  EXPECT_TRUE(prerender_contents->prerendering_has_started());
+}
+
+// Ensure that memory is not considered unless the admission is enabled.
+TEST_F(PrerenderTest, MemoryAdmissionDisabledByDefault) {
+  EXPECT_FALSE(prerender_manager()->config().memory_admission_enabled);
+  prerender_manager()->set_available_physical_memory(0);
+
+  GURL url("http://www.google.com/");
+  DummyPrerenderContents* prerender_contents =
+      prerender_manager()->CreateNextPrerenderContents(
+          url, FINAL_STATUS_USED);
+  EXPECT_TRUE(AddSimplePrerender(url));
+  EXPECT_TRUE(prerender_contents->prerendering_has_started());
+  ASSERT_EQ(prerender_contents, prerender_manager()->FindAndUseEntry(url));
+}
+
 }  // namespace prerender
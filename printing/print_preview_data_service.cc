@@ -4,11 +4,111 @@
 
 #include "chrome/browser/printing/print_preview_data_service.h"
 
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/memory/singleton.h"
 #include "base/stl_util.h"
+#include "content/public/browser/browser_thread.h"
 #include "printing/print_job_constants.h"
 
+using content::BrowserThread;
+
+namespace {
+
+const base::FilePath::CharType kSpillDirName[] =
+    FILE_PATH_LITERAL("Print Preview Pages");
+
+// Orders the uses of preview pages across all data stores, to find the least
+// recently used ones. Only accessed on the UI thread.
+uint64 g_next_use = 0;
+
+void RunGetDataCallback(
+    const PrintPreviewDataService::GetDataCallback& callback,
+    const scoped_refptr<base::RefCountedBytes>& data) {
+  callback.Run(data.get());
+}
+
+}  // namespace
+
+// PrintPreviewSpillFile is the file in the spill directory that holds the
+// preview pages of a PrintPreviewDataStore that were spilled out of memory. It
+// is only used on the FILE thread, where reads are ordered after the writes
+// posted before them. The file is created on the first write and deleted with
+// the last reference.
+class PrintPreviewSpillFile
+    : public base::RefCountedThreadSafe<
+          PrintPreviewSpillFile, BrowserThread::DeleteOnFileThread> {
+ public:
+  explicit PrintPreviewSpillFile(const base::FilePath& dir) : dir_(dir) {}
+
+  // Writes |data| at |offset|. Returns true on success.
+  bool Write(int64 offset, const scoped_refptr<base::RefCountedBytes>& data) {
+    DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+    if (!file_.IsValid() && !Create())
+      return false;
+
+    int size = static_cast<int>(data->size());
+    if (file_.Write(offset, data->front_as<char>(), size) != size) {
+      LOG(ERROR) << "Failed to spill print preview data to " << path_.value();
+      return false;
+    }
+    return true;
+  }
+
+  // Returns the |size| bytes at |offset|, or NULL if they cannot be read.
+  scoped_refptr<base::RefCountedBytes> Read(int64 offset, size_t size) {
+    DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+    DCHECK_GT(size, 0U);
+    if (!file_.IsValid())
+      return NULL;
+
+    scoped_refptr<base::RefCountedBytes> data(new base::RefCountedBytes());
+    data->data().resize(size);
+    int read_size = static_cast<int>(size);
+    if (file_.Read(offset, reinterpret_cast<char*>(&data->data()[0]),
+                   read_size) != read_size) {
+      LOG(ERROR) << "Failed to read print preview data from "
+                 << path_.value();
+      return NULL;
+    }
+    return data;
+  }
+
+ private:
+  friend struct BrowserThread::DeleteOnThread<BrowserThread::FILE>;
+  friend class base::DeleteHelper<PrintPreviewSpillFile>;
+
+  ~PrintPreviewSpillFile() {
+    DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+    if (!file_.IsValid())
+      return;
+    file_.Close();
+    base::DeleteFile(path_, false);
+  }
+
+  bool Create() {
+    if (!base::CreateDirectory(dir_) ||
+        !base::CreateTemporaryFileInDir(dir_, &path_)) {
+      LOG(ERROR) << "Failed to create a print preview spill file in "
+                 << dir_.value();
+      return false;
+    }
+    file_.Initialize(path_, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                                base::File::FLAG_WRITE);
+    return file_.IsValid();
+  }
+
+  const base::FilePath dir_;
+  base::FilePath path_;
+  base::File file_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrintPreviewSpillFile);
+};
+
 // PrintPreviewDataStore stores data for preview workflow and preview printing
 // workflow.
 //
@@ -22,21 +122,58 @@
 // PrintPreviewDataStore owns the data and is responsible for freeing it when
 // either:
 //    a) There is a new data.
-//    b) When PrintPreviewDataStore is destroyed.
+//    b) The page has been spilled to disk.
+//    c) When PrintPreviewDataStore is destroyed.
 //
 class PrintPreviewDataStore : public base::RefCounted<PrintPreviewDataStore> {
  public:
-  PrintPreviewDataStore() {}
+  // Pages are spilled to a file in |spill_dir|, or never if it is empty.
+  explicit PrintPreviewDataStore(const base::FilePath& spill_dir)
+      : memory_usage_(0),
+        spill_dir_(spill_dir),
+        spill_file_size_(0) {
+  }
 
-  // Get the preview page for the specified |index|.
+  // Get the preview page for the specified |index|, if it is in memory.
   void GetPreviewDataForIndex(int index,
                               scoped_refptr<base::RefCountedBytes>* data) {
     if (IsInvalidIndex(index))
       return;
 
     PreviewPageDataMap::iterator it = page_data_map_.find(index);
-    if (it != page_data_map_.end())
-      *data = it->second.get();
+    if (it != page_data_map_.end()) {
+      it->second.last_use = g_next_use++;
+      *data = it->second.data.get();
+    }
+  }
+
+  // Runs |callback| with the preview page for the specified |index|, reading
+  // it back from the spill file if needed.
+  void GetPreviewDataForIndexAsync(
+      int index,
+      const PrintPreviewDataService::GetDataCallback& callback) {
+    PreviewPageDataMap::iterator it = page_data_map_.find(index);
+    if (IsInvalidIndex(index) || it == page_data_map_.end()) {
+      callback.Run(NULL);
+      return;
+    }
+
+    PageData& page = it->second;
+    page.last_use = g_next_use++;
+    if (page.data.get()) {
+      callback.Run(page.data.get());
+      return;
+    }
+    if (!page.size || !spill_file_.get()) {
+      callback.Run(NULL);
+      return;
+    }
+    BrowserThread::PostTaskAndReplyWithResult(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(&PrintPreviewSpillFile::Read, spill_file_,
+                   page.spill_offset, page.size),
+        base::Bind(&RunGetDataCallback, callback));
   }
 
   // Set/Update the preview data entry for the specified |index|.
@@ -44,7 +181,17 @@ class PrintPreviewDataStore : public base::RefCounted<PrintPreviewDataStore> {
     if (IsInvalidIndex(index))
       return;
 
-    page_data_map_[index] = const_cast<base::RefCountedBytes*>(data);
+    PageData& page = page_data_map_[index];
+    bool is_page = index != printing::COMPLETE_PREVIEW_DOCUMENT_INDEX;
+    if (is_page && page.data.get() && !page.spilling)
+      memory_usage_ -= page.size;
+    page.data = const_cast<base::RefCountedBytes*>(data);
+    page.size = data ? data->size() : 0;
+    page.last_use = g_next_use++;
+    page.spilling = false;
+    page.unspillable = false;
+    if (is_page)
+      memory_usage_ += page.size;
   }
 
   // Returns the available draft page count.
@@ -55,19 +202,112 @@ class PrintPreviewDataStore : public base::RefCounted<PrintPreviewDataStore> {
     return page_data_map_size;
   }
 
+  // Returns the number of bytes of preview pages held in memory.
+  size_t memory_usage() const { return memory_usage_; }
+
+  // Finds the least recently used preview page that is held in memory.
+  // Returns false if there is none, or if pages cannot be spilled.
+  bool GetLeastRecentlyUsedPage(int* index, uint64* last_use) const {
+    if (spill_dir_.empty())
+      return false;
+
+    bool found = false;
+    for (PreviewPageDataMap::const_iterator it = page_data_map_.begin();
+         it != page_data_map_.end(); ++it) {
+      if (it->first == printing::COMPLETE_PREVIEW_DOCUMENT_INDEX ||
+          !it->second.data.get() || !it->second.size ||
+          it->second.spilling || it->second.unspillable) {
+        continue;
+      }
+      if (!found || it->second.last_use < *last_use) {
+        *index = it->first;
+        *last_use = it->second.last_use;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  // Writes the preview page for |index| to the spill file. Its memory is
+  // freed once the write succeeds, but no longer counts against the budget.
+  // Returns the number of bytes to be freed.
+  size_t SpillPage(int index) {
+    PreviewPageDataMap::iterator it = page_data_map_.find(index);
+    DCHECK(it != page_data_map_.end());
+    PageData& page = it->second;
+    DCHECK(page.data.get());
+    DCHECK(!page.spilling);
+    DCHECK(!spill_dir_.empty());
+
+    if (!spill_file_.get())
+      spill_file_ = new PrintPreviewSpillFile(spill_dir_);
+    page.spill_offset = spill_file_size_;
+    spill_file_size_ += page.size;
+    page.spilling = true;
+    memory_usage_ -= page.size;
+    BrowserThread::PostTaskAndReplyWithResult(
+        BrowserThread::FILE,
+        FROM_HERE,
+        base::Bind(&PrintPreviewSpillFile::Write, spill_file_,
+                   page.spill_offset, page.data),
+        base::Bind(&PrintPreviewDataStore::OnPageSpilled, this, index,
+                   page.data));
+    return page.size;
+  }
+
  private:
   friend class base::RefCounted<PrintPreviewDataStore>;
 
+  struct PageData {
+    PageData()
+        : size(0),
+          spill_offset(0),
+          last_use(0),
+          spilling(false),
+          unspillable(false) {}
+
+    // NULL if the page was spilled to disk.
+    scoped_refptr<base::RefCountedBytes> data;
+    size_t size;
+    // Where the page is in |spill_file_|, if it was spilled.
+    int64 spill_offset;
+    uint64 last_use;
+    // True while |data| is being written to |spill_file_|.
+    bool spilling;
+    // True if writing |data| to |spill_file_| failed.
+    bool unspillable;
+  };
+
   // 1:1 relationship between page index and its associated preview data.
   // Key: Page index is zero-based and can be
   // |printing::COMPLETE_PREVIEW_DOCUMENT_INDEX| to represent complete preview
   // document.
   // Value: Preview data.
-  typedef std::map<int, scoped_refptr<base::RefCountedBytes> >
-      PreviewPageDataMap;
+  typedef std::map<int, PageData> PreviewPageDataMap;
 
   ~PrintPreviewDataStore() {}
 
+  // Frees the memory of the page for |index| if |data| was written to the
+  // spill file. Otherwise the page is kept in memory for good.
+  void OnPageSpilled(int index,
+                     const scoped_refptr<base::RefCountedBytes>& data,
+                     bool success) {
+    PreviewPageDataMap::iterator it = page_data_map_.find(index);
+    // Ignore pages that were replaced while they were being written.
+    if (it == page_data_map_.end() || it->second.data.get() != data.get() ||
+        !it->second.spilling) {
+      return;
+    }
+    PageData& page = it->second;
+    page.spilling = false;
+    if (success) {
+      page.data = NULL;
+      return;
+    }
+    page.unspillable = true;
+    memory_usage_ += page.size;
+  }
+
   static bool IsInvalidIndex(int index) {
     return (index != printing::COMPLETE_PREVIEW_DOCUMENT_INDEX &&
             index < printing::FIRST_PAGE_INDEX);
@@ -75,15 +315,44 @@ class PrintPreviewDataStore : public base::RefCounted<PrintPreviewDataStore> {
 
   PreviewPageDataMap page_data_map_;
 
+  // Does not count |printing::COMPLETE_PREVIEW_DOCUMENT_INDEX|, nor the pages
+  // being spilled.
+  size_t memory_usage_;
+
+  // Empty for off-the-record profiles, whose pages stay in memory.
+  const base::FilePath spill_dir_;
+
+  // Created when the first page is spilled. Replaced pages are not reused,
+  // the file is deleted with the store.
+  scoped_refptr<PrintPreviewSpillFile> spill_file_;
+  int64 spill_file_size_;
+
   DISALLOW_COPY_AND_ASSIGN(PrintPreviewDataStore);
 };
 
+// static
+const size_t PrintPreviewDataService::kDefaultMemoryBudget = 32 * 1024 * 1024;
+
 // static
 PrintPreviewDataService* PrintPreviewDataService::GetInstance() {
   return Singleton<PrintPreviewDataService>::get();
 }
 
-PrintPreviewDataService::PrintPreviewDataService() {
+// static
+base::FilePath PrintPreviewDataService::GetSpillDir(
+    const base::FilePath& profile_path) {
+  return profile_path.Append(kSpillDirName);
+}
+
+// static
+void PrintPreviewDataService::DeleteSpillFiles(
+    const base::FilePath& profile_path) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+  base::DeleteFile(GetSpillDir(profile_path), true);
+}
+
+PrintPreviewDataService::PrintPreviewDataService()
+    : memory_budget_(kDefaultMemoryBudget) {
 }
 
 PrintPreviewDataService::~PrintPreviewDataService() {
@@ -99,14 +368,28 @@ void PrintPreviewDataService::GetDataEntry(
     it->second->GetPreviewDataForIndex(index, data_bytes);
 }
 
+void PrintPreviewDataService::GetDataEntryAsync(
+    int32 preview_ui_id,
+    int index,
+    const GetDataCallback& callback) {
+  PreviewDataStoreMap::const_iterator it = data_store_map_.find(preview_ui_id);
+  if (it == data_store_map_.end()) {
+    callback.Run(NULL);
+    return;
+  }
+  it->second->GetPreviewDataForIndexAsync(index, callback);
+}
+
 void PrintPreviewDataService::SetDataEntry(
     int32 preview_ui_id,
     int index,
-    const base::RefCountedBytes* data_bytes) {
+    const base::RefCountedBytes* data_bytes,
+    const base::FilePath& spill_dir) {
   if (!ContainsKey(data_store_map_, preview_ui_id))
-    data_store_map_[preview_ui_id] = new PrintPreviewDataStore();
+    data_store_map_[preview_ui_id] = new PrintPreviewDataStore(spill_dir);
 
   data_store_map_[preview_ui_id]->SetPreviewDataForIndex(index, data_bytes);
+  EnforceMemoryBudget();
 }
 
 void PrintPreviewDataService::RemoveEntry(int32 preview_ui_id) {
@@ -118,3 +401,41 @@ int PrintPreviewDataService::GetAvailableDraftPageCount(int32 preview_ui_id) {
   return (it == data_store_map_.end()) ?
       0 : it->second->GetAvailableDraftPageCount();
 }
+
+size_t PrintPreviewDataService::GetMemoryUsage() const {
+  size_t memory_usage = 0;
+  for (PreviewDataStoreMap::const_iterator it = data_store_map_.begin();
+       it != data_store_map_.end(); ++it) {
+    memory_usage += it->second->memory_usage();
+  }
+  return memory_usage;
+}
+
+void PrintPreviewDataService::SetMemoryBudgetForTesting(size_t memory_budget) {
+  memory_budget_ = memory_budget;
+  EnforceMemoryBudget();
+}
+
+void PrintPreviewDataService::EnforceMemoryBudget() {
+  size_t memory_usage = GetMemoryUsage();
+  while (memory_usage > memory_budget_) {
+    PrintPreviewDataStore* lru_store = NULL;
+    int lru_index = 0;
+    uint64 lru_use = 0;
+    for (PreviewDataStoreMap::const_iterator it = data_store_map_.begin();
+         it != data_store_map_.end(); ++it) {
+      int index;
+      uint64 last_use;
+      if (it->second->GetLeastRecentlyUsedPage(&index, &last_use) &&
+          (!lru_store || last_use < lru_use)) {
+        lru_store = it->second.get();
+        lru_index = index;
+        lru_use = last_use;
+      }
+    }
+    // Only pages which cannot be spilled are left in memory.
+    if (!lru_store)
+      return;
+    memory_usage -= lru_store->SpillPage(lru_index);
+  }
+}
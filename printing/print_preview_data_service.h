@@ -8,6 +8,7 @@
 #include <map>
 #include <string>
 
+#include "base/callback.h"
 #include "base/memory/ref_counted.h"
 
 template<typename T> struct DefaultSingletonTraits;
@@ -15,36 +16,77 @@ template<typename T> struct DefaultSingletonTraits;
 class PrintPreviewDataStore;
 
 namespace base {
+class FilePath;
 class RefCountedBytes;
 }
 
 // PrintPreviewDataService manages data stores for chrome://print requests.
 // It owns the data store object and is responsible for freeing it.
+//
+// The preview pages of all the stores are kept in memory up to a budget. Past
+// it, the least recently used pages are spilled to a file in a subdirectory of
+// the profile directory and read back on demand through GetDataEntryAsync().
+// A page keeps its memory until it is written, and stays in memory if the
+// write fails. The pages of off-the-record profiles are never written to
+// disk. Complete preview documents are printed in one piece, so they are
+// always kept in memory and do not count against the budget.
 class PrintPreviewDataService {
  public:
+  // Runs with the requested data, or NULL if it is not available.
+  typedef base::Callback<void(base::RefCountedBytes*)> GetDataCallback;
+
+  // The default number of bytes of preview pages kept in memory.
+  static const size_t kDefaultMemoryBudget;
+
   static PrintPreviewDataService* GetInstance();
 
+  // Returns the directory under |profile_path| that preview pages are spilled
+  // to.
+  static base::FilePath GetSpillDir(const base::FilePath& profile_path);
+
+  // Deletes the preview pages that a previous session spilled under
+  // |profile_path| and left behind by crashing. Must be called on the FILE
+  // thread, before any page of this session is spilled.
+  static void DeleteSpillFiles(const base::FilePath& profile_path);
+
   // Get the data entry from PrintPreviewDataStore. |index| is zero-based or
   // |printing::COMPLETE_PREVIEW_DOCUMENT_INDEX| to represent complete preview
   // data. Use |index| to retrieve a specific preview page data. |data| is set
-  // to NULL if the requested page is not yet available.
+  // to NULL if the requested page is not yet available, or if it was spilled
+  // to disk.
   void GetDataEntry(int32 preview_ui_id, int index,
                     scoped_refptr<base::RefCountedBytes>* data);
 
+  // Like GetDataEntry(), but reads the page back on the FILE thread if it was
+  // spilled to disk. |callback| is run on the UI thread, before this returns
+  // if the data is in memory.
+  void GetDataEntryAsync(int32 preview_ui_id, int index,
+                         const GetDataCallback& callback);
+
   // Set/Update the data entry in PrintPreviewDataStore. |index| is zero-based
   // or |printing::COMPLETE_PREVIEW_DOCUMENT_INDEX| to represent complete
   // preview data. Use |index| to set/update a specific preview page data.
   // NOTE: PrintPreviewDataStore owns the data. Do not refcount |data| before
   // calling this function. It will be refcounted in PrintPreviewDataStore.
+  // Preview pages may be spilled to a file in |spill_dir|, or never if it is
+  // empty.
   void SetDataEntry(int32 preview_ui_id, int index,
-                    const base::RefCountedBytes* data);
+                    const base::RefCountedBytes* data,
+                    const base::FilePath& spill_dir);
 
   // Remove the corresponding PrintPreviewUI entry from the map.
   void RemoveEntry(int32 preview_ui_id);
 
-  // Returns the available draft page count.
+  // Returns the available draft page count, including the pages spilled to
+  // disk.
   int GetAvailableDraftPageCount(int32 preview_ui_id);
 
+  // Returns the number of bytes of preview pages held in memory, not counting
+  // the complete preview documents, nor the pages being spilled.
+  size_t GetMemoryUsage() const;
+
+  void SetMemoryBudgetForTesting(size_t memory_budget);
+
  private:
   friend struct DefaultSingletonTraits<PrintPreviewDataService>;
 
@@ -57,8 +99,16 @@ class PrintPreviewDataService {
   PrintPreviewDataService();
   virtual ~PrintPreviewDataService();
 
+  // Spills the least recently used preview pages to disk until the pages held
+  // in memory fit in |memory_budget_|, or only pages which cannot be spilled
+  // are left.
+  void EnforceMemoryBudget();
+
   PreviewDataStoreMap data_store_map_;
 
+  // The number of bytes of preview pages to keep in memory.
+  size_t memory_budget_;
+
   DISALLOW_COPY_AND_ASSIGN(PrintPreviewDataService);
 };
 
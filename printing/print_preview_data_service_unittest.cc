@@ -0,0 +1,237 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/printing/print_preview_data_service.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/run_loop.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "printing/print_job_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int32 kPreviewUIId = 1234;
+
+// A synthetic document: 500 pages of 64 KB, far over the memory budget.
+const int kPageCount = 500;
+const size_t kPageSize = 64 * 1024;
+const size_t kMemoryBudget = 2 * 1024 * 1024;
+
+// Returns |size| bytes which differ for each |page|.
+base::RefCountedBytes* CreatePageData(int page, size_t size) {
+  std::vector<unsigned char> data(size);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<unsigned char>((page * 31 + i) % 251);
+  return base::RefCountedBytes::TakeVector(&data);
+}
+
+bool HasPageData(int page, size_t size, base::RefCountedBytes* data) {
+  if (!data || data->size() != size)
+    return false;
+  scoped_refptr<base::RefCountedBytes> expected(CreatePageData(page, size));
+  return expected->data() == data->data();
+}
+
+void StoreData(scoped_refptr<base::RefCountedBytes>* result,
+               bool* called,
+               base::RefCountedBytes* data) {
+  *result = data;
+  *called = true;
+}
+
+}  // namespace
+
+class PrintPreviewDataServiceTest : public testing::Test {
+ public:
+  PrintPreviewDataServiceTest() : service_(NULL) {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(spill_dir_.CreateUniqueTempDir());
+    service_ = PrintPreviewDataService::GetInstance();
+    service_->SetMemoryBudgetForTesting(kMemoryBudget);
+  }
+
+  virtual void TearDown() OVERRIDE {
+    service_->RemoveEntry(kPreviewUIId);
+    service_->SetMemoryBudgetForTesting(
+        PrintPreviewDataService::kDefaultMemoryBudget);
+    // Deletes the spill files.
+    base::RunLoop().RunUntilIdle();
+  }
+
+ protected:
+  void SetPage(int page, size_t size) {
+    service_->SetDataEntry(kPreviewUIId, page, CreatePageData(page, size),
+                           spill_dir_.path());
+  }
+
+  scoped_refptr<base::RefCountedBytes> GetPage(int page) {
+    scoped_refptr<base::RefCountedBytes> data;
+    service_->GetDataEntry(kPreviewUIId, page, &data);
+    return data;
+  }
+
+  // Reads the page back from disk if needed.
+  scoped_refptr<base::RefCountedBytes> GetPageAsync(int page) {
+    scoped_refptr<base::RefCountedBytes> data;
+    bool called = false;
+    service_->GetDataEntryAsync(kPreviewUIId, page,
+                                base::Bind(&StoreData, &data, &called));
+    base::RunLoop().RunUntilIdle();
+    EXPECT_TRUE(called);
+    return data;
+  }
+
+  PrintPreviewDataService* service_;
+  // Stands in for the spill directory of the profile.
+  base::ScopedTempDir spill_dir_;
+
+ private:
+  content::TestBrowserThreadBundle thread_bundle_;
+};
+
+TEST_F(PrintPreviewDataServiceTest, LargeDocumentStaysWithinBudget) {
+  for (int page = 0; page < kPageCount; ++page) {
+    SetPage(page, kPageSize);
+    EXPECT_LE(service_->GetMemoryUsage(), kMemoryBudget);
+  }
+  EXPECT_EQ(kPageCount, service_->GetAvailableDraftPageCount(kPreviewUIId));
+  // Pages keep their memory until they are written.
+  EXPECT_TRUE(HasPageData(0, kPageSize, GetPage(0).get()));
+  base::RunLoop().RunUntilIdle();
+
+  // The last pages are still in memory, the first ones were spilled.
+  EXPECT_TRUE(HasPageData(kPageCount - 1, kPageSize,
+                          GetPage(kPageCount - 1).get()));
+  EXPECT_FALSE(GetPage(0).get());
+
+  // Every page can be read back, one at a time.
+  for (int page = 0; page < kPageCount; ++page) {
+    EXPECT_TRUE(HasPageData(page, kPageSize, GetPageAsync(page).get()))
+        << "page " << page;
+  }
+  EXPECT_LE(service_->GetMemoryUsage(), kMemoryBudget);
+}
+
+TEST_F(PrintPreviewDataServiceTest, CompleteDocumentIsKeptInMemory) {
+  for (int page = 0; page < 10; ++page)
+    SetPage(page, kPageSize);
+  SetPage(printing::COMPLETE_PREVIEW_DOCUMENT_INDEX, 2 * kMemoryBudget);
+
+  // The document does not count against the budget, so no page was spilled to
+  // make room for it, and it is available synchronously for printing.
+  EXPECT_EQ(10 * kPageSize, service_->GetMemoryUsage());
+  EXPECT_TRUE(HasPageData(printing::COMPLETE_PREVIEW_DOCUMENT_INDEX,
+                          2 * kMemoryBudget,
+                          GetPage(printing::COMPLETE_PREVIEW_DOCUMENT_INDEX)
+                              .get()));
+  EXPECT_TRUE(HasPageData(9, kPageSize, GetPage(9).get()));
+  EXPECT_EQ(10, service_->GetAvailableDraftPageCount(kPreviewUIId));
+
+  // Even when the budget leaves no room for pages.
+  service_->SetMemoryBudgetForTesting(0);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0U, service_->GetMemoryUsage());
+  EXPECT_TRUE(HasPageData(printing::COMPLETE_PREVIEW_DOCUMENT_INDEX,
+                          2 * kMemoryBudget,
+                          GetPage(printing::COMPLETE_PREVIEW_DOCUMENT_INDEX)
+                              .get()));
+  EXPECT_FALSE(GetPage(9).get());
+  EXPECT_TRUE(HasPageData(9, kPageSize, GetPageAsync(9).get()));
+}
+
+TEST_F(PrintPreviewDataServiceTest, OffTheRecordPagesAreNotSpilled) {
+  // Off-the-record previews have no spill directory.
+  for (int page = 0; page < 100; ++page) {
+    service_->SetDataEntry(kPreviewUIId, page, CreatePageData(page, kPageSize),
+                           base::FilePath());
+  }
+  EXPECT_EQ(100 * kPageSize, service_->GetMemoryUsage());
+  for (int page = 0; page < 100; ++page)
+    EXPECT_TRUE(HasPageData(page, kPageSize, GetPage(page).get()));
+}
+
+TEST_F(PrintPreviewDataServiceTest, ReplaceSpilledPage) {
+  SetPage(0, kPageSize);
+  service_->SetMemoryBudgetForTesting(0);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(GetPage(0).get());
+  EXPECT_EQ(0U, service_->GetMemoryUsage());
+
+  // New data for a spilled page replaces the data on disk.
+  service_->SetMemoryBudgetForTesting(kMemoryBudget);
+  SetPage(0, kPageSize / 2);
+  EXPECT_EQ(kPageSize / 2, service_->GetMemoryUsage());
+  EXPECT_TRUE(HasPageData(0, kPageSize / 2, GetPage(0).get()));
+  EXPECT_TRUE(HasPageData(0, kPageSize / 2, GetPageAsync(0).get()));
+}
+
+TEST_F(PrintPreviewDataServiceTest, RemoveEntryFreesMemory) {
+  for (int page = 0; page < 100; ++page)
+    SetPage(page, kPageSize);
+  EXPECT_LT(0U, service_->GetMemoryUsage());
+
+  service_->RemoveEntry(kPreviewUIId);
+  EXPECT_EQ(0U, service_->GetMemoryUsage());
+  EXPECT_EQ(0, service_->GetAvailableDraftPageCount(kPreviewUIId));
+  EXPECT_FALSE(GetPageAsync(0).get());
+}
+
+TEST_F(PrintPreviewDataServiceTest, ReplacePageBeingSpilled) {
+  SetPage(0, kPageSize);
+  service_->SetMemoryBudgetForTesting(0);
+  EXPECT_EQ(0U, service_->GetMemoryUsage());
+
+  // The write of the old data completes after the page was replaced.
+  service_->SetMemoryBudgetForTesting(kMemoryBudget);
+  SetPage(0, kPageSize / 2);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(kPageSize / 2, service_->GetMemoryUsage());
+  EXPECT_TRUE(HasPageData(0, kPageSize / 2, GetPage(0).get()));
+}
+
+TEST_F(PrintPreviewDataServiceTest, PagesStayInMemoryIfSpillFails) {
+  // A file where the spill directory should be makes every write fail.
+  base::FilePath spill_dir;
+  ASSERT_TRUE(base::CreateTemporaryFileInDir(spill_dir_.path(), &spill_dir));
+  for (int page = 0; page < 10; ++page) {
+    service_->SetDataEntry(kPreviewUIId, page, CreatePageData(page, kPageSize),
+                           spill_dir);
+  }
+  service_->SetMemoryBudgetForTesting(0);
+  base::RunLoop().RunUntilIdle();
+
+  // The pages are not spilled again.
+  service_->SetMemoryBudgetForTesting(0);
+  EXPECT_EQ(10 * kPageSize, service_->GetMemoryUsage());
+  for (int page = 0; page < 10; ++page)
+    EXPECT_TRUE(HasPageData(page, kPageSize, GetPage(page).get()));
+}
+
+TEST_F(PrintPreviewDataServiceTest, MissingPageIsNotRead) {
+  service_->SetDataEntry(kPreviewUIId, 0, NULL, spill_dir_.path());
+  EXPECT_EQ(1, service_->GetAvailableDraftPageCount(kPreviewUIId));
+  EXPECT_FALSE(GetPageAsync(0).get());
+}
+
+TEST_F(PrintPreviewDataServiceTest, DeleteSpillFiles) {
+  // Pages spilled by a session that crashed.
+  base::FilePath spill_dir =
+      PrintPreviewDataService::GetSpillDir(spill_dir_.path());
+  ASSERT_TRUE(base::CreateDirectory(spill_dir));
+  base::FilePath spill_file;
+  ASSERT_TRUE(base::CreateTemporaryFileInDir(spill_dir, &spill_file));
+
+  PrintPreviewDataService::DeleteSpillFiles(spill_dir_.path());
+  EXPECT_FALSE(base::PathExists(spill_file));
+  EXPECT_FALSE(base::PathExists(spill_dir));
+  EXPECT_TRUE(base::PathExists(spill_dir_.path()));
+}
@@ -146,6 +146,10 @@
 #include "extensions/browser/guest_view/guest_view_manager.h"
 #endif
 
+#if defined(ENABLE_FULL_PRINTING)
+#include "chrome/browser/printing/print_preview_data_service.h"
+#endif
+
 #if defined(ENABLE_MANAGED_USERS)
 #include "chrome/browser/supervised_user/supervised_user_settings_service.h"
 #include "chrome/browser/supervised_user/supervised_user_settings_service_factory.h"
@@ -716,6 +720,14 @@ void ProfileImpl::DoFinalInit() {
         base::Bind(&EnsureReadmeFile, GetPath()),
         base::TimeDelta::FromMilliseconds(create_readme_delay_ms));
 
+#if defined(ENABLE_FULL_PRINTING)
+  // Delete the print preview pages left on disk by a session that crashed.
+  // This is posted before any page of this session can be spilled.
+  BrowserThread::PostTask(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&PrintPreviewDataService::DeleteSpillFiles, GetPath()));
+#endif
+
   TRACE_EVENT0("browser", "ProfileImpl::SetSaveSessionStorageOnDisk");
   content::BrowserContext::GetDefaultStoragePartition(this)->
       GetDOMStorageContext()->SetSaveSessionStorageOnDisk();
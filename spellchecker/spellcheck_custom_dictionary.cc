@@ -11,6 +11,7 @@
 #include "base/md5.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
+#include "base/time/time.h"
 #include "chrome/browser/spellchecker/spellcheck_host_metrics.h"
 #include "chrome/common/chrome_constants.h"
 #include "chrome/common/spellcheck_messages.h"
@@ -29,9 +30,25 @@ namespace {
 // Filename extension for backup dictionary file.
 const base::FilePath::CharType BACKUP_EXTENSION[] = FILE_PATH_LITERAL("backup");
 
+// Filename extension for the journal of changes to the dictionary file.
+const base::FilePath::CharType JOURNAL_EXTENSION[] =
+    FILE_PATH_LITERAL("journal");
+
 // Prefix for the checksum in the dictionary file.
 const char CHECKSUM_PREFIX[] = "checksum_v1 = ";
 
+// Operations in the journal records.
+const char JOURNAL_ADD_WORD = '+';
+const char JOURNAL_REMOVE_WORD = '-';
+
+// The length of the hex MD5 checksum at the start of each journal record.
+const size_t JOURNAL_CHECKSUM_LENGTH = 32;
+
+// The journal is compacted into the dictionary file once it is larger than
+// both this and the dictionary file. Small dictionaries would otherwise be
+// rewritten every few changes.
+const int64 MIN_JOURNAL_BYTES_TO_COMPACT = 4096;
+
 // The status of the checksum in a custom spellcheck dictionary.
 enum ChecksumStatus {
   VALID_CHECKSUM,
@@ -106,8 +123,9 @@ void LoadDictionaryFileReliably(WordList& custom_words,
 }
 
 // Backs up the original dictionary, saves |custom_words| and its checksum into
-// the custom spellcheck dictionary at |path|.
-void SaveDictionaryFileReliably(
+// the custom spellcheck dictionary at |path|. Returns the number of bytes
+// written.
+int64 SaveDictionaryFileReliably(
     const WordList& custom_words,
     const base::FilePath& path) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
@@ -121,6 +139,84 @@ void SaveDictionaryFileReliably(
   content << CHECKSUM_PREFIX << checksum;
   base::CopyFile(path, path.AddExtension(BACKUP_EXTENSION));
   base::ImportantFileWriter::WriteFileAtomically(path, content.str());
+  return static_cast<int64>(content.str().size());
+}
+
+// Appends a journal record for |operation| on |word| to |records|.
+void AppendJournalRecord(char operation,
+                         const std::string& word,
+                         std::string* records) {
+  std::string record = operation + word;
+  records->append(base::MD5String(record));
+  records->push_back(' ');
+  records->append(record);
+  records->push_back('\n');
+}
+
+// Replays the journal at |journal_path| onto |custom_words|, which becomes
+// sorted and free of duplicates if the journal has any records. Stops at the
+// first record that fails its checksum, which is where a write to the journal
+// was interrupted. Returns false if such a record was found.
+bool ReplayJournal(const base::FilePath& journal_path, WordList& custom_words) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  std::string contents;
+  if (!base::ReadFileToString(journal_path, &contents) || contents.empty())
+    return true;
+
+  WordSet words(custom_words.begin(), custom_words.end());
+  bool valid = true;
+  size_t pos = 0;
+  while (pos < contents.size()) {
+    size_t end = contents.find('\n', pos);
+    if (end == std::string::npos ||
+        end < pos + JOURNAL_CHECKSUM_LENGTH + 2 ||
+        contents[pos + JOURNAL_CHECKSUM_LENGTH] != ' ') {
+      valid = false;
+      break;
+    }
+    std::string record = contents.substr(
+        pos + JOURNAL_CHECKSUM_LENGTH + 1,
+        end - pos - JOURNAL_CHECKSUM_LENGTH - 1);
+    if (contents.compare(pos, JOURNAL_CHECKSUM_LENGTH,
+                         base::MD5String(record)) != 0) {
+      valid = false;
+      break;
+    }
+    if (record[0] == JOURNAL_ADD_WORD)
+      words.insert(record.substr(1));
+    else if (record[0] == JOURNAL_REMOVE_WORD)
+      words.erase(record.substr(1));
+    pos = end + 1;
+  }
+  custom_words.assign(words.begin(), words.end());
+  return valid;
+}
+
+// Returns true if the journal at |journal_path| has grown large enough to be
+// folded into the dictionary file at |path|.
+bool ShouldCompactJournal(const base::FilePath& path,
+                          const base::FilePath& journal_path) {
+  int64 journal_size = 0;
+  if (!base::GetFileSize(journal_path, &journal_size) ||
+      journal_size <= MIN_JOURNAL_BYTES_TO_COMPACT) {
+    return false;
+  }
+  int64 dictionary_size = 0;
+  return !base::GetFileSize(path, &dictionary_size) ||
+      journal_size > dictionary_size;
+}
+
+// Saves |custom_words| into the dictionary file at |path| and deletes its
+// journal, which |custom_words| must already include. Replaying the journal
+// again is harmless if the browser stops before it is deleted. Returns the
+// number of bytes written.
+int64 CompactDictionaryFile(const WordList& custom_words,
+                            const base::FilePath& path,
+                            const base::FilePath& journal_path) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  int64 bytes_written = SaveDictionaryFileReliably(custom_words, path);
+  base::DeleteFile(journal_path, false);
+  return bytes_written;
 }
 
 // Removes duplicate and invalid words from |to_add| word list and sorts it.
@@ -257,7 +353,7 @@ bool SpellcheckCustomDictionary::RemoveWord(const std::string& word) {
 }
 
 bool SpellcheckCustomDictionary::HasWord(const std::string& word) const {
-  return !!words_.count(word);
+  return word_lookup_.find(word) != word_lookup_.end();
 }
 
 void SpellcheckCustomDictionary::AddObserver(Observer* observer) {
@@ -396,10 +492,21 @@ syncer::SyncError SpellcheckCustomDictionary::ProcessSyncChanges(
 WordList SpellcheckCustomDictionary::LoadDictionaryFile(
     const base::FilePath& path) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::FilePath journal_path = path.AddExtension(JOURNAL_EXTENSION);
   WordList words;
   LoadDictionaryFileReliably(words, path);
-  if (!words.empty() && VALID_CHANGE != SanitizeWordsToAdd(WordSet(), words))
-    SaveDictionaryFileReliably(words, path);
+  bool journal_valid = ReplayJournal(journal_path, words);
+  bool sanitized =
+      !words.empty() && VALID_CHANGE != SanitizeWordsToAdd(WordSet(), words);
+  // Later records would be lost behind an interrupted record, so the journal
+  // must be compacted before anything is appended to it.
+  if (sanitized || !journal_valid ||
+      ShouldCompactJournal(path, journal_path)) {
+    CompactDictionaryFile(words, path, journal_path);
+  }
+  SpellCheckHostMetrics::RecordCustomDictionaryLoadTime(
+      base::TimeTicks::Now() - start);
   SpellCheckHostMetrics::RecordCustomWordCountStats(words.size());
   return words;
 }
@@ -412,22 +519,48 @@ void SpellcheckCustomDictionary::UpdateDictionaryFile(
   if (dictionary_change.empty())
     return;
 
-  WordList custom_words;
-  LoadDictionaryFileReliably(custom_words, path);
-
-  // Add words.
-  custom_words.insert(custom_words.end(),
-                      dictionary_change.to_add().begin(),
-                      dictionary_change.to_add().end());
-
-  // Remove words.
-  std::sort(custom_words.begin(), custom_words.end());
-  WordList remaining =
-      base::STLSetDifference<WordList>(custom_words,
-                                       dictionary_change.to_remove());
-  std::swap(custom_words, remaining);
+  // Words are added before they are removed, like in Apply().
+  std::string records;
+  for (WordList::const_iterator it = dictionary_change.to_add().begin();
+       it != dictionary_change.to_add().end();
+       ++it) {
+    AppendJournalRecord(JOURNAL_ADD_WORD, *it, &records);
+  }
+  for (WordList::const_iterator it = dictionary_change.to_remove().begin();
+       it != dictionary_change.to_remove().end();
+       ++it) {
+    AppendJournalRecord(JOURNAL_REMOVE_WORD, *it, &records);
+  }
 
-  SaveDictionaryFileReliably(custom_words, path);
+  base::FilePath journal_path = path.AddExtension(JOURNAL_EXTENSION);
+  int size = static_cast<int>(records.size());
+  bool appended = base::PathExists(journal_path) ?
+      base::AppendToFile(journal_path, records.data(), size) == size :
+      base::WriteFile(journal_path, records.data(), size) == size;
+  int64 bytes_written = size;
+  bool compact = !appended || ShouldCompactJournal(path, journal_path);
+  if (compact) {
+    // A partly appended record fails its checksum when replayed, and so does
+    // everything after it, so a failed append is folded in right away.
+    WordList custom_words;
+    LoadDictionaryFileReliably(custom_words, path);
+    ReplayJournal(journal_path, custom_words);
+    if (!appended) {
+      custom_words.insert(custom_words.end(),
+                          dictionary_change.to_add().begin(),
+                          dictionary_change.to_add().end());
+      std::sort(custom_words.begin(), custom_words.end());
+      custom_words.erase(std::unique(custom_words.begin(), custom_words.end()),
+                         custom_words.end());
+      WordList remaining =
+          base::STLSetDifference<WordList>(custom_words,
+                                           dictionary_change.to_remove());
+      std::swap(custom_words, remaining);
+    }
+    bytes_written += CompactDictionaryFile(custom_words, path, journal_path);
+  }
+  SpellCheckHostMetrics::RecordCustomDictionaryBytesWritten(bytes_written,
+                                                            compact);
 }
 
 void SpellcheckCustomDictionary::OnLoaded(WordList custom_words) {
@@ -446,12 +579,19 @@ void SpellcheckCustomDictionary::Apply(
   if (!dictionary_change.to_add().empty()) {
     words_.insert(dictionary_change.to_add().begin(),
                   dictionary_change.to_add().end());
+    word_lookup_.insert(dictionary_change.to_add().begin(),
+                        dictionary_change.to_add().end());
   }
   if (!dictionary_change.to_remove().empty()) {
     WordSet updated_words =
         base::STLSetDifference<WordSet>(words_,
                                         dictionary_change.to_remove());
     std::swap(words_, updated_words);
+    for (WordList::const_iterator it = dictionary_change.to_remove().begin();
+         it != dictionary_change.to_remove().end();
+         ++it) {
+      word_lookup_.erase(*it);
+    }
   }
 }
 
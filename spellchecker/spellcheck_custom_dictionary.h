@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "base/containers/hash_tables.h"
 #include "base/files/file_path.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
@@ -24,6 +25,16 @@
 //   foo
 //   checksum_v1 = ec3df4034567e59e119fcf87f2d9bad4
 //
+// Changes are appended to a journal next to the dictionary file instead of
+// rewriting it. Each journal record adds ('+') or removes ('-') a word and
+// starts with the checksum of the rest of the record:
+//
+//   4ad1d5105c265d0680955dead60df126 +baz
+//   313e930ca20dbaa345e1b8e55bd3beb5 -foo
+//
+// The journal is folded back into the dictionary file once it grows larger
+// than the dictionary file, or when a record fails its checksum.
+//
 class SpellcheckCustomDictionary : public SpellcheckDictionary,
                                    public syncer::SyncableService {
  public:
@@ -123,6 +134,7 @@ class SpellcheckCustomDictionary : public SpellcheckDictionary,
 
  private:
   friend class DictionarySyncIntegrationTestHelper;
+  friend class SpellcheckCustomDictionaryPerfTest;
   friend class SpellcheckCustomDictionaryTest;
 
   // Returns the list of words in the custom spellcheck dictionary at |path|.
@@ -132,7 +144,9 @@ class SpellcheckCustomDictionary : public SpellcheckDictionary,
       const base::FilePath& path);
 
   // Applies the change in |dictionary_change| to the custom spellcheck
-  // dictionary. Assumes that |dictionary_change| has been sanitized.
+  // dictionary by appending it to the journal, and compacts the journal into
+  // the dictionary file if it has grown too large. Assumes that
+  // |dictionary_change| has been sanitized.
   static void UpdateDictionaryFile(
       const Change& dictionary_change,
       const base::FilePath& path);
@@ -163,6 +177,9 @@ class SpellcheckCustomDictionary : public SpellcheckDictionary,
   // In-memory cache of the custom words file.
   chrome::spellcheck_common::WordSet words_;
 
+  // The same words as |words_|, for HasWord() to look up quickly.
+  base::hash_set<std::string> word_lookup_;
+
   // A path for custom dictionary.
   base::FilePath custom_dictionary_path_;
 
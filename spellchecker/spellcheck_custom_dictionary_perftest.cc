@@ -0,0 +1,84 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/spellchecker/spellcheck_custom_dictionary.h"
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "chrome/common/chrome_constants.h"
+#include "chrome/common/spellcheck_common.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using chrome::spellcheck_common::WordList;
+using chrome::spellcheck_common::WordSet;
+
+class SpellcheckCustomDictionaryPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  WordList LoadDictionaryFile(const base::FilePath& path) {
+    return SpellcheckCustomDictionary::LoadDictionaryFile(path);
+  }
+
+  void UpdateDictionaryFile(
+      const SpellcheckCustomDictionary::Change& dictionary_change,
+      const base::FilePath& path) {
+    SpellcheckCustomDictionary::UpdateDictionaryFile(dictionary_change, path);
+  }
+
+  content::TestBrowserThreadBundle thread_bundle_;
+  base::ScopedTempDir temp_dir_;
+};
+
+// Measures saving words one at a time to a dictionary imported from sync, and
+// loading it back with the journal.
+TEST_F(SpellcheckCustomDictionaryPerfTest, LargeDictionaryWriteAndLoad) {
+  static const int kNumWords = 5000;
+  static const int kNumChanges = 100;
+  base::FilePath path =
+      temp_dir_.path().Append(chrome::kCustomDictionaryFileName);
+  base::FilePath journal_path = path.AddExtension(FILE_PATH_LITERAL("journal"));
+
+  SpellcheckCustomDictionary::Change initial;
+  for (int i = 0; i < kNumWords; ++i)
+    initial.AddWord("imported" + base::IntToString(100000 + i));
+  initial.Sanitize(WordSet());
+  UpdateDictionaryFile(initial, path);
+  int64 dictionary_size = 0;
+  ASSERT_TRUE(base::GetFileSize(path, &dictionary_size));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumChanges; ++i) {
+    SpellcheckCustomDictionary::Change change;
+    change.AddWord("added" + base::IntToString(i));
+    UpdateDictionaryFile(change, path);
+  }
+  base::TimeDelta write_time = base::TimeTicks::Now() - start;
+  int64 journal_size = 0;
+  ASSERT_TRUE(base::GetFileSize(journal_path, &journal_size));
+
+  start = base::TimeTicks::Now();
+  WordList loaded_custom_words = LoadDictionaryFile(path);
+  base::TimeDelta load_time = base::TimeTicks::Now() - start;
+  EXPECT_EQ(static_cast<size_t>(kNumWords + kNumChanges),
+            loaded_custom_words.size());
+
+  perf_test::PrintResult("custom_dictionary_bytes_written", "", "per_change",
+                         static_cast<size_t>(journal_size / kNumChanges),
+                         "bytes", true);
+  perf_test::PrintResult("custom_dictionary_bytes_written", "", "rewrite",
+                         static_cast<size_t>(dictionary_size), "bytes",
+                         false);
+  perf_test::PrintResult("custom_dictionary_write", "", "per_change",
+                         write_time.InMillisecondsF() / kNumChanges, "ms",
+                         true);
+  perf_test::PrintResult("custom_dictionary_load", "", "with_journal",
+                         load_time.InMillisecondsF(), "ms", true);
+}
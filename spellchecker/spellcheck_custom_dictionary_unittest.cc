@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <vector>
 
 #include "base/file_util.h"
@@ -265,12 +266,15 @@ TEST_F(SpellcheckCustomDictionaryTest,
   EXPECT_EQ(expected, loaded_custom_words);
 }
 
-// Write to dictionary should backup previous version and write the word to the
-// end of the dictionary. If the dictionary file is corrupted on disk, the
-// previous version should be reloaded.
+// Write to dictionary should append the word to the journal and leave the
+// dictionary file alone. If the journal is corrupted on disk, the records
+// before the corruption should be reloaded and the journal compacted into the
+// dictionary file, which backs up the previous version. If the dictionary file
+// is corrupted on disk, the previous version should be reloaded.
 TEST_F(SpellcheckCustomDictionaryTest, CorruptedWriteShouldBeRecovered) {
   base::FilePath path =
       profile_.GetPath().Append(chrome::kCustomDictionaryFileName);
+  base::FilePath journal_path = path.AddExtension(FILE_PATH_LITERAL("journal"));
 
   std::string content = "foo\nbar";
   base::WriteFile(path, content.c_str(), content.length());
@@ -283,6 +287,22 @@ TEST_F(SpellcheckCustomDictionaryTest, CorruptedWriteShouldBeRecovered) {
   SpellcheckCustomDictionary::Change change;
   change.AddWord("baz");
   UpdateDictionaryFile(change, path);
+  std::string written;
+  base::ReadFileToString(path, &written);
+  EXPECT_EQ(content, written);
+
+  std::string journal;
+  base::ReadFileToString(journal_path, &journal);
+  journal.append("corruption");
+  base::WriteFile(journal_path, journal.c_str(), journal.length());
+  loaded_custom_words = LoadDictionaryFile(path);
+  WordList expected_with_baz;
+  expected_with_baz.push_back("bar");
+  expected_with_baz.push_back("baz");
+  expected_with_baz.push_back("foo");
+  EXPECT_EQ(expected_with_baz, loaded_custom_words);
+  EXPECT_FALSE(base::PathExists(journal_path));
+
   content.clear();
   base::ReadFileToString(path, &content);
   content.append("corruption");
@@ -291,6 +311,68 @@ TEST_F(SpellcheckCustomDictionaryTest, CorruptedWriteShouldBeRecovered) {
   EXPECT_EQ(expected, loaded_custom_words);
 }
 
+// The journal should be compacted into the dictionary file once it outgrows
+// it, without losing any words.
+TEST_F(SpellcheckCustomDictionaryTest, JournalShouldBeCompacted) {
+  base::FilePath path =
+      profile_.GetPath().Append(chrome::kCustomDictionaryFileName);
+  base::FilePath journal_path = path.AddExtension(FILE_PATH_LITERAL("journal"));
+
+  WordList expected;
+  int64 max_journal_size = 0;
+  for (int i = 0; i < 500; ++i) {
+    std::string word = "word" + base::IntToString(1000 + i);
+    SpellcheckCustomDictionary::Change change;
+    change.AddWord(word);
+    if (i % 5 == 4) {
+      change.RemoveWord(expected.back());
+      expected.pop_back();
+    }
+    expected.push_back(word);
+    UpdateDictionaryFile(change, path);
+    int64 journal_size = 0;
+    if (base::GetFileSize(journal_path, &journal_size))
+      max_journal_size = std::max(max_journal_size, journal_size);
+  }
+
+  int64 dictionary_size = 0;
+  ASSERT_TRUE(base::GetFileSize(path, &dictionary_size));
+  EXPECT_LT(0, max_journal_size);
+  EXPECT_GE(std::max(dictionary_size, static_cast<int64>(4096)) + 100,
+            max_journal_size);
+  EXPECT_EQ(expected, LoadDictionaryFile(path));
+}
+
+// Saving one word to a large dictionary should only write that word, not the
+// whole dictionary.
+TEST_F(SpellcheckCustomDictionaryTest, LargeDictionaryShouldOnlyAppendChanges) {
+  static const int kNumWords = 5000;
+  static const int kNumChanges = 100;
+  base::FilePath path =
+      profile_.GetPath().Append(chrome::kCustomDictionaryFileName);
+  base::FilePath journal_path = path.AddExtension(FILE_PATH_LITERAL("journal"));
+
+  SpellcheckCustomDictionary::Change initial;
+  for (int i = 0; i < kNumWords; ++i)
+    initial.AddWord("imported" + base::IntToString(100000 + i));
+  initial.Sanitize(WordSet());
+  UpdateDictionaryFile(initial, path);
+  int64 dictionary_size = 0;
+  ASSERT_TRUE(base::GetFileSize(path, &dictionary_size));
+
+  for (int i = 0; i < kNumChanges; ++i) {
+    SpellcheckCustomDictionary::Change change;
+    change.AddWord("added" + base::IntToString(i));
+    UpdateDictionaryFile(change, path);
+  }
+  int64 journal_size = 0;
+  ASSERT_TRUE(base::GetFileSize(journal_path, &journal_size));
+  EXPECT_GT(dictionary_size / 10, journal_size / kNumChanges);
+
+  EXPECT_EQ(static_cast<size_t>(kNumWords + kNumChanges),
+            LoadDictionaryFile(path).size());
+}
+
 TEST_F(SpellcheckCustomDictionaryTest,
        GetAllSyncDataAccuratelyReflectsDictionaryState) {
   SpellcheckCustomDictionary* dictionary =
@@ -1173,4 +1255,6 @@ TEST_F(SpellcheckCustomDictionaryTest, HasWord) {
   custom_dictionary->AddWord("foo");
   EXPECT_TRUE(custom_dictionary->HasWord("foo"));
   EXPECT_FALSE(custom_dictionary->HasWord("bar"));
+  custom_dictionary->RemoveWord("foo");
+  EXPECT_FALSE(custom_dictionary->HasWord("foo"));
 }
@@ -33,6 +33,21 @@ void SpellCheckHostMetrics::RecordCustomWordCountStats(size_t count) {
   UMA_HISTOGRAM_COUNTS("SpellCheck.CustomWords", count);
 }
 
+// static
+void SpellCheckHostMetrics::RecordCustomDictionaryLoadTime(
+    base::TimeDelta load_time) {
+  UMA_HISTOGRAM_TIMES("SpellCheck.CustomDictionary.LoadTime", load_time);
+}
+
+// static
+void SpellCheckHostMetrics::RecordCustomDictionaryBytesWritten(
+    int64 bytes,
+    bool compacted) {
+  UMA_HISTOGRAM_COUNTS("SpellCheck.CustomDictionary.BytesWrittenPerChange",
+                       static_cast<int>(bytes));
+  UMA_HISTOGRAM_BOOLEAN("SpellCheck.CustomDictionary.Compacted", compacted);
+}
+
 void SpellCheckHostMetrics::RecordEnabledStats(bool enabled) {
   UMA_HISTOGRAM_BOOLEAN("SpellCheck.Enabled", enabled);
   // Because SpellCheckHost is instantiated lazily, the size of
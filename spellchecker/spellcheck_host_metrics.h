@@ -35,6 +35,14 @@ class SpellCheckHostMetrics {
   // to be uploaded via UMA.
   static void RecordCustomWordCountStats(size_t count);
 
+  // Collects the time it took to load the custom dictionary and replay its
+  // journal, which is to be uploaded via UMA.
+  static void RecordCustomDictionaryLoadTime(base::TimeDelta load_time);
+
+  // Collects the number of bytes written to disk to save one change to the
+  // custom dictionary, which is to be uploaded via UMA.
+  static void RecordCustomDictionaryBytesWritten(int64 bytes, bool compacted);
+
   // Collects status of spellchecking enabling state, which is
   // to be uploaded via UMA
   void RecordEnabledStats(bool enabled);
@@ -4,6 +4,8 @@
 
 #include "chrome/browser/sync_file_system/drive_backend/sync_task_manager.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/location.h"
 #include "base/memory/scoped_ptr.h"
@@ -36,6 +38,12 @@ class SyncTaskAdapter : public ExclusiveTask {
 
 }  // namespace
 
+SyncTaskManager::Stats::Stats()
+    : completed_task_count(0),
+      completed_background_task_count(0),
+      blocked_task_count(0),
+      max_parallel_background_task_count(0) {}
+
 SyncTaskManager::PendingTask::PendingTask() {}
 
 SyncTaskManager::PendingTask::PendingTask(
@@ -58,6 +66,7 @@ SyncTaskManager::SyncTaskManager(
     base::SequencedTaskRunner* task_runner)
     : client_(client),
       maximum_background_task_(maximum_background_task),
+      exclusive_task_parked_(false),
       pending_task_seq_(0),
       task_token_seq_(SyncTaskToken::kMinimumBackgroundTaskTokenID),
       task_runner_(task_runner) {
@@ -209,7 +218,7 @@ void SyncTaskManager::NotifyTaskDoneBody(scoped_ptr<SyncTaskToken> token,
            << " " << token->location().ToString();
 
   if (token->blocking_factor()) {
-    dependency_manager_.Erase(token->blocking_factor());
+    ReleaseBlockingFactor(token->blocking_factor());
     token->clear_blocking_factor();
   }
 
@@ -228,8 +237,13 @@ void SyncTaskManager::NotifyTaskDoneBody(scoped_ptr<SyncTaskToken> token,
     task = running_foreground_task_.Pass();
   } else {
     task = running_background_tasks_.take_and_erase(token->token_id());
+    if (task)
+      ++stats_.completed_background_task_count;
   }
 
+  if (task)
+    ++stats_.completed_task_count;
+
   // Acquire the token to prevent a new task to jump into the queue.
   token = token_.Pass();
 
@@ -270,17 +284,23 @@ void SyncTaskManager::UpdateBlockingFactorBody(
 
   // Clear existing |blocking_factor| from |dependency_manager_| before
   // getting |foreground_task_token|, so that we can avoid dead lock.
+  bool woke_up_blocked_task = false;
   if (background_task_token && background_task_token->blocking_factor()) {
-    dependency_manager_.Erase(background_task_token->blocking_factor());
+    woke_up_blocked_task =
+        ReleaseBlockingFactor(background_task_token->blocking_factor());
     background_task_token->clear_blocking_factor();
   }
 
   // Try to get |foreground_task_token|.  If it's not available, wait for
-  // current foreground task to finish.
+  // current foreground task to finish.  If releasing the previous
+  // |blocking_factor| woke up blocked tasks, queue up behind them so that they
+  // don't starve.
   if (!foreground_task_token) {
     DCHECK(background_task_token);
-    foreground_task_token = GetToken(background_task_token->location(),
-                                     SyncStatusCallback());
+    if (!woke_up_blocked_task) {
+      foreground_task_token = GetToken(background_task_token->location(),
+                                       SyncStatusCallback());
+    }
     if (!foreground_task_token) {
       PushPendingTask(
           base::Bind(&SyncTaskManager::UpdateBlockingFactorBody,
@@ -298,29 +318,59 @@ void SyncTaskManager::UpdateBlockingFactorBody(
 
   // Check if the task can run as a background task now.
   // If there are too many task running or any other task blocks current
-  // task, wait for any other task to finish.
+  // task, park the task until any other task releases its |blocking_factor|.
+  // A parked task doesn't hold the foreground slot, so that independent tasks
+  // can start meanwhile.  Once an exclusive task is parked, no other task is
+  // admitted until it runs, as the exclusive task can only start after all
+  // running tasks are done.
+  bool is_blocked_task =
+      background_task_token &&
+      blocked_tasks_.contains(background_task_token->token_id());
   bool task_number_limit_exceeded =
-      !background_task_token &&
+      (!background_task_token || is_blocked_task) &&
       running_background_tasks_.size() >= maximum_background_task_;
-  if (task_number_limit_exceeded ||
+  if (task_number_limit_exceeded || exclusive_task_parked_ ||
       !dependency_manager_.Insert(blocking_factor.get())) {
     DCHECK(!running_background_tasks_.empty());
-    DCHECK(pending_backgrounding_task_.is_null());
+    ++stats_.blocked_task_count;
+    if (blocking_factor->exclusive)
+      exclusive_task_parked_ = true;
+
+    if (!background_task_token) {
+      tracked_objects::Location from_here = foreground_task_token->location();
+      SyncStatusCallback callback = foreground_task_token->callback();
+      foreground_task_token->clear_callback();
+
+      background_task_token =
+          SyncTaskToken::CreateForBackgroundTask(
+              AsWeakPtr(),
+              task_runner_,
+              task_token_seq_++,
+              scoped_ptr<BlockingFactor>());
+      background_task_token->UpdateTask(from_here, callback);
+      blocked_tasks_.set(background_task_token->token_id(),
+                         running_foreground_task_.Pass());
+    }
 
-    // Wait for NotifyTaskDone to release a |blocking_factor|.
-    pending_backgrounding_task_ =
+    ParkBlockedTask(
+        foreground_task_token.Pass(),
         base::Bind(&SyncTaskManager::UpdateBlockingFactorBody,
                    AsWeakPtr(),
-                   base::Passed(&foreground_task_token),
+                   base::Passed(scoped_ptr<SyncTaskToken>()),
                    base::Passed(&background_task_token),
                    base::Passed(&task_log),
                    base::Passed(&blocking_factor),
-                   continuation);
+                   continuation));
     return;
   }
 
   if (background_task_token) {
     background_task_token->set_blocking_factor(blocking_factor.Pass());
+    if (is_blocked_task) {
+      int64 token_id = background_task_token->token_id();
+      running_background_tasks_.set(
+          token_id, blocked_tasks_.take_and_erase(token_id));
+    }
   } else {
     tracked_objects::Location from_here = foreground_task_token->location();
     SyncStatusCallback callback = foreground_task_token->callback();
@@ -337,6 +387,10 @@ void SyncTaskManager::UpdateBlockingFactorBody(
                                   running_foreground_task_.Pass());
   }
 
+  stats_.max_parallel_background_task_count =
+      std::max(stats_.max_parallel_background_task_count,
+               running_background_tasks_.size());
+
   token_ = foreground_task_token.Pass();
   MaybeStartNextForegroundTask(scoped_ptr<SyncTaskToken>());
   background_task_token->SetTaskLog(task_log.Pass());
@@ -361,6 +415,40 @@ void SyncTaskManager::PushPendingTask(
   pending_tasks_.push(PendingTask(closure, priority, pending_task_seq_++));
 }
 
+void SyncTaskManager::ParkBlockedTask(
+    scoped_ptr<SyncTaskToken> foreground_task_token,
+    const base::Closure& blocked_task) {
+  DCHECK(sequence_checker_.CalledOnValidSequencedThread());
+  DCHECK(foreground_task_token);
+  DCHECK(!token_);
+
+  pending_backgrounding_tasks_.push_back(blocked_task);
+  token_ = foreground_task_token.Pass();
+  MaybeStartNextForegroundTask(scoped_ptr<SyncTaskToken>());
+}
+
+bool SyncTaskManager::ReleaseBlockingFactor(
+    const BlockingFactor* blocking_factor) {
+  DCHECK(sequence_checker_.CalledOnValidSequencedThread());
+
+  dependency_manager_.Erase(blocking_factor);
+  if (pending_backgrounding_tasks_.empty())
+    return false;
+
+  // The parked exclusive task, if any, is retried first and parks again if it
+  // still can't run.
+  exclusive_task_parked_ = false;
+
+  // Retry parked tasks in the order they were blocked, prior to other
+  // pending tasks.
+  std::deque<base::Closure> blocked_tasks;
+  blocked_tasks.swap(pending_backgrounding_tasks_);
+  for (std::deque<base::Closure>::const_iterator itr = blocked_tasks.begin();
+       itr != blocked_tasks.end(); ++itr)
+    PushPendingTask(*itr, PRIORITY_HIGH);
+  return true;
+}
+
 void SyncTaskManager::RunTask(scoped_ptr<SyncTaskToken> token,
                               scoped_ptr<SyncTask> task) {
   DCHECK(sequence_checker_.CalledOnValidSequencedThread());
@@ -379,13 +467,6 @@ void SyncTaskManager::MaybeStartNextForegroundTask(
     token_ = token.Pass();
   }
 
-  if (!pending_backgrounding_task_.is_null()) {
-    base::Closure closure = pending_backgrounding_task_;
-    pending_backgrounding_task_.Reset();
-    closure.Run();
-    return;
-  }
-
   if (!token_)
     return;
 
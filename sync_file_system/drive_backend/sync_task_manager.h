@@ -5,6 +5,7 @@
 #ifndef CHROME_BROWSER_SYNC_FILE_SYSTEM_DRIVE_BACKEND_SYNC_TASK_MANAGER_H_
 #define CHROME_BROWSER_SYNC_FILE_SYSTEM_DRIVE_BACKEND_SYNC_TASK_MANAGER_H_
 
+#include <deque>
 #include <queue>
 #include <vector>
 
@@ -39,7 +40,9 @@ struct BlockingFactor;
 // background tasks.  Running background task has a BlockingFactor that
 // describes which task can run in parallel.  When a task start running as a
 // background task, SyncTaskManager checks if any running background task
-// doesn't block the new background task, and queues it up if it can't run.
+// doesn't block the new background task, and parks it if it can't run.
+// A parked task doesn't occupy the foreground slot, so that tasks that don't
+// conflict with any running task can start while it is waiting.
 class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
  public:
   typedef base::Callback<void(const SyncStatusCallback& callback)> Task;
@@ -51,6 +54,24 @@ class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
     PRIORITY_HIGH,
   };
 
+  // Throughput counters of the scheduler.
+  struct Stats {
+    // Number of tasks that have finished, including background tasks.
+    int64 completed_task_count;
+
+    // Number of tasks that have finished as a background task.
+    int64 completed_background_task_count;
+
+    // Number of times a task was parked because a running background task
+    // blocked it or the number of background tasks hit the limit.
+    int64 blocked_task_count;
+
+    // Maximum number of background tasks that have run at the same time.
+    size_t max_parallel_background_task_count;
+
+    Stats();
+  };
+
   class Client {
    public:
     virtual ~Client() {}
@@ -119,6 +140,11 @@ class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
 
   bool IsRunningTask(int64 task_token_id) const;
 
+  const Stats& stats() const { return stats_; }
+  size_t running_background_task_count() const {
+    return running_background_tasks_.size();
+  }
+
   void DetachFromSequence();
 
  private:
@@ -159,6 +185,16 @@ class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
 
   void PushPendingTask(const base::Closure& closure, Priority priority);
 
+  // Parks a task that is waiting for a BlockingFactor so that it doesn't hold
+  // the foreground slot, and lets the next foreground task run.
+  // |blocked_task| is run again after any BlockingFactor is released.
+  void ParkBlockedTask(scoped_ptr<SyncTaskToken> foreground_task_token,
+                       const base::Closure& blocked_task);
+
+  // Releases |blocking_factor| from |dependency_manager_| and moves all parked
+  // tasks back to |pending_tasks_|.  Returns true if any task is woken up.
+  bool ReleaseBlockingFactor(const BlockingFactor* blocking_factor);
+
   void RunTask(scoped_ptr<SyncTaskToken> token,
                scoped_ptr<SyncTask> task);
 
@@ -175,10 +211,19 @@ class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
   // deletion.
   base::ScopedPtrHashMap<int64, SyncTask> running_background_tasks_;
 
+  // Owns SyncTask that is waiting to be backgrounded.  The task is moved to
+  // |running_background_tasks_| once its BlockingFactor is acquired.
+  base::ScopedPtrHashMap<int64, SyncTask> blocked_tasks_;
+
   size_t maximum_background_task_;
 
-  // Holds pending continuation to move task to background.
-  base::Closure pending_backgrounding_task_;
+  // Holds pending continuations to move tasks to background.  They are retried
+  // in FIFO order each time a BlockingFactor is released.
+  std::deque<base::Closure> pending_backgrounding_tasks_;
+
+  // True while a task with an exclusive BlockingFactor is parked.  New tasks
+  // are parked behind it instead of being admitted, so that it doesn't starve.
+  bool exclusive_task_parked_;
 
   std::priority_queue<PendingTask, std::vector<PendingTask>,
                       PendingTaskComparator> pending_tasks_;
@@ -194,6 +239,8 @@ class SyncTaskManager : public base::SupportsWeakPtr<SyncTaskManager> {
 
   TaskDependencyManager dependency_manager_;
 
+  Stats stats_;
+
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
   base::SequenceChecker sequence_checker_;
 
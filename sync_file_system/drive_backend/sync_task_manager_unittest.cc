@@ -194,7 +194,11 @@ class BackgroundTask : public SyncTask {
   virtual void RunPreflight(scoped_ptr<SyncTaskToken> token) OVERRIDE {
     scoped_ptr<BlockingFactor> blocking_factor(new BlockingFactor);
     blocking_factor->app_id = app_id_;
-    blocking_factor->paths.push_back(path_);
+    // A task without |path_| blocks all other tasks.
+    if (path_.empty())
+      blocking_factor->exclusive = true;
+    else
+      blocking_factor->paths.push_back(path_);
 
     SyncTaskManager::UpdateBlockingFactor(
         token.Pass(), blocking_factor.Pass(),
@@ -599,6 +603,105 @@ TEST(SyncTaskManagerTest, BackgroundTask_Throttled) {
   EXPECT_EQ(2, stats.max_parallel_task);
 }
 
+TEST(SyncTaskManagerTest, BackgroundTask_NotStalledByBlockedTask) {
+  base::MessageLoop message_loop;
+  SyncTaskManager task_manager(base::WeakPtr<SyncTaskManager::Client>(),
+                               10 /* maximum_background_task */,
+                               base::ThreadTaskRunnerHandle::Get());
+  task_manager.Initialize(SYNC_STATUS_OK);
+
+  SyncStatusCode status = SYNC_STATUS_FAILED;
+  BackgroundTask::Stats stats;
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", MAKE_PATH("/hoge"),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  // Blocked by the first task.
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", MAKE_PATH("/hoge/fuga"),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  // Independent from others.  This should not wait for the blocked task.
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", MAKE_PATH("/piyo"),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  message_loop.RunUntilIdle();
+
+  EXPECT_EQ(SYNC_STATUS_OK, status);
+  EXPECT_EQ(0, stats.running_background_task);
+  EXPECT_EQ(3, stats.finished_task);
+  EXPECT_EQ(2, stats.max_parallel_task);
+
+  EXPECT_EQ(3, task_manager.stats().completed_task_count);
+  EXPECT_EQ(3, task_manager.stats().completed_background_task_count);
+  EXPECT_EQ(1, task_manager.stats().blocked_task_count);
+  EXPECT_EQ(2u, task_manager.stats().max_parallel_background_task_count);
+  EXPECT_EQ(0u, task_manager.running_background_task_count());
+}
+
+TEST(SyncTaskManagerTest, BackgroundTask_ExclusiveTaskNotStarved) {
+  base::MessageLoop message_loop;
+  SyncTaskManager task_manager(base::WeakPtr<SyncTaskManager::Client>(),
+                               10 /* maximum_background_task */,
+                               base::ThreadTaskRunnerHandle::Get());
+  task_manager.Initialize(SYNC_STATUS_OK);
+
+  SyncStatusCode status = SYNC_STATUS_FAILED;
+  BackgroundTask::Stats stats;
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", MAKE_PATH("/hoge"),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  // Exclusive, so this waits for the first task.
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", base::FilePath(),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  // Independent from the first task, but this should queue up behind the
+  // exclusive task instead of running in parallel with the first one.
+  task_manager.ScheduleSyncTask(
+      FROM_HERE,
+      scoped_ptr<SyncTask>(new BackgroundTask(
+          "app_id", MAKE_PATH("/piyo"),
+          &stats)),
+      SyncTaskManager::PRIORITY_MED,
+      CreateResultReceiver(&status));
+
+  message_loop.RunUntilIdle();
+
+  EXPECT_EQ(SYNC_STATUS_OK, status);
+  EXPECT_EQ(0, stats.running_background_task);
+  EXPECT_EQ(3, stats.finished_task);
+  EXPECT_EQ(1, stats.max_parallel_task);
+
+  EXPECT_EQ(3, task_manager.stats().completed_task_count);
+  EXPECT_EQ(3, task_manager.stats().completed_background_task_count);
+  EXPECT_LT(0, task_manager.stats().blocked_task_count);
+  EXPECT_EQ(1u, task_manager.stats().max_parallel_background_task_count);
+  EXPECT_EQ(0u, task_manager.running_background_task_count());
+}
+
 TEST(SyncTaskManagerTest, UpdateBlockingFactor) {
   base::MessageLoop message_loop;
   SyncTaskManager task_manager(base::WeakPtr<SyncTaskManager::Client>(),
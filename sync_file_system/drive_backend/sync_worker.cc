@@ -7,6 +7,8 @@
 #include <vector>
 
 #include "base/bind.h"
+#include "base/command_line.h"
+#include "base/strings/string_number_conversions.h"
 #include "chrome/browser/drive/drive_service_interface.h"
 #include "chrome/browser/extensions/extension_service.h"
 #include "chrome/browser/sync_file_system/drive_backend/callback_helper.h"
@@ -34,6 +36,23 @@ namespace drive_backend {
 
 namespace {
 
+// Specifies the maximum number of SyncTasks that run in parallel as background
+// tasks.  Zero runs all tasks sequentially.
+const char kMaxParallelSyncTasks[] = "syncfs-max-parallel-tasks";
+
+// Tasks that touch different files of an app run in parallel up to this
+// number, unless overridden by |kMaxParallelSyncTasks|.
+const size_t kDefaultMaxParallelSyncTasks = 4;
+
+size_t GetMaximumBackgroundTask() {
+  std::string value = CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+      kMaxParallelSyncTasks);
+  size_t maximum_background_task = 0;
+  if (value.empty() || !base::StringToSizeT(value, &maximum_background_task))
+    return kDefaultMaxParallelSyncTasks;
+  return maximum_background_task;
+}
+
 void EmptyStatusCallback(SyncStatusCode status) {}
 
 void InvokeIdleCallback(const base::Closure& idle_callback,
@@ -72,7 +91,7 @@ void SyncWorker::Initialize(scoped_ptr<SyncEngineContext> context) {
   context_ = context.Pass();
 
   task_manager_.reset(new SyncTaskManager(
-      weak_ptr_factory_.GetWeakPtr(), 0 /* maximum_background_task */,
+      weak_ptr_factory_.GetWeakPtr(), GetMaximumBackgroundTask(),
       context_->GetWorkerTaskRunner()));
   task_manager_->Initialize(SYNC_STATUS_OK);
 
@@ -0,0 +1,238 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/task_manager/process_metrics_sampler.h"
+
+#include <set>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/process/process_metrics.h"
+#include "base/sequenced_task_runner.h"
+#include "base/stl_util.h"
+#include "base/task_runner_util.h"
+
+#if defined(OS_MACOSX)
+#include "content/public/browser/browser_child_process_host.h"
+#endif
+
+namespace task_manager {
+
+namespace {
+
+// Memory usage is read on every kMemorySamplePeriod-th pass, and on the first
+// pass that includes a process.
+const int kMemorySamplePeriod = 5;
+
+}  // namespace
+
+// The handles that the sampler opened for new processes, keyed by the caller's
+// handle. The handles that are not taken by the sampler are closed, e.g. if
+// the sampling task is skipped on shutdown.
+class ProcessMetricsSampler::OwnedHandles {
+ public:
+  OwnedHandles() {}
+
+  ~OwnedHandles() {
+    for (HandleMap::iterator iter = handles_.begin(); iter != handles_.end();
+         ++iter) {
+      base::CloseProcessHandle(iter->second);
+    }
+  }
+
+  void Add(base::ProcessHandle process, base::ProcessHandle handle) {
+    handles_[process] = handle;
+  }
+
+  // Returns false if there is no handle for |process|.
+  bool Take(base::ProcessHandle process, base::ProcessHandle* handle) {
+    HandleMap::iterator iter = handles_.find(process);
+    if (iter == handles_.end())
+      return false;
+    *handle = iter->second;
+    handles_.erase(iter);
+    return true;
+  }
+
+ private:
+  typedef std::map<base::ProcessHandle, base::ProcessHandle> HandleMap;
+
+  HandleMap handles_;
+
+  DISALLOW_COPY_AND_ASSIGN(OwnedHandles);
+};
+
+// A process being sampled, with the handle that the sampler opened for it.
+struct ProcessMetricsSampler::ProcessEntry {
+  explicit ProcessEntry(base::ProcessHandle handle)
+      : handle(handle),
+        passes_until_memory_sample(0) {
+#if !defined(OS_MACOSX)
+    metrics.reset(base::ProcessMetrics::CreateProcessMetrics(handle));
+#else
+    metrics.reset(base::ProcessMetrics::CreateProcessMetrics(
+        handle, content::BrowserChildProcessHost::GetPortProvider()));
+#endif
+  }
+
+  ~ProcessEntry() {
+    metrics.reset();
+    base::CloseProcessHandle(handle);
+  }
+
+  base::ProcessHandle handle;
+  scoped_ptr<base::ProcessMetrics> metrics;
+
+  // The memory values of the last pass that read them.
+  ProcessSample memory_sample;
+  int passes_until_memory_sample;
+};
+
+ProcessMetricsSampler::ProcessSample::ProcessSample()
+    : cpu_usage(0),
+      idle_wakeups(0),
+      is_private_and_shared_valid(false),
+      private_bytes(0),
+      shared_bytes(0),
+      is_physical_memory_valid(false),
+      physical_memory(0) {
+}
+
+ProcessMetricsSampler::ProcessSample::~ProcessSample() {
+}
+
+// static
+void ProcessMetricsSamplerTraits::Destruct(
+    const ProcessMetricsSampler* sampler) {
+  // If the sequence is gone the sampler is leaked, as the process metrics
+  // can't be deleted anywhere else.
+  if (sampler->task_runner_->RunsTasksOnCurrentThread())
+    delete sampler;
+  else
+    sampler->task_runner_->DeleteSoon(FROM_HERE, sampler);
+}
+
+ProcessMetricsSampler::ProcessMetricsSampler(
+    base::SequencedTaskRunner* task_runner)
+    : task_runner_(task_runner) {
+}
+
+void ProcessMetricsSampler::Sample(
+    const std::vector<base::ProcessHandle>& processes,
+    const SnapshotCallback& callback) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  // Open a handle to the processes seen for the first time. The sampler keeps
+  // using it until the process is dropped from |processes|.
+  OwnedHandles* new_handles = new OwnedHandles();
+  std::set<base::ProcessHandle> opened_processes;
+  for (std::vector<base::ProcessHandle>::const_iterator iter =
+           processes.begin();
+       iter != processes.end(); ++iter) {
+    if (ContainsKey(opened_processes_, *iter)) {
+      opened_processes.insert(*iter);
+      continue;
+    }
+    base::ProcessHandle handle;
+    if (base::OpenPrivilegedProcessHandle(base::GetProcId(*iter), &handle)) {
+      new_handles->Add(*iter, handle);
+      opened_processes.insert(*iter);
+    }
+  }
+  opened_processes_.swap(opened_processes);
+
+  std::vector<base::ProcessHandle> sampled_processes(opened_processes_.begin(),
+                                                     opened_processes_.end());
+  base::PostTaskAndReplyWithResult(
+      task_runner_.get(),
+      FROM_HERE,
+      base::Bind(&ProcessMetricsSampler::SampleOnSequence,
+                 this,
+                 sampled_processes,
+                 base::Owned(new_handles)),
+      callback);
+}
+
+ProcessMetricsSampler::~ProcessMetricsSampler() {
+  STLDeleteValues(&entries_);
+}
+
+scoped_ptr<ProcessMetricsSampler::Snapshot>
+ProcessMetricsSampler::SampleOnSequence(
+    const std::vector<base::ProcessHandle>& processes,
+    OwnedHandles* new_handles) {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+
+  // Forget the processes which are gone.
+  std::set<base::ProcessHandle> live_processes(processes.begin(),
+                                               processes.end());
+  for (EntryMap::iterator iter = entries_.begin(); iter != entries_.end();) {
+    if (!ContainsKey(live_processes, iter->first)) {
+      delete iter->second;
+      entries_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+
+  scoped_ptr<Snapshot> snapshot(new Snapshot());
+  for (std::set<base::ProcessHandle>::const_iterator iter =
+           live_processes.begin();
+       iter != live_processes.end(); ++iter) {
+    ProcessEntry*& entry = entries_[*iter];
+    if (!entry) {
+      base::ProcessHandle handle;
+      if (!new_handles->Take(*iter, &handle)) {
+        NOTREACHED();
+        entries_.erase(*iter);
+        continue;
+      }
+      entry = new ProcessEntry(handle);
+    }
+    base::ProcessMetrics* metrics = entry->metrics.get();
+
+    ProcessSample& sample = (*snapshot)[*iter];
+    sample.cpu_usage = metrics->GetCPUUsage();
+#if defined(OS_MACOSX)
+    // TODO: Implement GetIdleWakeupsPerSecond() on other platforms,
+    // crbug.com/120488
+    sample.idle_wakeups = metrics->GetIdleWakeupsPerSecond();
+#endif  // defined(OS_MACOSX)
+
+    if (entry->passes_until_memory_sample > 0) {
+      --entry->passes_until_memory_sample;
+    } else {
+      entry->passes_until_memory_sample = kMemorySamplePeriod - 1;
+      ProcessSample& memory_sample = entry->memory_sample;
+      memory_sample.is_private_and_shared_valid =
+          metrics->GetMemoryBytes(&memory_sample.private_bytes,
+                                  &memory_sample.shared_bytes);
+
+      base::WorkingSetKBytes ws_usage;
+      memory_sample.is_physical_memory_valid =
+          metrics->GetWorkingSetKBytes(&ws_usage);
+      if (memory_sample.is_physical_memory_valid) {
+#if defined(OS_LINUX)
+        // On Linux private memory is also resident. Just use it.
+        memory_sample.physical_memory = ws_usage.priv * 1024;
+#else
+        // Memory = working_set.private + working_set.shareable.
+        // We exclude the shared memory.
+        memory_sample.physical_memory = metrics->GetWorkingSetSize();
+        memory_sample.physical_memory -= ws_usage.shared * 1024;
+#endif
+      }
+    }
+    const ProcessSample& memory_sample = entry->memory_sample;
+    sample.is_private_and_shared_valid =
+        memory_sample.is_private_and_shared_valid;
+    sample.private_bytes = memory_sample.private_bytes;
+    sample.shared_bytes = memory_sample.shared_bytes;
+    sample.is_physical_memory_valid = memory_sample.is_physical_memory_valid;
+    sample.physical_memory = memory_sample.physical_memory;
+  }
+  return snapshot.Pass();
+}
+
+}  // namespace task_manager
@@ -0,0 +1,108 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_TASK_MANAGER_PROCESS_METRICS_SAMPLER_H_
+#define CHROME_BROWSER_TASK_MANAGER_PROCESS_METRICS_SAMPLER_H_
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/process/process_handle.h"
+#include "base/threading/thread_checker.h"
+
+namespace base {
+class ProcessMetrics;
+class SequencedTaskRunner;
+}
+
+namespace task_manager {
+
+class ProcessMetricsSampler;
+
+// Deletes the sampler on its sequence, where its process metrics live.
+struct ProcessMetricsSamplerTraits {
+  static void Destruct(const ProcessMetricsSampler* sampler);
+};
+
+// Samples the base::ProcessMetrics of a set of processes on a background
+// sequence, so that reading them (e.g. from /proc on Linux) doesn't block the
+// UI thread. The values of one sampling pass are handed off to the caller as
+// a single snapshot, so the caller never sees a mix of two passes.
+//
+// The sampler opens its own handle to each process, so the caller may close
+// its handles at any time. Memory usage is costlier to read than CPU usage
+// (it walks /proc/<pid>/smaps on Linux), so it is only read every few passes.
+class ProcessMetricsSampler
+    : public base::RefCountedThreadSafe<ProcessMetricsSampler,
+                                        ProcessMetricsSamplerTraits> {
+ public:
+  // The values sampled for one process. The is_XXX members indicate if a value
+  // is valid.
+  struct ProcessSample {
+    ProcessSample();
+    ~ProcessSample();
+
+    double cpu_usage;
+    int idle_wakeups;
+
+    bool is_private_and_shared_valid;
+    size_t private_bytes;
+    size_t shared_bytes;
+
+    bool is_physical_memory_valid;
+    size_t physical_memory;
+  };
+
+  typedef std::map<base::ProcessHandle, ProcessSample> Snapshot;
+  typedef base::Callback<void(scoped_ptr<Snapshot>)> SnapshotCallback;
+
+  explicit ProcessMetricsSampler(base::SequencedTaskRunner* task_runner);
+
+  // Samples all the |processes| on the background sequence, and runs
+  // |callback| with the snapshot on the calling thread. The metrics of the
+  // processes which are not in |processes| any more are discarded. Note that
+  // the CPU usage is computed since the previous pass that included the
+  // process. Must always be called on the same thread.
+  void Sample(const std::vector<base::ProcessHandle>& processes,
+              const SnapshotCallback& callback);
+
+ private:
+  friend class base::DeleteHelper<ProcessMetricsSampler>;
+  friend struct ProcessMetricsSamplerTraits;
+
+  class OwnedHandles;
+  struct ProcessEntry;
+
+  typedef std::map<base::ProcessHandle, ProcessEntry*> EntryMap;
+
+  ~ProcessMetricsSampler();
+
+  // Runs on |task_runner_|. Takes the handles of the new processes from
+  // |new_handles|.
+  scoped_ptr<Snapshot> SampleOnSequence(
+      const std::vector<base::ProcessHandle>& processes,
+      OwnedHandles* new_handles);
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  // The processes that the sampler has opened its own handle to. Only used on
+  // the thread that calls Sample().
+  std::set<base::ProcessHandle> opened_processes_;
+  base::ThreadChecker thread_checker_;
+
+  // The process metrics and handles, keyed by the caller's handle. They are
+  // owned by the sampler, and are only accessed on |task_runner_|.
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessMetricsSampler);
+};
+
+}  // namespace task_manager
+
+#endif  // CHROME_BROWSER_TASK_MANAGER_PROCESS_METRICS_SAMPLER_H_
@@ -0,0 +1,70 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/task_manager/process_metrics_sampler.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/process/process_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace task_manager {
+
+namespace {
+
+void ReceiveSnapshot(
+    scoped_ptr<ProcessMetricsSampler::Snapshot>* out,
+    scoped_ptr<ProcessMetricsSampler::Snapshot> snapshot) {
+  *out = snapshot.Pass();
+}
+
+}  // namespace
+
+TEST(ProcessMetricsSamplerTest, Sample) {
+  base::MessageLoop loop;
+  scoped_refptr<ProcessMetricsSampler> sampler(
+      new ProcessMetricsSampler(base::MessageLoopProxy::current().get()));
+
+  std::vector<base::ProcessHandle> processes;
+  processes.push_back(base::GetCurrentProcessHandle());
+
+  scoped_ptr<ProcessMetricsSampler::Snapshot> snapshot;
+  sampler->Sample(processes, base::Bind(&ReceiveSnapshot, &snapshot));
+  EXPECT_FALSE(snapshot);
+  loop.RunUntilIdle();
+  ASSERT_TRUE(snapshot);
+  ASSERT_EQ(1u, snapshot->size());
+  const ProcessMetricsSampler::ProcessSample& sample =
+      snapshot->find(base::GetCurrentProcessHandle())->second;
+  EXPECT_GE(sample.cpu_usage, 0);
+#if defined(OS_LINUX)
+  EXPECT_TRUE(sample.is_private_and_shared_valid);
+  EXPECT_TRUE(sample.is_physical_memory_valid);
+  EXPECT_GT(sample.physical_memory, 0u);
+#endif
+
+  // Memory usage is not read again on the next pass.
+  size_t physical_memory = sample.physical_memory;
+  snapshot.reset();
+  sampler->Sample(processes, base::Bind(&ReceiveSnapshot, &snapshot));
+  loop.RunUntilIdle();
+  ASSERT_TRUE(snapshot);
+  ASSERT_EQ(1u, snapshot->size());
+  EXPECT_EQ(physical_memory,
+            snapshot->find(base::GetCurrentProcessHandle())
+                ->second.physical_memory);
+
+  // Processes which are gone are not in the snapshot any more.
+  snapshot.reset();
+  sampler->Sample(std::vector<base::ProcessHandle>(),
+                  base::Bind(&ReceiveSnapshot, &snapshot));
+  loop.RunUntilIdle();
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->empty());
+}
+
+}  // namespace task_manager
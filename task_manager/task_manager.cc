@@ -7,14 +7,15 @@
 #include "base/bind.h"
 #include "base/i18n/number_formatting.h"
 #include "base/i18n/rtl.h"
+#include "base/metrics/histogram.h"
 #include "base/prefs/pref_registry_simple.h"
-#include "base/process/process_metrics.h"
 #include "base/rand_util.h"
 #include "base/stl_util.h"
 #include "base/strings/string16.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/task_manager/background_information.h"
@@ -24,6 +25,7 @@
 #include "chrome/browser/task_manager/guest_information.h"
 #include "chrome/browser/task_manager/panel_information.h"
 #include "chrome/browser/task_manager/printing_information.h"
+#include "chrome/browser/task_manager/process_metrics_sampler.h"
 #include "chrome/browser/task_manager/resource_provider.h"
 #include "chrome/browser/task_manager/tab_contents_information.h"
 #include "chrome/browser/task_manager/web_contents_resource_provider.h"
@@ -48,10 +50,6 @@
 #include "ui/gfx/image/image_skia.h"
 #include "ui/resources/grit/ui_resources.h"
 
-#if defined(OS_MACOSX)
-#include "content/public/browser/browser_child_process_host.h"
-#endif
-
 using content::BrowserThread;
 using content::ResourceRequestInfo;
 using content::WebContents;
@@ -237,11 +235,17 @@ TaskManagerModel::PerProcessValues::~PerProcessValues() {}
 ////////////////////////////////////////////////////////////////////////////////
 
 TaskManagerModel::TaskManagerModel(TaskManager* task_manager)
-    : pending_video_memory_usage_stats_update_(false),
+    : update_interval_(base::TimeDelta::FromMilliseconds(kUpdateTimeMs)),
+      pending_video_memory_usage_stats_update_(false),
       update_requests_(0),
       listen_requests_(0),
       update_state_(IDLE),
       goat_salt_(base::RandUint64()) {
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  process_metrics_sampler_ = new task_manager::ProcessMetricsSampler(
+      pool->GetSequencedTaskRunnerWithShutdownBehavior(
+          pool->GetSequenceToken(),
+          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN).get());
   AddResourceProvider(
       new task_manager::BrowserProcessResourceProvider(task_manager));
   AddResourceProvider(new task_manager::WebContentsResourceProvider(
@@ -570,24 +574,9 @@ bool TaskManagerModel::GetPhysicalMemory(int index, size_t* result) const {
   base::ProcessHandle handle = GetResource(index)->GetProcess();
   PerProcessValues& values(per_process_cache_[handle]);
 
-  if (!values.is_physical_memory_valid) {
-    base::WorkingSetKBytes ws_usage;
-    MetricsMap::const_iterator iter = metrics_map_.find(handle);
-    if (iter == metrics_map_.end() ||
-        !iter->second->GetWorkingSetKBytes(&ws_usage))
-      return false;
-
-    values.is_physical_memory_valid = true;
-#if defined(OS_LINUX)
-    // On Linux private memory is also resident. Just use it.
-    values.physical_memory = ws_usage.priv * 1024;
-#else
-    // Memory = working_set.private + working_set.shareable.
-    // We exclude the shared memory.
-    values.physical_memory = iter->second->GetWorkingSetSize();
-    values.physical_memory -= ws_usage.shared * 1024;
-#endif
-  }
+  // The value is sampled in the background; see Refresh().
+  if (!values.is_physical_memory_valid)
+    return false;
   *result = values.physical_memory;
   return true;
 }
@@ -959,19 +948,6 @@ void TaskManagerModel::AddResource(Resource* resource) {
     resources_.insert(++iter, resource);
   }
 
-  // Create the ProcessMetrics for this process if needed (not in map).
-  if (metrics_map_.find(process) == metrics_map_.end()) {
-    base::ProcessMetrics* pm =
-#if !defined(OS_MACOSX)
-        base::ProcessMetrics::CreateProcessMetrics(process);
-#else
-        base::ProcessMetrics::CreateProcessMetrics(
-            process, content::BrowserChildProcessHost::GetPortProvider());
-#endif
-
-    metrics_map_[process] = pm;
-  }
-
   // Notify the table that the contents have changed for it to redraw.
   FOR_EACH_OBSERVER(TaskManagerModelObserver, observer_list_,
                     OnItemsAdded(new_entry_index, 1));
@@ -996,18 +972,10 @@ void TaskManagerModel::RemoveResource(Resource* resource) {
     group_entries.erase(iter);
 
   // If there are no more entries for that process, do the clean-up.
-  if (group_entries.empty()) {
+  // The sampler drops the process metrics on the next pass.
+  if (group_entries.empty())
     group_map_.erase(group_iter);
 
-    // Nobody is using this process, we don't need the process metrics anymore.
-    MetricsMap::iterator pm_iter = metrics_map_.find(process);
-    DCHECK(pm_iter != metrics_map_.end());
-    if (pm_iter != metrics_map_.end()) {
-      delete pm_iter->second;
-      metrics_map_.erase(process);
-    }
-  }
-
   // Remove the entry from the model list.
   iter = std::find(resources_.begin(), resources_.end(), resource);
   DCHECK(iter != resources_.end());
@@ -1115,7 +1083,7 @@ void TaskManagerModel::Clear() {
     group_map_.clear();
 
     // Clear the process related info.
-    STLDeleteValues(&metrics_map_);
+    process_metrics_snapshot_.reset();
 
     // Clear the network maps.
     current_byte_count_map_.clear();
@@ -1134,6 +1102,7 @@ void TaskManagerModel::ModelChanged() {
 }
 
 void TaskManagerModel::Refresh() {
+  base::TimeTicks refresh_start = base::TimeTicks::Now();
   goat_salt_ = base::RandUint64();
 
   per_resource_cache_.clear();
@@ -1143,13 +1112,13 @@ void TaskManagerModel::Refresh() {
   nacl::NaClBrowser* nacl_browser = nacl::NaClBrowser::GetInstance();
 #endif  // !defined(DISABLE_NACL)
 
-  // Compute the CPU usage values and check if NaCl GDB debug stub port is
-  // known.
-  // Note that we compute the CPU usage for all resources (instead of doing it
-  // lazily) as process_util::GetCPUUsage() returns the CPU usage since the last
-  // time it was called, and not calling it everytime would skew the value the
-  // next time it is retrieved (as it would be for more than 1 cycle).
-  // The same is true for idle wakeups.
+  // Copy the process metrics sampled in the background and check if NaCl GDB
+  // debug stub port is known.
+  // Note that the CPU usage is sampled for all processes on every update
+  // (instead of doing it lazily) as process_util::GetCPUUsage() returns the CPU
+  // usage since the last time it was called, and not calling it everytime
+  // would skew the value the next time it is retrieved (as it would be for
+  // more than 1 cycle). The same is true for idle wakeups.
   for (ResourceList::iterator iter = resources_.begin();
        iter != resources_.end(); ++iter) {
     base::ProcessHandle process = (*iter)->GetProcess();
@@ -1164,30 +1133,30 @@ void TaskManagerModel::Refresh() {
       }
     }
 #endif  // !defined(DISABLE_NACL)
-    if (values.is_cpu_usage_valid && values.is_idle_wakeups_valid)
+    if (values.is_cpu_usage_valid || !process_metrics_snapshot_)
       continue;
-    MetricsMap::iterator metrics_iter = metrics_map_.find(process);
-    DCHECK(metrics_iter != metrics_map_.end());
-    if (!values.is_cpu_usage_valid) {
-      values.is_cpu_usage_valid = true;
-      values.cpu_usage = metrics_iter->second->GetCPUUsage();
-    }
-#if defined(OS_MACOSX)
-    // TODO: Implement GetIdleWakeupsPerSecond() on other platforms,
-    // crbug.com/120488
-    if (!values.is_idle_wakeups_valid) {
-      values.is_idle_wakeups_valid = true;
-      values.idle_wakeups = metrics_iter->second->GetIdleWakeupsPerSecond();
-    }
-#endif  // defined(OS_MACOSX)
+    task_manager::ProcessMetricsSampler::Snapshot::const_iterator sample_iter =
+        process_metrics_snapshot_->find(process);
+    if (sample_iter == process_metrics_snapshot_->end())
+      continue;
+    const task_manager::ProcessMetricsSampler::ProcessSample& sample =
+        sample_iter->second;
+    values.is_cpu_usage_valid = true;
+    values.cpu_usage = sample.cpu_usage;
+    values.is_idle_wakeups_valid = true;
+    values.idle_wakeups = sample.idle_wakeups;
+    values.is_private_and_shared_valid = sample.is_private_and_shared_valid;
+    values.private_bytes = sample.private_bytes;
+    values.shared_bytes = sample.shared_bytes;
+    values.is_physical_memory_valid = sample.is_physical_memory_valid;
+    values.physical_memory = sample.physical_memory;
   }
 
   // Send a request to refresh GPU memory consumption values
   RefreshVideoMemoryUsageStats();
 
   // Compute the new network usage values.
-  base::TimeDelta update_time =
-      base::TimeDelta::FromMilliseconds(kUpdateTimeMs);
+  base::TimeDelta update_time = update_interval_;
   for (ResourceValueMap::iterator iter = current_byte_count_map_.begin();
        iter != current_byte_count_map_.end(); ++iter) {
     PerResourceValues* values = &(per_resource_cache_[iter->first]);
@@ -1210,6 +1179,9 @@ void TaskManagerModel::Refresh() {
     FOR_EACH_OBSERVER(TaskManagerModelObserver, observer_list_,
                       OnItemsChanged(0, ResourceCount()));
   }
+
+  UMA_HISTOGRAM_TIMES("TaskManager.RefreshTime",
+                      base::TimeTicks::Now() - refresh_start);
 }
 
 void TaskManagerModel::NotifyResourceTypeStats(
@@ -1301,13 +1273,34 @@ void TaskManagerModel::RefreshCallback() {
     return;
   }
 
+  std::vector<base::ProcessHandle> processes;
+  for (GroupMap::const_iterator iter = group_map_.begin();
+       iter != group_map_.end(); ++iter) {
+    processes.push_back(iter->first);
+  }
+  process_metrics_sampler_->Sample(
+      processes,
+      base::Bind(&TaskManagerModel::OnProcessMetricsSampled, this));
+}
+
+void TaskManagerModel::OnProcessMetricsSampled(
+    scoped_ptr<task_manager::ProcessMetricsSampler::Snapshot> snapshot) {
+  DCHECK_NE(IDLE, update_state_);
+
+  if (update_state_ == STOPPING) {
+    // We have been asked to stop.
+    update_state_ = IDLE;
+    return;
+  }
+
+  process_metrics_snapshot_ = snapshot.Pass();
   Refresh();
 
   // Schedule the next update.
   base::MessageLoop::current()->PostDelayedTask(
       FROM_HERE,
       base::Bind(&TaskManagerModel::RefreshCallback, this),
-      base::TimeDelta::FromMilliseconds(kUpdateTimeMs));
+      update_interval_);
 }
 
 void TaskManagerModel::RefreshVideoMemoryUsageStats() {
@@ -1428,19 +1421,8 @@ base::string16 TaskManagerModel::GetMemCellText(int64 number) const {
 
 bool TaskManagerModel::CachePrivateAndSharedMemory(
     base::ProcessHandle handle) const {
-  PerProcessValues& values(per_process_cache_[handle]);
-  if (values.is_private_and_shared_valid)
-    return true;
-
-  MetricsMap::const_iterator iter = metrics_map_.find(handle);
-  if (iter == metrics_map_.end() ||
-      !iter->second->GetMemoryBytes(&values.private_bytes,
-                                    &values.shared_bytes)) {
-    return false;
-  }
-
-  values.is_private_and_shared_valid = true;
-  return true;
+  // The values are sampled in the background; see Refresh().
+  return per_process_cache_[handle].is_private_and_shared_valid;
 }
 
 bool TaskManagerModel::CacheWebCoreStats(int index) const {
@@ -15,8 +15,10 @@
 #include "base/memory/singleton.h"
 #include "base/observer_list.h"
 #include "base/strings/string16.h"
+#include "base/time/time.h"
 #include "base/timer/timer.h"
 #include "chrome/browser/renderer_host/web_cache_manager.h"
+#include "chrome/browser/task_manager/process_metrics_sampler.h"
 #include "chrome/browser/task_manager/resource_provider.h"
 #include "chrome/browser/ui/host_desktop.h"
 #include "content/public/common/gpu_memory_stats.h"
@@ -26,10 +28,6 @@ class PrefRegistrySimple;
 class TaskManagerModel;
 class TaskManagerModelGpuDataManagerObserver;
 
-namespace base {
-class ProcessMetrics;
-}
-
 namespace content {
 class WebContents;
 }
@@ -290,6 +288,12 @@ class TaskManagerModel : public base::RefCountedThreadSafe<TaskManagerModel> {
    // Updates the values for all rows.
   void Refresh();
 
+  // Sets the interval between two periodic updates. The process metrics are
+  // sampled in the background once per update.
+  void set_update_interval(const base::TimeDelta& update_interval) {
+    update_interval_ = update_interval;
+  }
+
   void NotifyResourceTypeStats(
         base::ProcessId renderer_id,
         const blink::WebCache::ResourceTypeStats& stats);
@@ -400,7 +404,6 @@ class TaskManagerModel : public base::RefCountedThreadSafe<TaskManagerModel> {
   typedef std::vector<scoped_refptr<task_manager::ResourceProvider> >
       ResourceProviderList;
   typedef std::map<base::ProcessHandle, ResourceList> GroupMap;
-  typedef std::map<base::ProcessHandle, base::ProcessMetrics*> MetricsMap;
   typedef std::map<task_manager::Resource*, int64> ResourceValueMap;
   typedef std::map<task_manager::Resource*,
                    PerResourceValues> PerResourceCache;
@@ -430,9 +433,15 @@ class TaskManagerModel : public base::RefCountedThreadSafe<TaskManagerModel> {
 
   ~TaskManagerModel();
 
-  // Callback from the timer to refresh. Invokes Refresh() as appropriate.
+  // Callback from the timer to refresh. Starts sampling the process metrics in
+  // the background as appropriate.
   void RefreshCallback();
 
+  // Called on the UI thread with the process metrics sampled by
+  // |process_metrics_sampler_|. Invokes Refresh() as appropriate.
+  void OnProcessMetricsSampled(
+      scoped_ptr<task_manager::ProcessMetricsSampler::Snapshot> snapshot);
+
   void RefreshVideoMemoryUsageStats();
 
   // Returns the network usage (in bytes per seconds) for the specified
@@ -467,9 +476,8 @@ class TaskManagerModel : public base::RefCountedThreadSafe<TaskManagerModel> {
   // displayed in the task manager's memory cell.
   base::string16 GetMemCellText(int64 number) const;
 
-  // Verifies the private and shared memory for |handle| is valid in
-  // |per_process_cache_|. Returns true if the data in |per_process_cache_| is
-  // valid.
+  // Returns true if the private and shared memory for |handle| is valid in
+  // |per_process_cache_|.
   bool CachePrivateAndSharedMemory(base::ProcessHandle handle) const;
 
   // Verifies |webcore_stats| in |per_resource_cache_|, returning true on
@@ -501,9 +509,17 @@ class TaskManagerModel : public base::RefCountedThreadSafe<TaskManagerModel> {
   // the model (but the actual Resources are owned by the ResourceProviders).
   GroupMap group_map_;
 
-  // A map to retrieve the process metrics for a process. The ProcessMetrics are
-  // owned by the model.
-  MetricsMap metrics_map_;
+  // Samples the process metrics of all the processes in |group_map_| off the
+  // UI thread.
+  scoped_refptr<task_manager::ProcessMetricsSampler> process_metrics_sampler_;
+
+  // The latest snapshot of the process metrics. Refresh() copies it into
+  // |per_process_cache_|.
+  scoped_ptr<task_manager::ProcessMetricsSampler::Snapshot>
+      process_metrics_snapshot_;
+
+  // The delay between two periodic updates.
+  base::TimeDelta update_interval_;
 
   // A map that keeps track of the number of bytes read per process since last
   // tick. The Resources are owned by the ResourceProviders.
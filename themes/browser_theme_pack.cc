@@ -6,6 +6,7 @@
 
 #include <limits>
 
+#include "base/bind.h"
 #include "base/files/file.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
@@ -410,6 +411,16 @@ const int kPreloadIDs[] = {
   PRS_THEME_NTP_ATTRIBUTION,
 };
 
+// Images that are visible in every browser window. They are decoded on the
+// file thread after a pack is loaded from disk, so that painting the first
+// window doesn't have to.
+const int kPrecomputeIDs[] = {
+  PRS_THEME_FRAME,
+  PRS_THEME_FRAME_INACTIVE,
+  PRS_THEME_TOOLBAR,
+  PRS_THEME_TAB_BACKGROUND,
+};
+
 // Returns true if this OS uses a browser frame which has a non zero width to
 // the left and the right of the web contents.
 bool HasFrameBorder() {
@@ -502,8 +513,12 @@ class ThemeImagePngSource : public gfx::ImageSkiaSource {
  public:
   typedef std::map<ui::ScaleFactor,
                    scoped_refptr<base::RefCountedMemory> > PngMap;
+  typedef std::map<ui::ScaleFactor, SkBitmap> BitmapMap;
 
-  explicit ThemeImagePngSource(const PngMap& png_map) : png_map_(png_map) {}
+  // |bitmap_map| holds bitmaps that were already decoded from |png_map|.
+  ThemeImagePngSource(const PngMap& png_map, const BitmapMap& bitmap_map)
+      : png_map_(png_map),
+        bitmap_map_(bitmap_map) {}
 
   virtual ~ThemeImagePngSource() {}
 
@@ -575,7 +590,6 @@ class ThemeImagePngSource : public gfx::ImageSkiaSource {
 
   PngMap png_map_;
 
-  typedef std::map<ui::ScaleFactor, SkBitmap> BitmapMap;
   BitmapMap bitmap_map_;
 
   DISALLOW_COPY_AND_ASSIGN(ThemeImagePngSource);
@@ -759,6 +773,16 @@ scoped_refptr<BrowserThemePack> BrowserThemePack::BuildFromDataPack(
                 << "from those supported by platform.";
     return NULL;
   }
+
+  // Images are decoded when they are first used; the ones every window shows
+  // are decoded ahead of that off the UI thread.
+  DecodedImages* decoded_images = new DecodedImages;
+  BrowserThread::PostTaskAndReply(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&BrowserThemePack::DecodeImagesOnFileThread, pack,
+                 decoded_images),
+      base::Bind(&BrowserThemePack::OnImagesDecoded, pack,
+                 base::Owned(decoded_images)));
   return pack;
 }
 
@@ -865,43 +889,13 @@ gfx::Image BrowserThemePack::GetImageNamed(int idr_id) {
   if (image_iter != images_on_ui_thread_.end())
     return image_iter->second;
 
-  ThemeImagePngSource::PngMap png_map;
-  for (size_t i = 0; i < scale_factors_.size(); ++i) {
-    scoped_refptr<base::RefCountedMemory> memory =
-        GetRawData(idr_id, scale_factors_[i]);
-    if (memory.get())
-      png_map[scale_factors_[i]] = memory;
-  }
-  if (!png_map.empty()) {
-    gfx::ImageSkia image_skia(new ThemeImagePngSource(png_map), 1.0f);
-    // |image_skia| takes ownership of ThemeImagePngSource.
-    gfx::Image ret = gfx::Image(image_skia);
-    images_on_ui_thread_[prs_id] = ret;
-    return ret;
-  }
-
-  return gfx::Image();
+  return CreateImageFromRawData(prs_id, DecodedImage());
 }
 
 base::RefCountedMemory* BrowserThemePack::GetRawData(
     int idr_id,
     ui::ScaleFactor scale_factor) const {
-  base::RefCountedMemory* memory = NULL;
-  int prs_id = GetPersistentIDByIDR(idr_id);
-  int raw_id = GetRawIDByPersistentID(prs_id, scale_factor);
-
-  if (raw_id != -1) {
-    if (data_pack_.get()) {
-      memory = data_pack_->GetStaticMemory(raw_id);
-    } else {
-      RawImages::const_iterator it = image_memory_.find(raw_id);
-      if (it != image_memory_.end()) {
-        memory = it->second.get();
-      }
-    }
-  }
-
-  return memory;
+  return GetRawDataByPersistentID(GetPersistentIDByIDR(idr_id), scale_factor);
 }
 
 bool BrowserThemePack::HasCustomImage(int idr_id) const {
@@ -1502,6 +1496,79 @@ void BrowserThemePack::AddRawImagesTo(const RawImages& images,
   }
 }
 
+base::RefCountedMemory* BrowserThemePack::GetRawDataByPersistentID(
+    int prs_id,
+    ui::ScaleFactor scale_factor) const {
+  base::RefCountedMemory* memory = NULL;
+  int raw_id = GetRawIDByPersistentID(prs_id, scale_factor);
+
+  if (raw_id != -1) {
+    if (data_pack_.get()) {
+      memory = data_pack_->GetStaticMemory(raw_id);
+    } else {
+      RawImages::const_iterator it = image_memory_.find(raw_id);
+      if (it != image_memory_.end()) {
+        memory = it->second.get();
+      }
+    }
+  }
+
+  return memory;
+}
+
+gfx::Image BrowserThemePack::CreateImageFromRawData(
+    int prs_id,
+    const DecodedImage& bitmaps) {
+  ThemeImagePngSource::PngMap png_map;
+  for (size_t i = 0; i < scale_factors_.size(); ++i) {
+    scoped_refptr<base::RefCountedMemory> memory =
+        GetRawDataByPersistentID(prs_id, scale_factors_[i]);
+    if (memory.get())
+      png_map[scale_factors_[i]] = memory;
+  }
+  if (png_map.empty())
+    return gfx::Image();
+
+  gfx::ImageSkia image_skia(new ThemeImagePngSource(png_map, bitmaps), 1.0f);
+  // |image_skia| takes ownership of ThemeImagePngSource.
+  gfx::Image ret = gfx::Image(image_skia);
+  images_on_ui_thread_[prs_id] = ret;
+  return ret;
+}
+
+void BrowserThemePack::DecodeImagesOnFileThread(
+    DecodedImages* decoded_images) const {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  DCHECK(data_pack_.get());
+
+  for (size_t i = 0; i < arraysize(kPrecomputeIDs); ++i) {
+    int prs_id = kPrecomputeIDs[i];
+    for (size_t j = 0; j < scale_factors_.size(); ++j) {
+      scoped_refptr<base::RefCountedMemory> memory =
+          GetRawDataByPersistentID(prs_id, scale_factors_[j]);
+      if (!memory.get())
+        continue;
+      SkBitmap bitmap;
+      if (!gfx::PNGCodec::Decode(memory->front(), memory->size(), &bitmap)) {
+        NOTREACHED() << "Unable to decode theme image for prs_id=" << prs_id;
+        continue;
+      }
+      (*decoded_images)[prs_id][scale_factors_[j]] = bitmap;
+    }
+  }
+}
+
+void BrowserThemePack::OnImagesDecoded(const DecodedImages* decoded_images) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+
+  for (DecodedImages::const_iterator it = decoded_images->begin();
+       it != decoded_images->end(); ++it) {
+    // Images that were used in the meantime have been decoded already.
+    if (images_on_ui_thread_.find(it->first) == images_on_ui_thread_.end())
+      CreateImageFromRawData(it->first, it->second);
+  }
+}
+
 color_utils::HSL BrowserThemePack::GetTintInternal(int id) const {
   if (tints_) {
     for (size_t i = 0; i < kTintTableLength; ++i) {
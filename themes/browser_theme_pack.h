@@ -14,6 +14,7 @@
 #include "base/sequenced_task_runner_helpers.h"
 #include "chrome/browser/themes/custom_theme_supplier.h"
 #include "extensions/common/extension.h"
+#include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColor.h"
 #include "ui/base/layout.h"
 #include "ui/gfx/color_utils.h"
@@ -105,6 +106,12 @@ class BrowserThemePack : public CustomThemeSupplier {
   // Maps image ids to maps of scale factors to file paths.
   typedef std::map<int, ScaleFactorToFileMap> FilePathMap;
 
+  // The bitmaps decoded for an image, by scale factor.
+  typedef std::map<ui::ScaleFactor, SkBitmap> DecodedImage;
+
+  // Maps image ids to decoded bitmaps.
+  typedef std::map<int, DecodedImage> DecodedImages;
+
   // Default. Everything is empty.
   BrowserThemePack();
 
@@ -208,6 +215,23 @@ class BrowserThemePack : public CustomThemeSupplier {
   // Generates raw images for any missing scale from an available scale.
   void GenerateRawImageForAllSupportedScales(int prs_id);
 
+  // Returns the PNG data for |prs_id| at |scale_factor|, or NULL.
+  base::RefCountedMemory* GetRawDataByPersistentID(
+      int prs_id, ui::ScaleFactor scale_factor) const;
+
+  // Creates the image for |prs_id| from its PNG data and adds it to
+  // |images_on_ui_thread_|. The PNG data is decoded when a representation is
+  // requested, except for the scale factors in |bitmaps|.
+  gfx::Image CreateImageFromRawData(int prs_id, const DecodedImage& bitmaps);
+
+  // Decodes the images that every browser window shows from |data_pack_|
+  // into |decoded_images|. Runs on the file thread after BuildFromDataPack().
+  void DecodeImagesOnFileThread(DecodedImages* decoded_images) const;
+
+  // Adds the images in |decoded_images| that haven't been used yet to
+  // |images_on_ui_thread_|.
+  void OnImagesDecoded(const DecodedImages* decoded_images);
+
   // Data pack, if we have one.
   scoped_ptr<ui::DataPack> data_pack_;
 
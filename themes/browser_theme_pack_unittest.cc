@@ -147,6 +147,10 @@ class BrowserThemePackTest : public ::testing::Test {
                                          &theme_pack_->images_on_ui_thread_);
   }
 
+  static size_t GetNumCachedImages(BrowserThemePack* pack) {
+    return pack->images_on_ui_thread_.size();
+  }
+
   // This function returns void in order to be able use ASSERT_...
   // The BrowserThemePack is returned in |pack|.
   void BuildFromUnpackedExtension(const base::FilePath& extension_path,
@@ -614,3 +618,29 @@ TEST_F(BrowserThemePackTest, HiDpiThemeTest) {
     VerifyHiDpiTheme(pack.get());
   }
 }
+
+TEST_F(BrowserThemePackTest, DecodesImagesAfterReadingPack) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  base::FilePath file = dir.path().AppendASCII("theme_data.pak");
+
+  {
+    base::FilePath hidpi_path = GetHiDpiThemePath();
+    scoped_refptr<BrowserThemePack> pack;
+    BuildFromUnpackedExtension(hidpi_path, pack);
+    ASSERT_TRUE(pack->WriteToDisk(file));
+  }
+
+  scoped_refptr<BrowserThemePack> pack =
+      BrowserThemePack::BuildFromDataPack(file, "gllekhaobjnhgeag");
+  ASSERT_TRUE(pack.get());
+  // Nothing is decoded on the UI thread while reading the pack.
+  EXPECT_EQ(0u, GetNumCachedImages(pack.get()));
+
+  // The frame, toolbar and tab images are decoded on the file thread.
+  message_loop.RunUntilIdle();
+  EXPECT_LT(0u, GetNumCachedImages(pack.get()));
+
+  // The images decoded ahead are the same as those decoded when used.
+  VerifyHiDpiTheme(pack.get());
+}
@@ -12,18 +12,237 @@
 #include <numeric>
 #include <vector>
 
+#include "base/bind.h"
+#include "base/cpu.h"
 #include "base/logging.h"
+#include "base/stl_util.h"
+#include "build/build_config.h"
+#include "chrome/browser/thumbnails/tile_runner.h"
 #include "skia/ext/convolver.h"
 #include "skia/ext/recursive_gaussian_convolution.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkSize.h"
 #include "ui/gfx/color_analysis.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
 namespace {
 
+using thumbnailing_utils::TileRunner;
+
 const float kSigmaThresholdForRecursive = 1.5f;
 const float kAspectRatioToleranceFactor = 1.02f;
 
+// Cleared by tests to compare the SIMD kernels below with the scalar ones.
+bool g_simd_kernels_enabled = true;
+
+// Scalar per-row kernels of the image passes. Each has an SSE2 counterpart
+// which must give exactly the same results.
+
+void ShiftLeftRow(uint8* row, int bit_shift, int width) {
+  for (int c = 0; c < width; ++c, ++row)
+    *row <<= bit_shift;
+}
+
+// Returns the largest squared gradient magnitude in the row.
+unsigned MaxGradientMagnitudeRow(const uint8* grad_x_row,
+                                 const uint8* grad_y_row,
+                                 int width) {
+  unsigned grad_max = 0;
+  for (int c = 0; c < width; ++c) {
+    unsigned grad_x = grad_x_row[c];
+    unsigned grad_y = grad_y_row[c];
+    grad_max = std::max(grad_max, grad_x * grad_x + grad_y * grad_y);
+  }
+  return grad_max;
+}
+
+// Stores the squared gradient magnitudes of the row, shifted right by
+// |bit_shift|, in |target_row|.
+void GradientMagnitudeRow(const uint8* grad_x_row,
+                          const uint8* grad_y_row,
+                          int bit_shift,
+                          int width,
+                          uint8* target_row) {
+  for (int c = 0; c < width; ++c) {
+    unsigned grad_x = grad_x_row[c];
+    unsigned grad_y = grad_y_row[c];
+    target_row[c] = (grad_x * grad_x + grad_y * grad_y) >> bit_shift;
+  }
+}
+
+// Adds the pixels of |image_row| to |column_sums| and returns their sum.
+unsigned AccumulateProfileRow(const uint8* image_row,
+                              int width,
+                              uint32* column_sums) {
+  unsigned row_sum = 0;
+  for (int c = 0; c < width; ++c) {
+    row_sum += image_row[c];
+    column_sums[c] += image_row[c];
+  }
+  return row_sum;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+void ShiftLeftRow_SSE2(uint8* row, int bit_shift, int width) {
+  // There is no 8-bit shift, so shift 16-bit lanes and drop the bits which
+  // crossed into the neighbouring byte.
+  const __m128i shift = _mm_cvtsi32_si128(bit_shift);
+  const __m128i mask = _mm_set1_epi8(static_cast<char>(0xFF << bit_shift));
+  int c = 0;
+  for (; c + 16 <= width; c += 16) {
+    __m128i* pixels = reinterpret_cast<__m128i*>(row + c);
+    __m128i shifted = _mm_sll_epi16(_mm_loadu_si128(pixels), shift);
+    _mm_storeu_si128(pixels, _mm_and_si128(shifted, mask));
+  }
+  ShiftLeftRow(row + c, bit_shift, width - c);
+}
+
+// Computes the squared gradient magnitudes of 16 pixels as four vectors of
+// 32-bit values.
+void GradientMagnitude16_SSE2(const uint8* grad_x_row,
+                              const uint8* grad_y_row,
+                              __m128i magnitudes[4]) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i grad_x =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(grad_x_row));
+  __m128i grad_y =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(grad_y_row));
+  __m128i grad_x_lo = _mm_unpacklo_epi8(grad_x, zero);
+  __m128i grad_x_hi = _mm_unpackhi_epi8(grad_x, zero);
+  __m128i grad_y_lo = _mm_unpacklo_epi8(grad_y, zero);
+  __m128i grad_y_hi = _mm_unpackhi_epi8(grad_y, zero);
+  // With the x and y gradients interleaved, multiplying the vector by itself
+  // and adding adjacent products gives grad_x * grad_x + grad_y * grad_y.
+  __m128i pairs[4] = {
+    _mm_unpacklo_epi16(grad_x_lo, grad_y_lo),
+    _mm_unpackhi_epi16(grad_x_lo, grad_y_lo),
+    _mm_unpacklo_epi16(grad_x_hi, grad_y_hi),
+    _mm_unpackhi_epi16(grad_x_hi, grad_y_hi),
+  };
+  for (int i = 0; i < 4; ++i)
+    magnitudes[i] = _mm_madd_epi16(pairs[i], pairs[i]);
+}
+
+unsigned MaxGradientMagnitudeRow_SSE2(const uint8* grad_x_row,
+                                      const uint8* grad_y_row,
+                                      int width) {
+  __m128i grad_max = _mm_setzero_si128();
+  int c = 0;
+  for (; c + 16 <= width; c += 16) {
+    __m128i magnitudes[4];
+    GradientMagnitude16_SSE2(grad_x_row + c, grad_y_row + c, magnitudes);
+    for (int i = 0; i < 4; ++i) {
+      // The magnitudes are below 2^17, so a signed comparison works.
+      __m128i greater = _mm_cmpgt_epi32(magnitudes[i], grad_max);
+      grad_max = _mm_or_si128(_mm_and_si128(greater, magnitudes[i]),
+                              _mm_andnot_si128(greater, grad_max));
+    }
+  }
+  uint32 lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), grad_max);
+  unsigned result = std::max(std::max(lanes[0], lanes[1]),
+                             std::max(lanes[2], lanes[3]));
+  return std::max(result, MaxGradientMagnitudeRow(grad_x_row + c,
+                                                  grad_y_row + c,
+                                                  width - c));
+}
+
+void GradientMagnitudeRow_SSE2(const uint8* grad_x_row,
+                               const uint8* grad_y_row,
+                               int bit_shift,
+                               int width,
+                               uint8* target_row) {
+  const __m128i shift = _mm_cvtsi32_si128(bit_shift);
+  // The scalar kernel truncates to 8 bits rather than saturating.
+  const __m128i low_byte = _mm_set1_epi32(0xFF);
+  int c = 0;
+  for (; c + 16 <= width; c += 16) {
+    __m128i magnitudes[4];
+    GradientMagnitude16_SSE2(grad_x_row + c, grad_y_row + c, magnitudes);
+    for (int i = 0; i < 4; ++i) {
+      magnitudes[i] =
+          _mm_and_si128(_mm_srl_epi32(magnitudes[i], shift), low_byte);
+    }
+    __m128i packed = _mm_packus_epi16(
+        _mm_packs_epi32(magnitudes[0], magnitudes[1]),
+        _mm_packs_epi32(magnitudes[2], magnitudes[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target_row + c), packed);
+  }
+  GradientMagnitudeRow(grad_x_row + c, grad_y_row + c, bit_shift, width - c,
+                       target_row + c);
+}
+
+unsigned AccumulateProfileRow_SSE2(const uint8* image_row,
+                                   int width,
+                                   uint32* column_sums) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i row_sum = _mm_setzero_si128();
+  int c = 0;
+  for (; c + 16 <= width; c += 16) {
+    __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(image_row + c));
+    // The sum of absolute differences from zero adds up each half.
+    row_sum = _mm_add_epi64(row_sum, _mm_sad_epu8(pixels, zero));
+    __m128i pixels_lo = _mm_unpacklo_epi8(pixels, zero);
+    __m128i pixels_hi = _mm_unpackhi_epi8(pixels, zero);
+    __m128i widened[4] = {
+      _mm_unpacklo_epi16(pixels_lo, zero),
+      _mm_unpackhi_epi16(pixels_lo, zero),
+      _mm_unpacklo_epi16(pixels_hi, zero),
+      _mm_unpackhi_epi16(pixels_hi, zero),
+    };
+    __m128i* sums = reinterpret_cast<__m128i*>(column_sums + c);
+    for (int i = 0; i < 4; ++i) {
+      _mm_storeu_si128(sums + i,
+                       _mm_add_epi32(_mm_loadu_si128(sums + i), widened[i]));
+    }
+  }
+  unsigned result = _mm_cvtsi128_si32(row_sum) +
+      _mm_cvtsi128_si32(_mm_srli_si128(row_sum, 8));
+  return result + AccumulateProfileRow(image_row + c, width - c,
+                                       column_sums + c);
+}
+
+#endif  // defined(ARCH_CPU_X86_FAMILY)
+
+// The row kernels used for an image, picked once per pass.
+struct RowKernels {
+  void (*shift_left)(uint8* row, int bit_shift, int width);
+  unsigned (*max_gradient_magnitude)(const uint8* grad_x_row,
+                                     const uint8* grad_y_row,
+                                     int width);
+  void (*gradient_magnitude)(const uint8* grad_x_row,
+                             const uint8* grad_y_row,
+                             int bit_shift,
+                             int width,
+                             uint8* target_row);
+  unsigned (*accumulate_profile)(const uint8* image_row,
+                                 int width,
+                                 uint32* column_sums);
+};
+
+RowKernels GetRowKernels() {
+  RowKernels kernels = {
+    ShiftLeftRow,
+    MaxGradientMagnitudeRow,
+    GradientMagnitudeRow,
+    AccumulateProfileRow,
+  };
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (g_simd_kernels_enabled && base::CPU().has_sse2()) {
+    kernels.shift_left = ShiftLeftRow_SSE2;
+    kernels.max_gradient_magnitude = MaxGradientMagnitudeRow_SSE2;
+    kernels.gradient_magnitude = GradientMagnitudeRow_SSE2;
+    kernels.accumulate_profile = AccumulateProfileRow_SSE2;
+  }
+#endif
+  return kernels;
+}
+
 template<class InputIterator, class OutputIterator, class Compare>
 void SlidingWindowMinMax(InputIterator first,
                          InputIterator last,
@@ -221,12 +440,230 @@ void ConstrainedProfileThresholding(const std::vector<float>& profile,
   }
 }
 
+
+// The one-dimensional skia filters, run over |area| of |source| into the same
+// area of |target|. Each returns the largest value written, or 0 for filters
+// which don't compute it.
+
+unsigned char ConvolveX1D(const skia::ConvolutionFilter1D* filter,
+                          bool absolute_values,
+                          const SkBitmap* source,
+                          SkBitmap* target,
+                          const SkIRect& area) {
+  skia::SingleChannelConvolveX1D(
+      source->getAddr8(area.x(), area.y()),
+      static_cast<int>(source->rowBytes()),
+      0, source->bytesPerPixel(),
+      *filter,
+      SkISize::Make(area.width(), area.height()),
+      target->getAddr8(area.x(), area.y()),
+      static_cast<int>(target->rowBytes()),
+      0, target->bytesPerPixel(), absolute_values);
+  return 0;
+}
+
+unsigned char ConvolveY1D(const skia::ConvolutionFilter1D* filter,
+                          bool absolute_values,
+                          const SkBitmap* source,
+                          SkBitmap* target,
+                          const SkIRect& area) {
+  skia::SingleChannelConvolveY1D(
+      source->getAddr8(area.x(), area.y()),
+      static_cast<int>(source->rowBytes()),
+      0, source->bytesPerPixel(),
+      *filter,
+      SkISize::Make(area.width(), area.height()),
+      target->getAddr8(area.x(), area.y()),
+      static_cast<int>(target->rowBytes()),
+      0, target->bytesPerPixel(), absolute_values);
+  return 0;
+}
+
+unsigned char RecursiveGaussianX(const skia::RecursiveFilter* filter,
+                                 bool absolute_values,
+                                 const SkBitmap* source,
+                                 SkBitmap* target,
+                                 const SkIRect& area) {
+  return skia::SingleChannelRecursiveGaussianX(
+      source->getAddr8(area.x(), area.y()),
+      static_cast<int>(source->rowBytes()),
+      0, source->bytesPerPixel(),
+      *filter,
+      SkISize::Make(area.width(), area.height()),
+      target->getAddr8(area.x(), area.y()),
+      static_cast<int>(target->rowBytes()),
+      0, target->bytesPerPixel(), absolute_values);
+}
+
+unsigned char RecursiveGaussianY(const skia::RecursiveFilter* filter,
+                                 bool absolute_values,
+                                 const SkBitmap* source,
+                                 SkBitmap* target,
+                                 const SkIRect& area) {
+  return skia::SingleChannelRecursiveGaussianY(
+      source->getAddr8(area.x(), area.y()),
+      static_cast<int>(source->rowBytes()),
+      0, source->bytesPerPixel(),
+      *filter,
+      SkISize::Make(area.width(), area.height()),
+      target->getAddr8(area.x(), area.y()),
+      static_cast<int>(target->rowBytes()),
+      0, target->bytesPerPixel(), absolute_values);
+}
+
+typedef base::Callback<unsigned char(const SkIRect&)> FilterPass;
+
+enum FilterDirection {
+  // Filters along rows, which are independent, so tiles are bands of rows.
+  FILTER_HORIZONTAL,
+  // Filters along columns, so tiles are strips of columns.
+  FILTER_VERTICAL,
+};
+
+void RunFilterTile(const FilterPass& pass,
+                   FilterDirection direction,
+                   const SkISize& image_size,
+                   int tile_count,
+                   unsigned char* maxima,
+                   int tile) {
+  int begin, end;
+  SkIRect area;
+  if (direction == FILTER_HORIZONTAL) {
+    TileRunner::GetTileBounds(
+        image_size.height(), tile_count, tile, &begin, &end);
+    area = SkIRect::MakeLTRB(0, begin, image_size.width(), end);
+  } else {
+    TileRunner::GetTileBounds(
+        image_size.width(), tile_count, tile, &begin, &end);
+    area = SkIRect::MakeLTRB(begin, 0, end, image_size.height());
+  }
+  maxima[tile] = area.isEmpty() ? 0 : pass.Run(area);
+}
+
+// Runs |pass| over the whole image and returns the largest value written.
+// Tiling gives exactly the same result as filtering the image at once, since
+// every row (or column) is filtered on its own.
+unsigned char RunFilterPass(TileRunner* tile_runner,
+                            FilterDirection direction,
+                            const SkISize& image_size,
+                            const FilterPass& pass) {
+  int tile_count = tile_runner->GetTileCount(
+      direction == FILTER_HORIZONTAL ? image_size.height()
+                                     : image_size.width());
+  std::vector<unsigned char> maxima(tile_count, 0);
+  tile_runner->Run(tile_count,
+                   base::Bind(&RunFilterTile, pass, direction, image_size,
+                              tile_count, &maxima[0]));
+  return *std::max_element(maxima.begin(), maxima.end());
+}
+
+// Row tiles of the per-pixel passes.
+
+void ShiftLeftTile(RowKernels kernels,
+                   SkBitmap* bitmap,
+                   int bit_shift,
+                   int tile_count,
+                   int tile) {
+  int begin, end;
+  TileRunner::GetTileBounds(bitmap->height(), tile_count, tile, &begin, &end);
+  for (int r = begin; r < end; ++r)
+    kernels.shift_left(bitmap->getAddr8(0, r), bit_shift, bitmap->width());
+}
+
+void MaxGradientMagnitudeTile(RowKernels kernels,
+                              const SkBitmap* grad_x,
+                              const SkBitmap* grad_y,
+                              int tile_count,
+                              unsigned* maxima,
+                              int tile) {
+  int begin, end;
+  TileRunner::GetTileBounds(grad_x->height(), tile_count, tile, &begin, &end);
+  unsigned grad_max = 0;
+  for (int r = begin; r < end; ++r) {
+    grad_max = std::max(grad_max, kernels.max_gradient_magnitude(
+        grad_x->getAddr8(0, r), grad_y->getAddr8(0, r), grad_x->width()));
+  }
+  maxima[tile] = grad_max;
+}
+
+void GradientMagnitudeTile(RowKernels kernels,
+                           const SkBitmap* grad_x,
+                           const SkBitmap* grad_y,
+                           int bit_shift,
+                           int tile_count,
+                           SkBitmap* target,
+                           int tile) {
+  int begin, end;
+  TileRunner::GetTileBounds(target->height(), tile_count, tile, &begin, &end);
+  for (int r = begin; r < end; ++r) {
+    kernels.gradient_magnitude(grad_x->getAddr8(0, r),
+                               grad_y->getAddr8(0, r),
+                               bit_shift,
+                               target->width(),
+                               target->getAddr8(0, r));
+  }
+}
+
+// Accumulates the rows of a tile of |area| into |rows| and into the column
+// sums of the tile, which are added up once all tiles are done.
+void AccumulateProfileTile(RowKernels kernels,
+                           const SkBitmap* bitmap,
+                           const gfx::Rect& area,
+                           int tile_count,
+                           std::vector<float>* rows,
+                           std::vector<std::vector<uint32> >* column_sums,
+                           int tile) {
+  int begin, end;
+  TileRunner::GetTileBounds(area.height(), tile_count, tile, &begin, &end);
+  std::vector<uint32>& tile_column_sums = (*column_sums)[tile];
+  tile_column_sums.resize(area.width(), 0);
+  for (int r = begin; r < end; ++r) {
+    // Points to the first byte of the row in the rectangle.
+    const uint8* image_row = bitmap->getAddr8(area.x(), r + area.y());
+    (*rows)[r] = kernels.accumulate_profile(image_row, area.width(),
+                                            vector_as_array(&tile_column_sums));
+  }
+}
+
+// (offset, length) in bytes of a run of columns to keep.
+typedef std::vector<std::pair<size_t, size_t> > ColumnRuns;
+
+void DecimateTile(const SkBitmap* bitmap,
+                  const std::vector<int>* source_rows,
+                  const ColumnRuns* column_runs,
+                  int tile_count,
+                  SkBitmap* target,
+                  int tile) {
+  int begin, end;
+  TileRunner::GetTileBounds(target->height(), tile_count, tile, &begin, &end);
+  for (int target_row = begin; target_row < end; ++target_row) {
+    const uint8* src_row = static_cast<const uint8*>(bitmap->getPixels()) +
+        (*source_rows)[target_row] * bitmap->rowBytes();
+    uint8* insertion_target = static_cast<uint8*>(target->getPixels()) +
+        target_row * target->rowBytes();
+    for (size_t i = 0; i < column_runs->size(); ++i) {
+      memcpy(insertion_target,
+             src_row + (*column_runs)[i].first,
+             (*column_runs)[i].second);
+      insertion_target += (*column_runs)[i].second;
+    }
+  }
+}
+
 }  // namespace
 
 namespace thumbnailing_utils {
 
 void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
                                           float kernel_sigma) {
+  TileRunner tile_runner;
+  ApplyGaussianGradientMagnitudeFilter(input_bitmap, kernel_sigma,
+                                       &tile_runner);
+}
+
+void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
+                                          float kernel_sigma,
+                                          TileRunner* tile_runner) {
   // The purpose of this function is to highlight salient
   // (attention-attracting?) features of the image for use in image
   // retargeting.
@@ -234,6 +671,7 @@ void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
   DCHECK(input_bitmap);
   DCHECK(input_bitmap->getPixels());
   DCHECK_EQ(kAlpha_8_SkColorType, input_bitmap->colorType());
+  DCHECK(tile_runner);
 
   // To perform computations we will need one intermediate buffer. It can
   // very well be just another bitmap.
@@ -247,130 +685,73 @@ void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
   intermediate2.allocPixels(input_bitmap->info().makeWH(image_size.width(),
                                                         image_size.height()));
 
+  RowKernels kernels = GetRowKernels();
   if (kernel_sigma <= kSigmaThresholdForRecursive) {
     // For small kernels classic implementation is faster.
     skia::ConvolutionFilter1D smoothing_filter;
     skia::SetUpGaussianConvolutionKernel(
         &smoothing_filter, kernel_sigma, false);
-    skia::SingleChannelConvolveX1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), false);
-    skia::SingleChannelConvolveY1D(
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(), false);
+    RunFilterPass(tile_runner, FILTER_HORIZONTAL, image_size,
+                  base::Bind(&ConvolveX1D, &smoothing_filter, false,
+                             input_bitmap, &intermediate));
+    RunFilterPass(tile_runner, FILTER_VERTICAL, image_size,
+                  base::Bind(&ConvolveY1D, &smoothing_filter, false,
+                             &intermediate, input_bitmap));
 
     skia::ConvolutionFilter1D gradient_filter;
     skia::SetUpGaussianConvolutionKernel(&gradient_filter, kernel_sigma, true);
-    skia::SingleChannelConvolveX1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), true);
-    skia::SingleChannelConvolveY1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate2.getAddr8(0, 0),
-        static_cast<int>(intermediate2.rowBytes()),
-        0, intermediate2.bytesPerPixel(), true);
+    RunFilterPass(tile_runner, FILTER_HORIZONTAL, image_size,
+                  base::Bind(&ConvolveX1D, &gradient_filter, true,
+                             input_bitmap, &intermediate));
+    RunFilterPass(tile_runner, FILTER_VERTICAL, image_size,
+                  base::Bind(&ConvolveY1D, &gradient_filter, true,
+                             input_bitmap, &intermediate2));
   } else {
     // For larger sigma values use the recursive filter.
     skia::RecursiveFilter smoothing_filter(kernel_sigma,
                                            skia::RecursiveFilter::FUNCTION);
-    skia::SingleChannelRecursiveGaussianX(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), false);
-    unsigned char smoothed_max = skia::SingleChannelRecursiveGaussianY(
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(), false);
+    RunFilterPass(tile_runner, FILTER_HORIZONTAL, image_size,
+                  base::Bind(&RecursiveGaussianX, &smoothing_filter, false,
+                             input_bitmap, &intermediate));
+    unsigned char smoothed_max = RunFilterPass(
+        tile_runner, FILTER_VERTICAL, image_size,
+        base::Bind(&RecursiveGaussianY, &smoothing_filter, false,
+                   &intermediate, input_bitmap));
     if (smoothed_max < 127) {
       int bit_shift = 8 - static_cast<int>(
           std::log10(static_cast<float>(smoothed_max)) / std::log10(2.0f));
-      for (int r = 0; r < image_size.height(); ++r) {
-        uint8* row = input_bitmap->getAddr8(0, r);
-        for (int c = 0; c < image_size.width(); ++c, ++row) {
-          *row <<= bit_shift;
-        }
-      }
+      int tile_count = tile_runner->GetTileCount(image_size.height());
+      tile_runner->Run(tile_count,
+                       base::Bind(&ShiftLeftTile, kernels, input_bitmap,
+                                  bit_shift, tile_count));
     }
 
     skia::RecursiveFilter gradient_filter(
         kernel_sigma, skia::RecursiveFilter::FIRST_DERIVATIVE);
-    skia::SingleChannelRecursiveGaussianX(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), true);
-    skia::SingleChannelRecursiveGaussianY(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate2.getAddr8(0, 0),
-        static_cast<int>(intermediate2.rowBytes()),
-        0, intermediate2.bytesPerPixel(), true);
+    RunFilterPass(tile_runner, FILTER_HORIZONTAL, image_size,
+                  base::Bind(&RecursiveGaussianX, &gradient_filter, true,
+                             input_bitmap, &intermediate));
+    RunFilterPass(tile_runner, FILTER_VERTICAL, image_size,
+                  base::Bind(&RecursiveGaussianY, &gradient_filter, true,
+                             input_bitmap, &intermediate2));
   }
 
-  unsigned grad_max = 0;
-  for (int r = 0; r < image_size.height(); ++r) {
-    const uint8* grad_x_row = intermediate.getAddr8(0, r);
-    const uint8* grad_y_row = intermediate2.getAddr8(0, r);
-    for (int c = 0; c < image_size.width(); ++c) {
-      unsigned grad_x = grad_x_row[c];
-      unsigned grad_y = grad_y_row[c];
-      grad_max = std::max(grad_max, grad_x * grad_x + grad_y * grad_y);
-    }
-  }
+  int tile_count = tile_runner->GetTileCount(image_size.height());
+  std::vector<unsigned> maxima(tile_count, 0);
+  tile_runner->Run(tile_count,
+                   base::Bind(&MaxGradientMagnitudeTile, kernels,
+                              &intermediate, &intermediate2, tile_count,
+                              &maxima[0]));
+  unsigned grad_max = *std::max_element(maxima.begin(), maxima.end());
 
   int bit_shift = 0;
   if (grad_max > 255)
     bit_shift = static_cast<int>(
         std::log10(static_cast<float>(grad_max)) / std::log10(2.0f)) - 7;
-  for (int r = 0; r < image_size.height(); ++r) {
-    const uint8* grad_x_row = intermediate.getAddr8(0, r);
-    const uint8* grad_y_row = intermediate2.getAddr8(0, r);
-    uint8* target_row = input_bitmap->getAddr8(0, r);
-    for (int c = 0; c < image_size.width(); ++c) {
-      unsigned grad_x = grad_x_row[c];
-      unsigned grad_y = grad_y_row[c];
-      target_row[c] = (grad_x * grad_x + grad_y * grad_y) >> bit_shift;
-    }
-  }
+  tile_runner->Run(tile_count,
+                   base::Bind(&GradientMagnitudeTile, kernels,
+                              &intermediate, &intermediate2, bit_shift,
+                              tile_count, input_bitmap));
 }
 
 void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
@@ -379,6 +760,18 @@ void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
                                     bool apply_log,
                                     std::vector<float>* rows,
                                     std::vector<float>* columns) {
+  TileRunner tile_runner;
+  ExtractImageProfileInformation(input_bitmap, area, target_size, apply_log,
+                                 rows, columns, &tile_runner);
+}
+
+void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
+                                    const gfx::Rect& area,
+                                    const gfx::Size& target_size,
+                                    bool apply_log,
+                                    std::vector<float>* rows,
+                                    std::vector<float>* columns,
+                                    TileRunner* tile_runner) {
   SkAutoLockPixels source_lock(input_bitmap);
   DCHECK(rows);
   DCHECK(columns);
@@ -395,16 +788,19 @@ void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
   rows->resize(area.height(), 0);
   columns->resize(area.width(), 0);
 
-  for (int r = 0; r < area.height(); ++r) {
-    // Points to the first byte of the row in the rectangle.
-    const uint8* image_row = input_bitmap.getAddr8(area.x(), r + area.y());
-    unsigned row_sum = 0;
-    for (int c = 0; c < area.width(); ++c, ++image_row) {
-      row_sum += *image_row;
-      (*columns)[c] += *image_row;
-    }
-    (*rows)[r] = row_sum;
+  // Column sums are kept as integers, which are exact (and so equal to
+  // adding up floats) until a column sums to 2^24.
+  int tile_count = tile_runner->GetTileCount(area.height());
+  std::vector<std::vector<uint32> > column_sums(tile_count);
+  tile_runner->Run(tile_count,
+                   base::Bind(&AccumulateProfileTile, GetRowKernels(),
+                              &input_bitmap, area, tile_count, rows,
+                              &column_sums));
+  for (int tile = 1; tile < tile_count; ++tile) {
+    for (int c = 0; c < area.width(); ++c)
+      column_sums[0][c] += column_sums[tile][c];
   }
+  std::copy(column_sums[0].begin(), column_sums[0].end(), columns->begin());
 
   if (apply_log) {
     // Generally for processing we will need to take logarithm of this data.
@@ -660,6 +1056,14 @@ void ConstrainedProfileSegmentation(const std::vector<float>& row_profile,
 SkBitmap ComputeDecimatedImage(const SkBitmap& bitmap,
                                const std::vector<bool>& rows,
                                const std::vector<bool>& columns) {
+  TileRunner tile_runner;
+  return ComputeDecimatedImage(bitmap, rows, columns, &tile_runner);
+}
+
+SkBitmap ComputeDecimatedImage(const SkBitmap& bitmap,
+                               const std::vector<bool>& rows,
+                               const std::vector<bool>& columns,
+                               TileRunner* tile_runner) {
   SkAutoLockPixels source_lock(bitmap);
   DCHECK(bitmap.getPixels());
   DCHECK_GT(bitmap.bytesPerPixel(), 0);
@@ -681,39 +1085,35 @@ SkBitmap ComputeDecimatedImage(const SkBitmap& bitmap,
   target.allocPixels(bitmap.info().makeWH(target_column_count,
                                           target_row_count));
 
-  int target_row = 0;
-  for (int r = 0; r < bitmap.height(); ++r) {
-    if (!rows[r])
-      continue;  // We can just skip this one.
-    uint8* src_row =
-        static_cast<uint8*>(bitmap.getPixels()) + r * bitmap.rowBytes();
-    uint8* insertion_target = static_cast<uint8*>(target.getPixels()) +
-        target_row * target.rowBytes();
-    int left_copy_pixel = -1;
-    for (int c = 0; c < bitmap.width(); ++c) {
-      if (left_copy_pixel < 0 && columns[c]) {
-        left_copy_pixel = c;  // Next time we will start copying from here.
-      } else if (left_copy_pixel >= 0 && !columns[c]) {
-        // This closes a fragment we want to copy. We do it now.
-        size_t bytes_to_copy = (c - left_copy_pixel) * bitmap.bytesPerPixel();
-        memcpy(insertion_target,
-               src_row + left_copy_pixel * bitmap.bytesPerPixel(),
-               bytes_to_copy);
-        left_copy_pixel = -1;
-        insertion_target += bytes_to_copy;
-      }
+  // The same columns are copied out of every row, so find the runs of them
+  // once.
+  ColumnRuns column_runs;
+  int left_copy_pixel = -1;
+  for (int c = 0; c <= bitmap.width(); ++c) {
+    bool included = c < bitmap.width() && columns[c];
+    if (left_copy_pixel < 0 && included) {
+      left_copy_pixel = c;  // Next time we will start copying from here.
+    } else if (left_copy_pixel >= 0 && !included) {
+      // This closes a fragment we want to copy.
+      column_runs.push_back(std::make_pair(
+          left_copy_pixel * bitmap.bytesPerPixel(),
+          (c - left_copy_pixel) * bitmap.bytesPerPixel()));
+      left_copy_pixel = -1;
     }
-    // We can still have the tail end to process here.
-    if (left_copy_pixel >= 0) {
-      size_t bytes_to_copy =
-          (bitmap.width() - left_copy_pixel) * bitmap.bytesPerPixel();
-      memcpy(insertion_target,
-             src_row + left_copy_pixel * bitmap.bytesPerPixel(),
-             bytes_to_copy);
-    }
-    target_row++;
   }
 
+  std::vector<int> source_rows;
+  source_rows.reserve(target_row_count);
+  for (int r = 0; r < bitmap.height(); ++r) {
+    if (rows[r])
+      source_rows.push_back(r);
+  }
+
+  int tile_count = tile_runner->GetTileCount(target_row_count);
+  tile_runner->Run(tile_count,
+                   base::Bind(&DecimateTile, &bitmap, &source_rows,
+                              &column_runs, tile_count, &target));
+
   return target;
 }
 
@@ -721,6 +1121,16 @@ SkBitmap CreateRetargetedThumbnailImage(
     const SkBitmap& source_bitmap,
     const gfx::Size& target_size,
     float kernel_sigma) {
+  TileRunner tile_runner;
+  return CreateRetargetedThumbnailImage(source_bitmap, target_size,
+                                        kernel_sigma, &tile_runner);
+}
+
+SkBitmap CreateRetargetedThumbnailImage(
+    const SkBitmap& source_bitmap,
+    const gfx::Size& target_size,
+    float kernel_sigma,
+    TileRunner* tile_runner) {
   // First thing we need for this method is to color-reduce the source_bitmap.
   SkBitmap reduced_color;
   reduced_color.allocPixels(SkImageInfo::MakeA8(source_bitmap.width(),
@@ -741,7 +1151,8 @@ SkBitmap CreateRetargetedThumbnailImage(
   }
 
   // Turn 'color-reduced' image into the 'energy' image.
-  ApplyGaussianGradientMagnitudeFilter(&reduced_color, kernel_sigma);
+  ApplyGaussianGradientMagnitudeFilter(&reduced_color, kernel_sigma,
+                                       tile_runner);
 
   // Extract vertical and horizontal projection of image features.
   std::vector<float> row_profile;
@@ -752,7 +1163,8 @@ SkBitmap CreateRetargetedThumbnailImage(
                                  target_size,
                                  true,
                                  &row_profile,
-                                 &column_profile);
+                                 &column_profile,
+                                 tile_runner);
 
   std::vector<bool> included_rows, included_columns;
   ConstrainedProfileSegmentation(row_profile,
@@ -763,7 +1175,12 @@ SkBitmap CreateRetargetedThumbnailImage(
 
   // Use the original image and computed inclusion vectors to create a resized
   // image.
-  return ComputeDecimatedImage(source_bitmap, included_rows, included_columns);
+  return ComputeDecimatedImage(source_bitmap, included_rows, included_columns,
+                               tile_runner);
+}
+
+void SetSIMDKernelsEnabledForTesting(bool enabled) {
+  g_simd_kernels_enabled = enabled;
 }
 
 }  // thumbnailing_utils
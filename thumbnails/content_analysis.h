@@ -16,6 +16,8 @@ class SkBitmap;
 
 namespace thumbnailing_utils {
 
+class TileRunner;
+
 // Compute in-place gaussian gradient magnitude of |input_bitmap| with sigma
 // |kernel_sigma|. |input_bitmap| is requried to be of SkBitmap::kA8_Config
 // type. The routine computes first-order gaussian derivative on a
@@ -24,6 +26,12 @@ namespace thumbnailing_utils {
 void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
                                           float kernel_sigma);
 
+// As above, with the image split into tiles run by |tile_runner|. The result
+// is the same however the image is tiled.
+void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
+                                          float kernel_sigma,
+                                          TileRunner* tile_runner);
+
 // Accumulates vertical and horizontal sum of pixel values from a subsection of
 // |input_bitmap| defined by |image_area|. The image is required to be of
 // SkBitmap::kA8_Config type.
@@ -39,6 +47,16 @@ void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
                                     std::vector<float>* rows,
                                     std::vector<float>* columns);
 
+// As above, with the rows of |image_area| split into tiles run by
+// |tile_runner|.
+void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
+                                    const gfx::Rect& image_area,
+                                    const gfx::Size& target_size,
+                                    bool apply_log,
+                                    std::vector<float>* rows,
+                                    std::vector<float>* columns,
+                                    TileRunner* tile_runner);
+
 // Compute a threshold value separating background (low) from signal (high)
 // areas in the |input| profile.
 float AutoSegmentPeaks(const std::vector<float>& input);
@@ -70,6 +88,13 @@ SkBitmap ComputeDecimatedImage(const SkBitmap& bitmap,
                                const std::vector<bool>& rows,
                                const std::vector<bool>& columns);
 
+// As above, with the rows of the result split into tiles run by
+// |tile_runner|.
+SkBitmap ComputeDecimatedImage(const SkBitmap& bitmap,
+                               const std::vector<bool>& rows,
+                               const std::vector<bool>& columns,
+                               TileRunner* tile_runner);
+
 // Creates a new bitmap which contains only 'interesting' areas of
 // |source_bitmap|. The |target_size| is used to estimate some computation
 // parameters, but the resulting bitmap will not necessarily be of that size.
@@ -80,6 +105,16 @@ SkBitmap CreateRetargetedThumbnailImage(const SkBitmap& source_bitmap,
                                         const gfx::Size& target_size,
                                         float kernel_sigma);
 
+// As above, with the image passes split into tiles run by |tile_runner|.
+SkBitmap CreateRetargetedThumbnailImage(const SkBitmap& source_bitmap,
+                                        const gfx::Size& target_size,
+                                        float kernel_sigma,
+                                        TileRunner* tile_runner);
+
+// The per-pixel passes of the routines above use SSE2 where the CPU supports
+// it. Tests disable that to compare the results with the scalar code.
+void SetSIMDKernelsEnabledForTesting(bool enabled);
+
 }  // namespace thumbnailing_utils
 
 #endif  // CHROME_BROWSER_THUMBNAILS_CONTENT_ANALYSIS_H_
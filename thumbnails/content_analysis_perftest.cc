@@ -0,0 +1,93 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/thumbnails/content_analysis.h"
+
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/rect.h"
+#include "ui/gfx/size.h"
+
+namespace thumbnailing_utils {
+
+namespace {
+
+const int kIterations = 5;
+
+// Draws a monochrome imitation of a page capture: 'text' on a light
+// background with a few 'pictures'.
+void DrawCapture(SkBitmap* bitmap) {
+  SkAutoLockPixels lock(*bitmap);
+  for (int r = 0; r < bitmap->height(); ++r) {
+    uint8* row = bitmap->getAddr8(0, r);
+    for (int c = 0; c < bitmap->width(); ++c) {
+      bool glyph = (r / 8) % 2 && (c / 8) % 2 && (c / 64 + r / 16) % 5;
+      bool picture = (r / 200) % 2 && (c / 320) % 2;
+      row[c] = picture ? static_cast<uint8>(r + c) : (glyph ? 45 : 210);
+    }
+  }
+}
+
+class ThumbnailContentAnalysisPerfTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    SetSIMDKernelsEnabledForTesting(true);
+  }
+
+  // Times the image passes on a capture of a 1280x800 window, and reports
+  // them as |trace|.
+  void RunKernels(const std::string& trace) {
+    SkBitmap capture;
+    capture.allocPixels(SkImageInfo::MakeA8(1280, 800));
+    DrawCapture(&capture);
+
+    base::TimeDelta gradient_time;
+    base::TimeDelta profile_time;
+    std::vector<float> rows, columns;
+    for (int i = 0; i < kIterations; ++i) {
+      SkBitmap energy;
+      ASSERT_TRUE(capture.copyTo(&energy, kAlpha_8_SkColorType));
+      base::TimeTicks start = base::TimeTicks::Now();
+      ApplyGaussianGradientMagnitudeFilter(&energy, 5.0f);
+      base::TimeTicks gradient_done = base::TimeTicks::Now();
+      ExtractImageProfileInformation(energy,
+                                     gfx::Rect(energy.width(),
+                                               energy.height()),
+                                     gfx::Size(212, 132),
+                                     true,
+                                     &rows,
+                                     &columns);
+      gradient_time += gradient_done - start;
+      profile_time += base::TimeTicks::Now() - gradient_done;
+    }
+    EXPECT_EQ(800u, rows.size());
+    EXPECT_EQ(1280u, columns.size());
+
+    perf_test::PrintResult("thumbnail_gradient_magnitude", "", trace,
+                           gradient_time.InMillisecondsF() / kIterations,
+                           "ms", true);
+    perf_test::PrintResult("thumbnail_image_profile", "", trace,
+                           profile_time.InMillisecondsF() / kIterations,
+                           "ms", true);
+  }
+};
+
+}  // namespace
+
+TEST_F(ThumbnailContentAnalysisPerfTest, ScalarKernels) {
+  SetSIMDKernelsEnabledForTesting(false);
+  RunKernels("scalar");
+}
+
+TEST_F(ThumbnailContentAnalysisPerfTest, SIMDKernels) {
+  SetSIMDKernelsEnabledForTesting(true);
+  RunKernels("simd");
+}
+
+}  // namespace thumbnailing_utils
@@ -7,12 +7,15 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <numeric>
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/threading/thread.h"
+#include "chrome/browser/thumbnails/tile_runner.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColor.h"
@@ -65,6 +68,46 @@ bool CompareImageFragments(const SkBitmap& bitmap_left,
   return true;
 }
 
+// Fills a monochrome |bitmap| with reproducible noise.
+void FillWithNoise(SkBitmap* bitmap, uint32 seed) {
+  SkAutoLockPixels lock(*bitmap);
+  for (int r = 0; r < bitmap->height(); ++r) {
+    uint8* row = bitmap->getAddr8(0, r);
+    for (int c = 0; c < bitmap->width(); ++c) {
+      seed = seed * 1103515245u + 12345u;
+      row[c] = static_cast<uint8>(seed >> 16);
+    }
+  }
+}
+
+// Draws a monochrome imitation of a page capture: 'text' on a light
+// background with a few 'pictures'.
+void DrawCapture(SkBitmap* bitmap) {
+  SkAutoLockPixels lock(*bitmap);
+  for (int r = 0; r < bitmap->height(); ++r) {
+    uint8* row = bitmap->getAddr8(0, r);
+    for (int c = 0; c < bitmap->width(); ++c) {
+      bool glyph = (r / 8) % 2 && (c / 8) % 2 && (c / 64 + r / 16) % 5;
+      bool picture = (r / 200) % 2 && (c / 320) % 2;
+      row[c] = picture ? static_cast<uint8>(r + c) : (glyph ? 45 : 210);
+    }
+  }
+}
+
+bool BitmapsEqual(const SkBitmap& bitmap_left, const SkBitmap& bitmap_right) {
+  SkAutoLockPixels left_lock(bitmap_left);
+  SkAutoLockPixels right_lock(bitmap_right);
+  if (bitmap_left.width() != bitmap_right.width() ||
+      bitmap_left.height() != bitmap_right.height())
+    return false;
+  for (int r = 0; r < bitmap_left.height(); ++r) {
+    if (memcmp(bitmap_left.getAddr8(0, r), bitmap_right.getAddr8(0, r),
+               bitmap_left.width()) != 0)
+      return false;
+  }
+  return true;
+}
+
 float AspectDifference(const gfx::Size& reference, const gfx::Size& candidate) {
   return std::abs(static_cast<float>(candidate.width()) / candidate.height() -
                   static_cast<float>(reference.width()) / reference.height());
@@ -75,6 +118,10 @@ float AspectDifference(const gfx::Size& reference, const gfx::Size& candidate) {
 namespace thumbnailing_utils {
 
 class ThumbnailContentAnalysisTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    SetSIMDKernelsEnabledForTesting(true);
+  }
 };
 
 TEST_F(ThumbnailContentAnalysisTest, ApplyGradientMagnitudeOnImpulse) {
@@ -158,6 +205,101 @@ TEST_F(ThumbnailContentAnalysisTest, ApplyGradientMagnitudeOnFrame) {
   EXPECT_EQ(ImagePixelSum(reduced_color, inner_rect), 0U);
 }
 
+TEST_F(ThumbnailContentAnalysisTest, SIMDGradientMagnitudeMatchesScalar) {
+  // An odd width leaves a tail for the scalar code in every row.
+  SkBitmap source;
+  source.allocPixels(SkImageInfo::MakeA8(301, 67));
+  FillWithNoise(&source, 7);
+
+  // Both the convolution and the recursive filter paths.
+  const float kSigmas[] = { 1.0f, 2.5f };
+  for (size_t i = 0; i < arraysize(kSigmas); ++i) {
+    SkBitmap scalar;
+    ASSERT_TRUE(source.copyTo(&scalar, kAlpha_8_SkColorType));
+    SetSIMDKernelsEnabledForTesting(false);
+    ApplyGaussianGradientMagnitudeFilter(&scalar, kSigmas[i]);
+
+    SkBitmap simd;
+    ASSERT_TRUE(source.copyTo(&simd, kAlpha_8_SkColorType));
+    SetSIMDKernelsEnabledForTesting(true);
+    ApplyGaussianGradientMagnitudeFilter(&simd, kSigmas[i]);
+
+    EXPECT_TRUE(BitmapsEqual(scalar, simd)) << "sigma " << kSigmas[i];
+  }
+}
+
+TEST_F(ThumbnailContentAnalysisTest, SIMDImageProfileMatchesScalar) {
+  SkBitmap source;
+  source.allocPixels(SkImageInfo::MakeA8(301, 67));
+  FillWithNoise(&source, 11);
+
+  // An unaligned area, with and without the logarithm and closing.
+  const gfx::Rect area(3, 5, 277, 60);
+  const gfx::Size kTargetSizes[] = { gfx::Size(), gfx::Size(40, 20) };
+  for (size_t i = 0; i < arraysize(kTargetSizes); ++i) {
+    bool apply_log = !kTargetSizes[i].IsEmpty();
+    std::vector<float> scalar_rows, scalar_columns;
+    SetSIMDKernelsEnabledForTesting(false);
+    ExtractImageProfileInformation(source, area, kTargetSizes[i], apply_log,
+                                   &scalar_rows, &scalar_columns);
+
+    std::vector<float> simd_rows, simd_columns;
+    SetSIMDKernelsEnabledForTesting(true);
+    ExtractImageProfileInformation(source, area, kTargetSizes[i], apply_log,
+                                   &simd_rows, &simd_columns);
+
+    EXPECT_EQ(scalar_rows, simd_rows);
+    EXPECT_EQ(scalar_columns, simd_columns);
+  }
+}
+
+TEST_F(ThumbnailContentAnalysisTest, TiledPassesMatchUntiled) {
+  base::Thread helper_thread("ContentAnalysisTestHelper");
+  ASSERT_TRUE(helper_thread.Start());
+  TileRunner tile_runner(helper_thread.message_loop_proxy(), 3);
+
+  SkBitmap capture;
+  capture.allocPixels(SkImageInfo::MakeA8(643, 410));
+  DrawCapture(&capture);
+
+  // Both the convolution and the recursive filter paths.
+  const float kSigmas[] = { 1.0f, 2.5f };
+  for (size_t i = 0; i < arraysize(kSigmas); ++i) {
+    SkBitmap untiled;
+    ASSERT_TRUE(capture.copyTo(&untiled, kAlpha_8_SkColorType));
+    ApplyGaussianGradientMagnitudeFilter(&untiled, kSigmas[i]);
+
+    SkBitmap tiled;
+    ASSERT_TRUE(capture.copyTo(&tiled, kAlpha_8_SkColorType));
+    ApplyGaussianGradientMagnitudeFilter(&tiled, kSigmas[i], &tile_runner);
+
+    EXPECT_TRUE(BitmapsEqual(untiled, tiled)) << "sigma " << kSigmas[i];
+  }
+
+  const gfx::Rect area(5, 3, 600, 400);
+  std::vector<float> untiled_rows, untiled_columns;
+  ExtractImageProfileInformation(capture, area, gfx::Size(120, 80), true,
+                                 &untiled_rows, &untiled_columns);
+  std::vector<float> tiled_rows, tiled_columns;
+  ExtractImageProfileInformation(capture, area, gfx::Size(120, 80), true,
+                                 &tiled_rows, &tiled_columns, &tile_runner);
+  EXPECT_EQ(untiled_rows, tiled_rows);
+  EXPECT_EQ(untiled_columns, tiled_columns);
+
+  std::vector<bool> rows(capture.height());
+  for (size_t i = 0; i < rows.size(); ++i)
+    rows[i] = i % 3 != 0;
+  std::vector<bool> columns(capture.width());
+  for (size_t i = 0; i < columns.size(); ++i)
+    columns[i] = (i / 10) % 2 == 0;
+  SkBitmap untiled = ComputeDecimatedImage(capture, rows, columns);
+  SkBitmap tiled = ComputeDecimatedImage(capture, rows, columns, &tile_runner);
+  EXPECT_FALSE(untiled.empty());
+  EXPECT_TRUE(BitmapsEqual(untiled, tiled));
+
+  helper_thread.Stop();
+}
+
 TEST_F(ThumbnailContentAnalysisTest, ExtractImageProfileInformation) {
   gfx::Canvas canvas(gfx::Size(800, 600), 1.0f, true);
 
@@ -4,10 +4,16 @@
 
 #include "chrome/browser/thumbnails/content_based_thumbnailing_algorithm.h"
 
+#include <algorithm>
+
+#include "base/lazy_instance.h"
 #include "base/metrics/histogram.h"
+#include "base/sys_info.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "chrome/browser/thumbnails/content_analysis.h"
+#include "chrome/browser/thumbnails/retargeting_queue.h"
 #include "chrome/browser/thumbnails/simple_thumbnail_crop.h"
+#include "chrome/browser/thumbnails/tile_runner.h"
 #include "content/public/browser/browser_thread.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/gfx/scrollbar_size.h"
@@ -21,6 +27,16 @@ const char kThumbnailHistogramName[] = "Thumbnail.RetargetMS";
 const char kFailureHistogramName[] = "Thumbnail.FailedRetargetMS";
 const float kScoreBoostFromSuccessfulRetargeting = 1.1f;
 
+// Each capture is split into tiles over the blocking pool, so captures are
+// retargeted one at a time. Newer captures replace older ones of the same
+// page while they wait.
+const size_t kMaxRunningRetargets = 1;
+const size_t kMaxWaitingRetargets = 4;
+
+// The blocking pool has few threads, and the thread retargeting a capture
+// runs tiles too.
+const int kMaxTileHelpers = 2;
+
 void CallbackInvocationAdapter(
     const thumbnails::ThumbnailingAlgorithm::ConsumerCallback& callback,
     scoped_refptr<thumbnails::ThumbnailingContext> context,
@@ -28,6 +44,52 @@ void CallbackInvocationAdapter(
   callback.Run(*context.get(), source_bitmap);
 }
 
+void DeliverRetargetedThumbnail(
+    const thumbnails::ThumbnailingAlgorithm::ConsumerCallback& callback,
+    base::TimeTicks capture_time,
+    const base::Closure& done,
+    const thumbnails::ThumbnailingContext& context,
+    const SkBitmap& thumbnail) {
+  UMA_HISTOGRAM_TIMES("Thumbnail.RetargetFreshness",
+                      base::TimeTicks::Now() - capture_time);
+  callback.Run(context, thumbnail);
+  done.Run();
+}
+
+bool StartRetargeting(const thumbnails::RetargetingQueue::Capture& capture,
+                      const base::Closure& done) {
+  if (!content::BrowserThread::GetBlockingPool()->
+          PostWorkerTaskWithShutdownBehavior(
+              FROM_HERE,
+              base::Bind(&thumbnails::ContentBasedThumbnailingAlgorithm::
+                             CreateRetargetedThumbnail,
+                         capture.source_bitmap,
+                         capture.thumbnail_size,
+                         capture.context,
+                         base::Bind(&DeliverRetargetedThumbnail,
+                                    capture.callback,
+                                    capture.capture_time,
+                                    done)),
+              base::SequencedWorkerPool::SKIP_ON_SHUTDOWN)) {
+    LOG(WARNING) << "PostSequencedWorkerTask failed. The thumbnail for "
+                 << capture.context->url << " will not be created.";
+    return false;
+  }
+  return true;
+}
+
+class DefaultRetargetingQueue : public thumbnails::RetargetingQueue {
+ public:
+  DefaultRetargetingQueue()
+      : RetargetingQueue(kMaxRunningRetargets,
+                         kMaxWaitingRetargets,
+                         base::Bind(&StartRetargeting)) {
+  }
+};
+
+base::LazyInstance<DefaultRetargetingQueue>::Leaky g_retargeting_queue =
+    LAZY_INSTANCE_INITIALIZER;
+
 }  // namespace
 
 namespace thumbnails {
@@ -87,17 +149,13 @@ void ContentBasedThumbnailingAlgorithm::ProcessBitmap(
     return;
   }
 
-  if (!BrowserThread::GetBlockingPool()->PostWorkerTaskWithShutdownBehavior(
-          FROM_HERE,
-          base::Bind(&CreateRetargetedThumbnail,
-                     source_bitmap,
-                     target_thumbnail_size,
-                     context,
-                     callback),
-          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN)) {
-    LOG(WARNING) << "PostSequencedWorkerTask failed. The thumbnail for "
-                 << context->url << " will not be created.";
-  }
+  RetargetingQueue::Capture capture;
+  capture.source_bitmap = source_bitmap;
+  capture.thumbnail_size = target_thumbnail_size;
+  capture.context = context;
+  capture.callback = callback;
+  capture.capture_time = base::TimeTicks::Now();
+  g_retargeting_queue.Get().Add(capture);
 }
 
 // static
@@ -157,10 +215,16 @@ void ContentBasedThumbnailingAlgorithm::CreateRetargetedThumbnail(
     scoped_refptr<ThumbnailingContext> context,
     const ConsumerCallback& callback) {
   base::TimeTicks begin_compute_thumbnail = base::TimeTicks::Now();
+  base::TimeTicks begin_thread_time =
+      thumbnailing_utils::TileRunner::ThreadTimeNow();
+  thumbnailing_utils::TileRunner tile_runner(
+      BrowserThread::GetBlockingPool()->GetTaskRunnerWithShutdownBehavior(
+          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+      std::min(base::SysInfo::NumberOfProcessors() - 1, kMaxTileHelpers));
   float kernel_sigma =
       context->clip_result == CLIP_RESULT_SOURCE_SAME_AS_TARGET ? 5.0f : 2.5f;
   SkBitmap thumbnail = thumbnailing_utils::CreateRetargetedThumbnailImage(
-      source_bitmap, thumbnail_size, kernel_sigma);
+      source_bitmap, thumbnail_size, kernel_sigma, &tile_runner);
   bool processing_failed = thumbnail.empty();
   if (processing_failed) {
     // Log and apply the method very much like in SimpleThumbnailCrop (except
@@ -186,6 +250,10 @@ void ContentBasedThumbnailingAlgorithm::CreateRetargetedThumbnail(
         SimpleThumbnailCrop::CalculateBoringScore(source_bitmap);
   if (!processing_failed)
     context->score.boring_score *= kScoreBoostFromSuccessfulRetargeting;
+  // The time spent on all threads, including the tiles run by helpers.
+  UMA_HISTOGRAM_TIMES("Thumbnail.RetargetCPUTime",
+                      thumbnailing_utils::TileRunner::ThreadTimeNow() -
+                          begin_thread_time + tile_runner.helper_time());
   context->score.good_clipping =
       (context->clip_result == CLIP_RESULT_WIDER_THAN_TALL ||
        context->clip_result == CLIP_RESULT_TALLER_THAN_WIDE ||
@@ -35,7 +35,8 @@ class ContentBasedThumbnailingAlgorithm : public ThumbnailingAlgorithm {
 
   // The function processes |source_bitmap| into a thumbnail of |thumbnail_size|
   // and passes the result into |callback| (on UI thread). |context| describes
-  // how the thumbnail is being created.
+  // how the thumbnail is being created. The image is processed in tiles, some
+  // of which run on other threads of the blocking pool.
   static void CreateRetargetedThumbnail(
       const SkBitmap& source_bitmap,
       const gfx::Size& thumbnail_size,
@@ -0,0 +1,84 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/thumbnails/retargeting_queue.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "content/public/browser/browser_thread.h"
+
+namespace thumbnails {
+
+using content::BrowserThread;
+
+RetargetingQueue::Capture::Capture() {
+}
+
+RetargetingQueue::Capture::~Capture() {
+}
+
+RetargetingQueue::RetargetingQueue(size_t max_running,
+                                   size_t max_waiting,
+                                   const StartCallback& start_callback)
+    : max_running_(max_running),
+      max_waiting_(max_waiting),
+      start_callback_(start_callback),
+      running_count_(0),
+      weak_factory_(this) {
+  DCHECK_GT(max_running_, 0u);
+  DCHECK_GT(max_waiting_, 0u);
+}
+
+RetargetingQueue::~RetargetingQueue() {
+}
+
+void RetargetingQueue::Add(const Capture& capture) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  DCHECK(capture.context.get());
+  bool coalesced = false;
+  for (std::deque<Capture>::iterator it = waiting_.begin();
+       it != waiting_.end(); ++it) {
+    if (it->context->service.get() == capture.context->service.get() &&
+        it->context->url == capture.context->url) {
+      // Keep the place in the queue, but make the thumbnail from the newest
+      // capture.
+      *it = capture;
+      coalesced = true;
+      break;
+    }
+  }
+  UMA_HISTOGRAM_BOOLEAN("Thumbnail.RetargetCaptureCoalesced", coalesced);
+
+  if (!coalesced) {
+    if (waiting_.size() == max_waiting_) {
+      VLOG(1) << "Dropping the capture of " << waiting_.front().context->url
+              << " to make room for " << capture.context->url;
+      waiting_.pop_front();
+    }
+    waiting_.push_back(capture);
+  }
+  StartCaptures();
+}
+
+void RetargetingQueue::StartCaptures() {
+  while (running_count_ < max_running_ && !waiting_.empty()) {
+    Capture capture = waiting_.front();
+    waiting_.pop_front();
+    if (start_callback_.Run(capture,
+                            base::Bind(&RetargetingQueue::OnCaptureDone,
+                                       weak_factory_.GetWeakPtr()))) {
+      running_count_++;
+    }
+  }
+}
+
+void RetargetingQueue::OnCaptureDone() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  DCHECK_GT(running_count_, 0u);
+  running_count_--;
+  StartCaptures();
+}
+
+}  // namespace thumbnails
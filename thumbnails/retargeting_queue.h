@@ -0,0 +1,73 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_THUMBNAILS_RETARGETING_QUEUE_H_
+#define CHROME_BROWSER_THUMBNAILS_RETARGETING_QUEUE_H_
+
+#include <deque>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "chrome/browser/thumbnails/thumbnailing_algorithm.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/size.h"
+
+namespace thumbnails {
+
+// Captures waiting to be retargeted into thumbnails, on the UI thread. At most
+// |max_running| captures are processed at a time. A capture of a page which
+// is still waiting is replaced by the newer capture of the same page, since
+// only the newest thumbnail of a page is kept, and once |max_waiting|
+// captures wait the oldest one is dropped.
+class RetargetingQueue {
+ public:
+  struct Capture {
+    Capture();
+    ~Capture();
+
+    SkBitmap source_bitmap;
+    gfx::Size thumbnail_size;
+    scoped_refptr<ThumbnailingContext> context;
+    ThumbnailingAlgorithm::ConsumerCallback callback;
+    // When the capture arrived, to report the freshness of the thumbnail.
+    base::TimeTicks capture_time;
+  };
+
+  // Starts processing |capture| and returns true, in which case |done| must
+  // be run on the UI thread once the capture is processed. Returns false if
+  // the capture could not be started.
+  typedef base::Callback<bool(const Capture& capture,
+                              const base::Closure& done)> StartCallback;
+
+  RetargetingQueue(size_t max_running,
+                   size_t max_waiting,
+                   const StartCallback& start_callback);
+  ~RetargetingQueue();
+
+  void Add(const Capture& capture);
+
+  size_t running_count() const { return running_count_; }
+  size_t waiting_count() const { return waiting_.size(); }
+
+ private:
+  void StartCaptures();
+  void OnCaptureDone();
+
+  const size_t max_running_;
+  const size_t max_waiting_;
+  const StartCallback start_callback_;
+  std::deque<Capture> waiting_;
+  size_t running_count_;
+
+  base::WeakPtrFactory<RetargetingQueue> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(RetargetingQueue);
+};
+
+}  // namespace thumbnails
+
+#endif  // CHROME_BROWSER_THUMBNAILS_RETARGETING_QUEUE_H_
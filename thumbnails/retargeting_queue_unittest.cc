@@ -0,0 +1,131 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/thumbnails/retargeting_queue.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "content/public/test/test_browser_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace thumbnails {
+
+namespace {
+
+class RetargetingQueueTest : public testing::Test {
+ protected:
+  RetargetingQueueTest()
+      : ui_thread_(content::BrowserThread::UI, &message_loop_),
+        fail_starts_(false) {
+  }
+
+  RetargetingQueue::StartCallback GetStartCallback() {
+    return base::Bind(&RetargetingQueueTest::Start, base::Unretained(this));
+  }
+
+  RetargetingQueue::Capture CreateCapture(const std::string& url, int width) {
+    RetargetingQueue::Capture capture;
+    capture.context = ThumbnailingContext::CreateThumbnailingContextForTest();
+    capture.context->url = GURL(url);
+    capture.source_bitmap.allocN32Pixels(width, 10);
+    return capture;
+  }
+
+  // Finishes the oldest started capture.
+  void FinishCapture() {
+    ASSERT_FALSE(done_closures_.empty());
+    base::Closure done = done_closures_.front();
+    done_closures_.erase(done_closures_.begin());
+    done.Run();
+  }
+
+  base::MessageLoopForUI message_loop_;
+  content::TestBrowserThread ui_thread_;
+  bool fail_starts_;
+  std::vector<RetargetingQueue::Capture> started_;
+  std::vector<base::Closure> done_closures_;
+
+ private:
+  bool Start(const RetargetingQueue::Capture& capture,
+             const base::Closure& done) {
+    if (fail_starts_)
+      return false;
+    started_.push_back(capture);
+    done_closures_.push_back(done);
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_F(RetargetingQueueTest, RunsUpToMaxRunning) {
+  RetargetingQueue queue(2, 10, GetStartCallback());
+  queue.Add(CreateCapture("http://a.com/", 10));
+  queue.Add(CreateCapture("http://b.com/", 10));
+  queue.Add(CreateCapture("http://c.com/", 10));
+  EXPECT_EQ(2u, queue.running_count());
+  EXPECT_EQ(1u, queue.waiting_count());
+  ASSERT_EQ(2u, started_.size());
+
+  FinishCapture();
+  EXPECT_EQ(2u, queue.running_count());
+  EXPECT_EQ(0u, queue.waiting_count());
+  ASSERT_EQ(3u, started_.size());
+  EXPECT_EQ(GURL("http://c.com/"), started_[2].context->url);
+
+  FinishCapture();
+  FinishCapture();
+  EXPECT_EQ(0u, queue.running_count());
+}
+
+TEST_F(RetargetingQueueTest, CoalescesCapturesOfAPage) {
+  RetargetingQueue queue(1, 10, GetStartCallback());
+  queue.Add(CreateCapture("http://a.com/", 10));
+  queue.Add(CreateCapture("http://b.com/", 10));
+  queue.Add(CreateCapture("http://c.com/", 10));
+  // Replaces the waiting capture of b.com, which keeps its place.
+  queue.Add(CreateCapture("http://b.com/", 20));
+  EXPECT_EQ(2u, queue.waiting_count());
+
+  FinishCapture();
+  ASSERT_EQ(2u, started_.size());
+  EXPECT_EQ(GURL("http://b.com/"), started_[1].context->url);
+  EXPECT_EQ(20, started_[1].source_bitmap.width());
+
+  // a.com is no longer waiting, so a new capture of it queues up.
+  queue.Add(CreateCapture("http://a.com/", 10));
+  EXPECT_EQ(2u, queue.waiting_count());
+}
+
+TEST_F(RetargetingQueueTest, DropsOldestWaitingCapture) {
+  RetargetingQueue queue(1, 2, GetStartCallback());
+  queue.Add(CreateCapture("http://a.com/", 10));
+  queue.Add(CreateCapture("http://b.com/", 10));
+  queue.Add(CreateCapture("http://c.com/", 10));
+  queue.Add(CreateCapture("http://d.com/", 10));
+  EXPECT_EQ(2u, queue.waiting_count());
+
+  FinishCapture();
+  FinishCapture();
+  ASSERT_EQ(3u, started_.size());
+  EXPECT_EQ(GURL("http://c.com/"), started_[1].context->url);
+  EXPECT_EQ(GURL("http://d.com/"), started_[2].context->url);
+}
+
+TEST_F(RetargetingQueueTest, CapturesWhichFailToStart) {
+  RetargetingQueue queue(1, 2, GetStartCallback());
+  fail_starts_ = true;
+  queue.Add(CreateCapture("http://a.com/", 10));
+  EXPECT_EQ(0u, queue.running_count());
+  EXPECT_EQ(0u, queue.waiting_count());
+
+  fail_starts_ = false;
+  queue.Add(CreateCapture("http://b.com/", 10));
+  EXPECT_EQ(1u, queue.running_count());
+}
+
+}  // namespace thumbnails
@@ -0,0 +1,148 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/thumbnails/tile_runner.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/task_runner.h"
+
+namespace thumbnailing_utils {
+
+namespace {
+
+// A few tiles per thread even out tiles which take longer than others.
+const int kTilesPerThread = 4;
+
+// Smaller tiles cost more in handing them out than they gain.
+const int kMinTileExtent = 32;
+
+}  // namespace
+
+// The tiles of a single Run() call. Helpers which start after all the tiles
+// were handed out keep it alive but find nothing to do.
+class TileRunner::Batch : public base::RefCountedThreadSafe<Batch> {
+ public:
+  Batch(int tile_count, const TileTask& task)
+      : tile_count_(tile_count),
+        task_(task),
+        next_tile_(0),
+        finished_tiles_(0),
+        all_finished_(&lock_) {
+  }
+
+  // Runs tiles until none are left to start.
+  void RunTiles(bool on_helper) {
+    while (true) {
+      int tile;
+      {
+        base::AutoLock lock(lock_);
+        if (next_tile_ == tile_count_)
+          return;
+        tile = next_tile_++;
+      }
+      base::TimeTicks start;
+      if (on_helper)
+        start = ThreadTimeNow();
+      task_.Run(tile);
+      base::AutoLock lock(lock_);
+      if (on_helper)
+        helper_time_ += ThreadTimeNow() - start;
+      if (++finished_tiles_ == tile_count_)
+        all_finished_.Signal();
+    }
+  }
+
+  // Waits for the tiles still running on helpers and returns the time the
+  // helpers spent running tiles.
+  base::TimeDelta WaitUntilFinished() {
+    base::AutoLock lock(lock_);
+    while (finished_tiles_ < tile_count_)
+      all_finished_.Wait();
+    return helper_time_;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<Batch>;
+
+  ~Batch() {}
+
+  const int tile_count_;
+  const TileTask task_;
+
+  base::Lock lock_;
+  int next_tile_;
+  int finished_tiles_;
+  base::TimeDelta helper_time_;
+  base::ConditionVariable all_finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(Batch);
+};
+
+TileRunner::TileRunner() : max_helpers_(0) {
+}
+
+TileRunner::TileRunner(const scoped_refptr<base::TaskRunner>& helper_runner,
+                       int max_helpers)
+    : helper_runner_(helper_runner),
+      max_helpers_(helper_runner.get() ? std::max(max_helpers, 0) : 0) {
+}
+
+TileRunner::~TileRunner() {
+}
+
+int TileRunner::GetTileCount(int extent) const {
+  if (max_helpers_ == 0)
+    return 1;
+  int tile_count = std::min((max_helpers_ + 1) * kTilesPerThread,
+                            extent / kMinTileExtent);
+  return std::max(tile_count, 1);
+}
+
+void TileRunner::Run(int tile_count, const TileTask& task) {
+  if (tile_count <= 1 || max_helpers_ == 0) {
+    for (int tile = 0; tile < tile_count; ++tile)
+      task.Run(tile);
+    return;
+  }
+
+  scoped_refptr<Batch> batch(new Batch(tile_count, task));
+  int helper_count = std::min(max_helpers_, tile_count - 1);
+  for (int i = 0; i < helper_count; ++i) {
+    if (!helper_runner_->PostTask(
+            FROM_HERE, base::Bind(&Batch::RunTiles, batch, true))) {
+      break;
+    }
+  }
+  batch->RunTiles(false);
+  helper_time_ += batch->WaitUntilFinished();
+}
+
+// static
+void TileRunner::GetTileBounds(int extent,
+                               int tile_count,
+                               int tile,
+                               int* begin,
+                               int* end) {
+  DCHECK_GT(tile_count, 0);
+  DCHECK_GE(tile, 0);
+  DCHECK_LT(tile, tile_count);
+  *begin = static_cast<int>(static_cast<int64>(extent) * tile / tile_count);
+  *end = static_cast<int>(static_cast<int64>(extent) * (tile + 1) /
+                          tile_count);
+}
+
+// static
+base::TimeTicks TileRunner::ThreadTimeNow() {
+  if (base::TimeTicks::IsThreadNowSupported())
+    return base::TimeTicks::ThreadNow();
+  return base::TimeTicks::Now();
+}
+
+}  // namespace thumbnailing_utils
@@ -0,0 +1,70 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_THUMBNAILS_TILE_RUNNER_H_
+#define CHROME_BROWSER_THUMBNAILS_TILE_RUNNER_H_
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+
+namespace base {
+class TaskRunner;
+}
+
+namespace thumbnailing_utils {
+
+// Runs the tiles of an image pass in parallel, on the calling thread and on up
+// to |max_helpers| tasks posted to a helper task runner. Tiles are handed out
+// one at a time, so helpers which start late (or not at all, when the helper
+// runner is busy) only cost parallelism: the calling thread runs whatever
+// tiles are left, and then waits only for tiles already running elsewhere.
+class TileRunner {
+ public:
+  typedef base::Callback<void(int)> TileTask;
+
+  // Runs all tiles on the calling thread.
+  TileRunner();
+  TileRunner(const scoped_refptr<base::TaskRunner>& helper_runner,
+             int max_helpers);
+  ~TileRunner();
+
+  // Returns how many tiles to split |extent| rows or columns into.
+  int GetTileCount(int extent) const;
+
+  // Calls |task| with each of [0, |tile_count|) and returns when all of them
+  // have finished. |task| must be safe to run concurrently for different
+  // tiles.
+  void Run(int tile_count, const TileTask& task);
+
+  // Returns the first and one past the last row or column of |tile| when
+  // |extent| is split into |tile_count| tiles.
+  static void GetTileBounds(int extent,
+                            int tile_count,
+                            int tile,
+                            int* begin,
+                            int* end);
+
+  // Returns the thread time where the platform supports it and the wall time
+  // otherwise.
+  static base::TimeTicks ThreadTimeNow();
+
+  // Time spent running tiles on the helpers so far, as measured by
+  // ThreadTimeNow().
+  base::TimeDelta helper_time() const { return helper_time_; }
+
+ private:
+  class Batch;
+
+  scoped_refptr<base::TaskRunner> helper_runner_;
+  const int max_helpers_;
+  base::TimeDelta helper_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(TileRunner);
+};
+
+}  // namespace thumbnailing_utils
+
+#endif  // CHROME_BROWSER_THUMBNAILS_TILE_RUNNER_H_
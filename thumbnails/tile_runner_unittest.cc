@@ -0,0 +1,81 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/thumbnails/tile_runner.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace thumbnailing_utils {
+
+namespace {
+
+void CountTile(base::Lock* lock, std::vector<int>* runs, int tile) {
+  base::AutoLock auto_lock(*lock);
+  (*runs)[tile]++;
+}
+
+}  // namespace
+
+TEST(TileRunnerTest, GetTileBounds) {
+  int previous_end = 0;
+  for (int tile = 0; tile < 7; ++tile) {
+    int begin, end;
+    TileRunner::GetTileBounds(100, 7, tile, &begin, &end);
+    EXPECT_EQ(previous_end, begin);
+    EXPECT_LE(14, end - begin);
+    EXPECT_GE(15, end - begin);
+    previous_end = end;
+  }
+  EXPECT_EQ(100, previous_end);
+}
+
+TEST(TileRunnerTest, RunsEachTileOnce) {
+  base::Thread helper_thread("TileRunnerTestHelper");
+  ASSERT_TRUE(helper_thread.Start());
+  TileRunner tile_runner(helper_thread.message_loop_proxy(), 3);
+  int tile_count = tile_runner.GetTileCount(1000);
+  EXPECT_LT(1, tile_count);
+
+  base::Lock lock;
+  std::vector<int> runs(tile_count, 0);
+  tile_runner.Run(tile_count, base::Bind(&CountTile, &lock, &runs));
+  for (int tile = 0; tile < tile_count; ++tile)
+    EXPECT_EQ(1, runs[tile]) << "tile " << tile;
+  helper_thread.Stop();
+}
+
+TEST(TileRunnerTest, FinishesWithoutHelpers) {
+  // The helpers are posted to this thread, which doesn't run them until
+  // Run() has done all the tiles itself.
+  base::MessageLoop message_loop;
+  TileRunner tile_runner(message_loop.message_loop_proxy(), 2);
+  int tile_count = tile_runner.GetTileCount(1000);
+
+  base::Lock lock;
+  std::vector<int> runs(tile_count, 0);
+  tile_runner.Run(tile_count, base::Bind(&CountTile, &lock, &runs));
+  base::RunLoop().RunUntilIdle();
+  for (int tile = 0; tile < tile_count; ++tile)
+    EXPECT_EQ(1, runs[tile]) << "tile " << tile;
+  EXPECT_EQ(base::TimeDelta(), tile_runner.helper_time());
+}
+
+TEST(TileRunnerTest, WithoutHelperRunner) {
+  TileRunner tile_runner;
+  EXPECT_EQ(1, tile_runner.GetTileCount(1000));
+
+  base::Lock lock;
+  std::vector<int> runs(3, 0);
+  tile_runner.Run(3, base::Bind(&CountTile, &lock, &runs));
+  EXPECT_EQ(std::vector<int>(3, 1), runs);
+}
+
+}  // namespace thumbnailing_utils
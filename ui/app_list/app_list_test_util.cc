@@ -7,6 +7,7 @@
 #include "base/files/file_path.h"
 #include "chrome/browser/extensions/extension_service.h"
 #include "chrome/common/chrome_constants.h"
+#include "content/public/test/test_utils.h"
 #include "extensions/common/extension_set.h"
 
 const char AppListTestBase::kHostedAppId[] =
@@ -36,6 +37,7 @@ void AppListTestBase::SetUp() {
       .Append(chrome::kPreferencesFilename);
   InitializeInstalledExtensionService(pref_path, source_install_dir);
   service_->Init();
+  content::RunAllBlockingPoolTasksUntilIdle();
 
   // There should be 5 extensions in the test profile.
   const extensions::ExtensionSet* extensions = service_->extensions();
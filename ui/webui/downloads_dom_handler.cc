@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/bind.h"
@@ -28,6 +29,7 @@
 #include "chrome/browser/download/download_item_model.h"
 #include "chrome/browser/download/download_prefs.h"
 #include "chrome/browser/download/download_query.h"
+#include "chrome/browser/download/download_query_index.h"
 #include "chrome/browser/download/download_service.h"
 #include "chrome/browser/download/download_service_factory.h"
 #include "chrome/browser/download/drag_download_item.h"
@@ -244,6 +246,12 @@ bool IsDownloadDisplayable(const content::DownloadItem& item) {
           !item.GetTargetFilePath().empty());
 }
 
+const DownloadQueryIndex* GetDownloadQueryIndex(
+    content::DownloadManager* manager) {
+  return DownloadServiceFactory::GetForBrowserContext(
+      manager->GetBrowserContext())->GetDownloadQueryIndex();
+}
+
 }  // namespace
 
 DownloadsDOMHandler::DownloadsDOMHandler(content::DownloadManager* dlm)
@@ -497,13 +505,14 @@ void DownloadsDOMHandler::ScheduleSendCurrentDownloads() {
 
 void DownloadsDOMHandler::SendCurrentDownloads() {
   update_scheduled_ = false;
-  content::DownloadManager::DownloadVector all_items, filtered_items;
+  content::DownloadManager::DownloadVector filtered_items;
+  std::vector<const DownloadQueryIndex*> indexes;
   if (main_notifier_.GetManager()) {
-    main_notifier_.GetManager()->GetAllDownloads(&all_items);
+    indexes.push_back(GetDownloadQueryIndex(main_notifier_.GetManager()));
     main_notifier_.GetManager()->CheckForHistoryFilesRemoval();
   }
   if (original_notifier_.get() && original_notifier_->GetManager()) {
-    original_notifier_->GetManager()->GetAllDownloads(&all_items);
+    indexes.push_back(GetDownloadQueryIndex(original_notifier_->GetManager()));
     original_notifier_->GetManager()->CheckForHistoryFilesRemoval();
   }
   DownloadQuery query;
@@ -513,7 +522,7 @@ void DownloadsDOMHandler::SendCurrentDownloads() {
   query.AddFilter(base::Bind(&IsDownloadDisplayable));
   query.AddSorter(DownloadQuery::SORT_START_TIME, DownloadQuery::DESCENDING);
   query.Limit(kMaxDownloads);
-  query.Search(all_items.begin(), all_items.end(), &filtered_items);
+  query.Search(indexes, &filtered_items);
   base::ListValue results_value;
   for (content::DownloadManager::DownloadVector::const_iterator
        iter = filtered_items.begin(); iter != filtered_items.end(); ++iter) {
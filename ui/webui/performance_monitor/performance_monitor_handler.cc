@@ -9,6 +9,7 @@
 #include "base/command_line.h"
 #include "base/time/time.h"
 #include "base/values.h"
+#include "chrome/browser/performance_monitor/constants.h"
 #include "chrome/browser/performance_monitor/database.h"
 #include "chrome/browser/performance_monitor/event.h"
 #include "chrome/browser/performance_monitor/metric.h"
@@ -338,10 +339,22 @@ void DoGetMetrics(base::ListValue* results,
         "maxValue",
         db->GetMaxStatsForActivityAndMetric(*metric_type) * conversion_factor);
 
-    // Retrieve all metrics in the database, and aggregate them into a series
-    // of points for each active interval.
-    scoped_ptr<Database::MetricVector> metric_vector =
-        db->GetStatsForActivityAndMetric(*metric_type, start, end);
+    // Retrieve the metrics in the database and aggregate them into a series
+    // of points for each active interval. The mean can be computed from the
+    // rollup tiers, but the median and the unaggregated points need every
+    // sample, so those read the raw statistics as long as they are retained
+    // and only fall back to the rollup tiers for older points.
+    scoped_ptr<Database::MetricVector> metric_vector;
+    if (aggregation_method == AGGREGATION_METHOD_MEAN) {
+      metric_vector = db->GetStatsForActivityAndMetric(kProcessChromeAggregate,
+                                                       *metric_type,
+                                                       start,
+                                                       end,
+                                                       resolution);
+    } else {
+      metric_vector = db->GetRawStatsForActivityAndMetric(
+          kProcessChromeAggregate, *metric_type, start, end, resolution);
+    }
 
     scoped_ptr<VectorOfMetricVectors> aggregated_metrics =
         AggregateMetric(*metric_type,
@@ -7,6 +7,8 @@
 #include <map>
 #include <vector>
 
+#include "base/bind.h"
+#include "base/files/file_path.h"
 #include "base/id_map.h"
 #include "base/lazy_instance.h"
 #include "base/memory/ref_counted_memory.h"
@@ -103,6 +105,19 @@ base::LazyInstance<PrintPreviewRequestIdMapWithLock>
 base::LazyInstance<IDMap<PrintPreviewUI> >
     g_print_preview_ui_id_map = LAZY_INSTANCE_INITIALIZER;
 
+// Serves |data|, the preview data read back for a chrome://print request, or
+// empty data if it is not available.
+void ServePreviewData(const content::WebUIDataSource::GotDataCallback& callback,
+                      base::RefCountedBytes* data) {
+  if (data) {
+    callback.Run(data);
+    return;
+  }
+  // Invalid request.
+  scoped_refptr<base::RefCountedBytes> empty_bytes(new base::RefCountedBytes);
+  callback.Run(empty_bytes.get());
+}
+
 // PrintPreviewUI serves data for chrome://print requests.
 //
 // The format for requesting PDF data is as follows:
@@ -127,8 +142,8 @@ bool HandleRequestCallback(
   if (!EndsWith(path, "/print.pdf", true))
     return false;
 
-  // Print Preview data.
-  scoped_refptr<base::RefCountedBytes> data;
+  // Print Preview data. Pages that were spilled to disk are read back
+  // asynchronously.
   std::vector<std::string> url_substr;
   base::SplitString(path, '/', &url_substr);
   int preview_ui_id = -1;
@@ -137,16 +152,11 @@ bool HandleRequestCallback(
       base::StringToInt(url_substr[0], &preview_ui_id),
       base::StringToInt(url_substr[1], &page_index) &&
       preview_ui_id >= 0) {
-    PrintPreviewDataService::GetInstance()->GetDataEntry(
-        preview_ui_id, page_index, &data);
-  }
-  if (data.get()) {
-    callback.Run(data.get());
+    PrintPreviewDataService::GetInstance()->GetDataEntryAsync(
+        preview_ui_id, page_index, base::Bind(&ServePreviewData, callback));
     return true;
   }
-  // Invalid request.
-  scoped_refptr<base::RefCountedBytes> empty_bytes(new base::RefCountedBytes);
-  callback.Run(empty_bytes.get());
+  ServePreviewData(callback, NULL);
   return true;
 }
 
@@ -411,7 +421,12 @@ void PrintPreviewUI::GetPrintPreviewDataForIndex(
 void PrintPreviewUI::SetPrintPreviewDataForIndex(
     int index,
     const base::RefCountedBytes* data) {
-  print_preview_data_service()->SetDataEntry(id_, index, data);
+  // Off-the-record previews are never written to disk.
+  Profile* profile = Profile::FromWebUI(web_ui());
+  base::FilePath spill_dir;
+  if (!profile->IsOffTheRecord())
+    spill_dir = PrintPreviewDataService::GetSpillDir(profile->GetPath());
+  print_preview_data_service()->SetDataEntry(id_, index, data, spill_dir);
 }
 
 void PrintPreviewUI::ClearAllPreviewData() {